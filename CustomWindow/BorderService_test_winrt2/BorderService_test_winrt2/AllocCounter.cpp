@@ -0,0 +1,101 @@
+#include "AllocCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> s_allocations{ 0 };
+// Constant-initialized, so reading it never allocates (safe inside operator new)
+static thread_local uint64_t t_allocations = 0;
+
+uint64_t HeapAllocations() { return s_allocations.load(std::memory_order_relaxed); }
+uint64_t ThreadHeapAllocations() { return t_allocations; }
+
+// An ELF shared object would export the replacements below and take over its host's heap;
+// the Linux shared engine (BORDER_ENGINE_EXPORTS) leaves them out. A DLL's stay in the DLL.
+#if defined(_WIN32) || !defined(BORDER_ENGINE_EXPORTS)
+static void* Allocate(std::size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    ++t_allocations;
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) return nullptr;
+        handler();
+    }
+}
+
+static void* AllocateAligned(std::size_t size, std::size_t align)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    ++t_allocations;
+    if (size == 0) size = 1;
+    for (;;) {
+#if defined(_MSC_VER)
+        void* p = _aligned_malloc(size, align);
+#else
+        void* p = std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+        if (p) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) return nullptr;
+        handler();
+    }
+}
+
+static void FreeAligned(void* p)
+{
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* p = Allocate(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size)
+{
+    if (void* p = Allocate(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    if (void* p = AllocateAligned(size, static_cast<std::size_t>(align))) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    if (void* p = AllocateAligned(size, static_cast<std::size_t>(align))) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return AllocateAligned(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return AllocateAligned(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
+#endif
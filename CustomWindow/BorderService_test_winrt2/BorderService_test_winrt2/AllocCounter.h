@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+// Replacement global operator new / delete (AllocCounter.cpp) that count every heap
+// allocation made through them, process-wide and per thread, so a frame can tell whether
+// it touched the heap (FrameScope in FrameArena.h). Portable; linked into the service and
+// the Linux bench. Not replaced in the Linux shared engine, where both counts stay 0.
+
+uint64_t HeapAllocations();
+// Allocations made by the calling thread
+uint64_t ThreadHeapAllocations();
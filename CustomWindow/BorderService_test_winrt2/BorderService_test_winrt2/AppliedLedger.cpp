@@ -0,0 +1,153 @@
+#include "AppliedLedger.h"
+
+static constexpr size_t kHeaderWords = kLedgerHeaderBytes / 8;
+static constexpr size_t kRecordWords = kLedgerRecordBytes / 8;
+
+enum HeaderWord : size_t { kWordMagic, kWordSizes, kWordCapacity, kWordSequence, kWordCount, kWordChecksum, kWordWrites };
+
+static uint64_t Pack(uint32_t lo, uint32_t hi) { return static_cast<uint64_t>(lo) | (static_cast<uint64_t>(hi) << 32); }
+static uint32_t Lo(uint64_t w) { return static_cast<uint32_t>(w); }
+static uint32_t Hi(uint64_t w) { return static_cast<uint32_t>(w >> 32); }
+
+static uint64_t Checksum(const uint64_t* records, uint32_t count)
+{
+    // FNV-1a over whole words, with a fold so high bits reach the low ones
+    uint64_t h = 0xCBF29CE484222325ull;
+    auto mix = [&h](uint64_t w) {
+        h = (h ^ w) * 0x100000001B3ull;
+        h ^= h >> 29;
+    };
+    mix(count);
+    for (size_t i = 0; i < static_cast<size_t>(count) * kRecordWords; ++i) mix(records[i]);
+    return h;
+}
+
+const char* LedgerResultName(LedgerResult r)
+{
+    switch (r) {
+    case LedgerResult::Ok: return "ok";
+    case LedgerResult::Empty: return "empty";
+    case LedgerResult::Invalid: return "invalid";
+    case LedgerResult::Torn: return "torn";
+    }
+    return "?";
+}
+
+size_t LedgerBytes(uint32_t capacity)
+{
+    return kLedgerHeaderBytes + static_cast<size_t>(capacity) * kLedgerRecordBytes;
+}
+
+LedgerResult ReadLedger(const void* memory, size_t bytes, std::vector<LedgerEntry>& out, uint32_t* writerPid)
+{
+    out.clear();
+    if (!memory || bytes < kLedgerHeaderBytes) return LedgerResult::Invalid;
+    const uint64_t* words = static_cast<const uint64_t*>(memory);
+
+    if (words[kWordMagic] == 0) return LedgerResult::Empty;
+    if (words[kWordMagic] != Pack(kLedgerMagic, kLedgerVersion) ||
+        words[kWordSizes] != Pack(kLedgerHeaderBytes, kLedgerRecordBytes)) {
+        return LedgerResult::Invalid;
+    }
+    const uint32_t capacity = Lo(words[kWordCapacity]);
+    const uint32_t count = Lo(words[kWordCount]);
+    if (LedgerBytes(capacity) > bytes || count > capacity) return LedgerResult::Invalid;
+    if (words[kWordSequence] & 1) return LedgerResult::Torn;
+
+    const uint64_t* records = words + kHeaderWords;
+    if (Checksum(records, count) != words[kWordChecksum]) return LedgerResult::Torn;
+
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint64_t* r = records + static_cast<size_t>(i) * kRecordWords;
+        LedgerEntry e;
+        e.hwnd = r[0];
+        e.identity = r[1];
+        e.border.color = Lo(r[2]);
+        e.border.thickness = static_cast<int32_t>(Hi(r[2]));
+        e.border.corner = static_cast<CornerStyle>(Lo(r[3]));
+        out.push_back(e);
+    }
+    if (writerPid) *writerPid = Hi(words[kWordCapacity]);
+    return LedgerResult::Ok;
+}
+
+bool LedgerWriter::Attach(void* memory, size_t bytes, uint32_t writerPid)
+{
+    if (!memory || bytes < kLedgerHeaderBytes) return false;
+    m_words = static_cast<uint64_t*>(memory);
+    m_capacity = static_cast<uint32_t>((bytes - kLedgerHeaderBytes) / kLedgerRecordBytes);
+    m_pid = writerPid;
+
+    std::vector<LedgerEntry> existing;
+    if (ReadLedger(memory, bytes, existing) == LedgerResult::Ok && Lo(m_words[kWordCapacity]) == m_capacity) return true;
+
+    // Format: empty, complete and checksummed, so a crash right after still reads as Ok
+    m_words[kWordSequence] = 1;
+    m_words[kWordSizes] = Pack(kLedgerHeaderBytes, kLedgerRecordBytes);
+    m_words[kWordCapacity] = Pack(m_capacity, m_pid);
+    m_words[kWordCount] = 0;
+    m_words[kWordChecksum] = Checksum(m_words + kHeaderWords, 0);
+    m_words[kWordWrites] = 0;
+    m_words[7] = 0;
+    m_words[kWordMagic] = Pack(kLedgerMagic, kLedgerVersion);
+    m_words[kWordSequence] = 2;
+    return true;
+}
+
+size_t LedgerWriter::Write(const std::vector<LedgerEntry>& entries)
+{
+    if (!m_words) return 0;
+    uint32_t count = static_cast<uint32_t>(entries.size());
+    uint32_t flags = 0;
+    if (count > m_capacity) {
+        count = m_capacity;
+        flags |= kLedgerTruncated;
+    }
+
+    const uint64_t seq = m_words[kWordSequence] | 1;
+    m_words[kWordSequence] = seq;
+    uint64_t* records = m_words + kHeaderWords;
+    for (uint32_t i = 0; i < count; ++i) {
+        const LedgerEntry& e = entries[i];
+        uint64_t* r = records + static_cast<size_t>(i) * kRecordWords;
+        r[0] = e.hwnd;
+        r[1] = e.identity;
+        r[2] = Pack(e.border.color, static_cast<uint32_t>(e.border.thickness));
+        r[3] = static_cast<uint64_t>(e.border.corner);
+    }
+    m_words[kWordCapacity] = Pack(m_capacity, m_pid);
+    m_words[kWordCount] = Pack(count, flags);
+    m_words[kWordChecksum] = Checksum(records, count);
+    ++m_words[kWordWrites];
+    m_words[kWordSequence] = seq + 1;
+    return count;
+}
+
+LedgerAdoption AdoptLedger(const std::vector<LedgerEntry>& entries, WindowRegistry& registry,
+                           const std::function<uint64_t(uint64_t)>& identityOf)
+{
+    LedgerAdoption result;
+    for (const LedgerEntry& e : entries) {
+        const uint64_t identity = e.hwnd ? identityOf(e.hwnd) : 0;
+        if (!identity || identity != e.identity || registry.Find(e.hwnd) != WindowRegistry::kNoSlot) {
+            ++result.stale;
+            continue;
+        }
+        const WindowRegistry::Slot s = registry.Acquire(e.hwnd);
+        registry.Applied(s) = e.border;
+        registry.Identity(s) = identity;
+        registry.Flags(s) |= WindowRegistry::kApplied | WindowRegistry::kAdopted;
+        ++result.adopted;
+    }
+    return result;
+}
+
+void CollectLedger(WindowRegistry& registry, std::vector<LedgerEntry>& out)
+{
+    out.clear();
+    for (WindowRegistry::Slot s = 0; s < registry.SlotCount(); ++s) {
+        if (!registry.IsLive(s) || !(registry.Flags(s) & WindowRegistry::kApplied)) continue;
+        out.push_back({ registry.Handle(s), registry.Identity(s), registry.Applied(s) });
+    }
+}
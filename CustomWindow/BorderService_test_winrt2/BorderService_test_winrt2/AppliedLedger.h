@@ -0,0 +1,91 @@
+#pragma once
+#include "WindowRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// DWM attributes the service has written, persisted so a restarted service adopts them
+// instead of re-sending every window's attributes and can still restore windows the
+// previous instance bordered (LedgerFile.h maps it from disk). Portable.
+//
+// Binary format, little-endian, every field an aligned 64-bit word:
+//   header (64 bytes)
+//     +0  magic 'BSAL' | version << 32
+//     +8  headerBytes | recordBytes << 32
+//     +16 capacity | writer pid << 32
+//     +24 sequence   odd while a Write is in progress (a crash mid-write leaves it odd)
+//     +32 count | flags << 32               (LedgerFlag)
+//     +40 checksum   word-wise FNV-1a over count and the count records
+//     +48 writes     completed writes since the file was formatted
+//     +56 reserved
+//   record i at 64 + 32 * i
+//     +0  hwnd
+//     +8  identity   of the window's creator (WindowIdentity), so a reused HWND value
+//                    is never taken for the window that was bordered
+//     +16 color (COLORREF) | thickness << 32
+//     +24 corner
+// A file that is not a complete, checksummed ledger is rejected as a whole; the service
+// then starts from an empty ledger, which only costs re-sending attributes.
+
+static constexpr uint32_t kLedgerMagic = 0x4C415342; // "BSAL"
+static constexpr uint32_t kLedgerVersion = 1;
+static constexpr uint32_t kLedgerHeaderBytes = 64;
+static constexpr uint32_t kLedgerRecordBytes = 32;
+
+enum LedgerFlag : uint32_t {
+    kLedgerTruncated = 1u << 0, // more windows were applied than the file holds
+};
+
+struct LedgerEntry {
+    uint64_t hwnd = 0;
+    uint64_t identity = 0;
+    AppliedBorder border;
+};
+
+enum class LedgerResult {
+    Ok,
+    Empty,      // zeroed (a new file)
+    Invalid,    // not a ledger, another version or layout
+    Torn,       // interrupted write or checksum mismatch
+};
+const char* LedgerResultName(LedgerResult r);
+
+// Bytes needed for a file holding capacity records
+size_t LedgerBytes(uint32_t capacity);
+
+// Copies the entries out of a ledger image. Nothing is returned unless the result is Ok.
+LedgerResult ReadLedger(const void* memory, size_t bytes, std::vector<LedgerEntry>& out, uint32_t* writerPid = nullptr);
+
+class LedgerWriter {
+public:
+    // memory must be 8-byte aligned. A valid ledger is kept as it is (the next Write
+    // replaces it); anything else is formatted as an empty ledger. Fails if bytes cannot
+    // hold the header.
+    bool Attach(void* memory, size_t bytes, uint32_t writerPid);
+    bool Attached() const { return m_words != nullptr; }
+    uint32_t Capacity() const { return m_capacity; }
+
+    // Single writer. Replaces the contents; entries beyond Capacity() are dropped and
+    // kLedgerTruncated is set. Returns the number of records written.
+    size_t Write(const std::vector<LedgerEntry>& entries);
+
+private:
+    uint64_t* m_words = nullptr;
+    uint32_t m_capacity = 0;
+    uint32_t m_pid = 0;
+};
+
+struct LedgerAdoption {
+    size_t adopted = 0; // seeded into the registry
+    size_t stale = 0;   // window gone, or the handle now belongs to another window
+};
+
+// Seeds the registry with the entries whose window still has the recorded identity
+// (identityOf returns 0 for a window that no longer exists). Adopted slots get
+// kApplied | kAdopted and their identity but are not visited, so the first pass diffs
+// them like its own writes and restores the ones it no longer targets.
+LedgerAdoption AdoptLedger(const std::vector<LedgerEntry>& entries, WindowRegistry& registry,
+                           const std::function<uint64_t(uint64_t)>& identityOf);
+// Ledger entries for every live kApplied slot (the identity column must be filled)
+void CollectLedger(WindowRegistry& registry, std::vector<LedgerEntry>& out);
@@ -3,6 +3,12 @@
 #include "Logging.h"
 #include "ConsoleUtil.h"
 #include "Args.h"
+#include "ProcessFilter.h"
+#include "WindowStyles.h"
+#ifdef BORDER_BENCH
+#include "Bench.h"
+#endif
+#include "FastStart.h"
 
 static bool ParseColorString(const wchar_t* hex, D2D1_COLOR_F& out);
 
@@ -18,6 +24,14 @@ bool IsWindows11OrGreater()
     return (v.dwMajorVersion > 10) || (v.dwMajorVersion == 10 && v.dwBuildNumber >= 22000);
 }
 
+RenderMode ResolveRenderMode(RenderMode mode)
+{
+    // Windows 11: DWM attributes where they work, the overlay for windows that refuse them.
+    // Windows 10 has no border color attribute, so every window would fall back.
+    if (mode != RenderMode::Auto) return mode;
+    return IsWindows11OrGreater() ? RenderMode::Hybrid : RenderMode::DComp;
+}
+
 void ParseArgsAndApply()
 {
     int argc = 0;
@@ -29,19 +43,68 @@ void ParseArgsAndApply()
         return s;
     };
 
+    // Snapshot first so that explicit arguments override the persisted settings
+    for (int i = 1; i < argc; ++i) {
+        if (tolower(argv[i]) == L"--faststart") { g_fastStart = true; break; }
+    }
+    if (g_fastStart) LoadStartupSnapshot();
+
+    // Border settings are collected here and published as one snapshot
+    BorderSettings settings = *g_settings.Read();
     for (int i = 0; i < argc; ++i)
     {
         std::wstring arg = tolower(argv[i]);
         if (arg == L"--console") { g_console = true; continue; }
+        if (arg == L"--faststart") continue;
 
         if (arg == L"--foregroundonly" && i + 1 < argc) {
             std::wstring v = tolower(argv[i + 1]);
-            g_foregroundWindowOnly = (v == L"1" || v == L"true" || v == L"on");
+            settings.foregroundOnly = (v == L"1" || v == L"true" || v == L"on");
             ++i; continue;
         }
         if (arg.rfind(L"--foregroundonly=", 0) == 0) {
             std::wstring v = tolower(arg.substr(17));
-            g_foregroundWindowOnly = (v == L"1" || v == L"true" || v == L"on");
+            settings.foregroundOnly = (v == L"1" || v == L"true" || v == L"on");
+            continue;
+        }
+
+        if (arg == L"--powerpolicy" && i + 1 < argc) {
+            std::wstring v = tolower(argv[i + 1]);
+            g_powerPolicyEnabled = (v == L"1" || v == L"true" || v == L"on");
+            ++i; continue;
+        }
+        if (arg.rfind(L"--powerpolicy=", 0) == 0) {
+            std::wstring v = tolower(arg.substr(14));
+            g_powerPolicyEnabled = (v == L"1" || v == L"true" || v == L"on");
+            continue;
+        }
+
+        if (arg == L"--region" && i + 1 < argc) {
+            std::wstring v = tolower(argv[i + 1]);
+            g_overlayRegion = (v == L"1" || v == L"true" || v == L"on");
+            ++i; continue;
+        }
+        if (arg.rfind(L"--region=", 0) == 0) {
+            std::wstring v = tolower(arg.substr(9));
+            g_overlayRegion = (v == L"1" || v == L"true" || v == L"on");
+            continue;
+        }
+
+        if (arg == L"--exitdeadline" && i + 1 < argc) {
+            try { g_exitRestoreMs = static_cast<uint32_t>((std::min)(std::stoul(argv[i + 1]), 60000ul)); } catch (...) {}
+            ++i; continue;
+        }
+        if (arg.rfind(L"--exitdeadline=", 0) == 0) {
+            try { g_exitRestoreMs = static_cast<uint32_t>((std::min)(std::stoul(arg.substr(15)), 60000ul)); } catch (...) {}
+            continue;
+        }
+
+        if (arg == L"--idlerelease" && i + 1 < argc) {
+            try { g_idleReleaseSec = static_cast<uint32_t>((std::min)(std::stoul(argv[i + 1]), 86400ul)); } catch (...) {}
+            ++i; continue;
+        }
+        if (arg.rfind(L"--idlerelease=", 0) == 0) {
+            try { g_idleReleaseSec = static_cast<uint32_t>((std::min)(std::stoul(arg.substr(14)), 86400ul)); } catch (...) {}
             continue;
         }
 
@@ -49,6 +112,7 @@ void ParseArgsAndApply()
             std::wstring v = tolower(argv[i + 1]);
             if (v == L"dwm") g_mode = RenderMode::Dwm;
             else if (v == L"dcomp") g_mode = RenderMode::DComp;
+            else if (v == L"hybrid") g_mode = RenderMode::Hybrid;
             else g_mode = RenderMode::Auto;
             ++i; continue;
         }
@@ -56,42 +120,71 @@ void ParseArgsAndApply()
             std::wstring v = tolower(arg.substr(7));
             if (v == L"dwm") g_mode = RenderMode::Dwm;
             else if (v == L"dcomp") g_mode = RenderMode::DComp;
+            else if (v == L"hybrid") g_mode = RenderMode::Hybrid;
             else g_mode = RenderMode::Auto;
             continue;
         }
 
         if (arg == L"--corner" && i + 1 < argc) {
-            g_cornerToken = tolower(argv[++i]);
+            settings.cornerToken = tolower(argv[++i]);
             continue;
         }
         if (arg.rfind(L"--corner=", 0) == 0) {
-            g_cornerToken = tolower(arg.substr(9));
+            settings.cornerToken = tolower(arg.substr(9));
+            continue;
+        }
+
+        if (arg == L"--effect" && i + 1 < argc) {
+            settings.effectToken = tolower(argv[++i]);
+            continue;
+        }
+        if (arg.rfind(L"--effect=", 0) == 0) {
+            settings.effectToken = tolower(arg.substr(9));
+            continue;
+        }
+
+        if (arg == L"--exclude" && i + 1 < argc) {
+            SetExcludedProcesses(argv[++i]);
+            continue;
+        }
+        if (arg.rfind(L"--exclude=", 0) == 0) {
+            SetExcludedProcesses(std::wstring(argv[i] + 10));
+            continue;
+        }
+
+        if (arg == L"--rules" && i + 1 < argc) {
+            LoadStyleRulesFromFile(argv[++i]);
+            continue;
+        }
+        if (arg.rfind(L"--rules=", 0) == 0) {
+            LoadStyleRulesFromFile(std::wstring(argv[i] + 8));
             continue;
         }
 
         if (arg == L"--color" && i + 1 < argc) {
             D2D1_COLOR_F cf{};
-            if (ParseColorString(argv[i + 1], cf)) { g_borderColor = cf; DebugLog(L"[Overlay] Arg color"); }
+            if (ParseColorString(argv[i + 1], cf)) { settings.color = { cf.r, cf.g, cf.b, cf.a }; DebugLog(L"[Overlay] Arg color"); }
             ++i; continue;
         }
         if (arg.rfind(L"--color=", 0) == 0) {
             std::wstring val = std::wstring(argv[i] + 8);
             D2D1_COLOR_F cf{};
-            if (ParseColorString(val.c_str(), cf)) { g_borderColor = cf; DebugLog(L"[Overlay] Arg color"); }
+            if (ParseColorString(val.c_str(), cf)) { settings.color = { cf.r, cf.g, cf.b, cf.a }; DebugLog(L"[Overlay] Arg color"); }
             continue;
         }
         if (arg == L"--thickness" && i + 1 < argc) {
-            try { float tv = std::stof(argv[i + 1]); if (tv > 0 && tv < 1000) { g_thickness = tv; DebugLog(L"[Overlay] Arg thickness"); } } catch (...) {}
+            try { float tv = std::stof(argv[i + 1]); if (tv > 0 && tv < 1000) { settings.thickness = tv; DebugLog(L"[Overlay] Arg thickness"); } } catch (...) {}
             ++i; continue;
         }
         if (arg.rfind(L"--thickness=", 0) == 0) {
             std::wstring val = std::wstring(argv[i] + 12);
-            try { float tv = std::stof(val); if (tv > 0 && tv < 1000) { g_thickness = tv; DebugLog(L"[Overlay] Arg thickness"); } } catch (...) {}
+            try { float tv = std::stof(val); if (tv > 0 && tv < 1000) { settings.thickness = tv; DebugLog(L"[Overlay] Arg thickness"); } } catch (...) {}
             continue;
         }
     }
 
     LocalFree(argv);
+    g_settings.Update([&](BorderSettings& s) { s = settings; });
 
     if (g_console) {
         EnsureConsole(true);
@@ -99,10 +192,40 @@ void ParseArgsAndApply()
         ShowConsole(true);
     }
 
-    if (g_mode == RenderMode::Auto) {
-        g_mode = IsWindows11OrGreater() ? RenderMode::Dwm : RenderMode::DComp;
-    }
+    g_mode = ResolveRenderMode(g_mode);
     DebugLog(L"[Overlay] Mode decided");
+
+    SaveStartupSnapshot();
+    MarkStartupPhase(Metric::StartupArgsUs);
+}
+
+// --bench is only compiled into the bench build (msbuild /p:BorderBench=true)
+bool RunBenchFromArgs(int& exitCode)
+{
+#ifndef BORDER_BENCH
+    (void)exitCode;
+    return false;
+#else
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) return false;
+    if (argc < 3 || _wcsicmp(argv[1], L"--bench") != 0) {
+        LocalFree(argv);
+        return false;
+    }
+
+    // Benchmark names and key=value arguments are ASCII
+    auto narrow = [](const wchar_t* w) {
+        std::string s;
+        for (; *w; ++w) s.push_back(static_cast<char>(*w));
+        return s;
+    };
+    std::vector<std::string> args;
+    for (int i = 3; i < argc; ++i) args.push_back(narrow(argv[i]));
+    exitCode = RunBench(narrow(argv[2]), args);
+    LocalFree(argv);
+    return true;
+#endif
 }
 
 static bool ParseColorString(const wchar_t* hex, D2D1_COLOR_F& out)
@@ -3,4 +3,8 @@
 #include "Globals.h"
 
 void ParseArgsAndApply();
+// "--bench <name> [key=value ...]": runs a headless benchmark (Bench.h); returns false if not requested
+bool RunBenchFromArgs(int& exitCode);
 bool IsWindows11OrGreater();
+// Auto -> the mode for this Windows version; other modes unchanged
+RenderMode ResolveRenderMode(RenderMode mode);
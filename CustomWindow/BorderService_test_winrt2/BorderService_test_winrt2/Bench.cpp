@@ -0,0 +1,2953 @@
+#include "Bench.h"
+#include "Metrics.h"
+#include "AppliedLedger.h"
+#include "BorderAtlas.h"
+#include "BorderEffects.h"
+#include "BorderEngine.h"
+#include "EventClassifier.h"
+#include "EventPipeline.h"
+#include "ExitRestore.h"
+#include "LatencyTracker.h"
+#include "LayoutSnapshot.h"
+#include "MonitorPartition.h"
+#include "MoveSizeSession.h"
+#include "PowerPolicy.h"
+#include "RectKernels.h"
+#include "SettingsSnapshot.h"
+#include "SimBackend.h"
+#include "StartupSnapshot.h"
+#include "StyleRules.h"
+#include "TierScheduler.h"
+#include "WindowRegistry.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+void BenchReport::Add(const std::string& key, double value)
+{
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.3f", value);
+    m_fields.emplace_back(key, buf);
+}
+
+void BenchReport::AddText(const std::string& key, const std::string& value)
+{
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    m_fields.emplace_back(key, quoted + "\"");
+}
+
+std::string BenchReport::ToJson() const
+{
+    std::string out = "{\"Benchmark\":\"" + m_name + "\"";
+    for (const auto& kv : m_fields) out += ",\"" + kv.first + "\":" + kv.second;
+    out += ",\"Metrics\":\"" + FormatMetrics() + "\"}";
+    return out;
+}
+
+int64_t BenchArg(const std::vector<std::string>& args, const std::string& key, int64_t fallback)
+{
+    const std::string prefix = key + "=";
+    for (const auto& a : args) {
+        if (a.compare(0, prefix.size(), prefix) != 0) continue;
+        char* end = nullptr;
+        long long v = std::strtoll(a.c_str() + prefix.size(), &end, 10);
+        if (end && *end == '\0') return v;
+    }
+    return fallback;
+}
+
+uint64_t BenchNowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// ---- power: policy priority and transitions ----
+
+static bool BenchPowerExpect(const PowerInputs& in, const PowerPolicyConfig& cfg, PowerState state, const char* reason)
+{
+    const PowerDecision d = EvaluatePowerPolicy(in, cfg);
+    if (d.state != state || std::strcmp(d.reason, reason) != 0) return false;
+    switch (state) {
+    case PowerState::Suspended: return d.refreshIntervalMs == 0 && !d.hooksEnabled && d.ecoQos;
+    case PowerState::Throttled: return d.refreshIntervalMs == cfg.throttledIntervalMs && d.hooksEnabled && d.ecoQos;
+    case PowerState::Active: return d.refreshIntervalMs == cfg.activeIntervalMs && d.hooksEnabled && !d.ecoQos;
+    }
+    return false;
+}
+
+static bool BenchPower(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t steps = static_cast<size_t>(BenchArg(args, "steps", 100000));
+    const PowerPolicyConfig cfg;
+
+    // Priority: each input wins over every one after it
+    PowerInputs in;
+    in.sessionLocked = in.displayOff = in.fullscreenForeground = in.batterySaver = in.onBattery = true;
+    bool ok = BenchPowerExpect(in, cfg, PowerState::Suspended, "locked");
+    in.sessionLocked = false;
+    ok = ok && BenchPowerExpect(in, cfg, PowerState::Suspended, "display-off");
+    in.displayOff = false;
+    ok = ok && BenchPowerExpect(in, cfg, PowerState::Suspended, "fullscreen");
+    in.fullscreenForeground = false;
+    ok = ok && BenchPowerExpect(in, cfg, PowerState::Throttled, "battery-saver");
+    in.batterySaver = false;
+    ok = ok && BenchPowerExpect(in, cfg, PowerState::Throttled, "battery");
+    in.onBattery = false;
+    ok = ok && BenchPowerExpect(in, cfg, PowerState::Active, "active");
+    // Configuration switches
+    PowerPolicyConfig lenient = cfg;
+    lenient.suspendOnFullscreen = lenient.throttleOnBattery = false;
+    in.fullscreenForeground = in.onBattery = true;
+    ok = ok && BenchPowerExpect(in, lenient, PowerState::Active, "active");
+    in.fullscreenForeground = in.onBattery = false;
+
+    // Engine: an identical decision is no transition; the count and power.state follow the inputs
+    PowerPolicyEngine engine(cfg);
+    ok = ok && engine.Current().state == PowerState::Active && MetricGet(Metric::PowerState) == 0;
+    ok = ok && !engine.Update(in) && MetricGet(Metric::PowerTransitions) == 0;
+    in.onBattery = true;
+    ok = ok && engine.Update(in) && MetricGet(Metric::PowerState) == static_cast<int64_t>(PowerState::Throttled);
+    in.batterySaver = true; // same decision, other reason
+    ok = ok && !engine.Update(in) && std::strcmp(engine.Current().reason, "battery-saver") == 0;
+    in.sessionLocked = true;
+    ok = ok && engine.Update(in) && MetricGet(Metric::PowerState) == static_cast<int64_t>(PowerState::Suspended);
+    ok = ok && MetricGet(Metric::PowerHooksSuspended) == 1 && MetricGet(Metric::PowerRefreshMs) == 0;
+    ok = ok && MetricGet(Metric::PowerTransitions) == 2;
+
+    // Random inputs: transitions are exactly the steps whose reference decision changed
+    std::mt19937 rng(26);
+    PowerPolicyEngine random(cfg);
+    const int64_t base = MetricGet(Metric::PowerTransitions);
+    PowerState last = random.Current().state;
+    uint64_t expected = 0, reported = 0;
+    const uint64_t t0 = BenchNowNs();
+    for (size_t i = 0; i < steps; ++i) {
+        const uint32_t bits = rng();
+        PowerInputs next;
+        // Mostly unlocked, display on: the interesting states stay reachable
+        next.sessionLocked = (bits & 0xF) == 0;
+        next.displayOff = (bits & 0xF0) == 0;
+        next.fullscreenForeground = (bits & 0x300) == 0;
+        next.batterySaver = (bits & 0xC00) == 0;
+        next.onBattery = (bits & 0x1000) != 0;
+        const PowerState want = EvaluatePowerPolicy(next, cfg).state;
+        if (want != last) ++expected;
+        last = want;
+        if (random.Update(next)) ++reported;
+        ok = ok && random.Current().state == want && MetricGet(Metric::PowerState) == static_cast<int64_t>(want);
+    }
+    const uint64_t updateNs = BenchNowNs() - t0;
+    ok = ok && reported == expected && MetricGet(Metric::PowerTransitions) - base == static_cast<int64_t>(expected);
+
+    report.Add("Steps", static_cast<double>(steps));
+    report.Add("Transitions", static_cast<double>(expected));
+    report.Add("NsPerUpdate", steps ? static_cast<double>(updateNs) / static_cast<double>(steps) : 0.0);
+    return ok;
+}
+
+// ---- rules: style rule compile + match throughput ----
+
+static std::wstring BenchWord(std::mt19937& rng, size_t len)
+{
+    std::wstring w;
+    for (size_t i = 0; i < len; ++i) w.push_back(static_cast<wchar_t>(L'a' + rng() % 26));
+    return w;
+}
+
+static bool BenchRules(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t ruleCount = static_cast<size_t>(BenchArg(args, "rules", 5000));
+    const size_t windowCount = static_cast<size_t>(BenchArg(args, "windows", 2000));
+    const size_t rounds = static_cast<size_t>(BenchArg(args, "rounds", 20));
+
+    std::mt19937 rng(28);
+    std::vector<std::wstring> processes, classes;
+    for (size_t i = 0; i < 400; ++i) processes.push_back(BenchWord(rng, 4 + rng() % 8));
+    for (size_t i = 0; i < 200; ++i) classes.push_back(BenchWord(rng, 6 + rng() % 10));
+
+    std::vector<StyleRule> rules;
+    rules.reserve(ruleCount);
+    for (size_t i = 0; i < ruleCount; ++i) {
+        StyleRule r;
+        switch (rng() % 5) {
+        case 0: r.process = processes[rng() % processes.size()]; break;
+        case 1: r.windowClass = classes[rng() % classes.size()]; break;
+        case 2: r.process = processes[rng() % processes.size()]; r.title = BenchWord(rng, 3 + rng() % 5); break;
+        default: r.title = BenchWord(rng, 4 + rng() % 6); break;
+        }
+        r.hasThickness = true;
+        r.thickness = 1.0f + static_cast<float>(i % 8);
+        rules.push_back(std::move(r));
+    }
+
+    struct Win { std::wstring process, cls, title; };
+    std::vector<Win> windows;
+    windows.reserve(windowCount);
+    for (size_t i = 0; i < windowCount; ++i) {
+        windows.push_back({ processes[rng() % processes.size()], classes[rng() % classes.size()],
+                            BenchWord(rng, 20 + rng() % 40) });
+        // Every other title carries some rule's pattern, so title rules match too
+        const StyleRule& r = rules[rng() % rules.size()];
+        if (i % 2 == 0 && !r.title.empty()) windows.back().title.insert(rng() % windows.back().title.size(), r.title);
+    }
+
+    CompiledStyleRules compiled;
+    uint64_t t0 = BenchNowNs();
+    compiled.Compile(rules);
+    uint64_t compileNs = BenchNowNs() - t0;
+
+    // The indexed matcher must pick the rule a first-match linear scan picks
+    auto linearMatch = [&](const Win& w) {
+        for (size_t i = 0; i < rules.size(); ++i) {
+            const StyleRule& rule = rules[i];
+            if (!rule.process.empty() && rule.process != w.process) continue;
+            if (!rule.windowClass.empty() && rule.windowClass != w.cls) continue;
+            if (!rule.title.empty() && w.title.find(rule.title) == std::wstring::npos) continue;
+            return static_cast<int32_t>(i);
+        }
+        return CompiledStyleRules::kNoMatch;
+    };
+    size_t mismatches = 0;
+    for (const auto& w : windows) {
+        if (compiled.Match(w.process, w.cls, w.title) != linearMatch(w)) ++mismatches;
+    }
+
+    size_t matched = 0;
+    t0 = BenchNowNs();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (const auto& w : windows) {
+            if (compiled.Match(w.process, w.cls, w.title) != CompiledStyleRules::kNoMatch) ++matched;
+        }
+    }
+    uint64_t matchNs = BenchNowNs() - t0;
+    const double evaluations = static_cast<double>(rounds * windows.size());
+
+    // Reference: first-match linear scan over the same rules
+    size_t linearMatched = 0;
+    const size_t linearRounds = rounds < 2 ? rounds : 2;
+    t0 = BenchNowNs();
+    for (size_t r = 0; r < linearRounds; ++r) {
+        for (const auto& w : windows) {
+            if (linearMatch(w) != CompiledStyleRules::kNoMatch) ++linearMatched;
+        }
+    }
+    uint64_t linearNs = BenchNowNs() - t0;
+
+    report.Add("RuleCount", static_cast<double>(rules.size()));
+    report.Add("WindowCount", static_cast<double>(windows.size()));
+    report.Add("CompileMs", compileNs / 1e6);
+    report.Add("MatchNsPerWindow", matchNs / evaluations);
+    report.Add("LinearScanNsPerWindow", linearRounds ? linearNs / static_cast<double>(linearRounds * windows.size()) : 0.0);
+    report.Add("MatchRatePct", 100.0 * matched / evaluations);
+    report.Add("LinearMatchRatePct", linearRounds ? 100.0 * linearMatched / (linearRounds * windows.size()) : 0.0);
+    report.Add("Mismatches", static_cast<double>(mismatches));
+    return mismatches == 0;
+}
+
+// ---- queue: intake -> render pipeline stress (producers race a slow consumer) ----
+
+static bool BenchQueue(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t producers = static_cast<size_t>(BenchArg(args, "producers", 4));
+    const size_t perProducer = static_cast<size_t>(BenchArg(args, "events", 250000));
+    const size_t capacity = static_cast<size_t>(BenchArg(args, "capacity", 1024));
+    const uint64_t batchWorkNs = static_cast<uint64_t>(BenchArg(args, "batch_work_ns", 20000));
+
+    std::atomic<uint64_t> consumed{ 0 }, batches{ 0 }, resyncs{ 0 }, orderErrors{ 0 };
+    std::vector<uint64_t> lastSeq(producers, 0);
+
+    // Simulated refresh cost per batch lets the ring fill up and exercise the overflow policy
+    EventPipeline pipeline(capacity, [&](const EventBatch& batch) {
+        for (const auto& e : batch.events) {
+            // Per-producer FIFO: sequence numbers from one producer must increase
+            uint64_t& last = lastSeq[e.idObject];
+            if (e.hwnd <= last) orderErrors.fetch_add(1, std::memory_order_relaxed);
+            last = e.hwnd;
+        }
+        consumed.fetch_add(batch.events.size(), std::memory_order_relaxed);
+        batches.fetch_add(1, std::memory_order_relaxed);
+        if (batch.overflowed) resyncs.fetch_add(1, std::memory_order_relaxed);
+        uint64_t until = BenchNowNs() + batchWorkNs;
+        while (BenchNowNs() < until) {}
+    });
+    pipeline.Start();
+
+    std::atomic<uint64_t> pushed{ 0 };
+    uint64_t t0 = BenchNowNs();
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            uint64_t ok = 0;
+            for (size_t i = 1; i <= perProducer; ++i) {
+                EventRecord rec;
+                rec.event = 0x800B; // EVENT_OBJECT_LOCATIONCHANGE
+                rec.idObject = static_cast<int32_t>(p);
+                rec.hwnd = i;
+                if (pipeline.Push(rec)) ++ok;
+            }
+            pushed.fetch_add(ok, std::memory_order_relaxed);
+        });
+    }
+    for (auto& t : threads) t.join();
+    uint64_t produceNs = BenchNowNs() - t0;
+
+    // Let the consumer finish what was accepted
+    uint64_t deadline = BenchNowNs() + 5000000000ull;
+    while (consumed.load() < pushed.load() && BenchNowNs() < deadline) std::this_thread::yield();
+    pipeline.RequestStop();
+    pipeline.Join();
+
+    const double total = static_cast<double>(producers * perProducer);
+    bool accountingOk = pushed.load() + pipeline.Dropped() == producers * perProducer &&
+                        consumed.load() == pushed.load() && orderErrors.load() == 0 &&
+                        (pipeline.Dropped() == 0 || resyncs.load() > 0);
+
+    // WakeAt: an empty timer batch at the deadline; a later call moves it, 0 cancels it
+    std::atomic<uint64_t> timerAt{ 0 }, timerBatches{ 0 };
+    EventPipeline timed(16, [&](const EventBatch& batch) {
+        if (!batch.timer || !batch.events.empty()) return;
+        timerAt.store(BenchNowNs());
+        timerBatches.fetch_add(1);
+    });
+    timed.Start();
+    const uint64_t w0 = BenchNowNs();
+    timed.WakeAt(w0 + 2000000000ull);
+    timed.WakeAt(w0 + 20000000ull);
+    while (!timerBatches.load() && BenchNowNs() < w0 + 5000000000ull) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    timed.WakeAt(BenchNowNs() + 10000000ull);
+    timed.WakeAt(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    timed.RequestStop();
+    timed.Join();
+    accountingOk = accountingOk && timerBatches.load() == 1 && timerAt.load() >= w0 + 20000000ull &&
+                   timerAt.load() < w0 + 1000000000ull;
+
+    // Ping-pong without a deadline: every push must wake the consumer by itself. A wake-up
+    // lost while the consumer was between batches would leave a record waiting for good.
+    const size_t roundTrips = static_cast<size_t>(BenchArg(args, "round_trips", 20000));
+    std::atomic<uint64_t> echoed{ 0 };
+    EventPipeline echo(16, [&](const EventBatch& batch) { echoed.fetch_add(batch.events.size(), std::memory_order_release); });
+    echo.Start();
+    size_t lostWakes = 0;
+    uint64_t maxRoundTripNs = 0;
+    for (size_t i = 1; i <= roundTrips && lostWakes == 0; ++i) {
+        EventRecord rec;
+        rec.hwnd = i;
+        const uint64_t r0 = BenchNowNs();
+        echo.Push(rec);
+        while (echoed.load(std::memory_order_acquire) < i) {
+            if (BenchNowNs() - r0 > 1000000000ull) {
+                ++lostWakes;
+                break;
+            }
+        }
+        maxRoundTripNs = std::max(maxRoundTripNs, BenchNowNs() - r0);
+    }
+    echo.RequestStop();
+    echo.Join();
+    accountingOk = accountingOk && lostWakes == 0;
+
+    report.Add("Producers", static_cast<double>(producers));
+    report.Add("Capacity", static_cast<double>(pipeline.Capacity()));
+    report.Add("EventsOffered", total);
+    report.Add("EventsAccepted", static_cast<double>(pushed.load()));
+    report.Add("EventsDropped", static_cast<double>(pipeline.Dropped()));
+    report.Add("EventsConsumed", static_cast<double>(consumed.load()));
+    report.Add("Batches", static_cast<double>(batches.load()));
+    report.Add("OverflowResyncs", static_cast<double>(resyncs.load()));
+    report.Add("PushNsPerEvent", produceNs * static_cast<double>(producers) / total);
+    report.Add("RoundTrips", static_cast<double>(roundTrips));
+    report.Add("MaxRoundTripUs", maxRoundTripNs / 1e3);
+    report.Add("LostWakes", static_cast<double>(lostWakes));
+    report.Add("AccountingOk", accountingOk ? 1.0 : 0.0);
+    return accountingOk;
+}
+
+// ---- registry: SoA window registry vs. the previous node-based maps ----
+
+// Counts bytes requested by the baseline unordered_map (nodes + bucket array; per-allocation
+// heap headers are not included, so the map figure is a lower bound)
+static size_t s_countedBytes = 0;
+static size_t s_countedAllocs = 0;
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+    CountingAllocator() = default;
+    template <typename U> CountingAllocator(const CountingAllocator<U>&) {}
+    T* allocate(size_t n)
+    {
+        s_countedBytes += n * sizeof(T);
+        ++s_countedAllocs;
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n)
+    {
+        s_countedBytes -= n * sizeof(T);
+        --s_countedAllocs;
+        ::operator delete(p);
+    }
+    template <typename U> bool operator==(const CountingAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+static bool BenchRegistry(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t windowCount = static_cast<size_t>(BenchArg(args, "windows", 10000));
+    const size_t frames = static_cast<size_t>(BenchArg(args, "frames", 200));
+    const size_t churnPct = static_cast<size_t>(BenchArg(args, "churn_pct", 1));
+
+    // HWND-like handles: small multiples of 4 around a common base, reshuffled (z-order) per frame
+    std::mt19937_64 rng(31);
+    std::vector<uint64_t> handles(windowCount);
+    uint64_t nextHandle = 0x10000;
+    for (auto& h : handles) { nextHandle += 4 * (1 + rng() % 8); h = nextHandle; }
+    auto churn = [&](std::vector<uint64_t>& hs) {
+        for (size_t i = 0; i < hs.size() * churnPct / 100; ++i) {
+            nextHandle += 4 * (1 + rng() % 8);
+            hs[rng() % hs.size()] = nextHandle; // a window closed, another opened
+        }
+        std::swap(hs[rng() % hs.size()], hs[rng() % hs.size()]); // restack
+    };
+    auto rectFor = [](uint64_t h) {
+        WindowRect r;
+        r.left = static_cast<int32_t>(h % 1900);
+        r.top = static_cast<int32_t>((h / 7) % 1000);
+        r.right = r.left + 400;
+        r.bottom = r.top + 300;
+        return r;
+    };
+
+    // Registry: one frame pass = acquire/visit/write columns, sweep, then a region/draw-like walk
+    std::vector<uint64_t> hs = handles;
+    WindowRegistry reg;
+    int64_t checksumA = 0;
+    uint64_t t0 = BenchNowNs();
+    for (size_t f = 0; f < frames; ++f) {
+        churn(hs);
+        reg.BeginPass();
+        for (uint64_t h : hs) {
+            WindowRegistry::Slot s = reg.Acquire(h);
+            reg.Visit(s);
+            reg.Rect(s) = rectFor(h);
+        }
+        reg.SweepUnvisited([](WindowRegistry::Slot) {});
+        for (WindowRegistry::Slot s : reg.Order()) {
+            const WindowRect& r = reg.Rect(s);
+            checksumA += (r.right - r.left) + static_cast<int64_t>(reg.Style(s).thickness);
+        }
+    }
+    uint64_t registryNs = BenchNowNs() - t0;
+
+    // Baseline: node-per-window map ledger plus a fresh rect vector per frame (the old layout)
+    struct Node { WindowRect rc; BorderStyle style; AppliedBorder applied; uint32_t seen; };
+    using Map = std::unordered_map<uint64_t, Node, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                                   CountingAllocator<std::pair<const uint64_t, Node>>>;
+    struct RectAndStyle { WindowRect rc; BorderStyle style; };
+    hs = handles;
+    rng.seed(31);
+    nextHandle = handles.back();
+    int64_t checksumB = 0;
+    size_t mapBytes = 0, mapAllocs = 0;
+    t0 = BenchNowNs();
+    {
+        Map map;
+        for (size_t f = 0; f < frames; ++f) {
+            churn(hs);
+            const uint32_t epoch = static_cast<uint32_t>(f + 1);
+            std::vector<RectAndStyle> rects;
+            rects.reserve(hs.size());
+            for (uint64_t h : hs) {
+                Node& n = map[h];
+                n.seen = epoch;
+                n.rc = rectFor(h);
+                rects.push_back({ n.rc, n.style });
+            }
+            for (auto it = map.begin(); it != map.end(); ) {
+                if (it->second.seen != epoch) it = map.erase(it);
+                else ++it;
+            }
+            for (const auto& rs : rects) checksumB += (rs.rc.right - rs.rc.left) + static_cast<int64_t>(rs.style.thickness);
+        }
+        mapBytes = s_countedBytes;
+        mapAllocs = s_countedAllocs;
+    }
+    uint64_t mapNs = BenchNowNs() - t0;
+
+    const double perWindowFrame = static_cast<double>(frames) * static_cast<double>(windowCount);
+    report.Add("Windows", static_cast<double>(reg.Size()));
+    report.Add("Frames", static_cast<double>(frames));
+    report.Add("RegistryNsPerWindowFrame", registryNs / perWindowFrame);
+    report.Add("MapNsPerWindowFrame", mapNs / perWindowFrame);
+    report.Add("RegistryBytesPerWindow", static_cast<double>(reg.MemoryBytes()) / reg.Size());
+    report.Add("MapBytesPerWindow", static_cast<double>(mapBytes) / windowCount);
+    report.Add("MapAllocations", static_cast<double>(mapAllocs));
+    report.Add("SlotCount", static_cast<double>(reg.SlotCount()));
+    // Both layouts must have walked the same windows
+    return checksumA == checksumB && reg.Size() == windowCount;
+}
+
+// ---- classifier: WinEvent classification against scripted window sessions ----
+
+struct BenchWindow { bool desktop, topLevel, tracked, trackable; };
+
+class BenchWindowFacts : public WindowFactSource {
+public:
+    std::unordered_map<uint64_t, BenchWindow> windows;
+    uint64_t queries = 0;
+    bool Query(uint64_t hwnd, WindowFact fact) override
+    {
+        ++queries;
+        auto it = windows.find(hwnd);
+        if (it == windows.end()) return false;
+        switch (fact) {
+        case WindowFact::Desktop: return it->second.desktop;
+        case WindowFact::TopLevel: return it->second.topLevel;
+        case WindowFact::Tracked: return it->second.tracked;
+        case WindowFact::Trackable: return it->second.trackable;
+        }
+        return false;
+    }
+};
+
+static bool BenchClassifier(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t rounds = static_cast<size_t>(BenchArg(args, "rounds", 20000));
+
+    // winuser.h values
+    const uint32_t kForeground = 0x0003, kMoveSizeStart = 0x000A, kMoveSizeEnd = 0x000B, kMinStart = 0x0016,
+                   kDestroy = 0x8001, kShow = 0x8002, kHide = 0x8003, kReorder = 0x8004, kLocation = 0x800B,
+                   kName = 0x800C, kValueChange = 0x800E, kCloaked = 0x8017, kUncloaked = 0x8018;
+    const int32_t kWindow = 0, kClient = -4, kVScroll = -5, kCaret = -8, kCursor = -9;
+    const uint64_t desktop = 0x10, editor = 0x100, edit = 0x200, tooltip = 0x300, newApp = 0x400, other = 0x500;
+
+    BenchWindowFacts facts;
+    facts.windows[desktop] = { true, true, false, false };
+    facts.windows[editor] = { false, true, true, true };
+    facts.windows[edit] = { false, false, false, false };    // child control
+    facts.windows[tooltip] = { false, true, false, false };  // WS_EX_TOOLWINDOW popup
+    facts.windows[newApp] = { false, true, false, true };    // eligible, not drawn yet
+    facts.windows[other] = { false, true, true, true };
+
+    struct Case { EventRecord rec; WindowChange expect; bool typing; };
+    auto ev = [](uint32_t event, int32_t obj, uint64_t h) { EventRecord e; e.event = event; e.idObject = obj; e.hwnd = h; return e; };
+    const std::vector<Case> cases = {
+        // Typing in an editor: none of these may cost a refresh
+        { ev(kLocation, kCaret, edit), WindowChange::None, true },
+        { ev(kLocation, kCursor, 0), WindowChange::None, true },
+        { ev(kLocation, kVScroll, edit), WindowChange::None, true },
+        { ev(kLocation, kWindow, edit), WindowChange::None, true },
+        { ev(kName, kClient, edit), WindowChange::None, true },
+        { ev(kName, kWindow, edit), WindowChange::None, true },
+        { ev(kValueChange, kClient, edit), WindowChange::None, true },
+        { ev(kReorder, kClient, edit), WindowChange::None, true },
+        { ev(kShow, kWindow, tooltip), WindowChange::None, true },
+        { ev(kHide, kWindow, tooltip), WindowChange::None, true },
+        { ev(kDestroy, kWindow, tooltip), WindowChange::None, true },
+        { ev(kShow, kCaret, edit), WindowChange::None, true },
+        // Title "*" marker: only the style rule re-evaluation may turn this into a refresh
+        { ev(kName, kWindow, editor), WindowChange::Renamed, true },
+        // Window management that must get through
+        { ev(kLocation, kWindow, editor), WindowChange::Moved, false },
+        { ev(kLocation, kWindow, newApp), WindowChange::Moved, false },
+        { ev(kShow, kWindow, newApp), WindowChange::Shown, false },
+        { ev(kHide, kWindow, other), WindowChange::Hidden, false },
+        { ev(kMinStart, kWindow, other), WindowChange::Hidden, false },
+        { ev(kCloaked, kWindow, other), WindowChange::Hidden, false },
+        { ev(kUncloaked, kWindow, newApp), WindowChange::Shown, false },
+        { ev(kCloaked, kWindow, tooltip), WindowChange::None, false },
+        { ev(kReorder, kClient, desktop), WindowChange::Restacked, false },
+        { ev(kForeground, kWindow, newApp), WindowChange::Focus, false },
+        { ev(kDestroy, kWindow, other), WindowChange::Destroyed, false },
+        { ev(kMoveSizeStart, kWindow, editor), WindowChange::MoveSizeStart, false },
+        { ev(kMoveSizeStart, kWindow, tooltip), WindowChange::None, false },
+        { ev(kMoveSizeEnd, kWindow, tooltip), WindowChange::MoveSizeEnd, false },
+        { ev(kEventRefreshRequest, 0, 0), WindowChange::Refresh, false },
+    };
+
+    bool ok = true;
+    size_t typingRefreshes = 0, mismatches = 0;
+    for (const auto& c : cases) {
+        // Stage 1 must agree with the full classification whenever it drops something
+        bool pre = c.rec.event == kEventRefreshRequest || PreFilterEvent(c.rec.event, c.rec.idObject, c.rec.hwnd);
+        WindowChange got = ClassifyEvent(c.rec, facts);
+        if (!pre && got != WindowChange::None) ok = false;
+        if (got != c.expect) {
+            ++mismatches;
+            std::fprintf(stderr, "classifier: event 0x%x obj %d hwnd 0x%llx -> %s, expected %s\n",
+                         c.rec.event, c.rec.idObject, static_cast<unsigned long long>(c.rec.hwnd),
+                         WindowChangeName(got), WindowChangeName(c.expect));
+        }
+        if (c.typing && got != WindowChange::None && got != WindowChange::Renamed) ++typingRefreshes;
+    }
+    ok = ok && mismatches == 0 && typingRefreshes == 0;
+
+    // Throughput over the same mix
+    ResetMetrics();
+    facts.queries = 0;
+    size_t accepted = 0;
+    uint64_t t0 = BenchNowNs();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (const auto& c : cases) {
+            if (ClassifyEvent(c.rec, facts) != WindowChange::None) ++accepted;
+        }
+    }
+    uint64_t ns = BenchNowNs() - t0;
+    const double total = static_cast<double>(rounds * cases.size());
+
+    report.Add("Cases", static_cast<double>(cases.size()));
+    report.Add("Mismatches", static_cast<double>(mismatches));
+    report.Add("TypingRefreshes", static_cast<double>(typingRefreshes));
+    report.Add("AcceptedPct", 100.0 * accepted / total);
+    report.Add("FactQueriesPerEvent", facts.queries / total);
+    report.Add("NsPerEvent", ns / total);
+    return ok;
+}
+
+// ---- layout: seqlock-published window layout with concurrent readers ----
+
+static LayoutWindow BenchLayoutWindow(uint64_t frame, uint32_t i)
+{
+    // Every field derives from (frame, i), so a reader can tell a torn copy from a clean one
+    LayoutWindow w;
+    w.hwnd = (frame << 16) | i;
+    w.rect = { static_cast<int32_t>(frame), static_cast<int32_t>(i), static_cast<int32_t>(frame + i), -static_cast<int32_t>(i) };
+    w.flags = kLayoutVisible | ((i % 2) ? kLayoutApplied : 0u);
+    w.color = static_cast<uint32_t>(frame * 2654435761u) ^ i;
+    w.thickness = static_cast<float>(frame % 16);
+    w.corner = static_cast<CornerStyle>(i % 4);
+    return w;
+}
+
+static bool BenchLayoutConsistent(const LayoutFrame& f)
+{
+    if (f.screen.right != static_cast<int32_t>(f.frame) || f.windows.size() != 20 + f.frame % 60) return false;
+    for (uint32_t i = 0; i < f.windows.size(); ++i) {
+        const LayoutWindow want = BenchLayoutWindow(f.frame, i);
+        const LayoutWindow& got = f.windows[i];
+        if (got.hwnd != want.hwnd || got.rect.left != want.rect.left || got.rect.top != want.rect.top ||
+            got.rect.right != want.rect.right || got.rect.bottom != want.rect.bottom || got.flags != want.flags ||
+            got.color != want.color || got.thickness != want.thickness || got.corner != want.corner) return false;
+    }
+    return true;
+}
+
+static bool BenchLayout(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t readerCount = static_cast<size_t>(BenchArg(args, "readers", 4));
+    const uint64_t frames = static_cast<uint64_t>(BenchArg(args, "frames", 200000));
+    const uint32_t capacity = static_cast<uint32_t>(BenchArg(args, "capacity", 256));
+
+    std::vector<uint64_t> region(LayoutBytes(capacity) / 8, 0);
+    LayoutWriter writer;
+    bool ok = writer.Attach(region.data(), region.size() * 8, 1234);
+
+    // Truncation: a tiny region keeps the first windows and says so
+    {
+        std::vector<uint64_t> small(LayoutBytes(3) / 8, 0);
+        LayoutWriter w;
+        LayoutReader r;
+        std::vector<LayoutWindow> five;
+        for (uint32_t i = 0; i < 5; ++i) five.push_back(BenchLayoutWindow(1, i));
+        w.Attach(small.data(), small.size() * 8, 1);
+        w.Publish({ 0, 0, 1, 1 }, five, 0);
+        LayoutFrame f;
+        ok = ok && r.Attach(small.data(), small.size() * 8) && r.TryRead(f) == LayoutReader::Result::Ok &&
+             f.windows.size() == 3 && (f.flags & kLayoutTruncated) && f.windows[2].hwnd == five[2].hwnd;
+    }
+
+    std::atomic<bool> done{ false };
+    std::atomic<uint64_t> reads{ 0 }, midReads{ 0 }, busy{ 0 }, retries{ 0 }, torn{ 0 }, invalid{ 0 };
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < readerCount; ++r) {
+        readers.emplace_back([&] {
+            LayoutReader reader;
+            reader.Attach(region.data(), region.size() * 8);
+            LayoutFrame f;
+            f.windows.reserve(capacity);
+            uint64_t myReads = 0, myMidReads = 0, myBusy = 0, myRetries = 0, myTorn = 0, myInvalid = 0, lastSeq = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                switch (reader.TryRead(f, 16, &myRetries)) {
+                case LayoutReader::Result::Ok:
+                    ++myReads;
+                    // A frame the writer had already moved past: read while it was publishing
+                    if (f.frame && f.frame < frames) ++myMidReads;
+                    // Sequence never goes backwards; contents always belong to one frame
+                    if (f.sequence < lastSeq || (f.frame && !BenchLayoutConsistent(f))) ++myTorn;
+                    lastSeq = f.sequence;
+                    break;
+                case LayoutReader::Result::Busy: ++myBusy; break;
+                case LayoutReader::Result::Invalid: ++myInvalid; break;
+                }
+            }
+            reads += myReads; midReads += myMidReads; busy += myBusy; retries += myRetries; torn += myTorn; invalid += myInvalid;
+        });
+    }
+
+    std::vector<LayoutWindow> windows;
+    windows.reserve(capacity);
+    uint64_t maxPublishNs = 0;
+    const uint64_t t0 = BenchNowNs();
+    for (uint64_t f = 1; f <= frames; ++f) {
+        windows.clear();
+        for (uint32_t i = 0; i < 20 + f % 60; ++i) windows.push_back(BenchLayoutWindow(f, i));
+        const uint64_t p0 = BenchNowNs();
+        writer.Publish({ 0, 0, static_cast<int32_t>(f), 0 }, windows, 0);
+        maxPublishNs = std::max(maxPublishNs, BenchNowNs() - p0);
+        if (f % 1024 == 0) std::this_thread::yield(); // let readers in on a single core
+    }
+    const uint64_t writeNs = BenchNowNs() - t0;
+    done.store(true, std::memory_order_release);
+    for (auto& t : readers) t.join();
+
+    // Final state is readable and exact
+    LayoutReader check;
+    LayoutFrame last;
+    ok = ok && check.Attach(region.data(), region.size() * 8) && check.TryRead(last) == LayoutReader::Result::Ok &&
+         last.frame == frames && last.writerPid == 1234 && BenchLayoutConsistent(last);
+    // Zero torn reads proves nothing unless consistent copies were taken during the writes
+    ok = ok && reads.load() > 0 && midReads.load() > 0 && torn.load() == 0 && invalid.load() == 0;
+
+    report.Add("Readers", static_cast<double>(readerCount));
+    report.Add("Frames", static_cast<double>(frames));
+    report.Add("RegionBytes", static_cast<double>(region.size() * 8));
+    report.Add("NsPerPublish", static_cast<double>(writeNs) / static_cast<double>(frames));
+    report.Add("MaxPublishUs", static_cast<double>(maxPublishNs) / 1e3);
+    report.Add("Reads", static_cast<double>(reads.load()));
+    report.Add("ReadsDuringWrites", static_cast<double>(midReads.load()));
+    report.Add("BusyReads", static_cast<double>(busy.load()));
+    report.Add("Retries", static_cast<double>(retries.load()));
+    report.Add("TornReads", static_cast<double>(torn.load()));
+    report.Add("InvalidReads", static_cast<double>(invalid.load()));
+    return ok;
+}
+
+// ---- snapshot: settings published by pointer swap, read from many threads ----
+
+static void BenchSnapshotFill(BorderSettings& s, uint64_t version)
+{
+    // Every field derives from the version, so a reader can tell a mixed snapshot from a
+    // clean one; the token lives on the heap, so reading a freed snapshot shows too
+    const float f = static_cast<float>(version % 4096);
+    s.color = { f, f + 1.0f, f + 2.0f, f + 3.0f };
+    s.thickness = f;
+    s.cornerToken = L"v" + std::to_wstring(version);
+    s.foregroundOnly = (version % 2) != 0;
+}
+
+static bool BenchSnapshotConsistent(const BorderSettings& s)
+{
+    if (s.version == 1) return s.cornerToken == L"default"; // the defaults
+    BorderSettings want;
+    BenchSnapshotFill(want, s.version);
+    return s.cornerToken == want.cornerToken && s.thickness == want.thickness && s.color.r == want.color.r &&
+           s.color.g == want.color.g && s.color.b == want.color.b && s.color.a == want.color.a &&
+           s.foregroundOnly == want.foregroundOnly;
+}
+
+static bool BenchSnapshot(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t readerCount = static_cast<size_t>(BenchArg(args, "readers", 4));
+    const size_t writerCount = static_cast<size_t>(std::max<int64_t>(1, BenchArg(args, "writers", 2)));
+    const uint64_t updates = static_cast<uint64_t>(BenchArg(args, "updates", 100000));
+
+    SettingsStore store;
+    auto publish = [&store] {
+        return store.Update([](BorderSettings& s) { BenchSnapshotFill(s, s.version + 1); });
+    };
+
+    // Uncontended cost of one read, and of one copy-edit-publish
+    const uint64_t quietReads = 1000000;
+    uint64_t sink = 0;
+    uint64_t t0 = BenchNowNs();
+    for (uint64_t i = 0; i < quietReads; ++i) sink += store.Read()->version;
+    const uint64_t readNs = BenchNowNs() - t0;
+    bool ok = sink == quietReads;
+
+    // A pass tagged with a snapshot learns that a newer one exists
+    {
+        const auto pass = store.Read();
+        ok = ok && !pass.Superseded();
+        publish();
+        ok = ok && pass.Superseded() && !store.Read().Superseded() && pass->version + 1 == store.Version();
+        // Still pinned by pass: the retired snapshot must survive a reclaim
+        ok = ok && store.Reclaim() == 1 && BenchSnapshotConsistent(*pass);
+    }
+    ok = ok && store.Reclaim() == 0 && store.LiveSnapshots() == 1;
+
+    std::atomic<bool> done{ false };
+    std::atomic<uint64_t> reads{ 0 }, torn{ 0 }, backwards{ 0 };
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < readerCount; ++r) {
+        readers.emplace_back([&] {
+            uint64_t myReads = 0, myTorn = 0, myBackwards = 0, last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const auto settings = store.Read();
+                ++myReads;
+                if (!BenchSnapshotConsistent(*settings)) ++myTorn;
+                if (settings->version < last) ++myBackwards;
+                last = settings->version;
+                // Now and then hold the snapshot across several publishes, like a long pass
+                if (myReads % 64 == 0) {
+                    std::this_thread::yield();
+                    if (!BenchSnapshotConsistent(*settings)) ++myTorn;
+                }
+            }
+            reads += myReads; torn += myTorn; backwards += myBackwards;
+        });
+    }
+
+    const uint64_t perWriter = updates / writerCount;
+    std::atomic<uint64_t> maxUpdateNs{ 0 };
+    t0 = BenchNowNs();
+    std::vector<std::thread> writers;
+    for (size_t w = 0; w < writerCount; ++w) {
+        writers.emplace_back([&] {
+            uint64_t myMax = 0;
+            for (uint64_t i = 1; i <= perWriter; ++i) {
+                const uint64_t u0 = BenchNowNs();
+                publish();
+                myMax = std::max(myMax, BenchNowNs() - u0);
+                if (i % 256 == 0) std::this_thread::yield(); // let readers in on a single core
+            }
+            uint64_t cur = maxUpdateNs.load();
+            while (myMax > cur && !maxUpdateNs.compare_exchange_weak(cur, myMax)) {}
+        });
+    }
+    for (auto& t : writers) t.join();
+    const uint64_t writeNs = BenchNowNs() - t0;
+    done.store(true, std::memory_order_release);
+    for (auto& t : readers) t.join();
+
+    // Every update published exactly once; nothing leaked once the readers are gone
+    const uint64_t published = perWriter * writerCount;
+    const size_t retiredAfterStress = store.Reclaim();
+    ok = ok && store.Version() == 2 + published && BenchSnapshotConsistent(*store.Read());
+    ok = ok && retiredAfterStress == 0 && store.LiveSnapshots() == 1;
+    ok = ok && torn.load() == 0 && backwards.load() == 0;
+
+    report.Add("Readers", static_cast<double>(readerCount));
+    report.Add("Writers", static_cast<double>(writerCount));
+    report.Add("Updates", static_cast<double>(published));
+    report.Add("NsPerQuietRead", static_cast<double>(readNs) / static_cast<double>(quietReads));
+    report.Add("NsPerUpdate", static_cast<double>(writeNs) / static_cast<double>(published ? published : 1));
+    report.Add("MaxUpdateUs", static_cast<double>(maxUpdateNs.load()) / 1e3);
+    report.Add("Reads", static_cast<double>(reads.load()));
+    report.Add("TornReads", static_cast<double>(torn.load()));
+    report.Add("BackwardReads", static_cast<double>(backwards.load()));
+    report.Add("LiveSnapshots", static_cast<double>(store.LiveSnapshots()));
+    return ok;
+}
+
+// ---- faststart: the settings snapshot a --faststart launch paints its first frame from ----
+
+static bool BenchStartupSnapshotEqual(const StartupSnapshot& a, const StartupSnapshot& b)
+{
+    return a.mode == b.mode && a.color == b.color && a.thickness == b.thickness && a.corner == b.corner &&
+           a.foregroundOnly == b.foregroundOnly && a.effect == b.effect && a.powerPolicy == b.powerPolicy &&
+           a.exclusions == b.exclusions && a.rules == b.rules;
+}
+
+// Every mode SaveStartupSnapshot writes must load as written; anything else loads the default
+static bool BenchFastStart(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t rounds = static_cast<size_t>(BenchArg(args, "rounds", 10000));
+    size_t mismatches = 0;
+    for (const wchar_t* mode : { L"auto", L"dwm", L"dcomp", L"hybrid" }) {
+        StartupSnapshot saved;
+        saved.mode = mode;
+        saved.color = L"#80112233";
+        saved.thickness = 3.5f;
+        saved.corner = L"round";
+        saved.foregroundOnly = true;
+        saved.effect = L"pulse:800";
+        saved.powerPolicy = false;
+        saved.exclusions = L"game|obs64";
+        saved.rules = L"process=code.exe; color=#FF0000FF|class=Notepad; thickness=2";
+        StartupSnapshot loaded;
+        if (!ParseStartupSnapshot(SerializeStartupSnapshot(saved), loaded) || !BenchStartupSnapshotEqual(saved, loaded))
+            ++mismatches;
+    }
+
+    StartupSnapshot unknown, loaded;
+    unknown.mode = L"gdi";
+    bool ok = ParseStartupSnapshot(SerializeStartupSnapshot(unknown), loaded) && loaded.mode == L"auto";
+    ok = ok && !ParseStartupSnapshot(L"mode=dwm\n", loaded);
+
+    StartupSnapshot saved;
+    saved.mode = L"hybrid";
+    const std::wstring text = SerializeStartupSnapshot(saved);
+    const uint64_t t0 = BenchNowNs();
+    for (size_t i = 0; i < rounds; ++i) ok = ok && ParseStartupSnapshot(text, loaded) && loaded.mode == saved.mode;
+    const uint64_t parseNs = BenchNowNs() - t0;
+
+    report.Add("Mismatches", static_cast<double>(mismatches));
+    report.Add("ParseUs", rounds ? static_cast<double>(parseNs) / 1e3 / rounds : 0.0);
+    return ok && mismatches == 0;
+}
+
+// ---- atlas: nine-patch border tiles versus per-window rasterization ----
+
+static const BorderStyle s_atlasStyles[] = {
+    { { 0.0f, 0.8f, 1.0f, 1.0f }, 5.0f, CornerStyle::Default },
+    { { 1.0f, 0.2f, 0.2f, 1.0f }, 2.0f, CornerStyle::DoNot },
+    { { 0.3f, 1.0f, 0.3f, 0.6f }, 3.5f, CornerStyle::Round },
+    { { 1.0f, 1.0f, 0.0f, 1.0f }, 1.0f, CornerStyle::RoundSmall },
+    { { 0.5f, 0.5f, 1.0f, 0.8f }, 12.0f, CornerStyle::Round },
+};
+
+static size_t BenchSurfaceDiff(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+    size_t diff = 0;
+    for (size_t i = 0; i < a.size(); ++i) diff += a[i] != b[i];
+    return diff;
+}
+
+static bool BenchAtlas(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t windowCount = static_cast<size_t>(BenchArg(args, "windows", 40));
+    const size_t frames = static_cast<size_t>(BenchArg(args, "frames", 200));
+    const int32_t width = 1920, height = 1080;
+    std::mt19937 rng(37);
+
+    std::vector<uint32_t> direct(static_cast<size_t>(width) * height), composed(direct.size());
+    PixelSurface directSurface{ direct.data(), width, height, width };
+    PixelSurface composedSurface{ composed.data(), width, height, width };
+    auto randomRect = [&](int32_t minSize) {
+        const int32_t w = minSize + static_cast<int32_t>(rng() % 900), h = minSize + static_cast<int32_t>(rng() % 600);
+        // Some windows hang off the screen edges
+        const int32_t x = static_cast<int32_t>(rng() % (width + 100)) - 100, y = static_cast<int32_t>(rng() % (height + 60)) - 60;
+        return WindowRect{ x, y, x + w, y + h };
+    };
+
+    // Composed tiles reproduce the reference rasterizer pixel for pixel, overlaps included
+    BorderAtlas atlas(8);
+    std::vector<NinePatchBlit> blits;
+    size_t exactDiff = 0, smallDiff = 0;
+    for (const BorderStyle& style : s_atlasStyles) {
+        const NinePatchKey key = NinePatchKey::From(style, 96);
+        std::fill(direct.begin(), direct.end(), 0u);
+        std::fill(composed.begin(), composed.end(), 0u);
+        for (int i = 0; i < 12; ++i) {
+            const WindowRect rc = randomRect(120);
+            RasterizeBorder(rc, key.Thickness(), key.Radius(), key.color, directSurface);
+            const NinePatchTile* tile = atlas.Acquire(key);
+            if (!tile) return false;
+            blits.clear();
+            ComposeNinePatch(*tile, rc, blits);
+            BlitNinePatch(*tile, blits, composedSurface);
+        }
+        exactDiff += BenchSurfaceDiff(direct, composed);
+
+        // Windows smaller than two corners are approximate, but drawn and bounded
+        std::fill(direct.begin(), direct.end(), 0u);
+        std::fill(composed.begin(), composed.end(), 0u);
+        const WindowRect tiny{ 300, 300, 310, 306 };
+        const NinePatchTile* tile = atlas.Acquire(key);
+        RasterizeBorder(tiny, key.Thickness(), key.Radius(), key.color, directSurface);
+        blits.clear();
+        ComposeNinePatch(*tile, tiny, blits);
+        BlitNinePatch(*tile, blits, composedSurface);
+        smallDiff += BenchSurfaceDiff(direct, composed);
+        for (int32_t y = 0; y < height; ++y) {
+            for (int32_t x = 0; x < width; ++x) {
+                const bool inside = x >= tiny.left - tile->outset && x < tiny.right + tile->outset &&
+                                    y >= tiny.top - tile->outset && y < tiny.bottom + tile->outset;
+                if (!inside && composed[static_cast<size_t>(y) * width + x]) return false;
+            }
+        }
+    }
+    bool ok = exactDiff == 0 && atlas.Misses() == std::size(s_atlasStyles) && atlas.Evictions() == 0;
+
+    // LRU: capacity 2, touch A, B, A, C -> B is evicted, A survives
+    {
+        BorderAtlas lru(2);
+        const NinePatchKey a = NinePatchKey::From(s_atlasStyles[0], 96);
+        const NinePatchKey b = NinePatchKey::From(s_atlasStyles[1], 96);
+        const NinePatchKey c = NinePatchKey::From(s_atlasStyles[0], 144); // same style, other DPI
+        const uint64_t idA = lru.Acquire(a)->id;
+        const uint64_t idB = lru.Acquire(b)->id;
+        lru.Acquire(a);
+        lru.Acquire(c);
+        ok = ok && lru.Size() == 2 && lru.Evictions() == 1 && lru.Contains(idA) && !lru.Contains(idB);
+        ok = ok && lru.Acquire(a)->id == idA && lru.Hits() == 2 && lru.Acquire(b)->id != idB && lru.Misses() == 4;
+        BorderStyle huge = s_atlasStyles[0];
+        huge.thickness = 400.0f;
+        ok = ok && lru.Acquire(NinePatchKey::From(huge, 96)) == nullptr && lru.Size() == 2;
+    }
+
+    // Frame cost: every window's border redrawn, as a refresh does
+    struct Placed { WindowRect rect; NinePatchKey key; };
+    std::vector<Placed> scene;
+    for (size_t i = 0; i < windowCount; ++i) {
+        scene.push_back({ randomRect(160), NinePatchKey::From(s_atlasStyles[i % 3 == 0 ? 2 : 0], 96) });
+    }
+    auto moveSome = [&](size_t frame) {
+        for (size_t i = frame % 4; i < scene.size(); i += 4) {
+            scene[i].rect.left += 3; scene[i].rect.right += 3;
+            scene[i].rect.top += 1; scene[i].rect.bottom += 1;
+        }
+    };
+
+    BorderAtlas frameAtlas;
+    uint64_t geometryNs = 0, atlasNs = 0;
+    for (size_t f = 0; f < frames; ++f) {
+        moveSome(f);
+        std::fill(direct.begin(), direct.end(), 0u);
+        uint64_t t0 = BenchNowNs();
+        for (const Placed& p : scene) RasterizeBorder(p.rect, p.key.Thickness(), p.key.Radius(), p.key.color, directSurface);
+        geometryNs += BenchNowNs() - t0;
+
+        std::fill(composed.begin(), composed.end(), 0u);
+        t0 = BenchNowNs();
+        for (const Placed& p : scene) {
+            const NinePatchTile* tile = frameAtlas.Acquire(p.key);
+            blits.clear();
+            ComposeNinePatch(*tile, p.rect, blits);
+            BlitNinePatch(*tile, blits, composedSurface);
+        }
+        atlasNs += BenchNowNs() - t0;
+        if (f == frames - 1) ok = ok && BenchSurfaceDiff(direct, composed) == 0;
+    }
+    ok = ok && frameAtlas.Misses() == 2;
+
+    const double perGeometry = static_cast<double>(geometryNs) / static_cast<double>(frames ? frames : 1);
+    const double perAtlas = static_cast<double>(atlasNs) / static_cast<double>(frames ? frames : 1);
+    report.Add("Windows", static_cast<double>(windowCount));
+    report.Add("Frames", static_cast<double>(frames));
+    report.Add("ExactDiffPixels", static_cast<double>(exactDiff));
+    report.Add("SmallWindowDiffPixels", static_cast<double>(smallDiff));
+    report.Add("NsPerFrameGeometry", perGeometry);
+    report.Add("NsPerFrameAtlas", perAtlas);
+    report.Add("Speedup", perAtlas > 0 ? perGeometry / perAtlas : 0.0);
+    report.Add("AtlasHits", static_cast<double>(frameAtlas.Hits()));
+    report.Add("AtlasMisses", static_cast<double>(frameAtlas.Misses()));
+    report.Add("AtlasBytes", static_cast<double>(frameAtlas.Bytes()));
+    return ok;
+}
+
+// ---- geometry: batch rect kernels, every SIMD path against the scalar one ----
+
+struct BenchGeometryOut {
+    RectColumns clipped, outer, translated, bands[kBandCount];
+    RectColumnsF floats;
+    std::vector<uint8_t> visible;
+    std::vector<int32_t> extent;
+};
+
+static void BenchGeometryRun(const RectColumns& in, const std::vector<float>& thickness, const WindowRect& screen,
+                             BenchGeometryOut& out)
+{
+    const size_t n = in.Size();
+    out.visible.resize(n);
+    out.extent.resize(n);
+    ClipRects(in, screen, out.clipped, out.visible.data());
+    StrokeExtents(thickness.data(), n, out.extent.data());
+    ExpandRects(in, out.extent.data(), out.outer);
+    BorderBands(in, out.extent.data(), out.bands);
+    TranslateRects(in, -screen.left, -screen.top, out.translated);
+    RectsToFloat(out.translated, out.floats);
+}
+
+template <typename T>
+static bool BenchSameBits(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+static bool BenchSameColumns(const RectColumns& a, const RectColumns& b)
+{
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool BenchGeometrySame(const BenchGeometryOut& a, const BenchGeometryOut& b)
+{
+    bool same = BenchSameColumns(a.clipped, b.clipped) && BenchSameColumns(a.outer, b.outer) &&
+                BenchSameColumns(a.translated, b.translated) && a.visible == b.visible && a.extent == b.extent &&
+                BenchSameBits(a.floats.left, b.floats.left) && BenchSameBits(a.floats.top, b.floats.top) &&
+                BenchSameBits(a.floats.right, b.floats.right) && BenchSameBits(a.floats.bottom, b.floats.bottom);
+    for (size_t k = 0; k < kBandCount; ++k) same = same && BenchSameColumns(a.bands[k], b.bands[k]);
+    return same;
+}
+
+static bool BenchGeometry(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t count = static_cast<size_t>(BenchArg(args, "rects", 4096));
+    const uint64_t iterations = static_cast<uint64_t>(BenchArg(args, "iterations", 2000));
+    const WindowRect screen{ -1920, -40, 3840, 2160 };
+    std::mt19937 rng(40);
+
+    RectColumns rects;
+    std::vector<float> thickness;
+    for (size_t i = 0; i < count; ++i) {
+        // Mostly on screen, some off it, some empty or inverted
+        const int32_t l = static_cast<int32_t>(rng() % 12000) - 6000;
+        const int32_t t = static_cast<int32_t>(rng() % 6000) - 3000;
+        const int32_t w = static_cast<int32_t>(rng() % 2400) - (i % 17 == 0 ? 1200 : 0);
+        const int32_t h = static_cast<int32_t>(rng() % 1600) - (i % 19 == 0 ? 800 : 0);
+        rects.Push({ l, t, l + w, t + h });
+        static const float edge[] = { 0.0f, 0.001f, 0.5f, 1.0f, 1.001f, 2.0f, 4.9999f, 5.0f, 16.25f, 1000.0f };
+        thickness.push_back((i % 3 == 0) ? edge[rng() % 10] : static_cast<float>(rng() % 4000) / 100.0f);
+    }
+
+    const RectIsa best = DetectRectIsa();
+    bool ok = true;
+
+    // Reference results on every batch length around the vector widths (tails), then the full batch
+    std::vector<BenchGeometryOut> reference;
+    SetRectIsa(RectIsa::Scalar);
+    for (size_t n = 0; n <= 19 && n <= count; ++n) {
+        RectColumns part;
+        for (size_t i = 0; i < n; ++i) part.Push(rects.Get(count - n + i));
+        std::vector<float> partT(thickness.end() - static_cast<ptrdiff_t>(n), thickness.end());
+        reference.emplace_back();
+        BenchGeometryRun(part, partT, screen, reference.back());
+    }
+    BenchGeometryOut full;
+    BenchGeometryRun(rects, thickness, screen, full);
+
+    // Spot-check the scalar reference against the formulas of the code it replaces
+    for (size_t i = 0; i < count; ++i) {
+        const WindowRect r = rects.Get(i);
+        int32_t t = static_cast<int32_t>(thickness[i] + 0.999f);
+        if (t < 1) t = 1;
+        const WindowRect c = full.clipped.Get(i);
+        const bool visible = std::max(r.left, screen.left) < std::min(r.right, screen.right) &&
+                             std::max(r.top, screen.top) < std::min(r.bottom, screen.bottom);
+        ok = ok && full.extent[i] == t && (full.visible[i] != 0) == visible &&
+             c.left == std::max(r.left, screen.left) && c.bottom == std::min(r.bottom, screen.bottom) &&
+             full.outer.Get(i) == WindowRect{ r.left - t, r.top - t, r.right + t, r.bottom + t } &&
+             full.bands[kBandTop].Get(i) == WindowRect{ r.left - t, r.top - t, r.right + t, r.top } &&
+             full.bands[kBandRight].Get(i) == WindowRect{ r.right, r.top, r.right + t, r.bottom } &&
+             full.floats.left[i] == static_cast<float>(r.left - screen.left);
+    }
+
+    std::string mismatches;
+    for (uint32_t isa = 0; isa <= static_cast<uint32_t>(best); ++isa) {
+        const RectIsa path = SetRectIsa(static_cast<RectIsa>(isa));
+        BenchGeometryOut out;
+        for (size_t n = 0; n < reference.size(); ++n) {
+            RectColumns part;
+            for (size_t i = 0; i < n; ++i) part.Push(rects.Get(count - n + i));
+            std::vector<float> partT(thickness.end() - static_cast<ptrdiff_t>(n), thickness.end());
+            BenchGeometryRun(part, partT, screen, out);
+            if (!BenchGeometrySame(out, reference[n])) mismatches += std::string(RectIsaName(path)) + "@" + std::to_string(n) + " ";
+        }
+        BenchGeometryRun(rects, thickness, screen, out);
+        if (!BenchGeometrySame(out, full)) mismatches += std::string(RectIsaName(path)) + "@full ";
+
+        // Per-kernel throughput
+        const double perRect = static_cast<double>(iterations) * static_cast<double>(count);
+        auto time = [&](auto&& kernel) {
+            const uint64_t t0 = BenchNowNs();
+            for (uint64_t it = 0; it < iterations; ++it) kernel();
+            return static_cast<double>(BenchNowNs() - t0) / perRect;
+        };
+        const std::string prefix = std::string(RectIsaName(path)) + ".";
+        report.Add(prefix + "ClipNsPerRect", time([&] { ClipRects(rects, screen, out.clipped, out.visible.data()); }));
+        report.Add(prefix + "StrokeNsPerRect", time([&] { StrokeExtents(thickness.data(), count, out.extent.data()); }));
+        report.Add(prefix + "ExpandNsPerRect", time([&] { ExpandRects(rects, out.extent.data(), out.outer); }));
+        report.Add(prefix + "BandsNsPerRect", time([&] { BorderBands(rects, out.extent.data(), out.bands); }));
+        report.Add(prefix + "TranslateNsPerRect", time([&] { TranslateRects(rects, -screen.left, -screen.top, out.translated); }));
+        report.Add(prefix + "ToFloatNsPerRect", time([&] { RectsToFloat(out.translated, out.floats); }));
+    }
+    SetRectIsa(best);
+    ok = ok && mismatches.empty();
+
+    report.Add("Rects", static_cast<double>(count));
+    report.Add("Iterations", static_cast<double>(iterations));
+    report.AddText("DetectedIsa", RectIsaName(best));
+    report.AddText("Mismatches", mismatches);
+    return ok;
+}
+
+// ---- ledger: warm restart from the persisted applied-state ledger ----
+
+struct BenchDesktopWindow {
+    uint64_t hwnd;
+    uint64_t identity; // 0 = destroyed
+    AppliedBorder want;
+};
+
+// One DWM pass as ApplyDwmAttributesToTargets does it: write what differs, restore what
+// is no longer targeted. Returns DwmSetWindowAttribute calls (color + thickness = 2).
+static uint64_t BenchLedgerPass(WindowRegistry& reg, const std::vector<BenchDesktopWindow>& desktop,
+                                const std::vector<bool>& targeted, uint64_t& skipped, uint64_t& restored)
+{
+    uint64_t calls = 0;
+    reg.BeginPass();
+    for (size_t i = 0; i < desktop.size(); ++i) {
+        const BenchDesktopWindow& w = desktop[i];
+        if (!w.identity || !targeted[i]) continue;
+        const WindowRegistry::Slot s = reg.Acquire(w.hwnd);
+        reg.Visit(s);
+        uint32_t& flags = reg.Flags(s);
+        const bool adopted = (flags & WindowRegistry::kAdopted) != 0;
+        flags &= ~WindowRegistry::kAdopted;
+        AppliedBorder& applied = reg.Applied(s);
+        if ((flags & WindowRegistry::kApplied) && applied.color == w.want.color &&
+            applied.thickness == w.want.thickness && applied.corner == w.want.corner) {
+            if (adopted) ++skipped;
+            continue;
+        }
+        calls += 2 + (!(flags & WindowRegistry::kApplied) || applied.corner != w.want.corner);
+        applied = w.want;
+        flags |= WindowRegistry::kApplied;
+        if (!reg.Identity(s)) reg.Identity(s) = w.identity;
+    }
+    reg.SweepUnvisited([&](WindowRegistry::Slot s) {
+        if (!(reg.Flags(s) & WindowRegistry::kApplied)) return;
+        calls += 2;
+        if (reg.Flags(s) & WindowRegistry::kAdopted) ++restored;
+    });
+    return calls;
+}
+
+static bool BenchLedger(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t windowCount = static_cast<size_t>(BenchArg(args, "windows", 500));
+    const uint32_t capacity = static_cast<uint32_t>(BenchArg(args, "capacity", 1024));
+    const uint64_t writes = static_cast<uint64_t>(BenchArg(args, "writes", 20000));
+    std::mt19937 rng(39);
+    bool ok = true;
+
+    std::vector<BenchDesktopWindow> desktop;
+    for (size_t i = 0; i < windowCount; ++i) {
+        const uint32_t c = static_cast<uint32_t>(i % 5);
+        desktop.push_back({ 0x10000 + i * 8, 0xABC00000ull + i, { 0x00FF8000u + c, 1 + static_cast<int32_t>(c), static_cast<CornerStyle>(c % 4) } });
+    }
+    std::vector<bool> all(windowCount, true);
+
+    // First instance borders everything and persists the ledger to a real file
+    WindowRegistry first;
+    uint64_t skipped = 0, restored = 0;
+    const uint64_t coldCalls = BenchLedgerPass(first, desktop, all, skipped, restored);
+    std::vector<uint64_t> image(LedgerBytes(capacity) / 8, 0);
+    LedgerWriter writer;
+    ok = ok && writer.Attach(image.data(), image.size() * 8, 4321);
+    std::vector<LedgerEntry> entries;
+    CollectLedger(first, entries);
+    ok = ok && writer.Write(entries) == std::min<size_t>(windowCount, capacity);
+
+    const std::string path = "border_ledger_bench.bin";
+    std::vector<uint64_t> loaded(image.size(), 0);
+    if (FILE* f = std::fopen(path.c_str(), "wb")) {
+        ok = ok && std::fwrite(image.data(), 8, image.size(), f) == image.size();
+        std::fclose(f);
+    } else {
+        ok = false;
+    }
+    if (FILE* f = std::fopen(path.c_str(), "rb")) {
+        ok = ok && std::fread(loaded.data(), 8, loaded.size(), f) == loaded.size();
+        std::fclose(f);
+    } else {
+        ok = false;
+    }
+    std::remove(path.c_str());
+
+    // Meanwhile: 10% of the windows closed, 5% of the handles reused by new windows,
+    // 10% of the survivors no longer targeted, 5% restyled
+    size_t closed = 0, reused = 0, dropped = 0, restyled = 0;
+    std::vector<bool> targeted(windowCount, true);
+    for (size_t i = 0; i < windowCount; ++i) {
+        const uint32_t roll = rng() % 100;
+        if (roll < 10) { desktop[i].identity = 0; ++closed; }
+        else if (roll < 15) { desktop[i].identity ^= 0x5555; ++reused; }
+        else if (roll < 25) { targeted[i] = false; ++dropped; }
+        else if (roll < 30) { desktop[i].want.color ^= 0x000080u; ++restyled; }
+    }
+
+    // Second instance, cold (empty registry) versus warm (adopted ledger)
+    std::unordered_map<uint64_t, uint64_t> identities;
+    for (const auto& w : desktop) identities[w.hwnd] = w.identity;
+    auto identityOf = [&](uint64_t hwnd) -> uint64_t {
+        auto it = identities.find(hwnd);
+        return it == identities.end() ? 0 : it->second;
+    };
+    std::vector<LedgerEntry> read;
+    uint32_t pid = 0;
+    ok = ok && ReadLedger(loaded.data(), loaded.size() * 8, read, &pid) == LedgerResult::Ok && pid == 4321 &&
+         read.size() == entries.size();
+    for (size_t i = 0; ok && i < read.size(); ++i) {
+        ok = read[i].hwnd == entries[i].hwnd && read[i].identity == entries[i].identity &&
+             read[i].border.color == entries[i].border.color && read[i].border.thickness == entries[i].border.thickness &&
+             read[i].border.corner == entries[i].border.corner;
+    }
+
+    WindowRegistry cold;
+    uint64_t coldSkipped = 0, coldRestored = 0;
+    const uint64_t restartColdCalls = BenchLedgerPass(cold, desktop, targeted, coldSkipped, coldRestored);
+
+    WindowRegistry warm;
+    const uint64_t a0 = BenchNowNs();
+    const LedgerAdoption adoption = AdoptLedger(read, warm, identityOf);
+    const uint64_t adoptNs = BenchNowNs() - a0;
+    uint64_t warmSkipped = 0, warmRestored = 0;
+    const uint64_t restartWarmCalls = BenchLedgerPass(warm, desktop, targeted, warmSkipped, warmRestored);
+
+    const size_t recorded = std::min<size_t>(windowCount, capacity);
+    const bool complete = recorded == windowCount;
+    // Every recorded live window with its identity is adopted; closed and reused handles are stale
+    ok = ok && adoption.adopted + adoption.stale == read.size();
+    if (complete) {
+        ok = ok && adoption.stale == closed + reused && warmRestored == dropped &&
+             warmSkipped == windowCount - closed - reused - dropped - restyled && coldRestored == 0 &&
+             restartWarmCalls < restartColdCalls;
+    }
+
+    // Validation: zeroed, torn, corrupted, foreign and truncated images
+    {
+        std::vector<LedgerEntry> out;
+        std::vector<uint64_t> zero(image.size(), 0);
+        ok = ok && ReadLedger(zero.data(), zero.size() * 8, out) == LedgerResult::Empty;
+        ok = ok && ReadLedger(image.data(), 63, out) == LedgerResult::Invalid;
+        ok = ok && ReadLedger(image.data(), LedgerBytes(capacity) - 8, out) == LedgerResult::Invalid;
+
+        std::vector<uint64_t> bad = image;
+        bad[3] |= 1; // crashed mid-write
+        ok = ok && ReadLedger(bad.data(), bad.size() * 8, out) == LedgerResult::Torn && out.empty();
+        bad = image;
+        bad[8 + 2] ^= 1; // one record bit flipped
+        ok = ok && ReadLedger(bad.data(), bad.size() * 8, out) == LedgerResult::Torn;
+        bad = image;
+        bad[0] = (static_cast<uint64_t>(kLedgerVersion + 1) << 32) | kLedgerMagic;
+        ok = ok && ReadLedger(bad.data(), bad.size() * 8, out) == LedgerResult::Invalid;
+        bad = image;
+        bad[4] = capacity + 1ull; // count beyond capacity
+        ok = ok && ReadLedger(bad.data(), bad.size() * 8, out) == LedgerResult::Invalid;
+
+        // Garbage is formatted on Attach; a valid ledger is kept
+        std::vector<uint64_t> junk(image.size(), 0xDEADBEEFDEADBEEFull);
+        LedgerWriter w;
+        ok = ok && w.Attach(junk.data(), junk.size() * 8, 7) &&
+             ReadLedger(junk.data(), junk.size() * 8, out) == LedgerResult::Ok && out.empty();
+        std::vector<uint64_t> keep = image;
+        ok = ok && w.Attach(keep.data(), keep.size() * 8, 7) &&
+             ReadLedger(keep.data(), keep.size() * 8, out) == LedgerResult::Ok && out.size() == read.size();
+
+        std::vector<uint64_t> small(LedgerBytes(3) / 8, 0);
+        ok = ok && w.Attach(small.data(), small.size() * 8, 7) && w.Write(entries) == std::min<size_t>(3, entries.size()) &&
+             ReadLedger(small.data(), small.size() * 8, out) == LedgerResult::Ok && out.size() == std::min<size_t>(3, entries.size()) &&
+             (entries.size() <= 3 || ((small[4] >> 32) & kLedgerTruncated));
+    }
+
+    // Save cost: the service rewrites the ledger after every pass that changed something
+    CollectLedger(warm, entries);
+    const uint64_t w0 = BenchNowNs();
+    for (uint64_t i = 0; i < writes; ++i) writer.Write(entries);
+    const uint64_t writeNs = BenchNowNs() - w0;
+    ok = ok && ReadLedger(image.data(), image.size() * 8, read) == LedgerResult::Ok && read.size() == std::min<size_t>(entries.size(), capacity);
+
+    report.Add("Windows", static_cast<double>(windowCount));
+    report.Add("FileBytes", static_cast<double>(image.size() * 8));
+    report.Add("Closed", static_cast<double>(closed));
+    report.Add("Reused", static_cast<double>(reused));
+    report.Add("Dropped", static_cast<double>(dropped));
+    report.Add("Restyled", static_cast<double>(restyled));
+    report.Add("Adopted", static_cast<double>(adoption.adopted));
+    report.Add("Stale", static_cast<double>(adoption.stale));
+    report.Add("Skipped", static_cast<double>(warmSkipped));
+    report.Add("Restored", static_cast<double>(warmRestored));
+    report.Add("FirstStartDwmCalls", static_cast<double>(coldCalls));
+    report.Add("ColdRestartDwmCalls", static_cast<double>(restartColdCalls));
+    report.Add("WarmRestartDwmCalls", static_cast<double>(restartWarmCalls));
+    report.Add("AdoptUs", static_cast<double>(adoptNs) / 1e3);
+    report.Add("NsPerWrite", writes ? static_cast<double>(writeNs) / static_cast<double>(writes) : 0.0);
+    return ok;
+}
+
+// ---- latency: event-to-present accounting with a fake clock and compositor ----
+
+// Microsecond clock; the tick count starts just below its 32-bit wrap
+class BenchLatencyClock : public LatencyClock {
+public:
+    uint64_t nowUs = 1000000;
+    uint32_t tickBase = 0xFFFFFFFFu - 3000;
+    uint64_t NowUs() override { return nowUs; }
+    uint32_t TickMs() override { return Tick(nowUs); }
+    uint32_t Tick(uint64_t us) const { return tickBase + static_cast<uint32_t>(us / 1000); }
+};
+
+// Vblanks every periodUs from 0; reports the last one at or before the clock
+class BenchPresentSource : public PresentSource {
+public:
+    explicit BenchPresentSource(const BenchLatencyClock& clock) : m_clock(clock) {}
+    uint64_t periodUs = 16667;
+    uint64_t missed = 0;
+    bool available = true;
+    bool Query(PresentTiming& out) override
+    {
+        if (!available) return false;
+        out.vblankUs = m_clock.nowUs / periodUs * periodUs;
+        out.periodUs = periodUs;
+        out.missedFrames = missed;
+        return true;
+    }
+    uint64_t NextVblank(uint64_t us) const { return (us + periodUs - 1) / periodUs * periodUs; }
+
+private:
+    const BenchLatencyClock& m_clock;
+};
+
+static uint64_t BenchExactPercentile(std::vector<uint64_t> v, double p)
+{
+    if (v.empty()) return 0;
+    const size_t rank = std::max<size_t>(1, static_cast<size_t>(p / 100.0 * v.size() + 0.999999));
+    std::nth_element(v.begin(), v.begin() + (rank - 1), v.end());
+    return v[rank - 1];
+}
+
+static bool BenchLatency(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t frames = static_cast<size_t>(BenchArg(args, "frames", 20000));
+    std::mt19937 rng(43);
+    BenchLatencyClock clock;
+    BenchPresentSource present(clock);
+    LatencyTracker tracker(clock, present);
+    bool ok = true;
+
+    // Batches of moves (and now and then a focus change) queued for 0-30 ms, drawn in
+    // 0.5-6 ms; the compositor is polled every third frame, like the next batch would
+    std::vector<uint64_t> moved, focus;
+    std::vector<uint64_t> eventUs;
+    uint64_t notes = 0, costNs = 0;
+    for (size_t f = 0; f < frames; ++f) {
+        const uint32_t events = 1 + rng() % 6;
+        const bool withFocus = rng() % 8 == 0;
+        eventUs.clear();
+        for (uint32_t e = 0; e < events; ++e) {
+            eventUs.push_back(clock.nowUs);
+            clock.nowUs += rng() % 5000;
+        }
+        const uint64_t t0 = BenchNowNs();
+        for (uint64_t us : eventUs) tracker.Note(WindowChange::Moved, clock.Tick(us));
+        if (withFocus) tracker.Note(WindowChange::Focus, clock.Tick(eventUs.back()));
+        costNs += BenchNowNs() - t0;
+        notes += events + (withFocus ? 1 : 0);
+        clock.nowUs += 500 + rng() % 5500;
+        tracker.Committed();
+
+        // Exact latencies; the tracker only sees whole-millisecond ticks (within the tolerance)
+        const uint64_t shown = present.NextVblank(clock.nowUs);
+        moved.push_back(shown - eventUs.front());
+        if (withFocus) focus.push_back(shown - eventUs.back());
+
+        clock.nowUs += rng() % 3 == 0 ? present.periodUs * (1 + rng() % 3) : 0;
+        if (f % 3 == 2) {
+            clock.nowUs = present.NextVblank(clock.nowUs);
+            tracker.Poll();
+        }
+    }
+    clock.nowUs = present.NextVblank(clock.nowUs + present.periodUs);
+    tracker.Poll();
+
+    // Pending frames never exceed kMaxPending between polls here, so every frame resolves
+    ok = ok && tracker.Frames() == frames && tracker.Pending() == 0 && tracker.DroppedPending() == 0;
+    ok = ok && tracker.Histogram(WindowChange::Moved).Count() == frames &&
+         tracker.Histogram(WindowChange::Focus).Count() == focus.size();
+    auto close = [](uint64_t measured, uint64_t exact) {
+        const uint64_t tolerance = exact / 8 + 1000;
+        return measured + tolerance >= exact && measured <= exact + tolerance;
+    };
+    for (double p : { 50.0, 95.0, 99.0 }) {
+        ok = ok && close(tracker.Histogram(WindowChange::Moved).Percentile(p), BenchExactPercentile(moved, p)) &&
+             close(tracker.Histogram(WindowChange::Focus).Percentile(p), BenchExactPercentile(focus, p));
+    }
+    const uint64_t movedP50 = tracker.Histogram(WindowChange::Moved).Percentile(50);
+    const uint64_t movedP99 = tracker.Histogram(WindowChange::Moved).Percentile(99);
+
+    // Deterministic cases on a fresh tracker
+    tracker.Reset();
+    const uint64_t base = present.NextVblank(clock.nowUs) + 100;
+    clock.nowUs = base;
+    tracker.Poll();
+    // An event 7 ms old, committed 2 ms later: shown at the next vblank
+    tracker.Note(WindowChange::Shown, clock.Tick(base - 7000));
+    clock.nowUs += 2000;
+    tracker.Committed();
+    const uint64_t expectShown = present.NextVblank(clock.nowUs) - (base - 7000) / 1000 * 1000;
+    ok = ok && tracker.Pending() == 1 && tracker.Poll() == 0; // not presented yet
+    // The compositor misses two frames while it is pending
+    present.missed += 2;
+    clock.nowUs = present.NextVblank(clock.nowUs) + 3 * present.periodUs;
+    ok = ok && tracker.Poll() == 1 && tracker.MissedFrames() == 2;
+    ok = ok && close(tracker.Histogram(WindowChange::Shown).Percentile(50), expectShown);
+    // Misses with nothing pending, or across a long gap between polls, are not ours
+    present.missed += 5;
+    clock.nowUs += present.periodUs;
+    tracker.Poll();
+    tracker.Note(WindowChange::Hidden, clock.TickMs());
+    tracker.Committed();
+    present.missed += 4;
+    clock.nowUs += 20 * present.periodUs;
+    ok = ok && tracker.Poll() == 1 && tracker.MissedFrames() == 2;
+    // Untimed and implausible timestamps; a batch that drew nothing
+    tracker.Note(WindowChange::Moved, 0);
+    tracker.Note(WindowChange::Moved, clock.TickMs() + 5000);
+    tracker.Note(WindowChange::Moved, clock.TickMs() - LatencyTracker::kMaxEventAgeMs - 1);
+    tracker.Note(WindowChange::None, clock.TickMs());
+    tracker.Committed();
+    ok = ok && tracker.Untimed() == 3 && tracker.Pending() == 0;
+    tracker.Note(WindowChange::Destroyed, clock.TickMs());
+    tracker.Discard();
+    tracker.Committed();
+    ok = ok && tracker.Pending() == 0;
+    // Nobody polls: the oldest frames are given up
+    for (size_t i = 0; i < LatencyTracker::kMaxPending + 2; ++i) {
+        tracker.Note(WindowChange::Restacked, clock.TickMs());
+        clock.nowUs += 100;
+        tracker.Committed();
+    }
+    ok = ok && tracker.Pending() == LatencyTracker::kMaxPending && tracker.DroppedPending() == 2;
+    present.available = false;
+    clock.nowUs += present.periodUs;
+    ok = ok && tracker.Poll() == 0;
+    present.available = true;
+    ok = ok && tracker.Poll() == LatencyTracker::kMaxPending;
+    tracker.Publish();
+    ok = ok && MetricGet(Metric::LatencyFrames) == static_cast<int64_t>(tracker.Frames()) &&
+         MetricGet(Metric::LatencyMissedFrames) == 2 && MetricGet(Metric::LatencyShownP50Us) > 0;
+
+    report.Add("Frames", static_cast<double>(frames));
+    report.Add("MovedP50Ms", movedP50 / 1e3);
+    report.Add("MovedP50ExactMs", BenchExactPercentile(moved, 50) / 1e3);
+    report.Add("MovedP99Ms", movedP99 / 1e3);
+    report.Add("MovedP99ExactMs", BenchExactPercentile(moved, 99) / 1e3);
+    report.Add("NsPerNote", static_cast<double>(costNs) / static_cast<double>(notes ? notes : 1));
+    return ok;
+}
+
+// ---- tiers: foreground-first refresh against the flat z-order pass, on a virtual clock ----
+
+// Every round a settings change dirties all windows, and 1 ms later focus moves on (the
+// old and new foreground windows change color). A DWM write costs writeUs; the render
+// thread handles one thing at a time. Window 1 is a popup owned by window 2.
+struct BenchTierSim {
+    size_t windows = 0;
+    uint64_t writeNs = 0;
+    uint64_t now = 0;
+    size_t foreground = 2;
+    uint32_t settings = 1;
+    std::vector<uint32_t> applied;
+    std::vector<uint64_t> sliceStarts;
+    size_t maxSlice = 0;
+
+    uint64_t RootOwner(size_t i) const { return i == 1 ? 2 : i; }
+    bool InForeground(size_t i) const { return RootOwner(i) == foreground; }
+    uint32_t Desired(size_t i) const { return settings * 2 + (InForeground(i) ? 1 : 0); }
+    void Write(size_t i)
+    {
+        applied[i] = Desired(i);
+        now += writeNs;
+    }
+    bool Converged() const
+    {
+        for (size_t i = 0; i < windows; ++i) {
+            if (applied[i] != Desired(i)) return false;
+        }
+        return true;
+    }
+};
+
+struct BenchTierResult {
+    std::vector<uint64_t> foregroundNs; // event -> foreground window written
+    std::vector<uint64_t> drainNs;      // round start -> every window written
+    bool ok = true;
+};
+
+static BenchTierResult BenchRunTiers(size_t windows, size_t rounds, uint64_t writeNs, bool tiered, const TierOptions& options)
+{
+    BenchTierSim sim;
+    sim.windows = windows;
+    sim.writeNs = writeNs;
+    sim.applied.assign(windows, 0);
+    TierScheduler tiers(options);
+    std::vector<TierItem> dirty;
+    std::vector<uint64_t> now, slice;
+    std::mt19937 rng(45);
+    BenchTierResult result;
+
+    // A full pass; returns when the foreground window was written
+    auto pass = [&]() {
+        uint64_t foregroundAt = 0;
+        if (!tiered) {
+            for (size_t i = 0; i < windows; ++i) {
+                if (sim.applied[i] == sim.Desired(i)) continue;
+                sim.Write(i);
+                if (i == sim.foreground) foregroundAt = sim.now;
+            }
+            return foregroundAt;
+        }
+        dirty.clear();
+        now.clear();
+        for (size_t i = 0; i < windows; ++i) {
+            if (sim.applied[i] != sim.Desired(i)) dirty.push_back({ i, sim.InForeground(i) });
+        }
+        tiers.Plan(dirty, sim.now, now);
+        for (uint64_t i : now) {
+            sim.Write(static_cast<size_t>(i));
+            if (i == sim.foreground) foregroundAt = sim.now;
+        }
+        tiers.ForegroundDone(sim.now);
+        return foregroundAt;
+    };
+    // Background slices that become due before `until` (a slice is never interrupted)
+    auto idle = [&](uint64_t until) {
+        while (tiered && tiers.NextDueNs() && tiers.NextDueNs() < until) {
+            sim.now = std::max(sim.now, tiers.NextDueNs());
+            slice.clear();
+            const uint64_t start = sim.now;
+            if (!tiers.NextSlice(sim.now, slice)) break;
+            sim.sliceStarts.push_back(start);
+            sim.maxSlice = std::max(sim.maxSlice, slice.size());
+            for (uint64_t i : slice) {
+                if (sim.applied[i] != sim.Desired(static_cast<size_t>(i))) sim.Write(static_cast<size_t>(i));
+            }
+        }
+        if (until != UINT64_MAX) sim.now = std::max(sim.now, until);
+    };
+
+    for (size_t r = 0; r < rounds; ++r) {
+        const uint64_t t0 = sim.now;
+        ++sim.settings;
+        const uint64_t shown = pass();
+        result.foregroundNs.push_back(shown - t0);
+
+        const uint64_t focusAt = t0 + 1000000;
+        idle(focusAt);
+        size_t next = static_cast<size_t>(rng() % windows);
+        if (next == 1 || next == sim.foreground) next = sim.foreground == 2 ? 7 : 2;
+        sim.foreground = next;
+        const uint64_t start = std::max(sim.now, focusAt);
+        sim.now = start;
+        const uint64_t focused = pass();
+        result.foregroundNs.push_back(focused - focusAt);
+
+        idle(UINT64_MAX);
+        result.drainNs.push_back(sim.now - t0);
+        result.ok = result.ok && sim.Converged() && (!tiered || tiers.Backlog() == 0);
+    }
+    // Slices never exceed the budget nor come closer together than the interval
+    result.ok = result.ok && sim.maxSlice <= options.budget;
+    for (size_t i = 1; i < sim.sliceStarts.size(); ++i) {
+        result.ok = result.ok && sim.sliceStarts[i] - sim.sliceStarts[i - 1] >= options.intervalNs;
+    }
+    result.ok = result.ok && (!tiered || tiers.BackgroundWindows() > 0);
+    return result;
+}
+
+static bool BenchTiers(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t windows = static_cast<size_t>(BenchArg(args, "windows", 60));
+    const size_t rounds = static_cast<size_t>(BenchArg(args, "rounds", 200));
+    const uint64_t writeNs = static_cast<uint64_t>(BenchArg(args, "write_us", 300)) * 1000;
+    TierOptions options;
+    options.budget = static_cast<size_t>(BenchArg(args, "budget", 8));
+    options.intervalNs = static_cast<uint64_t>(BenchArg(args, "interval_ms", 8)) * 1000000;
+    bool ok = windows >= 16 && options.budget > 0;
+
+    const BenchTierResult flat = BenchRunTiers(windows, rounds, writeNs, false, options);
+    const BenchTierResult tiered = BenchRunTiers(windows, rounds, writeNs, true, options);
+    ok = ok && flat.ok && tiered.ok;
+    const uint64_t flatP50 = BenchExactPercentile(flat.foregroundNs, 50), flatP99 = BenchExactPercentile(flat.foregroundNs, 99);
+    const uint64_t tierP50 = BenchExactPercentile(tiered.foregroundNs, 50), tierP99 = BenchExactPercentile(tiered.foregroundNs, 99);
+    // The foreground window (with its popup) never waits for more than a slice of background
+    // windows plus its own group
+    ok = ok && tierP99 < flatP99 && tierP99 <= (options.budget + 3) * writeNs;
+
+    // Scheduler semantics on their own
+    TierScheduler tiers(options);
+    std::vector<uint64_t> fg, slice;
+    ok = ok && tiers.NextDueNs() == 0 && tiers.NextSlice(1000, slice) == 0;
+    std::vector<TierItem> dirty;
+    for (uint64_t i = 0; i < 20; ++i) dirty.push_back({ i + 1, i == 4 || i == 5 });
+    tiers.Plan(dirty, 1000, fg);
+    ok = ok && fg.size() == 2 && fg[0] == 5 && fg[1] == 6 && tiers.Backlog() == 18 && tiers.NextDueNs() == 1000;
+    ok = ok && tiers.NextSlice(1000, slice) == std::min<size_t>(options.budget, 18) && slice[0] == 1;
+    // Rate limited across plans: a new pass replaces the backlog but not the interval
+    slice.clear();
+    ok = ok && tiers.NextSlice(1000 + options.intervalNs - 1, slice) == 0;
+    dirty.resize(3);
+    fg.clear();
+    tiers.Plan(dirty, 2000, fg);
+    ok = ok && fg.empty() && tiers.Backlog() == 3 && tiers.NextDueNs() == 1000 + options.intervalNs;
+    ok = ok && tiers.NextSlice(1000 + options.intervalNs, slice) == 3 && tiers.Backlog() == 0 && tiers.NextDueNs() == 0;
+    ok = ok && tiers.DrainNs() == 1000 + options.intervalNs - 2000;
+
+    // Planning cost for a large desktop
+    dirty.clear();
+    for (uint64_t i = 0; i < 1000; ++i) dirty.push_back({ i + 1, i % 97 == 0 });
+    const uint64_t t0 = BenchNowNs();
+    const size_t plans = 2000;
+    for (size_t i = 0; i < plans; ++i) {
+        fg.clear();
+        tiers.Plan(dirty, i, fg);
+    }
+    const uint64_t planNs = BenchNowNs() - t0;
+
+    report.Add("Windows", static_cast<double>(windows));
+    report.Add("Budget", static_cast<double>(options.budget));
+    report.Add("FlatForegroundP50Ms", flatP50 / 1e6);
+    report.Add("FlatForegroundP99Ms", flatP99 / 1e6);
+    report.Add("TieredForegroundP50Ms", tierP50 / 1e6);
+    report.Add("TieredForegroundP99Ms", tierP99 / 1e6);
+    report.Add("FlatDrainP50Ms", BenchExactPercentile(flat.drainNs, 50) / 1e6);
+    report.Add("TieredDrainP50Ms", BenchExactPercentile(tiered.drainNs, 50) / 1e6);
+    report.Add("NsPerPlan1000", static_cast<double>(planNs) / plans);
+    return ok;
+}
+
+// ---- exit: restoring default borders at shutdown, in parallel under a deadline ----
+
+// hwnd % 7 == 0 is gone; a hung window blocks until released. Every other restore costs
+// about what a cross-process DwmSetWindowAttribute does.
+class BenchRestoreTarget : public RestoreTarget {
+public:
+    explicit BenchRestoreTarget(size_t windows) : calls(new std::atomic<uint32_t>[windows + 1]), m_windows(windows)
+    {
+        for (size_t i = 0; i <= windows; ++i) calls[i].store(0);
+    }
+    std::unique_ptr<std::atomic<uint32_t>[]> calls; // per hwnd
+    std::unordered_map<uint64_t, bool> hung;        // fixed before a run
+    std::atomic<bool> release{ false };
+    std::atomic<int> inFlight{ 0 };
+    std::chrono::microseconds cost{ 200 };
+
+    RestoreOutcome Restore(const LedgerEntry& entry) override
+    {
+        inFlight.fetch_add(1);
+        calls[entry.hwnd].fetch_add(1);
+        RestoreOutcome outcome = RestoreOutcome::Restored;
+        if (entry.hwnd % 7 == 0) {
+            outcome = RestoreOutcome::Skipped;
+        } else if (hung.count(entry.hwnd)) {
+            while (!release.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } else {
+            std::this_thread::sleep_for(cost);
+        }
+        inFlight.fetch_sub(1);
+        return outcome;
+    }
+    size_t Gone() const { return m_windows / 7; }
+
+private:
+    size_t m_windows;
+};
+
+static std::vector<LedgerEntry> BenchRestoreEntries(size_t windows)
+{
+    std::vector<LedgerEntry> entries(windows);
+    for (size_t i = 0; i < windows; ++i) {
+        entries[i].hwnd = i + 1;
+        entries[i].identity = 0x1000 + i;
+        entries[i].border.color = 0x00FF8000;
+        entries[i].border.thickness = 2;
+    }
+    return entries;
+}
+
+static bool BenchExit(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t windows = static_cast<size_t>(BenchArg(args, "windows", 256));
+    const size_t workers = static_cast<size_t>(BenchArg(args, "workers", 4));
+    const uint64_t deadlineMs = static_cast<uint64_t>(BenchArg(args, "deadline", 150));
+    const std::vector<LedgerEntry> entries = BenchRestoreEntries(windows);
+    bool ok = windows >= 32;
+
+    // Baseline: the serial loop, one window after the other
+    BenchRestoreTarget serialTarget(windows);
+    uint64_t t0 = BenchNowNs();
+    size_t serialRestored = 0;
+    for (const LedgerEntry& e : entries) {
+        if (serialTarget.Restore(e) == RestoreOutcome::Restored) ++serialRestored;
+    }
+    const uint64_t serialNs = BenchNowNs() - t0;
+
+    // Parallel, everything finishes: each window exactly once, the gone ones skipped
+    BenchRestoreTarget target(windows);
+    RestoreOptions options;
+    options.workers = workers;
+    options.batch = 8;
+    options.deadlineNs = 60ull * 1000000000ull;
+    const RestoreReport all = RestoreInParallel(entries, target, options);
+    ok = ok && all.restored == serialRestored && all.skipped == target.Gone() && all.timedOut == 0 &&
+         all.abandonedWorkers == 0 && all.unfinished.empty();
+    for (size_t i = 1; i <= windows; ++i) ok = ok && target.calls[i].load() == 1;
+
+    // Hung windows, each the last of its batch: a worker per hung window is abandoned and
+    // the others finish everything else before the deadline
+    BenchRestoreTarget hungTarget(windows);
+    const uint64_t hungIds[] = { 8, 24, 40 };
+    for (uint64_t id : hungIds) hungTarget.hung[id] = true;
+    options.deadlineNs = deadlineMs * 1000000ull;
+    const RestoreReport timed = RestoreInParallel(entries, hungTarget, options);
+    ok = ok && timed.timedOut == 3 && timed.unfinished.size() == 3 && timed.abandonedWorkers == 3 &&
+         timed.restored + timed.skipped + timed.timedOut == windows;
+    for (const LedgerEntry& e : timed.unfinished) ok = ok && hungTarget.hung.count(e.hwnd) == 1;
+    // Returns at the deadline, not when the hung windows come back
+    ok = ok && timed.elapsedNs >= options.deadlineNs && timed.elapsedNs < options.deadlineNs + 250000000ull;
+    const uint64_t timedNs = timed.elapsedNs;
+    hungTarget.release.store(true);
+    while (hungTarget.inFlight.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    for (size_t i = 1; i <= windows; ++i) ok = ok && hungTarget.calls[i].load() == 1;
+
+    // A zero budget restores nothing and starts no worker
+    BenchRestoreTarget keepTarget(windows);
+    options.deadlineNs = 0;
+    const RestoreReport keep = RestoreInParallel(entries, keepTarget, options);
+    ok = ok && keep.restored == 0 && keep.timedOut == windows && keep.unfinished.size() == windows;
+    for (size_t i = 1; i <= windows; ++i) ok = ok && keepTarget.calls[i].load() == 0;
+    ok = ok && RestoreInParallel({}, keepTarget, options).timedOut == 0;
+
+    report.Add("Windows", static_cast<double>(windows));
+    report.Add("Workers", static_cast<double>(workers));
+    report.Add("SerialMs", serialNs / 1e6);
+    report.Add("ParallelMs", all.elapsedNs / 1e6);
+    report.Add("Speedup", static_cast<double>(serialNs) / static_cast<double>(all.elapsedNs ? all.elapsedNs : 1));
+    report.Add("HungDeadlineMs", static_cast<double>(deadlineMs));
+    report.Add("HungElapsedMs", timedNs / 1e6);
+    return ok;
+}
+
+// ---- scenarios: end-to-end runs against the simulated desktop (SimBackend.h) ----
+// Time is simulated at 60 ticks per second; the events of one tick form one batch, which
+// is what the render thread sees whenever event delivery outpaces it.
+
+struct ScenarioContext {
+    SimDesktop& desktop;
+    SimService& service;
+    std::vector<EventRecord>& events; // WinEvents for the current tick
+    std::vector<uint64_t>& windows;   // top-level windows, oldest first
+    std::mt19937& rng;
+    size_t tick = 0;
+    BorderStyle style;                // last style applied through ApplySettings
+    bool moveSize = true;             // drags report MOVESIZESTART / END (movesize=0: bare LOCATIONCHANGEs)
+    bool bursts = true;               // mass transitions are held and drawn once (burst=0: per batch)
+    bool region = true;               // overlay clipped by a window region (region=0: painter-order draw)
+};
+
+struct ScenarioTotals {
+    size_t ticks = 0, redraws = 0, timerRefreshes = 0, maxTracked = 0;
+    uint64_t offered = 0, queued = 0;
+    uint64_t frameAllocations = 0, allocatingFrames = 0; // heap allocations inside RunFrame
+    size_t lastAllocatingTick = SIZE_MAX;                // SIZE_MAX: no frame allocated
+    size_t sessionChecks = 0, sessionMismatches = 0;     // session frames against full rebuilds
+};
+
+struct ScenarioSpec {
+    size_t windows;     // opened before the clock starts
+    int64_t seconds;
+    bool foregroundOnly;
+    void (*step)(ScenarioContext&);                                 // once per tick
+    bool (*check)(const ScenarioContext&, const ScenarioTotals&);   // false = scenario broken
+};
+
+static const wchar_t* const s_simProcesses[] = { L"code", L"chrome", L"explorer", L"notepad", L"devenv", L"winword", L"slack", L"cmd" };
+
+static uint64_t OpenSimWindow(ScenarioContext& ctx, size_t index, const WindowRect& rc)
+{
+    const size_t p = index % (sizeof(s_simProcesses) / sizeof(s_simProcesses[0]));
+    uint64_t h = ctx.desktop.Create(rc, s_simProcesses[p], std::wstring(s_simProcesses[p]) + L"_frame",
+                                    L"document " + std::to_wstring(index), ctx.events);
+    ctx.windows.push_back(h);
+    return h;
+}
+
+static WindowRect RandomSimRect(std::mt19937& rng, const WindowRect& screen)
+{
+    const int32_t w = 400 + static_cast<int32_t>(rng() % 1200), h = 300 + static_cast<int32_t>(rng() % 700);
+    const int32_t x = screen.left + static_cast<int32_t>(rng() % static_cast<uint32_t>(screen.right - screen.left - w));
+    const int32_t y = screen.top + static_cast<int32_t>(rng() % static_cast<uint32_t>(screen.bottom - screen.top - h));
+    return { x, y, x + w, y + h };
+}
+
+static double Percentile(std::vector<uint64_t> v, double p)
+{
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    return static_cast<double>(v[static_cast<size_t>(p * static_cast<double>(v.size() - 1))]);
+}
+
+static bool RunScenario(BenchReport& report, const std::vector<std::string>& args, const ScenarioSpec& spec)
+{
+    const size_t windowCount = static_cast<size_t>(BenchArg(args, "windows", static_cast<int64_t>(spec.windows)));
+    const size_t ticks = static_cast<size_t>(BenchArg(args, "seconds", spec.seconds) * 60);
+    const size_t timerTicks = static_cast<size_t>(BenchArg(args, "timer_ms", 150) * 60 / 1000); // WM_TIMER 1; 0 = off
+    const size_t sampleTicks = 6; // one TimeSeriesData sample per 100 ms
+    const double tickNs = 1e9 / 60.0;
+
+    const WindowRect screen{ 0, 0, 2560, 1440 };
+    SimDesktop desktop(screen);
+    SimService service(desktop, static_cast<size_t>(BenchArg(args, "capacity", 1024)));
+    std::vector<EventRecord> events;
+    std::vector<uint64_t> windows;
+    std::mt19937 rng(33);
+    ScenarioContext ctx{ desktop, service, events, windows, rng, 0, BorderStyle{}, BenchArg(args, "movesize", 1) != 0,
+                         BenchArg(args, "burst", 1) != 0, BenchArg(args, "region", 1) != 0 };
+    service.ApplySettings(ctx.style, spec.foregroundOnly);
+    service.EnableBursts(ctx.bursts);
+    service.SetRegionMode(ctx.region);
+    IdleOptions idle;
+    idle.idleNs = static_cast<uint64_t>(BenchArg(args, "idle_ms", 10000)) * 1000000ull;
+    service.SetIdleOptions(idle);
+
+    // Desktop as it stands when the scenario starts; settling frame is not measured
+    for (size_t i = 0; i < windowCount; ++i) OpenSimWindow(ctx, i, RandomSimRect(rng, screen));
+    for (const auto& e : events) service.Offer(e);
+    service.RunFrame();
+    events.clear();
+    ResetMetrics();
+
+    ScenarioTotals totals;
+    const SimStageNs base = service.Stages();
+    uint64_t primitives = 0;
+    std::vector<uint64_t> frameNs;
+    frameNs.reserve(ticks);
+    std::vector<double> cpu, memory;
+    std::string series = "[";
+    uint64_t bucketBusy = 0, bucketMaxFrame = 0;
+    size_t bucketRedraws = 0, bucketEvents = 0;
+    std::vector<WindowRect> regionBefore;
+
+    for (size_t t = 0; t < ticks; ++t) {
+        ctx.tick = t;
+        service.SetClock(static_cast<uint64_t>(static_cast<double>(t) * tickNs));
+        events.clear();
+        spec.step(ctx);
+        if (timerTicks && t % timerTicks == 0) {
+            EventRecord r;
+            r.event = kEventRefreshRequest;
+            events.push_back(r);
+            ++totals.timerRefreshes;
+        }
+
+        const uint64_t intakeBefore = service.Stages().intake;
+        for (const auto& e : events) {
+            if (service.Offer(e)) ++totals.queued;
+        }
+        totals.offered += events.size();
+        if (ctx.region) regionBefore = service.Region();
+        const uint64_t t0 = BenchNowNs();
+        const bool redrew = service.RunFrame();
+        const uint64_t ns = BenchNowNs() - t0;
+        // Every incremental session frame against a full recompute (outside the timing)
+        if (service.LastFrameWasSession() && ctx.region) {
+            ++totals.sessionChecks;
+            if (!service.VerifySessionFrame(regionBefore)) ++totals.sessionMismatches;
+        }
+        ++totals.ticks;
+        totals.maxTracked = std::max(totals.maxTracked, service.Windows().Size());
+        totals.frameAllocations += service.LastFrameAllocations();
+        if (service.LastFrameAllocations()) {
+            ++totals.allocatingFrames;
+            totals.lastAllocatingTick = t;
+        }
+
+        bucketBusy += ns + service.Stages().intake - intakeBefore;
+        bucketEvents += events.size();
+        if (redrew) {
+            ++totals.redraws;
+            ++bucketRedraws;
+            primitives += service.PrimitiveCount();
+            frameNs.push_back(ns);
+            bucketMaxFrame = std::max(bucketMaxFrame, ns);
+        }
+
+        if ((t + 1) % sampleTicks == 0 || t + 1 == ticks) {
+            const size_t span = (t % sampleTicks) + 1;
+            const double cpuPct = 100.0 * static_cast<double>(bucketBusy) / (tickNs * static_cast<double>(span));
+            const double memMB = static_cast<double>(service.MemoryBytes()) / (1024.0 * 1024.0);
+            cpu.push_back(cpuPct);
+            memory.push_back(memMB);
+            char buf[256];
+            std::snprintf(buf, sizeof(buf),
+                          "%s{\"ElapsedSeconds\":%.3f,\"CpuPercent\":%.4f,\"MemoryMB\":%.4f,\"FrameMs\":%.4f,\"Redraws\":%zu,\"Events\":%zu}",
+                          series.size() > 1 ? "," : "", static_cast<double>(t + 1) / 60.0, cpuPct, memMB,
+                          static_cast<double>(bucketMaxFrame) / 1e6, bucketRedraws, bucketEvents);
+            series += buf;
+            bucketBusy = bucketMaxFrame = 0;
+            bucketRedraws = bucketEvents = 0;
+        }
+    }
+    series += "]";
+
+    const SimStageNs& end = service.Stages();
+    const double redraws = totals.redraws ? static_cast<double>(totals.redraws) : 1.0;
+    auto avg = [](const std::vector<double>& v) {
+        double sum = 0;
+        for (double x : v) sum += x;
+        return v.empty() ? 0.0 : sum / static_cast<double>(v.size());
+    };
+    auto perRedrawUs = [&](uint64_t a, uint64_t b) { return static_cast<double>(a - b) / 1e3 / redraws; };
+    double frameSum = 0;
+    for (uint64_t ns : frameNs) frameSum += static_cast<double>(ns);
+
+    // PerformanceResult fields (CustomWindow.Tests) first, then frame / stage detail
+    report.AddText("Backend", "simulated");
+    report.AddText("Present", ctx.region ? "region" : "painter");
+    report.Add("AverageCpuPercent", avg(cpu));
+    report.Add("MaxCpuPercent", cpu.empty() ? 0.0 : *std::max_element(cpu.begin(), cpu.end()));
+    report.Add("MinCpuPercent", cpu.empty() ? 0.0 : *std::min_element(cpu.begin(), cpu.end()));
+    report.Add("AverageMemoryMB", avg(memory));
+    report.Add("MaxMemoryMB", memory.empty() ? 0.0 : *std::max_element(memory.begin(), memory.end()));
+    report.Add("MinMemoryMB", memory.empty() ? 0.0 : *std::min_element(memory.begin(), memory.end()));
+    report.Add("MeasurementDurationMs", static_cast<double>(ticks) * 1000.0 / 60.0);
+    report.Add("SampleCount", static_cast<double>(cpu.size()));
+    report.Add("Windows", static_cast<double>(windowCount));
+    report.Add("Ticks", static_cast<double>(totals.ticks));
+    report.Add("Redraws", static_cast<double>(totals.redraws));
+    report.Add("TimerRefreshes", static_cast<double>(totals.timerRefreshes));
+    report.Add("EventsOffered", static_cast<double>(totals.offered));
+    report.Add("EventsQueued", static_cast<double>(totals.queued));
+    report.Add("EventsDropped", static_cast<double>(service.Dropped()));
+    report.Add("MaxTracked", static_cast<double>(totals.maxTracked));
+    report.Add("RegionRects", static_cast<double>(service.RegionRects()));
+    report.Add("AverageFrameMs", frameNs.empty() ? 0.0 : frameSum / static_cast<double>(frameNs.size()) / 1e6);
+    report.Add("P95FrameMs", Percentile(frameNs, 0.95) / 1e6);
+    report.Add("P99FrameMs", Percentile(frameNs, 0.99) / 1e6);
+    report.Add("MaxFrameMs", frameNs.empty() ? 0.0 : static_cast<double>(*std::max_element(frameNs.begin(), frameNs.end())) / 1e6);
+    report.Add("IntakeNsPerEvent", totals.offered ? static_cast<double>(end.intake - base.intake) / static_cast<double>(totals.offered) : 0.0);
+    report.Add("ClassifyUsPerTick", static_cast<double>(end.classify - base.classify) / 1e3 / static_cast<double>(ticks ? ticks : 1));
+    report.Add("EnumerateUsPerRedraw", perRedrawUs(end.enumerate, base.enumerate));
+    report.Add("RegistryUsPerRedraw", perRedrawUs(end.registry, base.registry));
+    report.Add("StyleUsPerRedraw", perRedrawUs(end.style, base.style));
+    report.Add("RegionUsPerRedraw", perRedrawUs(end.region, base.region));
+    report.Add("DrawUsPerRedraw", perRedrawUs(end.draw, base.draw));
+    report.Add("PrimitivesPerRedraw", static_cast<double>(primitives) / redraws);
+    report.Add("MoveSizeSessions", static_cast<double>(MetricGet(Metric::MoveSizeSessions)));
+    report.Add("SessionFrames", static_cast<double>(MetricGet(Metric::MoveSizeFrames)));
+    report.Add("LastSessionP99Ms", static_cast<double>(MetricGet(Metric::MoveSizeLastP99Us)) / 1e3);
+    report.Add("SessionFramesChecked", static_cast<double>(totals.sessionChecks));
+    report.Add("SessionFrameMismatches", static_cast<double>(totals.sessionMismatches));
+    report.Add("Bursts", static_cast<double>(MetricGet(Metric::BurstCount)));
+    report.Add("LastBurstEvents", static_cast<double>(MetricGet(Metric::BurstLastEvents)));
+    report.Add("LastBurstWindows", static_cast<double>(MetricGet(Metric::BurstLastWindows)));
+    report.Add("LastBurstSettleMs", static_cast<double>(MetricGet(Metric::BurstSettleUs)) / 1e3);
+    report.Add("IdleReleases", static_cast<double>(MetricGet(Metric::IdleReleases)));
+    report.Add("Rehydrations", static_cast<double>(MetricGet(Metric::IdleRehydrations)));
+    report.Add("LastRehydrateMs", static_cast<double>(MetricGet(Metric::IdleRehydrateUs)) / 1e3);
+    report.Add("ActiveMemoryKB", static_cast<double>(MetricGet(Metric::IdlePrivateKbActive)));
+    report.Add("IdleMemoryKB", static_cast<double>(MetricGet(Metric::IdlePrivateKbIdle)));
+    report.Add("FrameHeapAllocations", static_cast<double>(totals.frameAllocations));
+    report.Add("AllocatingFrames", static_cast<double>(totals.allocatingFrames));
+    report.Add("LastAllocatingTick", totals.lastAllocatingTick == SIZE_MAX ? -1.0 : static_cast<double>(totals.lastAllocatingTick));
+    report.Add("ArenaPeakKB", static_cast<double>(service.Arena().PeakUsed()) / 1024.0);
+    report.Add("ArenaBlockAllocations", static_cast<double>(service.Arena().BlockAllocations()));
+    report.AddJson("TimeSeriesData", series);
+
+    // Region-less runs never build a region
+    if (!ctx.region && service.RegionRects() != 0) return false;
+    if (totals.sessionMismatches) return false;
+    return spec.check ? spec.check(ctx, totals) : true;
+}
+
+// idle: an editor in front, typing and an occasional title "*" toggle; only the refresh
+// timer may cost redraws
+static void StepIdle(ScenarioContext& ctx)
+{
+    const uint64_t front = ctx.desktop.Foreground();
+    if (ctx.tick % 8 == 0) ctx.desktop.Type(front, ctx.events);
+    if (ctx.tick % 120 == 0) {
+        const SimWindow* w = ctx.desktop.Find(front);
+        ctx.desktop.SetTitle(front, w->title.back() == L'*' ? w->title.substr(0, w->title.size() - 1) : w->title + L"*", ctx.events);
+    }
+}
+
+static bool CheckIdle(const ScenarioContext&, const ScenarioTotals& t)
+{
+    return t.redraws <= t.timerRefreshes;
+}
+
+// drag: the front window follows a 120 Hz mouse, two moves per tick; the button is
+// released and pressed again every two seconds
+static void StepDrag(ScenarioContext& ctx)
+{
+    const uint64_t front = ctx.desktop.Foreground();
+    const int32_t dir = (ctx.tick / 120) % 2 ? -1 : 1;
+    if (ctx.moveSize && ctx.tick % 120 == 0) ctx.desktop.BeginMoveSize(front, ctx.events);
+    ctx.desktop.MoveBy(front, 3 * dir, 2 * dir, ctx.events);
+    ctx.desktop.MoveBy(front, 3 * dir, 1 * dir, ctx.events);
+    if (ctx.moveSize && ctx.tick % 120 == 119) ctx.desktop.EndMoveSize(front, ctx.events);
+}
+
+static bool CheckDrag(const ScenarioContext& ctx, const ScenarioTotals& t)
+{
+    // Every session ends in one reconcile; the others were session frames
+    const int64_t sessions = ctx.moveSize ? static_cast<int64_t>(t.ticks / 120) : 0;
+    // and, with a region, was checked against a full rebuild
+    const bool checked = !ctx.moveSize || !ctx.region || t.sessionChecks == static_cast<size_t>(sessions * 119);
+    return t.redraws == t.ticks && MetricGet(Metric::MoveSizeSessions) == sessions &&
+           MetricGet(Metric::MoveSizeFrames) == sessions * 119 && checked;
+}
+
+// cascade: 200 windows opened one per tick, held, then closed oldest first
+static void StepCascade(ScenarioContext& ctx)
+{
+    const size_t count = 200, closeAt = 260;
+    if (ctx.tick < count) {
+        const int32_t off = static_cast<int32_t>((ctx.tick % 40) * 24 + (ctx.tick / 40) * 60);
+        OpenSimWindow(ctx, ctx.tick, { 40 + off, 30 + static_cast<int32_t>((ctx.tick % 40) * 24), 1240 + off, 830 + static_cast<int32_t>((ctx.tick % 40) * 24) });
+    } else if (ctx.tick >= closeAt && ctx.tick < closeAt + count) {
+        ctx.desktop.Destroy(ctx.windows[ctx.tick - closeAt], ctx.events);
+    }
+}
+
+static bool CheckCascade(const ScenarioContext& ctx, const ScenarioTotals& t)
+{
+    return t.maxTracked == 200 && ctx.service.Windows().Size() == 0;
+}
+
+// alttab: Alt held down, Tab hammered; a new window comes forward twice per tick
+static void StepAltTab(ScenarioContext& ctx)
+{
+    for (int i = 0; i < 2; ++i) ctx.desktop.Activate(ctx.windows[ctx.rng() % ctx.windows.size()], ctx.events);
+}
+
+static bool CheckAltTab(const ScenarioContext& ctx, const ScenarioTotals& t)
+{
+    return ctx.service.Dropped() == 0 && t.redraws == t.ticks;
+}
+
+// foreground: foreground-only mode, focus moves every 250 ms
+static void StepForeground(ScenarioContext& ctx)
+{
+    if (ctx.tick % 15 == 0) ctx.desktop.Activate(ctx.windows[ctx.rng() % ctx.windows.size()], ctx.events);
+}
+
+static bool CheckForeground(const ScenarioContext&, const ScenarioTotals& t)
+{
+    return t.maxTracked <= 1;
+}
+
+// settings: SET every 100 ms (thickness / color / corner), RULES every second
+static void StepSettings(ScenarioContext& ctx)
+{
+    if (ctx.tick % 6 == 0) {
+        const size_t n = ctx.tick / 6;
+        ctx.style.thickness = 2.0f + static_cast<float>(n % 6);
+        ctx.style.color = { static_cast<float>(n % 3) / 2.0f, 0.5f, 1.0f, 1.0f };
+        ctx.style.corner = n % 2 ? CornerStyle::Round : CornerStyle::DoNot;
+        ctx.service.ApplySettings(ctx.style, false);
+        ctx.events.push_back(EventRecord{}); // kEventRefreshRequest
+    }
+    if (ctx.tick % 60 == 30) {
+        std::wstring rules;
+        for (size_t i = 0; i < 20; ++i) {
+            rules += L"process=" + std::wstring(s_simProcesses[i % 8]) + L"; title=document " +
+                     std::to_wstring((ctx.tick + i) % 30) + L"; color=#FF" + (i % 2 ? L"8000" : L"0080") + L"|";
+        }
+        ctx.service.ApplyRules(rules);
+        ctx.events.push_back(EventRecord{});
+    }
+}
+
+static bool CheckSettings(const ScenarioContext& ctx, const ScenarioTotals&)
+{
+    // Rules only recolor, so every window must carry the latest thickness
+    const WindowRegistry& reg = ctx.service.Windows();
+    for (WindowRegistry::Slot s : reg.Order()) {
+        if (reg.Style(s).thickness != ctx.style.thickness) return false;
+    }
+    return !reg.Order().empty();
+}
+
+// desktop: 100 windows on two virtual desktops, every other one on the second; every two
+// seconds the user switches desktops. Windows cloaks the 50 windows left behind and
+// uncloaks the 50 arriving, a quarter of them per tick. Each switch must settle into one
+// redraw showing exactly the new desktop's windows.
+static const size_t kDesktopSwitchTicks = 120;
+static const size_t kDesktopSwitchSpread = 4;
+
+static void StepDesktop(ScenarioContext& ctx)
+{
+    const size_t phase = ctx.tick % kDesktopSwitchTicks;
+    if (phase >= kDesktopSwitchSpread) return;
+    const size_t target = (ctx.tick / kDesktopSwitchTicks) % 2;
+    const size_t n = ctx.windows.size(), per = (n + kDesktopSwitchSpread - 1) / kDesktopSwitchSpread;
+    for (size_t i = phase * per; i < std::min(n, (phase + 1) * per); ++i) {
+        ctx.desktop.Cloak(ctx.windows[i], i % 2 != target, ctx.events);
+    }
+}
+
+static bool CheckDesktop(const ScenarioContext& ctx, const ScenarioTotals& t)
+{
+    const size_t switches = (t.ticks + kDesktopSwitchTicks - 1) / kDesktopSwitchTicks;
+    const size_t shown = ctx.windows.size() / 2;
+    if (ctx.service.Windows().Size() != shown) return false;
+    if (!ctx.bursts) return true;
+    // The first switch only cloaks; every later one moves all the windows
+    return MetricGet(Metric::BurstCount) == static_cast<int64_t>(switches) &&
+           (switches < 2 || MetricGet(Metric::BurstLastWindows) == static_cast<int64_t>(ctx.windows.size())) &&
+           t.redraws <= t.timerRefreshes + switches;
+}
+
+// suspend: every two seconds the overlay suspends (session lock, display off) for one
+// second. Meanwhile a third of the windows change virtual desktop and, with the hooks
+// down, nothing reports it; while running another third changes with its events. Each
+// resume must re-query the cloak states and border exactly the current desktop's windows.
+static const size_t kSuspendPeriod = 120;
+
+static void StepSuspend(ScenarioContext& ctx)
+{
+    const size_t phase = ctx.tick % kSuspendPeriod;
+    if (phase == 10 || phase == 70) {
+        ctx.service.SetSuspended(phase == 10);
+    } else if (phase == 40 || phase == 90) {
+        for (uint64_t h : ctx.windows) {
+            if (ctx.rng() % 3 == 0) ctx.desktop.Cloak(h, !ctx.desktop.Find(h)->cloaked, ctx.events);
+        }
+    }
+}
+
+static bool CheckSuspend(const ScenarioContext& ctx, const ScenarioTotals& t)
+{
+    if (t.ticks < kSuspendPeriod) return false;
+    size_t shown = 0;
+    for (uint64_t h : ctx.windows) {
+        const bool cloaked = ctx.desktop.Find(h)->cloaked;
+        if ((ctx.service.Windows().Find(h) != WindowRegistry::kNoSlot) == cloaked) return false;
+        if (!cloaked) ++shown;
+    }
+    return ctx.service.Windows().Size() == shown;
+}
+
+// minimize: Win+D one second in, every window restored at 13 s. Ten seconds with nothing
+// to draw release the scratch and the arena; the restore must rebuild them within the
+// first-frame budget and border every window again.
+static void StepMinimize(ScenarioContext& ctx)
+{
+    if (ctx.tick != 60 && ctx.tick != 780) return;
+    for (uint64_t h : ctx.windows) ctx.desktop.Minimize(h, ctx.tick == 60, ctx.events);
+}
+
+static bool CheckMinimize(const ScenarioContext& ctx, const ScenarioTotals& t)
+{
+    const IdleReclaimer& idle = ctx.service.Idle();
+    if (ctx.service.Windows().Size() != ctx.windows.size() || ctx.service.Dropped()) return false;
+    // idle_ms longer than the minimized stretch: nothing may be released
+    if (static_cast<double>(idle.Options().idleNs) > 12e9) return idle.Releases() == 0;
+    return t.ticks >= 780 && idle.Releases() == 1 && idle.Rehydrations() == 1 && idle.OverBudget() == 0 &&
+           MetricGet(Metric::IdlePrivateKbIdle) < MetricGet(Metric::IdlePrivateKbActive);
+}
+
+// alloc: a workload that repeats every 6 seconds (a drag there and back, six windows
+// brought forward, a title edited and restored, typing throughout). The first two periods
+// grow the pooled containers and the frame arena to their high-water marks; after that
+// no frame may touch the heap.
+static const size_t kSteadyPeriod = 360; // a multiple of the 9-tick refresh timer
+
+static void StepSteady(ScenarioContext& ctx)
+{
+    const size_t phase = ctx.tick % kSteadyPeriod;
+    const uint64_t front = ctx.desktop.Foreground();
+    if (ctx.tick % 8 == 0) ctx.desktop.Type(front, ctx.events);
+    if (phase < 120) {
+        if (ctx.moveSize && phase == 0) ctx.desktop.BeginMoveSize(front, ctx.events);
+        const int32_t dir = phase < 60 ? 1 : -1;
+        ctx.desktop.MoveBy(front, 4 * dir, 2 * dir, ctx.events);
+        if (ctx.moveSize && phase == 119) ctx.desktop.EndMoveSize(front, ctx.events);
+    } else if (phase < 240) {
+        if ((phase - 120) % 20 == 0) ctx.desktop.Activate(ctx.windows[(phase - 120) / 20], ctx.events);
+    } else if (phase == 240 || phase == 300) {
+        const SimWindow* w = ctx.desktop.Find(front);
+        ctx.desktop.SetTitle(front, phase == 240 ? w->title + L"*" : w->title.substr(0, w->title.size() - 1), ctx.events);
+    }
+}
+
+static bool CheckSteady(const ScenarioContext&, const ScenarioTotals& t)
+{
+    return t.ticks > 2 * kSteadyPeriod && (t.lastAllocatingTick == SIZE_MAX || t.lastAllocatingTick < 2 * kSteadyPeriod);
+}
+
+static bool BenchIdle(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 20, 10, false, StepIdle, CheckIdle }); }
+static bool BenchDrag(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 20, 10, false, StepDrag, CheckDrag }); }
+static bool BenchCascade(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 0, 8, false, StepCascade, CheckCascade }); }
+static bool BenchAltTab(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 30, 10, false, StepAltTab, CheckAltTab }); }
+static bool BenchForeground(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 30, 10, true, StepForeground, CheckForeground }); }
+static bool BenchSettings(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 30, 10, false, StepSettings, CheckSettings }); }
+static bool BenchAlloc(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 30, 24, false, StepSteady, CheckSteady }); }
+static bool BenchMinimize(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 30, 16, false, StepMinimize, CheckMinimize }); }
+static bool BenchDesktop(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 100, 10, false, StepDesktop, CheckDesktop }); }
+static bool BenchSuspend(BenchReport& r, const std::vector<std::string>& a) { return RunScenario(r, a, { 40, 10, false, StepSuspend, CheckSuspend }); }
+
+// ---- effects: the focused-window effect against a recording compositor ----
+
+// Stands in for DirectComposition: counts what the controller asks for and evaluates the
+// running curve the way the compositor does on every vblank, with no call from the service
+class BenchEffectCompositor : public EffectCompositor {
+public:
+    uint64_t nowNs = 0;
+    uint64_t draws = 0, places = 0, animations = 0, hides = 0;
+
+    bool DrawBorder(int32_t, int32_t, const WindowRect&, const BorderStyle&) override
+    {
+        ++draws;
+        return true;
+    }
+    void Place(int32_t, int32_t) override { ++places; }
+    void Animate(const OpacityCurve& curve) override
+    {
+        ++animations;
+        m_curve = curve;
+        m_startNs = nowNs;
+        m_hidden = false;
+    }
+    void Hide() override
+    {
+        ++hides;
+        m_hidden = true;
+    }
+
+    uint64_t Calls() const { return draws + places + animations + hides; }
+    float Opacity() const
+    {
+        return m_hidden || m_curve.segments.empty() ? 0.0f : EvaluateCurve(m_curve, static_cast<double>(nowNs - m_startNs) / 1e9);
+    }
+
+private:
+    OpacityCurve m_curve;
+    uint64_t m_startNs = 0;
+    bool m_hidden = true;
+};
+
+// A pulse across focus changes between windows of two sizes and a drag of the focused
+// window, then a switch to fade. Every tick without window events (the refresh timer aside)
+// must reach neither the compositor nor the draw, while the opacity the compositor shows
+// keeps moving.
+static bool BenchEffects(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t windowCount = static_cast<size_t>(std::max<int64_t>(BenchArg(args, "windows", 20), 14));
+    const size_t timerTicks = static_cast<size_t>(BenchArg(args, "timer_ms", 150) * 60 / 1000);
+    const bool region = BenchArg(args, "region", 1) != 0;
+    const double tickNs = 1e9 / 60.0;
+    const size_t ticks = 960, fadeAt = 720, dragAt = 540, dragTicks = 60;
+    const std::pair<size_t, size_t> focusChanges[] = { { 120, 3 }, { 240, 5 }, { 360, 8 }, { 480, 10 }, { 780, 13 }, { 870, 4 } };
+
+    const WindowRect screen{ 0, 0, 2560, 1440 };
+    SimDesktop desktop(screen);
+    SimService service(desktop);
+    BenchEffectCompositor compositor;
+    std::vector<EventRecord> events;
+    service.ApplySettings(BorderStyle{}, false);
+    service.SetRegionMode(region);
+    BorderEffect effect;
+    effect.kind = BorderEffectKind::Pulse;
+    effect.periodMs = static_cast<uint32_t>(BenchArg(args, "period_ms", 1000));
+    service.SetEffect(effect, &compositor);
+
+    // Overlapping windows of two sizes, so some focus changes only move the effect
+    std::vector<uint64_t> windows;
+    auto size = [](size_t i) { return i % 2 ? std::make_pair(900, 600) : std::make_pair(1100, 700); };
+    for (size_t i = 0; i < windowCount; ++i) {
+        const int32_t x = 40 + static_cast<int32_t>(i % 10) * 110, y = 30 + static_cast<int32_t>(i % 7) * 90;
+        windows.push_back(desktop.Create({ x, y, x + size(i).first, y + size(i).second }, L"code", L"code_frame",
+                                         L"document " + std::to_wstring(i), events));
+    }
+    for (const auto& e : events) service.Offer(e);
+    service.RunFrame();
+    events.clear();
+    ResetMetrics();
+
+    bool ok = compositor.draws == 1 && compositor.animations == 1 && service.Effects().Target() == windows.back();
+    size_t lastTarget = windowCount - 1, expectDraws = 1, fadeAnimations = 0;
+    uint64_t quietTicks = 0, quietCalls = 0, quietRedraws = 0, timerRedraws = 0, eventTicks = 0;
+    float pulseMin = 1.0f, pulseMax = 0.0f;
+    std::vector<float> pulseSamples;
+    uint64_t updateNs = 0;
+
+    for (size_t t = 0; t < ticks; ++t) {
+        const uint64_t nowNs = static_cast<uint64_t>(static_cast<double>(t) * tickNs);
+        service.SetClock(nowNs);
+        compositor.nowNs = nowNs;
+        events.clear();
+
+        for (const auto& f : focusChanges) {
+            if (f.first != t) continue;
+            desktop.Activate(windows[f.second], events);
+            if (size(f.second) != size(lastTarget)) ++expectDraws;
+            lastTarget = f.second;
+            if (t >= fadeAt) ++fadeAnimations;
+        }
+        const uint64_t dragged = windows[10];
+        if (t == dragAt) desktop.BeginMoveSize(dragged, events);
+        if (t > dragAt && t < dragAt + dragTicks - 1) desktop.MoveBy(dragged, 7, 3, events);
+        if (t == dragAt + dragTicks - 1) desktop.EndMoveSize(dragged, events);
+        if (t == fadeAt) {
+            effect.kind = BorderEffectKind::Fade;
+            service.SetEffect(effect, &compositor);
+            ++fadeAnimations;
+        }
+        const bool quiet = events.empty() && t != fadeAt;
+        const bool timer = timerTicks && t % timerTicks == 0;
+        if (t == fadeAt || timer) {
+            EventRecord r;
+            r.event = kEventRefreshRequest;
+            events.push_back(r);
+        }
+
+        for (const auto& e : events) service.Offer(e);
+        const uint64_t calls = compositor.Calls();
+        const uint64_t t0 = BenchNowNs();
+        const bool redrew = service.RunFrame();
+        updateNs += BenchNowNs() - t0;
+
+        if (quiet) {
+            ++quietTicks;
+            quietCalls += compositor.Calls() - calls;
+            if (redrew && !timer) ++quietRedraws;
+            if (redrew && timer) {
+                ++timerRedraws;
+                // A full pass: every window but the effect's, plus the clears without a region
+                ok = ok && service.PrimitiveCount() == (region ? windowCount - 1 : 2 * windowCount - 1);
+            }
+            if (t < fadeAt) {
+                const float o = compositor.Opacity();
+                pulseMin = std::min(pulseMin, o);
+                pulseMax = std::max(pulseMax, o);
+                pulseSamples.push_back(o);
+            }
+        } else {
+            ++eventTicks;
+        }
+    }
+
+    // The pulse kept moving between focus changes, from opaque down to its low point
+    std::sort(pulseSamples.begin(), pulseSamples.end());
+    const size_t distinct = static_cast<size_t>(std::unique(pulseSamples.begin(), pulseSamples.end()) - pulseSamples.begin());
+    ok = ok && quietCalls == 0 && quietRedraws == 0;
+    ok = ok && pulseMax > 0.95f && pulseMin < effect.minOpacity + 0.05f && distinct > 30;
+    // Focus changes retarget; content is redrawn only for a new size; the pulse keeps its
+    // phase, a fade restarts on every focus change
+    ok = ok && service.Effects().Retargets() == 1 + sizeof(focusChanges) / sizeof(focusChanges[0]);
+    ok = ok && compositor.draws == expectDraws && compositor.animations == 1 + fadeAnimations;
+    ok = ok && compositor.places >= dragTicks - 2 && service.Effects().Target() == windows[lastTarget];
+    // Long after the last fade-in: held opaque
+    ok = ok && compositor.Opacity() == 1.0f;
+
+    // Turning the effect off hides the visual and the surface draws the window again
+    service.SetEffect(BorderEffect(), &compositor);
+    EventRecord r;
+    r.event = kEventRefreshRequest;
+    service.Offer(r);
+    service.RunFrame();
+    ok = ok && compositor.hides == 1 && service.Effects().Target() == 0 &&
+         service.PrimitiveCount() == (region ? windowCount : 2 * windowCount);
+
+    report.AddText("Backend", "simulated");
+    report.AddText("Present", region ? "region" : "painter");
+    report.Add("Windows", static_cast<double>(windowCount));
+    report.Add("Ticks", static_cast<double>(ticks));
+    report.Add("EventTicks", static_cast<double>(eventTicks));
+    report.Add("QuietTicks", static_cast<double>(quietTicks));
+    report.Add("QuietCompositorCalls", static_cast<double>(quietCalls));
+    report.Add("QuietRedraws", static_cast<double>(quietRedraws));
+    report.Add("TimerRedraws", static_cast<double>(timerRedraws));
+    report.Add("Retargets", static_cast<double>(service.Effects().Retargets()));
+    report.Add("EffectDraws", static_cast<double>(compositor.draws));
+    report.Add("EffectPlaces", static_cast<double>(compositor.places));
+    report.Add("EffectAnimations", static_cast<double>(compositor.animations));
+    report.Add("PulseMinOpacity", pulseMin);
+    report.Add("PulseMaxOpacity", pulseMax);
+    report.Add("PulseDistinctOpacities", static_cast<double>(distinct));
+    report.Add("UsPerTick", static_cast<double>(updateNs) / 1e3 / static_cast<double>(ticks));
+    return ok;
+}
+
+// ---- monitors: per-monitor partition, pacing and topology diffs on simulated layouts ----
+
+// 1440p at 144 Hz, a 150% 4K panel at 60 Hz to its right and a 240 Hz 1080p panel to its
+// left, at negative virtual-screen coordinates as Windows places it
+static std::vector<MonitorDesc> BenchMonitorLayout()
+{
+    std::vector<MonitorDesc> m(3);
+    m[0] = { 1, { 0, 0, 2560, 1440 }, 96, 144 };
+    m[1] = { 2, { 2560, 0, 6400, 2160 }, 144, 60 };
+    m[2] = { 3, { -1920, 0, 0, 1080 }, 96, 240 };
+    return m;
+}
+
+struct BenchMonitorWindow {
+    uint64_t handle = 0;
+    WindowRect rect;
+    BorderStyle style;
+};
+
+static WindowRect BenchOuter(const BenchMonitorWindow& w)
+{
+    return MoveSizeDamage(w.rect, w.rect, w.style.thickness);
+}
+
+static MonitorMask BenchSignaturePass(MonitorPartition& monitors, const std::vector<BenchMonitorWindow>& windows)
+{
+    monitors.BeginSignatures();
+    for (const BenchMonitorWindow& w : windows) monitors.AddToSignatures(BenchOuter(w), WindowDrawState(w.handle, w.rect, w.style, 1));
+    return monitors.EndSignatures();
+}
+
+// Reference: a monitor looks different iff the z-ordered windows reaching it differ
+static MonitorMask BenchChangedMonitors(const MonitorPartition& monitors, const std::vector<BenchMonitorWindow>& before,
+                                        const std::vector<BenchMonitorWindow>& after)
+{
+    MonitorMask changed = 0;
+    for (size_t m = 0; m < monitors.Count(); ++m) {
+        const MonitorMask bit = MonitorMask(1) << m;
+        std::vector<const BenchMonitorWindow*> a, b;
+        for (const BenchMonitorWindow& w : before) if (monitors.Touching(BenchOuter(w)) & bit) a.push_back(&w);
+        for (const BenchMonitorWindow& w : after) if (monitors.Touching(BenchOuter(w)) & bit) b.push_back(&w);
+        bool same = a.size() == b.size();
+        for (size_t i = 0; same && i < a.size(); ++i) {
+            same = a[i]->handle == b[i]->handle && a[i]->rect == b[i]->rect && a[i]->style == b[i]->style;
+        }
+        if (!same) changed |= bit;
+    }
+    return changed;
+}
+
+static bool BenchLayoutChange(MonitorPartition& monitors, const std::vector<MonitorDesc>& layout, MonitorMask rebuilt,
+                              MonitorMask retimed, size_t removed)
+{
+    MonitorLayoutChange change;
+    monitors.Apply(layout, change);
+    return change.rebuilt == rebuilt && change.retimed == retimed && change.removed.size() == removed;
+}
+
+// A window scattered over the layout, inside one monitor or across an edge
+static BenchMonitorWindow BenchPlaceWindow(std::mt19937& rng, uint64_t handle)
+{
+    BenchMonitorWindow w;
+    w.handle = handle;
+    const int32_t width = 300 + static_cast<int32_t>(rng() % 900), height = 200 + static_cast<int32_t>(rng() % 700);
+    const int32_t left = -1920 + static_cast<int32_t>(rng() % (6400 + 1920 - width));
+    const int32_t top = static_cast<int32_t>(rng() % (1080 - height + 1));
+    w.rect = { left, top, left + width, top + height };
+    w.style.thickness = (rng() % 4 == 0) ? 8.0f : 4.0f;
+    return w;
+}
+
+// A drag with input every millisecond: left 240 Hz panel, then across the 144 Hz one, then
+// on the 60 Hz one. Each monitor must be drawn at most once per its own period and no
+// damage may wait longer than one period (plus the tick that notices it).
+struct BenchPacingResult {
+    bool ok = true;
+    uint64_t draws[3] = {};
+    uint64_t phaseDraws[3][3] = {}; // [phase][monitor]
+    uint64_t maxWaitNs[3] = {};
+    uint64_t minGapNs[3] = { UINT64_MAX, UINT64_MAX, UINT64_MAX };
+    uint64_t pixels = 0;
+    uint64_t ticks = 0;
+};
+
+static BenchPacingResult BenchRunPacing(MonitorPartition& monitors, uint64_t phaseMs)
+{
+    BenchPacingResult r;
+    const uint64_t tickNs = 1000000;
+    // The three phases' paths: within the left panel, from it across the middle one, within the right one
+    const int32_t xs[4] = { -1800, -1000, 3000, 5400 };
+    uint64_t waitingSince[3] = {};
+    uint64_t lastDraw[3] = {};
+    WindowRect rect{ -1800, 100, -1000, 700 };
+    const float thickness = 4.0f;
+    uint64_t now = 1000000000ull;
+    for (size_t phase = 0; phase < 3; ++phase) {
+        for (uint64_t t = 0; t < phaseMs; ++t, now += tickNs) {
+            ++r.ticks;
+            const int32_t x = xs[phase] + static_cast<int32_t>((static_cast<int64_t>(xs[phase + 1]) - xs[phase]) * static_cast<int64_t>(t) / static_cast<int64_t>(phaseMs));
+            // Each phase stays clear of the edges it does not cross
+            const int32_t y = 100 + static_cast<int32_t>(t % 50);
+            const WindowRect next{ x, y, x + 800, y + 600 };
+            if (!(next == rect)) {
+                const MonitorMask before = monitors.Pending();
+                monitors.Invalidate(MoveSizeDamage(rect, next, thickness));
+                for (size_t m = 0; m < 3; ++m) {
+                    if ((monitors.Pending() & ~before) & (MonitorMask(1) << m)) waitingSince[m] = now;
+                }
+                rect = next;
+            }
+            // The render thread: whatever is due now; the rest waits for its slot
+            const MonitorMask due = monitors.Due(now);
+            for (size_t m = 0; m < 3; ++m) {
+                if (!(due & (MonitorMask(1) << m))) continue;
+                const WindowRect& d = monitors.PendingRect(m);
+                r.pixels += static_cast<uint64_t>(d.right - d.left) * static_cast<uint64_t>(d.bottom - d.top);
+                r.maxWaitNs[m] = std::max(r.maxWaitNs[m], now - waitingSince[m]);
+                if (lastDraw[m]) r.minGapNs[m] = std::min(r.minGapNs[m], now - lastDraw[m]);
+                lastDraw[m] = now;
+                ++r.draws[m];
+                ++r.phaseDraws[phase][m];
+                monitors.Drawn(m, now);
+            }
+            // The pipeline's next wake-up is never in the past while something waits
+            const uint64_t wake = monitors.NextDueNs();
+            r.ok = r.ok && (monitors.Pending() ? wake > now : wake == 0);
+        }
+    }
+    // Once the drag stops, the damage left over goes out by the slowest period
+    now += monitors.PeriodNs(1);
+    const MonitorMask due = monitors.Due(now);
+    r.ok = r.ok && due == monitors.Pending();
+    for (size_t m = 0; m < 3; ++m) {
+        if (due & (MonitorMask(1) << m)) monitors.Drawn(m, now);
+    }
+    for (size_t m = 0; m < 3; ++m) {
+        const uint64_t period = monitors.PeriodNs(m);
+        r.ok = r.ok && (r.minGapNs[m] == UINT64_MAX || r.minGapNs[m] >= period - period / 8);
+        r.ok = r.ok && r.maxWaitNs[m] <= period + tickNs;
+    }
+    return r;
+}
+
+static bool BenchMonitors(BenchReport& report, const std::vector<std::string>& args)
+{
+    const size_t windowCount = static_cast<size_t>(std::max<int64_t>(BenchArg(args, "windows", 60), 4));
+    const size_t edits = static_cast<size_t>(BenchArg(args, "edits", 2000));
+    const uint64_t phaseMs = static_cast<uint64_t>(std::max<int64_t>(BenchArg(args, "phase_ms", 1000), 100));
+    const std::vector<MonitorDesc> layout = BenchMonitorLayout();
+    MonitorPartition monitors;
+    bool ok = BenchLayoutChange(monitors, layout, 0x7, 0, 0) && monitors.Count() == 3 && monitors.Pending() == 0x7;
+
+    // Which monitors a rect reaches, which one owns it, and its DPI
+    ok = ok && monitors.Touching({ 100, 100, 900, 700 }) == 0x1 && monitors.Touching({ 2400, 100, 2700, 700 }) == 0x3;
+    ok = ok && monitors.Touching({ -100, 100, 100, 700 }) == 0x5 && monitors.Touching({ -1920, 1200, -100, 1300 }) == 0;
+    ok = ok && monitors.Primary({ 2400, 100, 3000, 700 }) == 1 && monitors.Primary({ -1000, 1200, -900, 1300 }) == 2;
+    ok = ok && monitors.ScaleThickness(1, 4.0f) == 6.0f && monitors.ScaleThickness(0, 4.0f) == 4.0f;
+    for (size_t m = 0; m < 3; ++m) monitors.Drawn(m, 1);
+
+    // Full passes: random edits (move, restyle, raise, close, open), each compared with the
+    // brute-force reference
+    std::mt19937 rng(7);
+    std::vector<BenchMonitorWindow> windows;
+    uint64_t nextHandle = 0x1000;
+    for (size_t i = 0; i < windowCount; ++i) windows.push_back(BenchPlaceWindow(rng, nextHandle++));
+    ok = ok && BenchSignaturePass(monitors, windows) == 0x7 && BenchSignaturePass(monitors, windows) == 0;
+    uint64_t partitionedPixels = 0, changedMonitors = 0, mismatches = 0;
+    const uint64_t screenPixels = static_cast<uint64_t>(6400 + 1920) * 2160;
+    for (size_t e = 0; e < edits; ++e) {
+        const std::vector<BenchMonitorWindow> before = windows;
+        const size_t i = rng() % windows.size();
+        switch (rng() % 5) {
+        case 0: {
+            const int32_t dx = static_cast<int32_t>(rng() % 801) - 400, dy = static_cast<int32_t>(rng() % 201) - 100;
+            windows[i].rect = { windows[i].rect.left + dx, windows[i].rect.top + dy, windows[i].rect.right + dx, windows[i].rect.bottom + dy };
+            break;
+        }
+        case 1:
+            windows[i].style.color.r = static_cast<float>(rng() % 256) / 255.0f;
+            break;
+        case 2: {
+            const BenchMonitorWindow w = windows[i];
+            windows.erase(windows.begin() + static_cast<ptrdiff_t>(i));
+            windows.insert(windows.begin(), w);
+            break;
+        }
+        case 3:
+            if (windows.size() > windowCount / 2) windows.erase(windows.begin() + static_cast<ptrdiff_t>(i));
+            break;
+        default:
+            windows.insert(windows.begin() + static_cast<ptrdiff_t>(rng() % (windows.size() + 1)), BenchPlaceWindow(rng, nextHandle++));
+            break;
+        }
+        const MonitorMask expected = BenchChangedMonitors(monitors, before, windows);
+        const MonitorMask got = BenchSignaturePass(monitors, windows);
+        if (got != expected) ++mismatches;
+        changedMonitors += CountMonitors(got);
+        for (size_t m = 0; m < 3; ++m) {
+            if (!(got & (MonitorMask(1) << m))) continue;
+            const WindowRect& b = monitors.Monitor(m).bounds;
+            partitionedPixels += static_cast<uint64_t>(b.right - b.left) * static_cast<uint64_t>(b.bottom - b.top);
+        }
+        for (size_t m = 0; m < 3; ++m) {
+            if (monitors.Pending() & (MonitorMask(1) << m)) monitors.Drawn(m, 2 + e);
+        }
+    }
+    ok = ok && mismatches == 0 && monitors.Pending() == 0;
+
+    // Pacing on every monitor's own cadence
+    const BenchPacingResult pacing = BenchRunPacing(monitors, phaseMs);
+    const double seconds = static_cast<double>(phaseMs) / 1000.0;
+    ok = ok && pacing.ok;
+    // Phase 1 never leaves the 240 Hz panel, phase 3 never leaves the 60 Hz one
+    ok = ok && pacing.phaseDraws[0][0] == 0 && pacing.phaseDraws[0][1] == 0 && pacing.phaseDraws[2][2] == 0 && pacing.phaseDraws[2][0] <= 1;
+    ok = ok && pacing.phaseDraws[0][2] >= static_cast<uint64_t>(240 * seconds * 0.9) && pacing.phaseDraws[0][2] <= static_cast<uint64_t>(240 * seconds * 8 / 7) + 1;
+    ok = ok && pacing.phaseDraws[2][1] >= static_cast<uint64_t>(60 * seconds * 0.9) && pacing.phaseDraws[2][1] <= static_cast<uint64_t>(60 * seconds * 8 / 7) + 1;
+
+    // Topology: only what changed is rebuilt; the rest keeps its signature and cadence
+    std::vector<MonitorDesc> next = layout;
+    ok = ok && BenchLayoutChange(monitors, next, 0, 0, 0) && monitors.Pending() == 0;
+    next[1].refreshHz = 120;
+    ok = ok && BenchLayoutChange(monitors, next, 0, 0x2, 0) && monitors.PeriodNs(1) == 1000000000ull / 120;
+    next[1].dpi = 192;
+    ok = ok && BenchLayoutChange(monitors, next, 0x2, 0, 0) && monitors.Pending() == 0x2 && monitors.PendingFull(1);
+    monitors.Drawn(1, 5000000000ull);
+    ok = ok && BenchSignaturePass(monitors, windows) == 0;
+    // Unplugging the left panel shifts the virtual screen's origin; the others stay
+    next.pop_back();
+    ok = ok && BenchLayoutChange(monitors, next, 0, 0, 1) && monitors.Pending() == 0;
+    ok = ok && BenchSignaturePass(monitors, windows) == 0;
+    // Enumeration order is not identity
+    std::swap(next[0], next[1]);
+    ok = ok && BenchLayoutChange(monitors, next, 0, 0, 0) && monitors.IndexOf(1) == 1 && BenchSignaturePass(monitors, windows) == 0;
+    // Ids come from device names, the same for a display however often it is re-enumerated
+    // and distinct per display
+    std::vector<uint64_t> deviceIds;
+    for (int d = 1; d <= 64; ++d) deviceIds.push_back(MonitorDeviceId((L"\\\\.\\DISPLAY" + std::to_wstring(d)).c_str()));
+    ok = ok && deviceIds[0] == MonitorDeviceId(L"\\\\.\\DISPLAY1") && MonitorDeviceId(nullptr) != 0 &&
+         std::find(deviceIds.begin(), deviceIds.end(), 0ull) == deviceIds.end();
+    std::sort(deviceIds.begin(), deviceIds.end());
+    ok = ok && std::unique(deviceIds.begin(), deviceIds.end()) == deviceIds.end();
+    next.push_back({ 4, { 6400, 0, 8320, 1200 }, 96, 75 });
+    ok = ok && BenchLayoutChange(monitors, next, 0x4, 0, 0) && monitors.Pending() == 0x4;
+    const uint64_t rebuilds = monitors.Rebuilds();
+    std::vector<MonitorDesc> many;
+    for (uint64_t i = 0; i < 40; ++i) many.push_back({ 100 + i, { static_cast<int32_t>(i) * 100, 0, static_cast<int32_t>(i + 1) * 100, 100 }, 96, 60 });
+    MonitorPartition wall;
+    ok = ok && BenchLayoutChange(wall, many, ~MonitorMask(0), 0, 0) && wall.Count() == MonitorPartition::kMaxMonitors;
+
+    // Cost of a full pass's partition over a large desktop
+    MonitorPartition timed;
+    MonitorLayoutChange change;
+    timed.Apply(layout, change);
+    std::vector<BenchMonitorWindow> large;
+    for (size_t i = 0; i < 1000; ++i) large.push_back(BenchPlaceWindow(rng, 0x100000 + i));
+    const size_t passes = 500;
+    const uint64_t t0 = BenchNowNs();
+    for (size_t i = 0; i < passes; ++i) {
+        large[i % large.size()].rect.left ^= 1;
+        BenchSignaturePass(timed, large);
+    }
+    const uint64_t passNs = BenchNowNs() - t0;
+
+    report.Add("Windows", static_cast<double>(windowCount));
+    report.Add("Edits", static_cast<double>(edits));
+    report.Add("PartitionMismatches", static_cast<double>(mismatches));
+    report.Add("MonitorsRedrawnPerEdit", static_cast<double>(changedMonitors) / static_cast<double>(edits));
+    report.Add("PartitionedPixelShare", static_cast<double>(partitionedPixels) / static_cast<double>(screenPixels * edits));
+    report.Add("Draws240HzPerSec", static_cast<double>(pacing.phaseDraws[0][2]) / seconds);
+    report.Add("Draws60HzPerSec", static_cast<double>(pacing.phaseDraws[2][1]) / seconds);
+    report.Add("Draws144Hz", static_cast<double>(pacing.draws[0]));
+    report.Add("MaxWait240HzMs", pacing.maxWaitNs[2] / 1e6);
+    report.Add("MaxWait144HzMs", pacing.maxWaitNs[0] / 1e6);
+    report.Add("MaxWait60HzMs", pacing.maxWaitNs[1] / 1e6);
+    report.Add("DragMpixDrawn", pacing.pixels / 1e6);
+    report.Add("PipelinesRebuilt", static_cast<double>(rebuilds));
+    report.Add("UsPerPass1000", static_cast<double>(passNs) / 1e3 / passes);
+    return ok;
+}
+
+// ---- engine: the BorderEngine.h C ABI against the simulated desktop ----
+
+#ifndef _WIN32
+// A host pushing its windows' changes, flushing and reading stats, with nothing but the
+// exported functions
+static bool BenchEngine(BenchReport& report, const std::vector<std::string>& args)
+{
+    const uint32_t windowCount = static_cast<uint32_t>(BenchArg(args, "windows", 40));
+    const uint32_t rounds = static_cast<uint32_t>(BenchArg(args, "rounds", 2000));
+    bool ok = BorderEngineAbiVersion() == BORDER_ENGINE_ABI_VERSION;
+
+    BorderEngineSettings settings{};
+    settings.size = sizeof(settings);
+    settings.color = 0xFF00CCFFu;
+    settings.thickness = 4.0f;
+    settings.corner = BORDER_ENGINE_CORNER_ROUND;
+    settings.mode = BORDER_ENGINE_MODE_AUTO;
+
+    // Argument checks leave no engine behind
+    BorderEngine* engine = nullptr;
+    BorderEngineSettings bad = settings;
+    bad.thickness = 0.0f;
+    ok = ok && BorderEngineCreate(nullptr, &engine) == BORDER_ENGINE_INVALID_ARGUMENT && !engine;
+    ok = ok && BorderEngineCreate(&bad, &engine) == BORDER_ENGINE_INVALID_ARGUMENT && !engine;
+    bad = settings;
+    bad.size = 8;
+    ok = ok && BorderEngineCreate(&bad, &engine) == BORDER_ENGINE_INVALID_ARGUMENT && !engine;
+
+    const uint64_t c0 = BenchNowNs();
+    ok = ok && BorderEngineCreate(&settings, &engine) == BORDER_ENGINE_OK && engine;
+    const uint64_t createNs = BenchNowNs() - c0;
+    if (!engine) return false;
+    BorderEngine* second = nullptr;
+    ok = ok && BorderEngineCreate(&settings, &second) == BORDER_ENGINE_BUSY && !second;
+
+    auto stats = [&]() {
+        BorderEngineStats s{};
+        s.size = sizeof(s);
+        ok = ok && BorderEngineGetStats(engine, &s) == BORDER_ENGINE_OK && s.size == sizeof(s);
+        return s;
+    };
+    auto delta = [](uint32_t i, uint32_t kind, int32_t dx) {
+        BorderWindowDelta d{};
+        d.size = sizeof(d);
+        d.hwnd = 0x20000 + i * 4ull;
+        d.kind = kind;
+        d.left = static_cast<int32_t>(i % 8) * 120 + dx;
+        d.top = static_cast<int32_t>(i / 8) * 90;
+        d.right = d.left + 400;
+        d.bottom = d.top + 300;
+        return d;
+    };
+
+    std::vector<BorderWindowDelta> deltas;
+    for (uint32_t i = 0; i < windowCount; ++i) deltas.push_back(delta(i, BORDER_DELTA_SHOWN, 0));
+    ok = ok && BorderEnginePushWindowDeltas(engine, deltas.data(), windowCount) == BORDER_ENGINE_OK;
+    ok = ok && BorderEngineFlush(engine, 1000) == BORDER_ENGINE_OK;
+    const BorderEngineStats shown = stats();
+    ok = ok && shown.windows == windowCount && shown.redraws >= 2 && shown.settingsVersion == 1;
+
+    // An interactive drag of one window: the host's hot path
+    const BorderWindowDelta start = delta(0, BORDER_DELTA_MOVESIZE_START, 0);
+    ok = ok && BorderEnginePushWindowDeltas(engine, &start, 1) == BORDER_ENGINE_OK;
+    std::vector<uint64_t> samples;
+    samples.reserve(rounds);
+    for (uint32_t r = 1; r <= rounds; ++r) {
+        const BorderWindowDelta move = delta(0, BORDER_DELTA_MOVED, static_cast<int32_t>(r % 200));
+        const uint64_t t0 = BenchNowNs();
+        ok = ok && BorderEnginePushWindowDeltas(engine, &move, 1) == BORDER_ENGINE_OK &&
+             BorderEngineFlush(engine, 1000) == BORDER_ENGINE_OK;
+        samples.push_back(BenchNowNs() - t0);
+    }
+    const BorderWindowDelta end = delta(0, BORDER_DELTA_MOVESIZE_END, 0);
+    ok = ok && BorderEnginePushWindowDeltas(engine, &end, 1) == BORDER_ENGINE_OK;
+    ok = ok && BorderEngineFlush(engine, 1000) == BORDER_ENGINE_OK;
+    const BorderEngineStats dragged = stats();
+    ok = ok && dragged.frames == shown.frames + rounds + 1 && dragged.redraws > shown.redraws &&
+         dragged.windows == windowCount;
+
+    // Settings and rules republish and redraw; unknown delta kinds are refused whole
+    settings.color = 0xFFFF4000u;
+    settings.corner = BORDER_ENGINE_CORNER_SQUARE;
+    ok = ok && BorderEngineSetSettings(engine, &settings) == BORDER_ENGINE_OK;
+    ok = ok && BorderEngineSetRules(engine, "class=HostWindow; title=\xC3\xA9; thickness=9") == BORDER_ENGINE_OK;
+    BorderWindowDelta unknown = delta(1, 99, 0);
+    ok = ok && BorderEnginePushWindowDeltas(engine, &unknown, 1) == BORDER_ENGINE_INVALID_ARGUMENT;
+    ok = ok && BorderEnginePushWindowDeltas(engine, nullptr, 1) == BORDER_ENGINE_INVALID_ARGUMENT;
+    ok = ok && BorderEngineFlush(engine, 1000) == BORDER_ENGINE_OK;
+    const BorderEngineStats restyled = stats();
+    ok = ok && restyled.settingsVersion == 2 && restyled.redraws > dragged.redraws;
+
+    // Delta arrays are strided by their elements' size: a host built against a longer
+    // struct works, a short or mixed size is refused
+    struct NewerDelta {
+        BorderWindowDelta delta;
+        uint64_t later;
+    };
+    NewerDelta newer[3] = {};
+    for (uint32_t i = 0; i < 3; ++i) {
+        newer[i].delta = delta(windowCount + i, BORDER_DELTA_SHOWN, 0);
+        newer[i].delta.size = sizeof(NewerDelta);
+        newer[i].later = ~0ull;
+    }
+    ok = ok && BorderEnginePushWindowDeltas(engine, &newer[0].delta, 3) == BORDER_ENGINE_OK;
+    newer[2].delta.size = sizeof(BorderWindowDelta);
+    newer[0].delta.kind = BORDER_DELTA_DESTROYED;
+    ok = ok && BorderEnginePushWindowDeltas(engine, &newer[0].delta, 3) == BORDER_ENGINE_INVALID_ARGUMENT;
+    BorderWindowDelta shortDelta = delta(1, BORDER_DELTA_DESTROYED, 0);
+    shortDelta.size = offsetof(BorderWindowDelta, left);
+    ok = ok && BorderEnginePushWindowDeltas(engine, &shortDelta, 1) == BORDER_ENGINE_INVALID_ARGUMENT;
+    ok = ok && BorderEngineFlush(engine, 1000) == BORDER_ENGINE_OK && stats().windows == windowCount + 3;
+
+    // Half the windows close
+    deltas.clear();
+    for (uint32_t i = 0; i < windowCount; i += 2) deltas.push_back(delta(i, BORDER_DELTA_DESTROYED, 0));
+    ok = ok && BorderEnginePushWindowDeltas(engine, deltas.data(), static_cast<uint32_t>(deltas.size())) == BORDER_ENGINE_OK;
+    ok = ok && BorderEngineFlush(engine, 1000) == BORDER_ENGINE_OK;
+    const BorderEngineStats closed = stats();
+    ok = ok && closed.windows == windowCount + 3 - deltas.size();
+
+    // A host built against a shorter struct gets only the fields it knows about
+    BorderEngineStats older{};
+    older.size = offsetof(BorderEngineStats, windows);
+    older.windows = 12345;
+    ok = ok && BorderEngineGetStats(engine, &older) == BORDER_ENGINE_OK && older.size == offsetof(BorderEngineStats, windows) &&
+         older.frames == closed.frames && older.windows == 12345;
+    older.size = 4;
+    ok = ok && BorderEngineGetStats(engine, &older) == BORDER_ENGINE_INVALID_ARGUMENT;
+
+    BorderEngineDestroy(engine);
+    // The process-wide slot is free again
+    ok = ok && BorderEngineCreate(&settings, &second) == BORDER_ENGINE_OK && second;
+    BorderEngineDestroy(second);
+
+    std::sort(samples.begin(), samples.end());
+    report.Add("CreateMs", createNs / 1e6);
+    report.Add("DragFrameP50Us", samples.empty() ? 0.0 : samples[samples.size() / 2] / 1e3);
+    report.Add("DragFrameP99Us", samples.empty() ? 0.0 : samples[samples.size() * 99 / 100] / 1e3);
+    report.Add("Frames", static_cast<double>(closed.frames));
+    report.Add("Redraws", static_cast<double>(closed.redraws));
+    report.Add("EventsQueued", static_cast<double>(closed.eventsQueued));
+    report.Add("EventsDropped", static_cast<double>(closed.eventsDropped));
+    report.Add("LastFrameHeapAllocations", static_cast<double>(closed.lastFrameAllocations));
+    return ok;
+}
+#endif
+
+struct BenchEntry {
+    const char* name;
+    bool (*run)(BenchReport&, const std::vector<std::string>&); // false = check failed
+};
+
+static const BenchEntry s_benches[] = {
+    { "power", BenchPower },
+    { "rules", BenchRules },
+    { "queue", BenchQueue },
+    { "registry", BenchRegistry },
+    { "classifier", BenchClassifier },
+    { "layout", BenchLayout },
+    { "snapshot", BenchSnapshot },
+    { "faststart", BenchFastStart },
+    { "atlas", BenchAtlas },
+    { "geometry", BenchGeometry },
+    { "ledger", BenchLedger },
+    { "latency", BenchLatency },
+    { "exit", BenchExit },
+    { "tiers", BenchTiers },
+    { "idle", BenchIdle },
+    { "drag", BenchDrag },
+    { "cascade", BenchCascade },
+    { "alttab", BenchAltTab },
+    { "foreground", BenchForeground },
+    { "settings", BenchSettings },
+    { "alloc", BenchAlloc },
+    { "desktop", BenchDesktop },
+    { "minimize", BenchMinimize },
+    { "suspend", BenchSuspend },
+    { "effects", BenchEffects },
+    { "monitors", BenchMonitors },
+#ifndef _WIN32
+    { "engine", BenchEngine },
+#endif
+};
+
+int RunBench(const std::string& name, const std::vector<std::string>& args)
+{
+    for (const auto& b : s_benches) {
+        if (name != b.name) continue;
+        ResetMetrics();
+        // isa=0|1|2 runs any benchmark on the scalar / SSE2 / AVX2 geometry path
+        const int64_t isa = BenchArg(args, "isa", -1);
+        SetRectIsa(isa >= 0 ? static_cast<RectIsa>(isa) : DetectRectIsa());
+        BenchReport report(b.name);
+        bool ok = b.run(report, args);
+        std::printf("%s\n", report.ToJson().c_str());
+        std::fflush(stdout);
+        return ok ? 0 : 1;
+    }
+    std::fprintf(stderr, "unknown benchmark '%s'; available:", name.c_str());
+    for (const auto& b : s_benches) std::fprintf(stderr, " %s", b.name);
+    std::fprintf(stderr, "\n");
+    return 2;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Headless benchmarks over the portable modules.
+// Windows: BorderService_test_winrt2.exe --bench <name> [key=value ...] (built with msbuild /p:BorderBench=true)
+// Linux:   see BenchMain.cpp
+// Each run prints one JSON object on stdout. Scenario runs (idle, drag, ...) use the
+// PerformanceResult field names from CustomWindow.Tests so plot_performance.py can chart them.
+
+class BenchReport {
+public:
+    explicit BenchReport(std::string name) : m_name(std::move(name)) {}
+
+    void Add(const std::string& key, double value);
+    void AddText(const std::string& key, const std::string& value);
+    // json must already be a valid JSON value (array / object)
+    void AddJson(const std::string& key, std::string json) { m_fields.emplace_back(key, std::move(json)); }
+    std::string ToJson() const;
+
+private:
+    std::string m_name;
+    std::vector<std::pair<std::string, std::string>> m_fields; // key -> rendered JSON value
+};
+
+// "key=value" arguments after the benchmark name; returns fallback if absent or malformed
+int64_t BenchArg(const std::vector<std::string>& args, const std::string& key, int64_t fallback);
+
+// Monotonic nanoseconds for timing loops
+uint64_t BenchNowNs();
+
+// Returns 0 on success, 1 if the benchmark's own checks failed, 2 for an unknown name
+int RunBench(const std::string& name, const std::vector<std::string>& args);
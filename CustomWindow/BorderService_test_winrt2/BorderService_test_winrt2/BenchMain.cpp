@@ -0,0 +1,47 @@
+#include "Bench.h"
+
+// Non-Windows entry point for the portable benchmarks (Windows: msbuild /p:BorderBench=true, then --bench).
+//   g++ -std=c++17 -O2 -pthread AllocCounter.cpp AppliedLedger.cpp Bench.cpp BenchMain.cpp BorderAtlas.cpp BorderEffects.cpp
+//       BorderEngineAbi.cpp BorderEngineSim.cpp CloakCache.cpp EventClassifier.cpp EventPipeline.cpp ExitRestore.cpp
+//       FrameArena.cpp IdleResources.cpp LatencyTracker.cpp LayoutSnapshot.cpp Metrics.cpp MonitorPartition.cpp
+//       MoveSizeSession.cpp PowerPolicy.cpp ProcessExclusion.cpp RectKernels.cpp SettingsSnapshot.cpp SimBackend.cpp
+//       StartupSnapshot.cpp StyleRules.cpp TierScheduler.cpp TransitionBurst.cpp WindowRegistry.cpp -o border_bench
+//   The same sources minus Bench.cpp / BenchMain.cpp build the engine as a shared object. The version
+//   script makes every dynamic symbol but the BorderEngine.h functions local (-fvisibility=hidden alone
+//   still exports weak std:: template instantiations):
+//   g++ -std=c++17 -O2 -pthread -shared -fPIC -fvisibility=hidden -DBORDER_ENGINE_EXPORTS <sources>
+//       -Wl,--version-script=BorderEngine.map -o libborderengine.so
+//   ./border_bench power steps=100000   (policy priority and transitions)
+//   ./border_bench rules rules=5000 windows=2000
+//   ./border_bench queue producers=8 capacity=512
+//   ./border_bench registry windows=10000 frames=200
+//   ./border_bench classifier
+//   ./border_bench layout readers=4 frames=200000
+//   ./border_bench snapshot readers=4 writers=2 updates=100000
+//   ./border_bench faststart   (startup snapshot round trip, every render mode)
+//   ./border_bench atlas windows=40 frames=200
+//   ./border_bench ledger windows=500
+//   ./border_bench latency frames=20000   (fake clock and compositor)
+//   ./border_bench exit windows=256 workers=4 deadline=150   (shutdown restore, some windows hung)
+//   ./border_bench tiers windows=60 budget=8 interval_ms=8 write_us=300   (foreground-first refresh)
+//   ./border_bench geometry rects=4096 iterations=2000
+//   ./border_bench drag isa=0   (any benchmark on the scalar geometry path; 1 = SSE2, 2 = AVX2)
+//   ./border_bench drag windows=20 seconds=10 timer_ms=150 > bench_drag.json
+//   ./border_bench drag movesize=0   (drags without move/size sessions, for comparison)
+//   ./border_bench alloc windows=30 seconds=24   (fails if a steady-state frame allocates)
+//   ./border_bench desktop windows=100 burst=0   (virtual-desktop switches drawn per batch, for comparison)
+//   ./border_bench drag region=0   (region-less overlay: no region, painter-order draw; any scenario)
+//   ./border_bench minimize idle_ms=10000   (idle release while every window is minimized)
+//   ./border_bench suspend windows=40   (cloak changes while suspended, re-queried on resume)
+//   ./border_bench effects period_ms=1000 region=1   (focused-window pulse / fade, recording compositor)
+//   ./border_bench monitors windows=60 edits=2000 phase_ms=1000   (per-monitor partition and pacing, 60/144/240 Hz)
+//   ./border_bench engine windows=40 rounds=2000   (the BorderEngine.h C ABI, simulated desktop)
+//   (scenarios: idle drag cascade alttab foreground settings alloc desktop minimize suspend; chart with plot_performance.py)
+#ifndef _WIN32
+int main(int argc, char** argv)
+{
+    if (argc < 2) return RunBench("", {});
+    std::vector<std::string> args(argv + 2, argv + argc);
+    return RunBench(argv[1], args);
+}
+#endif
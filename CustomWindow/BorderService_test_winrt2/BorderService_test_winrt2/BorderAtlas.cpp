@@ -0,0 +1,211 @@
+#include "BorderAtlas.h"
+#include <algorithm>
+#include <cmath>
+
+static uint32_t Quantize64(float v)
+{
+    return v <= 0.0f ? 0u : static_cast<uint32_t>(std::lround(v * 64.0f));
+}
+
+static uint32_t Channel(float v)
+{
+    if (v <= 0.0f) return 0u;
+    if (v >= 1.0f) return 255u;
+    return static_cast<uint32_t>(v * 255.0f + 0.5f);
+}
+
+NinePatchKey NinePatchKey::From(const BorderStyle& style, uint32_t dpi)
+{
+    NinePatchKey k;
+    const ColorF& c = style.color;
+    k.color = (Channel(c.a) << 24) | (Channel(c.r) << 16) | (Channel(c.g) << 8) | Channel(c.b);
+    k.thickness64 = Quantize64(style.thickness);
+    k.radius64 = Quantize64(CornerRadius(style.corner));
+    k.dpi = dpi;
+    return k;
+}
+
+size_t NinePatchKeyHash::operator()(const NinePatchKey& k) const noexcept
+{
+    uint64_t h = (static_cast<uint64_t>(k.color) << 32) ^ (static_cast<uint64_t>(k.thickness64) << 16) ^ k.radius64;
+    h ^= static_cast<uint64_t>(k.dpi) * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 29;
+    return static_cast<size_t>(h * 0xBF58476D1CE4E5B9ull);
+}
+
+void NinePatchExtent(float thickness, float radius, int32_t& corner, int32_t& outset)
+{
+    // outset: the outer half of the stroke plus one pixel of anti-aliasing. The inner part
+    // of the corner square must hold both the arc and the inner half of the stroke.
+    const int32_t half = static_cast<int32_t>(std::ceil(thickness * 0.5f)) + 1;
+    outset = half;
+    corner = outset + std::max(static_cast<int32_t>(std::ceil(radius)), half);
+}
+
+// Source-over of a premultiplied pixel
+static inline uint32_t Over(uint32_t src, uint32_t dst)
+{
+    const uint32_t sa = src >> 24;
+    if (sa == 255) return src;
+    if (sa == 0 && src == 0) return dst;
+    const uint32_t inv = 255 - sa;
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t s = (src >> shift) & 0xFF;
+        const uint32_t d = (dst >> shift) & 0xFF;
+        const uint32_t v = s + (d * inv + 127) / 255;
+        out |= std::min(v, 255u) << shift;
+    }
+    return out;
+}
+
+void RasterizeBorder(const WindowRect& rect, float thickness, float radius, uint32_t color, PixelSurface& surface)
+{
+    int32_t corner = 0, outset = 0;
+    NinePatchExtent(thickness, radius, corner, outset);
+
+    const float cx = (rect.left + rect.right) * 0.5f;
+    const float cy = (rect.top + rect.bottom) * 0.5f;
+    const float bx = (rect.right - rect.left) * 0.5f;
+    const float by = (rect.bottom - rect.top) * 0.5f;
+    const float r = std::min(radius, std::min(bx, by));
+    const float half = thickness * 0.5f;
+    const float alpha = static_cast<float>(color >> 24) / 255.0f;
+    const float cr = static_cast<float>((color >> 16) & 0xFF);
+    const float cg = static_cast<float>((color >> 8) & 0xFF);
+    const float cb = static_cast<float>(color & 0xFF);
+
+    // The ring a nine-patch covers: `corner` pixels from each outer edge
+    const int32_t x0 = rect.left - outset, x1 = rect.right + outset;
+    const int32_t y0 = rect.top - outset, y1 = rect.bottom + outset;
+    const int32_t ix0 = x0 + corner, ix1 = x1 - corner, iy0 = y0 + corner, iy1 = y1 - corner;
+
+    for (int32_t y = std::max(y0, 0); y < std::min(y1, surface.height); ++y) {
+        uint32_t* row = surface.pixels + static_cast<ptrdiff_t>(y) * surface.stride;
+        const bool band = y < iy0 || y >= iy1;
+        for (int32_t x = std::max(x0, 0); x < std::min(x1, surface.width); ++x) {
+            if (!band && x >= ix0 && x < ix1) {
+                x = ix1 - 1; // skip the interior
+                continue;
+            }
+            // Signed distance to the rounded rect, at the pixel center
+            const float qx = std::fabs(x + 0.5f - cx) - bx + r;
+            const float qy = std::fabs(y + 0.5f - cy) - by + r;
+            const float ox = std::max(qx, 0.0f), oy = std::max(qy, 0.0f);
+            const float d = std::sqrt(ox * ox + oy * oy) + std::min(std::max(qx, qy), 0.0f) - r;
+            const float coverage = std::min(std::min(std::max(half + 0.5f - std::fabs(d), 0.0f), 1.0f), thickness);
+            if (coverage <= 0.0f) continue;
+            const float a = alpha * coverage;
+            const uint32_t px = (Channel(a) << 24) | (static_cast<uint32_t>(cr * a + 0.5f) << 16) |
+                                (static_cast<uint32_t>(cg * a + 0.5f) << 8) | static_cast<uint32_t>(cb * a + 0.5f);
+            row[x] = Over(px, row[x]);
+        }
+    }
+}
+
+// Splits an extent into (source start, source length, destination start, destination length)
+// for the low corner, the stretched strip and the high corner
+struct Span { int32_t src, srcLen, dst, dstLen; };
+
+static void SplitSpan(int32_t dst0, int32_t dstLen, int32_t corner, int32_t size, Span out[3])
+{
+    int32_t low = corner, high = corner;
+    if (dstLen < 2 * corner) {
+        // Small window: the corners meet in the middle and the strip vanishes
+        low = dstLen / 2;
+        high = dstLen - low;
+    }
+    out[0] = { 0, low, dst0, low };
+    out[1] = { corner, 1, dst0 + low, dstLen - low - high };
+    out[2] = { size - high, high, dst0 + dstLen - high, high };
+}
+
+void ComposeNinePatch(const NinePatchTile& tile, const WindowRect& rect, std::vector<NinePatchBlit>& out)
+{
+    Span cols[3], rows[3];
+    SplitSpan(rect.left - tile.outset, rect.right - rect.left + 2 * tile.outset, tile.corner, tile.size, cols);
+    SplitSpan(rect.top - tile.outset, rect.bottom - rect.top + 2 * tile.outset, tile.corner, tile.size, rows);
+    for (int j = 0; j < 3; ++j) {
+        for (int i = 0; i < 3; ++i) {
+            if (i == 1 && j == 1) continue; // interior
+            if (cols[i].dstLen <= 0 || rows[j].dstLen <= 0) continue;
+            out.push_back({ cols[i].src, rows[j].src, cols[i].srcLen, rows[j].srcLen,
+                            cols[i].dst, rows[j].dst, cols[i].dstLen, rows[j].dstLen });
+        }
+    }
+}
+
+void BlitNinePatch(const NinePatchTile& tile, const std::vector<NinePatchBlit>& blits, PixelSurface& surface)
+{
+    for (const NinePatchBlit& b : blits) {
+        const int32_t x0 = std::max(b.dstX, 0), x1 = std::min(b.dstX + b.dstW, surface.width);
+        const int32_t y0 = std::max(b.dstY, 0), y1 = std::min(b.dstY + b.dstH, surface.height);
+        for (int32_t y = y0; y < y1; ++y) {
+            const int32_t sy = b.srcY + (b.srcH == 1 ? 0 : y - b.dstY);
+            const uint32_t* src = tile.pixels.data() + static_cast<ptrdiff_t>(sy) * tile.size + b.srcX;
+            uint32_t* dst = surface.pixels + static_cast<ptrdiff_t>(y) * surface.stride;
+            if (b.srcW == 1) {
+                const uint32_t px = src[0];
+                if (px) for (int32_t x = x0; x < x1; ++x) dst[x] = Over(px, dst[x]);
+            } else {
+                for (int32_t x = x0; x < x1; ++x) {
+                    const uint32_t px = src[x - b.dstX];
+                    if (px) dst[x] = Over(px, dst[x]);
+                }
+            }
+        }
+    }
+}
+
+const NinePatchTile* BorderAtlas::Acquire(const NinePatchKey& key)
+{
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        ++m_hits;
+        m_tiles.splice(m_tiles.begin(), m_tiles, it->second);
+        return &m_tiles.front();
+    }
+    ++m_misses;
+
+    int32_t corner = 0, outset = 0;
+    NinePatchExtent(key.Thickness(), key.Radius(), corner, outset);
+    if (corner > kMaxNinePatchCorner) return nullptr;
+
+    while (m_tiles.size() >= m_capacity) {
+        m_bytes -= m_tiles.back().Bytes();
+        m_index.erase(m_tiles.back().key);
+        m_tiles.pop_back();
+        ++m_evictions;
+    }
+
+    NinePatchTile tile;
+    tile.id = m_nextId++;
+    tile.key = key;
+    tile.corner = corner;
+    tile.outset = outset;
+    tile.size = 2 * corner + 1;
+    tile.pixels.assign(static_cast<size_t>(tile.size) * tile.size, 0u);
+    PixelSurface s{ tile.pixels.data(), tile.size, tile.size, tile.size };
+    const WindowRect virtualWindow{ outset, outset, tile.size - outset, tile.size - outset };
+    RasterizeBorder(virtualWindow, key.Thickness(), key.Radius(), key.color, s);
+
+    m_bytes += tile.Bytes();
+    m_tiles.push_front(std::move(tile));
+    m_index.emplace(key, m_tiles.begin());
+    return &m_tiles.front();
+}
+
+bool BorderAtlas::Contains(uint64_t id) const
+{
+    for (const NinePatchTile& t : m_tiles) {
+        if (t.id == id) return true;
+    }
+    return false;
+}
+
+void BorderAtlas::Clear()
+{
+    m_tiles.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "StyleRules.h"
+#include "WindowRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Pre-rasterized nine-patch border tiles, one per (color, thickness, radius, DPI), so a
+// frame composes every window's border from a handful of blits instead of stroking
+// anti-aliased rounded geometry per window (DrawBorders). Portable.
+//
+// A tile is the border of a small virtual window, size x size pixels with size = 2*corner+1:
+//
+//   +--------+-+--------+     corner squares are copied as they are;
+//   | corner |s| corner |     the 1-pixel strips s (column / row `corner`) are stretched
+//   +--------+-+--------+     along the window edges; the center pixel is never drawn.
+//   |   s    | |   s    |
+//   +--------+-+--------+     The window rect's edges sit `outset` pixels inside the tile
+//   | corner |s| corner |     edges, so the border reaches `outset` pixels outside the window.
+//   +--------+-+--------+
+//
+// The geometry matches DrawBorders: a stroke of the given thickness centered on the
+// (rounded) window rect. The virtual window is large enough that every pixel of a corner
+// square sees the same distance field as in the real window, so composing is exact for
+// windows at least 2*(corner-outset) pixels wide and high and close for smaller ones.
+
+struct NinePatchKey {
+    uint32_t color = 0;         // 0xAARRGGBB, straight alpha
+    uint32_t thickness64 = 0;   // thickness in 1/64 px
+    uint32_t radius64 = 0;      // corner radius in 1/64 px
+    uint32_t dpi = 96;
+
+    static NinePatchKey From(const BorderStyle& style, uint32_t dpi);
+    float Thickness() const { return thickness64 / 64.0f; }
+    float Radius() const { return radius64 / 64.0f; }
+    bool operator==(const NinePatchKey& o) const
+    {
+        return color == o.color && thickness64 == o.thickness64 && radius64 == o.radius64 && dpi == o.dpi;
+    }
+};
+
+struct NinePatchKeyHash {
+    size_t operator()(const NinePatchKey& k) const noexcept;
+};
+
+struct NinePatchTile {
+    uint64_t id = 0;            // unique per generated tile, never reused (device bitmap cache key)
+    NinePatchKey key;
+    int32_t size = 0;
+    int32_t corner = 0;
+    int32_t outset = 0;
+    std::vector<uint32_t> pixels; // size*size, premultiplied 0xAARRGGBB (BGRA bytes), row-major
+
+    size_t Bytes() const { return pixels.size() * sizeof(uint32_t); }
+};
+
+// Premultiplied 32-bit pixels (BGRA in memory), stride in pixels
+struct PixelSurface {
+    uint32_t* pixels = nullptr;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t stride = 0;
+};
+
+// Source rect in the tile -> destination rect; a 1-pixel source is stretched
+struct NinePatchBlit {
+    int32_t srcX = 0, srcY = 0, srcW = 0, srcH = 0;
+    int32_t dstX = 0, dstY = 0, dstW = 0, dstH = 0;
+};
+
+// Corner square and outset for a style; larger than kMaxNinePatchCorner gets no tile
+static constexpr int32_t kMaxNinePatchCorner = 96;
+void NinePatchExtent(float thickness, float radius, int32_t& corner, int32_t& outset);
+
+// Stroke of the (rounded) rect, drawn source-over into the surface, limited to the ring of
+// pixels a nine-patch would cover (clipped to the surface). The reference rasterizer and
+// the tile generator.
+void RasterizeBorder(const WindowRect& rect, float thickness, float radius, uint32_t color, PixelSurface& surface);
+
+// Appends the (up to 8) blits that draw the tile around rect (surface coordinates)
+void ComposeNinePatch(const NinePatchTile& tile, const WindowRect& rect, std::vector<NinePatchBlit>& out);
+// Software blit of ComposeNinePatch output, source-over, clipped to the surface
+void BlitNinePatch(const NinePatchTile& tile, const std::vector<NinePatchBlit>& blits, PixelSurface& surface);
+
+class BorderAtlas {
+public:
+    explicit BorderAtlas(size_t capacity = 16) : m_capacity(capacity ? capacity : 1) {}
+
+    // Tile for the key, generated on a miss (evicting the least recently used tile when
+    // full). nullptr if the style is too large for a tile. Valid until the next Acquire.
+    const NinePatchTile* Acquire(const NinePatchKey& key);
+    bool Contains(uint64_t id) const;
+    void Clear();
+
+    size_t Size() const { return m_tiles.size(); }
+    size_t Capacity() const { return m_capacity; }
+    size_t Bytes() const { return m_bytes; }
+    uint64_t Hits() const { return m_hits; }
+    uint64_t Misses() const { return m_misses; }
+    uint64_t Evictions() const { return m_evictions; }
+
+private:
+    size_t m_capacity;
+    std::list<NinePatchTile> m_tiles; // most recently used first
+    std::unordered_map<NinePatchKey, std::list<NinePatchTile>::iterator, NinePatchKeyHash> m_index;
+    size_t m_bytes = 0;
+    uint64_t m_nextId = 1;
+    uint64_t m_hits = 0, m_misses = 0, m_evictions = 0;
+};
@@ -0,0 +1,155 @@
+#include "BorderEffects.h"
+#include "RectKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cwctype>
+
+bool ParseBorderEffect(const std::wstring& token, BorderEffect& out)
+{
+    std::wstring t = token;
+    std::transform(t.begin(), t.end(), t.begin(), [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+    const size_t colon = t.find(L':');
+    const std::wstring name = t.substr(0, colon);
+
+    BorderEffect e = out;
+    if (name == L"none" || name == L"off") e.kind = BorderEffectKind::None;
+    else if (name == L"pulse") e.kind = BorderEffectKind::Pulse;
+    else if (name == L"fade") e.kind = BorderEffectKind::Fade;
+    else return false;
+
+    if (colon != std::wstring::npos) {
+        unsigned long ms = 0;
+        try { ms = std::stoul(t.substr(colon + 1)); } catch (...) { return false; }
+        e.periodMs = static_cast<uint32_t>(std::min(std::max(ms, 100ul), 10000ul));
+    }
+    out = e;
+    return true;
+}
+
+void BuildOpacityCurve(const BorderEffect& effect, OpacityCurve& out)
+{
+    out.segments.clear();
+    const float low = std::min(std::max(effect.minOpacity, 0.0f), 1.0f);
+    const double period = effect.periodMs / 1000.0;
+    switch (effect.kind) {
+    case BorderEffectKind::Pulse: {
+        // Opaque at the start, down to `low` half a period later; no end, runs until replaced
+        CurveSegment s;
+        s.kind = CurveSegment::Sinusoidal;
+        s.a = (1.0f + low) * 0.5f;
+        s.b = (1.0f - low) * 0.5f;
+        s.c = static_cast<float>(1.0 / period);
+        s.d = 90.0f;
+        out.segments.push_back(s);
+        break;
+    }
+    case BorderEffectKind::Fade: {
+        // Linear from `low` to opaque, then held
+        CurveSegment s;
+        s.kind = CurveSegment::Cubic;
+        s.a = low;
+        s.b = static_cast<float>((1.0 - low) / period);
+        out.segments.push_back(s);
+        CurveSegment end;
+        end.kind = CurveSegment::End;
+        end.begin = period;
+        end.a = 1.0f;
+        out.segments.push_back(end);
+        break;
+    }
+    case BorderEffectKind::None:
+        break;
+    }
+}
+
+float EvaluateCurve(const OpacityCurve& curve, double seconds)
+{
+    const CurveSegment* active = nullptr;
+    for (const CurveSegment& s : curve.segments) {
+        if (s.begin > seconds) break;
+        active = &s;
+    }
+    if (!active) return curve.segments.empty() ? 1.0f : 0.0f;
+
+    const double t = seconds - active->begin;
+    switch (active->kind) {
+    case CurveSegment::Cubic:
+        return static_cast<float>(active->a + t * (active->b + t * (active->c + t * active->d)));
+    case CurveSegment::Sinusoidal:
+        return static_cast<float>(active->a + active->b * std::sin(2.0 * 3.14159265358979323846 * active->c * t +
+                                                                   active->d * 3.14159265358979323846 / 180.0));
+    case CurveSegment::End:
+        return active->a;
+    }
+    return 1.0f;
+}
+
+bool BorderEffectController::SetEffect(const BorderEffect& effect)
+{
+    if (effect == m_effect) return false;
+    m_effect = effect;
+    BuildOpacityCurve(m_effect, m_curve);
+    // Hidden by the next Update if disabled, restarted with the new curve otherwise
+    m_shown = false;
+    return true;
+}
+
+bool BorderEffectController::Update(uint64_t window, const WindowRect& rect, const BorderStyle& style, EffectCompositor& compositor)
+{
+    if (!Enabled() || window == 0) {
+        const bool touched = m_target != 0 || m_shown;
+        if (touched) compositor.Hide();
+        m_target = 0;
+        m_shown = false;
+        return touched;
+    }
+
+    // Content: the window rect grown by the stroke's whole-pixel extent (as the region's
+    // occluders are), with the window placed at that margin
+    int32_t extent = 0;
+    StrokeExtents(&style.thickness, 1, &extent);
+    const int32_t width = rect.right - rect.left + 2 * extent;
+    const int32_t height = rect.bottom - rect.top + 2 * extent;
+    const int32_t x = rect.left - extent, y = rect.top - extent;
+
+    bool touched = false;
+    if (!m_drawn || width != m_width || height != m_height || style != m_style) {
+        const WindowRect local{ extent, extent, width - extent, height - extent };
+        if (!compositor.DrawBorder(width, height, local, style)) {
+            // Nothing to show; the surface pass keeps drawing this window
+            if (m_shown) compositor.Hide();
+            m_target = 0;
+            m_shown = m_drawn = false;
+            return true;
+        }
+        m_drawn = true;
+        m_width = width;
+        m_height = height;
+        m_style = style;
+        ++m_draws;
+        touched = true;
+    }
+    if (!m_shown || window != m_target || x != m_x || y != m_y) {
+        compositor.Place(x, y);
+        m_x = x;
+        m_y = y;
+        touched = true;
+    }
+    // A pulse keeps its phase across focus changes; a fade starts again on every new window
+    if (!m_shown || (window != m_target && m_effect.kind == BorderEffectKind::Fade)) {
+        compositor.Animate(m_curve);
+        ++m_animations;
+        touched = true;
+    }
+    if (window != m_target) ++m_retargets;
+    m_target = window;
+    m_shown = true;
+    return touched;
+}
+
+void BorderEffectController::Reset(EffectCompositor& compositor)
+{
+    if (m_target != 0 || m_shown) compositor.Hide();
+    m_target = 0;
+    m_shown = m_drawn = false;
+}
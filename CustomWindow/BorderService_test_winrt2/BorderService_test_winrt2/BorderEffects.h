@@ -0,0 +1,100 @@
+#pragma once
+#include "StyleRules.h"
+#include "WindowRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Animated border of the focused window (--effect / SET effect=). Redrawing the surface at
+// the display rate would cost a full CPU pass per frame, so the focused window's border is
+// drawn once into its own visual and the compositor animates that visual's opacity from a
+// curve: after setup the effect costs no draw and no commit. A focus change moves the
+// visual (and restarts a fade); its content is redrawn only when the new window's size or
+// style differs. Portable; the render thread owns the controller (OverlayDComp.cpp drives
+// DirectComposition through EffectCompositor, SimBackend.h a recording fake).
+
+enum class BorderEffectKind : uint8_t { None = 0, Pulse, Fade };
+
+struct BorderEffect {
+    BorderEffectKind kind = BorderEffectKind::None;
+    uint32_t periodMs = 1200;  // pulse: one full cycle; fade: the fade-in
+    float minOpacity = 0.3f;   // low point of the pulse, start of the fade
+
+    bool operator==(const BorderEffect& o) const
+    {
+        return kind == o.kind && periodMs == o.periodMs && minOpacity == o.minOpacity;
+    }
+    bool operator!=(const BorderEffect& o) const { return !(*this == o); }
+};
+
+// "none", "pulse", "fade", optionally ":<period ms>" ("pulse:800"). False (out unchanged)
+// for anything else; the period is clamped to [100, 10000].
+bool ParseBorderEffect(const std::wstring& token, BorderEffect& out);
+
+// A scalar animation as IDCompositionAnimation takes it: segments from their begin offset
+// on, until the next segment or the end
+struct CurveSegment {
+    enum Kind : uint8_t { Cubic, Sinusoidal, End };
+    Kind kind = Cubic;
+    double begin = 0.0; // seconds after the animation starts
+    // Cubic: a + b*t + c*t^2 + d*t^3 with t relative to begin.
+    // Sinusoidal: a + b*sin(2*pi*c*t + d degrees). End: holds a from begin on.
+    float a = 0, b = 0, c = 0, d = 0;
+};
+
+struct OpacityCurve {
+    std::vector<CurveSegment> segments;
+};
+
+void BuildOpacityCurve(const BorderEffect& effect, OpacityCurve& out);
+// The value the compositor shows `seconds` after the animation started
+float EvaluateCurve(const OpacityCurve& curve, double seconds);
+
+// What the controller needs from the compositor. Calls are batched into the frame's own
+// commit; nothing here commits.
+class EffectCompositor {
+public:
+    virtual ~EffectCompositor() = default;
+    // Content of width x height pixels: the stroke around `window` (content coordinates)
+    virtual bool DrawBorder(int32_t width, int32_t height, const WindowRect& window, const BorderStyle& style) = 0;
+    // Content origin in overlay coordinates
+    virtual void Place(int32_t x, int32_t y) = 0;
+    // Starts the curve on the visual's opacity, from its beginning (showing it if hidden)
+    virtual void Animate(const OpacityCurve& curve) = 0;
+    // Opacity 0; the content is kept
+    virtual void Hide() = 0;
+};
+
+class BorderEffectController {
+public:
+    // True if the effect changed; the next Update starts over
+    bool SetEffect(const BorderEffect& effect);
+    const BorderEffect& Effect() const { return m_effect; }
+    bool Enabled() const { return m_effect.kind != BorderEffectKind::None; }
+
+    // The window the effect visual carries (0: none); the surface pass must skip it
+    uint64_t Target() const { return m_target; }
+
+    // Before each overlay frame: the window to carry the effect (0 for none) with its
+    // overlay-coordinate rect and style. Touches the compositor only for what changed;
+    // true if it did.
+    bool Update(uint64_t window, const WindowRect& rect, const BorderStyle& style, EffectCompositor& compositor);
+    // Forgets the target and hides the visual (idle release, lost devices)
+    void Reset(EffectCompositor& compositor);
+
+    uint64_t Retargets() const { return m_retargets; }
+    uint64_t Draws() const { return m_draws; }
+    uint64_t Animations() const { return m_animations; }
+
+private:
+    BorderEffect m_effect;
+    OpacityCurve m_curve;
+    uint64_t m_target = 0;
+    bool m_shown = false;   // content drawn and an animation running
+    bool m_drawn = false;   // m_width / m_height / m_style describe the content
+    int32_t m_width = 0, m_height = 0;
+    BorderStyle m_style;
+    int32_t m_x = 0, m_y = 0;
+    uint64_t m_retargets = 0, m_draws = 0, m_animations = 0;
+};
@@ -0,0 +1,182 @@
+#include "pch.h"
+#include "BorderEngine.h"
+#include "BorderEngineAbi.h"
+#include "Globals.h"
+#include "Args.h"
+#include "EngineHost.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "Pipeline.h"
+#include "Tray.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// BorderEngine.dll (msbuild /p:BorderEngineDll=true): the service's engine on a thread of
+// its own inside the host process. That thread plays the service's main thread: it owns the
+// overlay window and runs its message loop; the intake and render threads are the usual ones.
+
+struct BorderEngine {
+    std::thread thread;
+    DWORD threadId = 0;
+    HANDLE started = nullptr; // set once StartEngine has returned
+    int startResult = 0;
+    std::atomic<bool> running{ false };
+};
+
+static std::mutex s_engineLock;
+static BorderEngine* s_engine = nullptr;
+
+static RenderMode EngineMode(uint32_t mode)
+{
+    switch (mode) {
+    case BORDER_ENGINE_MODE_DWM: return RenderMode::Dwm;
+    case BORDER_ENGINE_MODE_OVERLAY: return RenderMode::DComp;
+    case BORDER_ENGINE_MODE_HYBRID: return RenderMode::Hybrid;
+    }
+    return RenderMode::Auto;
+}
+
+static void EngineThread(BorderEngine* engine)
+{
+    SetThreadDescription(GetCurrentThread(), L"BorderOverlay engine");
+    SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+    // Create the message queue before signalling, so an early Destroy's WM_QUIT is not lost
+    MSG msg{};
+    PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+
+    engine->startResult = StartEngine();
+    engine->running.store(engine->startResult == 0, std::memory_order_release);
+    SetEvent(engine->started);
+    if (engine->startResult == 0) RunEngineLoop();
+    engine->running.store(false, std::memory_order_release);
+    StopEngine();
+    winrt::uninit_apartment();
+}
+
+static int32_t CheckRunning(BorderEngine* engine)
+{
+    if (!engine) return BORDER_ENGINE_INVALID_ARGUMENT;
+    return engine->running.load(std::memory_order_acquire) ? BORDER_ENGINE_OK : BORDER_ENGINE_STOPPED;
+}
+
+static void JoinEngine(BorderEngine* engine)
+{
+    PostThreadMessageW(engine->threadId, WM_QUIT, 0, 0);
+    if (engine->thread.joinable()) engine->thread.join();
+    CloseHandle(engine->started);
+}
+
+extern "C" {
+
+BORDER_ENGINE_API uint32_t BORDER_ENGINE_CALL BorderEngineAbiVersion(void)
+{
+    return BORDER_ENGINE_ABI_VERSION;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineCreate(const BorderEngineSettings* settings, BorderEngine** engine)
+{
+    if (!engine) return BORDER_ENGINE_INVALID_ARGUMENT;
+    *engine = nullptr;
+    if (!ValidEngineSettings(settings)) return BORDER_ENGINE_INVALID_ARGUMENT;
+
+    std::lock_guard<std::mutex> guard(s_engineLock);
+    if (s_engine) return BORDER_ENGINE_BUSY;
+
+    // What ParseArgsAndApply decides for the EXE
+    g_mode = ResolveRenderMode(EngineMode(settings->mode));
+    g_settings.Update([&](BorderSettings& s) { ApplyEngineSettings(*settings, s); });
+
+    std::unique_ptr<BorderEngine> created(new BorderEngine);
+    created->started = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!created->started) return BORDER_ENGINE_FAILED;
+    created->thread = std::thread(EngineThread, created.get());
+    created->threadId = GetThreadId(static_cast<HANDLE>(created->thread.native_handle()));
+    WaitForSingleObject(created->started, INFINITE);
+
+    if (created->startResult != 0) {
+        DebugLogF(L"[Engine] Startup failed (%d)", created->startResult);
+        JoinEngine(created.get());
+        return BORDER_ENGINE_FAILED;
+    }
+    *engine = s_engine = created.release();
+    return BORDER_ENGINE_OK;
+}
+
+BORDER_ENGINE_API void BORDER_ENGINE_CALL BorderEngineDestroy(BorderEngine* engine)
+{
+    if (!engine) return;
+    std::lock_guard<std::mutex> guard(s_engineLock);
+    if (engine != s_engine) return;
+    JoinEngine(engine);
+    delete engine;
+    s_engine = nullptr;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineSetSettings(BorderEngine* engine, const BorderEngineSettings* settings)
+{
+    if (!ValidEngineSettings(settings)) return BORDER_ENGINE_INVALID_ARGUMENT;
+    const int32_t state = CheckRunning(engine);
+    if (state != BORDER_ENGINE_OK) return state;
+    const BorderEngineSettings copy = *settings;
+    PublishSettings([copy](BorderSettings& s) { ApplyEngineSettings(copy, s); });
+    return BORDER_ENGINE_OK;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineSetRules(BorderEngine* engine, const char* rules)
+{
+    const int32_t state = CheckRunning(engine);
+    if (state != BORDER_ENGINE_OK) return state;
+    PostOverlayCommand(L"RULES " + Utf8ToWide(rules));
+    return BORDER_ENGINE_OK;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEnginePushWindowDeltas(BorderEngine* engine, const BorderWindowDelta* deltas, uint32_t count)
+{
+    if (!deltas && count) return BORDER_ENGINE_INVALID_ARGUMENT;
+    const int32_t state = CheckRunning(engine);
+    if (state != BORDER_ENGINE_OK) return state;
+    BorderWindowDelta d;
+    EventRecord e;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!EngineDeltaAt(deltas, i, d)) return BORDER_ENGINE_INVALID_ARGUMENT;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        EngineDeltaAt(deltas, i, d);
+        EngineDeltaEvent(d, e);
+        // The hooks skip this process; its deltas take the hook callback's path instead
+        if (e.event == kEventRefreshRequest) RequestRender();
+        else WinEventProc(nullptr, e.event, KeyHwnd(e.hwnd), e.idObject, CHILDID_SELF, 0, e.timeMs);
+    }
+    return BORDER_ENGINE_OK;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineFlush(BorderEngine* engine, uint32_t timeoutMs)
+{
+    const int32_t state = CheckRunning(engine);
+    if (state != BORDER_ENGINE_OK) return state;
+    // Tasks run before each batch: the first task's batch takes everything queued before it,
+    // so the task it posts runs once that batch has been drawn
+    auto done = std::shared_ptr<void>(CreateEventW(nullptr, TRUE, FALSE, nullptr), CloseHandle);
+    if (!done) return BORDER_ENGINE_FAILED;
+    PostRenderTask([done] { PostRenderTask([done] { SetEvent(done.get()); }); });
+    if (WaitForSingleObject(done.get(), timeoutMs) == WAIT_OBJECT_0) return BORDER_ENGINE_OK;
+    return CheckRunning(engine) == BORDER_ENGINE_OK ? BORDER_ENGINE_TIMEOUT : BORDER_ENGINE_STOPPED;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineGetStats(BorderEngine* engine, BorderEngineStats* stats)
+{
+    if (!engine) return BORDER_ENGINE_INVALID_ARGUMENT;
+    BorderEngineStats full{};
+    full.frames = static_cast<uint64_t>(MetricGet(Metric::AllocFrames));
+    full.redraws = static_cast<uint64_t>(MetricGet(Metric::RenderRedraws));
+    full.windows = static_cast<uint64_t>(MetricGet(Metric::RenderDwmWindows) + MetricGet(Metric::RenderOverlayWindows));
+    full.eventsQueued = static_cast<uint64_t>(MetricGet(Metric::QueuePushed));
+    full.eventsDropped = static_cast<uint64_t>(MetricGet(Metric::QueueDropped));
+    full.settingsVersion = g_settings.Version();
+    full.lastFrameAllocations = static_cast<uint64_t>(MetricGet(Metric::AllocFrame));
+    return CopyEngineStats(full, stats);
+}
+
+} // extern "C"
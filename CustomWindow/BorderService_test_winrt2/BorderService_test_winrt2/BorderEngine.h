@@ -0,0 +1,127 @@
+#pragma once
+#include <stdint.h>
+
+/* C ABI of the border engine, for hosting it in-process (the GUI, on a thread the engine
+ * starts itself) instead of launching the service EXE and talking WM_COPYDATA to it.
+ * Plain C: opaque handle, fixed-width fields, status codes, no exceptions across the
+ * boundary. Stable: structs only ever grow at the end and carry their own size, so a
+ * host compiled against an older header keeps working.
+ *
+ * Windows builds it into BorderEngine.dll (msbuild /p:BorderEngineDll=true) against the
+ * live desktop; the standalone EXE runs the same engine code (EngineHost.h). Elsewhere it
+ * is built against the simulated desktop (SimBackend.h): linked into the bench, whose
+ * "engine" benchmark drives it through these functions only, or as libborderengine.so
+ * (build line in BenchMain.cpp).
+ *
+ * The engine state is process-wide: one engine at a time. Every function may be called
+ * from any thread. */
+
+#if defined(_WIN32)
+#  if defined(BORDER_ENGINE_EXPORTS)
+#    define BORDER_ENGINE_API __declspec(dllexport)
+#  elif defined(BORDER_ENGINE_STATIC)
+#    define BORDER_ENGINE_API
+#  else
+#    define BORDER_ENGINE_API __declspec(dllimport)
+#  endif
+#  define BORDER_ENGINE_CALL __cdecl
+#else
+#  define BORDER_ENGINE_API __attribute__((visibility("default")))
+#  define BORDER_ENGINE_CALL
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BORDER_ENGINE_ABI_VERSION 2u
+
+/* Status codes */
+#define BORDER_ENGINE_OK 0
+#define BORDER_ENGINE_INVALID_ARGUMENT (-1) /* null pointer, short struct size, value out of range */
+#define BORDER_ENGINE_BUSY (-2)             /* an engine already exists in this process */
+#define BORDER_ENGINE_FAILED (-3)           /* startup failed (window, devices, hooks) */
+#define BORDER_ENGINE_TIMEOUT (-4)
+#define BORDER_ENGINE_STOPPED (-5)          /* the engine exited on its own (tray Exit) */
+
+#define BORDER_ENGINE_MODE_AUTO 0u   /* hybrid on Windows 11, overlay before */
+#define BORDER_ENGINE_MODE_DWM 1u
+#define BORDER_ENGINE_MODE_OVERLAY 2u
+#define BORDER_ENGINE_MODE_HYBRID 3u
+
+#define BORDER_ENGINE_CORNER_DEFAULT 0u
+#define BORDER_ENGINE_CORNER_SQUARE 1u
+#define BORDER_ENGINE_CORNER_ROUND 2u
+#define BORDER_ENGINE_CORNER_ROUND_SMALL 3u
+
+typedef struct BorderEngine BorderEngine;
+
+typedef struct BorderEngineSettings {
+    uint32_t size;           /* sizeof(BorderEngineSettings) */
+    uint32_t color;          /* 0xAARRGGBB */
+    float thickness;         /* pixels, (0, 1000) */
+    uint32_t corner;         /* BORDER_ENGINE_CORNER_* */
+    uint32_t foregroundOnly; /* 0 / 1 */
+    uint32_t mode;           /* BORDER_ENGINE_MODE_*; read by BorderEngineCreate only */
+} BorderEngineSettings;
+
+/* Window changes, as the WinEvent hooks would report them */
+#define BORDER_DELTA_SHOWN 1u
+#define BORDER_DELTA_HIDDEN 2u
+#define BORDER_DELTA_MOVED 3u
+#define BORDER_DELTA_FOCUSED 4u
+#define BORDER_DELTA_DESTROYED 5u
+#define BORDER_DELTA_MOVESIZE_START 6u
+#define BORDER_DELTA_MOVESIZE_END 7u
+#define BORDER_DELTA_REFRESH 8u /* re-read every window; hwnd is ignored */
+
+/* The engine's own hooks skip the host process, so an in-process host pushes the changes
+ * of its own windows. The bounds are the window's after the change; the Windows engine
+ * reads the live window instead, the simulated one has nothing else to go by.
+ * Passed as an array: every element's size is the same and is the array's stride, so a
+ * host built against a shorter or longer version of the struct still works (fields past
+ * the host's size read as 0). ABI version 1 had no size field. */
+typedef struct BorderWindowDelta {
+    uint32_t size;   /* sizeof(BorderWindowDelta) */
+    uint32_t kind;   /* BORDER_DELTA_* */
+    uint64_t hwnd;
+    uint32_t timeMs; /* GetTickCount-style event time, 0 if unknown */
+    int32_t left, top, right, bottom;
+} BorderWindowDelta;
+
+typedef struct BorderEngineStats {
+    uint32_t size;                 /* set by the caller: sizeof(BorderEngineStats) */
+    uint32_t reserved;
+    uint64_t frames;               /* render batches handled */
+    uint64_t redraws;              /* batches that drew */
+    uint64_t windows;              /* windows bordered by the last full pass */
+    uint64_t eventsQueued;
+    uint64_t eventsDropped;        /* queue overflow; the next batch resyncs */
+    uint64_t settingsVersion;
+    uint64_t lastFrameAllocations; /* heap allocations of the last frame (alloc.frame) */
+} BorderEngineStats;
+
+BORDER_ENGINE_API uint32_t BORDER_ENGINE_CALL BorderEngineAbiVersion(void);
+
+/* Starts the engine (overlay, hooks, render thread) and draws the first frame before
+ * returning. *engine is null on failure. */
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineCreate(const BorderEngineSettings* settings, BorderEngine** engine);
+/* Stops it, restores what it changed and frees it. Null is ignored. */
+BORDER_ENGINE_API void BORDER_ENGINE_CALL BorderEngineDestroy(BorderEngine* engine);
+
+/* Publishes a new settings snapshot and redraws (mode is ignored) */
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineSetSettings(BorderEngine* engine, const BorderEngineSettings* settings);
+/* Style rules, UTF-8, in the --rules file format; null or "" clears them */
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineSetRules(BorderEngine* engine, const char* rules);
+/* Never blocks; deltas that overflow the queue are counted and covered by a resync.
+ * deltas[0].size gives the stride; an element of another size, or an unknown kind,
+ * rejects the whole call. */
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEnginePushWindowDeltas(BorderEngine* engine, const BorderWindowDelta* deltas, uint32_t count);
+/* Waits until everything pushed or set before the call has been drawn */
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineFlush(BorderEngine* engine, uint32_t timeoutMs);
+/* Fills the first stats->size bytes */
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineGetStats(BorderEngine* engine, BorderEngineStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
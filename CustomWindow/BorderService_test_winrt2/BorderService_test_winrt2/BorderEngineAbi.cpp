@@ -0,0 +1,117 @@
+#include "BorderEngineAbi.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// WinUser.h values, so the conversion stays portable (see EventClassifier.cpp)
+static constexpr uint32_t kEventSystemForeground = 0x0003;
+static constexpr uint32_t kEventSystemMoveSizeStart = 0x000A;
+static constexpr uint32_t kEventSystemMoveSizeEnd = 0x000B;
+static constexpr uint32_t kEventObjectDestroy = 0x8001;
+static constexpr uint32_t kEventObjectShow = 0x8002;
+static constexpr uint32_t kEventObjectHide = 0x8003;
+static constexpr uint32_t kEventObjectLocationChange = 0x800B;
+static constexpr int32_t kObjidWindow = 0;
+
+bool ValidEngineSettings(const BorderEngineSettings* s)
+{
+    // Version 1 of the struct is the smallest a host can pass
+    if (!s || s->size < sizeof(BorderEngineSettings)) return false;
+    if (!(s->thickness > 0.0f && s->thickness < 1000.0f)) return false;
+    return s->corner <= BORDER_ENGINE_CORNER_ROUND_SMALL && s->mode <= BORDER_ENGINE_MODE_HYBRID;
+}
+
+static ColorF EngineColor(uint32_t argb)
+{
+    return { ((argb >> 16) & 0xFF) / 255.0f, ((argb >> 8) & 0xFF) / 255.0f, (argb & 0xFF) / 255.0f, (argb >> 24) / 255.0f };
+}
+
+void ApplyEngineSettings(const BorderEngineSettings& in, BorderSettings& out)
+{
+    out.color = EngineColor(in.color);
+    out.thickness = in.thickness;
+    out.cornerToken = CornerStyleToken(static_cast<CornerStyle>(in.corner));
+    out.foregroundOnly = in.foregroundOnly != 0;
+}
+
+BorderStyle EngineStyle(const BorderEngineSettings& in)
+{
+    BorderStyle s;
+    s.color = EngineColor(in.color);
+    s.thickness = in.thickness;
+    s.corner = static_cast<CornerStyle>(in.corner);
+    return s;
+}
+
+bool EngineDeltaAt(const BorderWindowDelta* deltas, uint32_t i, BorderWindowDelta& out)
+{
+    // The fields of ABI version 2; anything added later is zero for older hosts
+    static constexpr uint32_t kMinSize = offsetof(BorderWindowDelta, bottom) + sizeof(int32_t);
+    if (!deltas) return false;
+    const uint32_t stride = deltas[0].size;
+    if (stride < kMinSize) return false;
+    const unsigned char* element = reinterpret_cast<const unsigned char*>(deltas) + static_cast<size_t>(stride) * i;
+    uint32_t size = 0;
+    std::memcpy(&size, element, sizeof(size));
+    if (size != stride) return false;
+    out = BorderWindowDelta{};
+    std::memcpy(&out, element, std::min<size_t>(stride, sizeof(out)));
+    out.size = sizeof(out);
+    EventRecord e;
+    return EngineDeltaEvent(out, e);
+}
+
+bool EngineDeltaEvent(const BorderWindowDelta& d, EventRecord& out)
+{
+    static const uint32_t kEvents[] = {
+        0,                          // (unused)
+        kEventObjectShow,           // BORDER_DELTA_SHOWN
+        kEventObjectHide,           // BORDER_DELTA_HIDDEN
+        kEventObjectLocationChange, // BORDER_DELTA_MOVED
+        kEventSystemForeground,     // BORDER_DELTA_FOCUSED
+        kEventObjectDestroy,        // BORDER_DELTA_DESTROYED
+        kEventSystemMoveSizeStart,  // BORDER_DELTA_MOVESIZE_START
+        kEventSystemMoveSizeEnd,    // BORDER_DELTA_MOVESIZE_END
+        kEventRefreshRequest,       // BORDER_DELTA_REFRESH
+    };
+    if (d.kind == 0 || d.kind >= sizeof(kEvents) / sizeof(kEvents[0])) return false;
+    out = EventRecord{};
+    out.event = kEvents[d.kind];
+    if (d.kind != BORDER_DELTA_REFRESH) {
+        out.idObject = kObjidWindow;
+        out.hwnd = d.hwnd;
+        out.timeMs = d.timeMs;
+    }
+    return true;
+}
+
+std::wstring Utf8ToWide(const char* s)
+{
+    std::wstring out;
+    if (!s) return out;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+    while (*p) {
+        uint32_t cp = *p++;
+        int extra = cp >= 0xF0 ? 3 : cp >= 0xE0 ? 2 : cp >= 0xC0 ? 1 : 0;
+        if (extra) cp &= 0x3F >> extra;
+        for (; extra > 0 && (*p & 0xC0) == 0x80; --extra) cp = (cp << 6) | (*p++ & 0x3F);
+        if (extra) cp = 0xFFFD; // truncated sequence
+        if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+            cp -= 0x10000;
+            out.push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+            out.push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+        } else {
+            out.push_back(static_cast<wchar_t>(cp));
+        }
+    }
+    return out;
+}
+
+int32_t CopyEngineStats(const BorderEngineStats& full, BorderEngineStats* out)
+{
+    if (!out || out->size < offsetof(BorderEngineStats, frames)) return BORDER_ENGINE_INVALID_ARGUMENT;
+    const uint32_t size = out->size;
+    std::memcpy(out, &full, size < sizeof(full) ? size : sizeof(full));
+    out->size = size;
+    return BORDER_ENGINE_OK;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "BorderEngine.h"
+#include "EventPipeline.h"
+#include "SettingsSnapshot.h"
+#include <string>
+
+// Conversions between the C ABI (BorderEngine.h) and the engine's own types, shared by the
+// Windows engine (BorderEngine.cpp) and the simulated one (BorderEngineSim.cpp). Portable.
+
+// False for a null or short struct or a value out of range
+bool ValidEngineSettings(const BorderEngineSettings* s);
+// The border fields (color, thickness, corner, foregroundOnly) of a settings snapshot
+void ApplyEngineSettings(const BorderEngineSettings& in, BorderSettings& out);
+BorderStyle EngineStyle(const BorderEngineSettings& in);
+// Validates a BorderEnginePushWindowDeltas array and copies element i into out, zero-filled
+// past the host's size. False for a null array, a size shorter than the original fields
+// or differing from deltas[0].size, or an unknown kind.
+bool EngineDeltaAt(const BorderWindowDelta* deltas, uint32_t i, BorderWindowDelta& out);
+// The WinEvent the hooks report for a delta (kEventRefreshRequest for BORDER_DELTA_REFRESH).
+// False for an unknown kind.
+bool EngineDeltaEvent(const BorderWindowDelta& d, EventRecord& out);
+std::wstring Utf8ToWide(const char* s);
+// Copies the first out->size bytes of full, keeping out->size
+int32_t CopyEngineStats(const BorderEngineStats& full, BorderEngineStats* out);
@@ -0,0 +1,179 @@
+// BorderEngine.h against the simulated desktop (SimBackend.h), for builds without Windows.
+// The host's window deltas become SimDesktop mutations, so the engine sees the WinEvents
+// Windows would report for them; Flush runs the render thread's frame inline.
+#ifndef _WIN32
+#include "BorderEngine.h"
+#include "BorderEngineAbi.h"
+#include "SimBackend.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct BorderEngine {
+    // The host's windows can be anywhere on the virtual screen
+    SimDesktop desktop{ WindowRect{ -32768, -32768, 32767, 32767 } };
+    SimService service{ desktop };
+    std::unordered_map<uint64_t, uint64_t> windows; // host handle -> simulated window
+    std::vector<EventRecord> events;                // scratch
+    std::mutex lock;
+    uint64_t frames = 0;
+    uint64_t queued = 0;
+    uint64_t settingsVersion = 1;
+};
+
+static std::mutex s_engineLock;
+static BorderEngine* s_engine = nullptr;
+
+static void OfferAll(BorderEngine& engine)
+{
+    for (const EventRecord& e : engine.events) {
+        if (engine.service.Offer(e)) ++engine.queued;
+    }
+    engine.events.clear();
+}
+
+static void OfferRefresh(BorderEngine& engine)
+{
+    engine.events.push_back(EventRecord{});
+    OfferAll(engine);
+}
+
+static void ApplyDelta(BorderEngine& engine, const BorderWindowDelta& d)
+{
+    const WindowRect rc{ d.left, d.top, d.right, d.bottom };
+    auto it = engine.windows.find(d.hwnd);
+    const uint64_t sim = it == engine.windows.end() ? 0 : it->second;
+    switch (d.kind) {
+    case BORDER_DELTA_SHOWN:
+        if (sim) engine.desktop.MoveTo(sim, rc, engine.events);
+        else engine.windows.emplace(d.hwnd, engine.desktop.Create(rc, L"host.exe", L"HostWindow", L"", engine.events));
+        break;
+    case BORDER_DELTA_HIDDEN:
+    case BORDER_DELTA_DESTROYED:
+        // The simulated desktop has no hidden windows; SHOWN brings it back
+        if (sim) {
+            engine.desktop.Destroy(sim, engine.events);
+            engine.windows.erase(it);
+        }
+        break;
+    case BORDER_DELTA_MOVED:
+        if (sim) engine.desktop.MoveTo(sim, rc, engine.events);
+        break;
+    case BORDER_DELTA_FOCUSED:
+        if (sim) engine.desktop.Activate(sim, engine.events);
+        break;
+    case BORDER_DELTA_MOVESIZE_START:
+        if (sim) engine.desktop.BeginMoveSize(sim, engine.events);
+        break;
+    case BORDER_DELTA_MOVESIZE_END:
+        if (sim) engine.desktop.EndMoveSize(sim, engine.events);
+        break;
+    case BORDER_DELTA_REFRESH:
+        engine.events.push_back(EventRecord{});
+        break;
+    }
+    OfferAll(engine);
+}
+
+static void RunFrame(BorderEngine& engine)
+{
+    engine.service.RunFrame();
+    ++engine.frames;
+}
+
+extern "C" {
+
+BORDER_ENGINE_API uint32_t BORDER_ENGINE_CALL BorderEngineAbiVersion(void)
+{
+    return BORDER_ENGINE_ABI_VERSION;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineCreate(const BorderEngineSettings* settings, BorderEngine** engine)
+{
+    if (!engine) return BORDER_ENGINE_INVALID_ARGUMENT;
+    *engine = nullptr;
+    if (!ValidEngineSettings(settings)) return BORDER_ENGINE_INVALID_ARGUMENT;
+
+    std::lock_guard<std::mutex> guard(s_engineLock);
+    if (s_engine) return BORDER_ENGINE_BUSY;
+    std::unique_ptr<BorderEngine> created(new BorderEngine);
+    created->service.ApplySettings(EngineStyle(*settings), settings->foregroundOnly != 0);
+    OfferRefresh(*created);
+    RunFrame(*created);
+    *engine = s_engine = created.release();
+    return BORDER_ENGINE_OK;
+}
+
+BORDER_ENGINE_API void BORDER_ENGINE_CALL BorderEngineDestroy(BorderEngine* engine)
+{
+    if (!engine) return;
+    std::lock_guard<std::mutex> guard(s_engineLock);
+    if (engine != s_engine) return;
+    delete s_engine;
+    s_engine = nullptr;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineSetSettings(BorderEngine* engine, const BorderEngineSettings* settings)
+{
+    if (!engine || !ValidEngineSettings(settings)) return BORDER_ENGINE_INVALID_ARGUMENT;
+    std::lock_guard<std::mutex> guard(engine->lock);
+    engine->service.ApplySettings(EngineStyle(*settings), settings->foregroundOnly != 0);
+    ++engine->settingsVersion;
+    OfferRefresh(*engine);
+    return BORDER_ENGINE_OK;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineSetRules(BorderEngine* engine, const char* rules)
+{
+    if (!engine) return BORDER_ENGINE_INVALID_ARGUMENT;
+    const std::wstring text = Utf8ToWide(rules);
+    std::lock_guard<std::mutex> guard(engine->lock);
+    engine->service.ApplyRules(text);
+    OfferRefresh(*engine);
+    return BORDER_ENGINE_OK;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEnginePushWindowDeltas(BorderEngine* engine, const BorderWindowDelta* deltas, uint32_t count)
+{
+    if (!engine || (!deltas && count)) return BORDER_ENGINE_INVALID_ARGUMENT;
+    BorderWindowDelta d;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!EngineDeltaAt(deltas, i, d)) return BORDER_ENGINE_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> guard(engine->lock);
+    for (uint32_t i = 0; i < count; ++i) {
+        EngineDeltaAt(deltas, i, d);
+        ApplyDelta(*engine, d);
+    }
+    return BORDER_ENGINE_OK;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineFlush(BorderEngine* engine, uint32_t timeoutMs)
+{
+    (void)timeoutMs; // the frame runs on the calling thread
+    if (!engine) return BORDER_ENGINE_INVALID_ARGUMENT;
+    std::lock_guard<std::mutex> guard(engine->lock);
+    RunFrame(*engine);
+    return BORDER_ENGINE_OK;
+}
+
+BORDER_ENGINE_API int32_t BORDER_ENGINE_CALL BorderEngineGetStats(BorderEngine* engine, BorderEngineStats* stats)
+{
+    if (!engine) return BORDER_ENGINE_INVALID_ARGUMENT;
+    BorderEngineStats full{};
+    {
+        std::lock_guard<std::mutex> guard(engine->lock);
+        full.frames = engine->frames;
+        full.redraws = engine->service.Redraws();
+        full.windows = engine->service.Windows().Size();
+        full.eventsQueued = engine->queued;
+        full.eventsDropped = engine->service.Dropped();
+        full.settingsVersion = engine->settingsVersion;
+        full.lastFrameAllocations = engine->service.LastFrameAllocations();
+    }
+    return CopyEngineStats(full, stats);
+}
+
+} // extern "C"
+#endif
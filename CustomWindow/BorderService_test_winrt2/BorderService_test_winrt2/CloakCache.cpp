@@ -0,0 +1,34 @@
+#include "CloakCache.h"
+
+void CloakCache::Note(uint64_t hwnd, bool cloaked)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_cloaked[hwnd] = cloaked;
+}
+
+void CloakCache::Forget(uint64_t hwnd)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_cloaked.erase(hwnd);
+}
+
+void CloakCache::Clear()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_cloaked.clear();
+}
+
+bool CloakCache::Find(uint64_t hwnd, bool& cloaked) const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto it = m_cloaked.find(hwnd);
+    if (it == m_cloaked.end()) return false;
+    cloaked = it->second;
+    return true;
+}
+
+size_t CloakCache::Size() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_cloaked.size();
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+// DWMWA_CLOAKED per window. The CLOAKED / UNCLOAKED hooks keep it current, so a desktop
+// switch re-enumerates without a DWM round trip per window; windows no event has covered
+// yet are queried once and noted. Only as good as the events that fed it: whoever drops
+// them (a queue overflow, a suspension with the hooks down) clears it. Portable; any
+// thread (DwmUtil.cpp, SimService).
+class CloakCache {
+public:
+    void Note(uint64_t hwnd, bool cloaked);
+    // Re-queried on the window's next check (destroyed: the value is reused)
+    void Forget(uint64_t hwnd);
+    void Clear();
+    // False if nothing is known about the window
+    bool Find(uint64_t hwnd, bool& cloaked) const;
+    size_t Size() const;
+
+private:
+    mutable std::mutex m_lock;
+    std::unordered_map<uint64_t, bool> m_cloaked;
+};
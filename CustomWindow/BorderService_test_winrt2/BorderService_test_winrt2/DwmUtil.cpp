@@ -3,13 +3,48 @@
 #include "Logging.h"
 #include "DwmUtil.h"
 #include "Args.h"
+#include "CloakCache.h"
+#include "Metrics.h"
+#include "ProcessFilter.h"
+#include "WindowStyles.h"
+#include "LayoutPublisher.h"
+#include "LedgerFile.h"
+#include "OverlayDComp.h"
+#include "Pipeline.h"
+#include "RectKernels.h"
+#include "TierScheduler.h"
+#include <chrono>
+
+static CloakCache s_cloaked;
+
+void NoteWindowCloak(HWND h, bool cloaked)
+{
+    s_cloaked.Note(HwndKey(h), cloaked);
+}
+
+void ForgetWindowCloak(HWND h)
+{
+    s_cloaked.Forget(HwndKey(h));
+}
+
+void ClearCloakCache()
+{
+    s_cloaked.Clear();
+}
 
 static bool IsWindowCloaked(HWND h)
 {
+    bool cached = false;
+    if (s_cloaked.Find(HwndKey(h), cached)) {
+        MetricAdd(Metric::CloakCacheHits);
+        return cached;
+    }
+    MetricAdd(Metric::CloakQueries);
     BOOL cloaked = FALSE;
-    if (SUCCEEDED(DwmGetWindowAttribute(h, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))))
-        return cloaked != FALSE;
-    return false;
+    if (FAILED(DwmGetWindowAttribute(h, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))))
+        return false;
+    NoteWindowCloak(h, cloaked != FALSE);
+    return cloaked != FALSE;
 }
 
 bool IsAltTabEligible(HWND h)
@@ -38,45 +73,70 @@ bool GetWindowBounds(HWND h, RECT& out)
     return GetWindowRect(h, &out) != 0;
 }
 
-std::vector<HWND> CollectUserVisibleWindows()
+// Candidates go straight into out; the ones off the virtual screen or, in foreground-only
+// mode, outside the foreground window are then compacted away in place. The bounds columns
+// are pooled per thread, so a steady frame allocates nothing but out itself.
+template <typename Vec>
+static void CollectUserVisibleWindowsInto(Vec& out)
 {
-    std::vector<HWND> result;
+    out.clear();
     HWND foregroundWnd = nullptr;
-    if (g_foregroundWindowOnly) {
+    const bool foregroundOnly = g_settings.Read()->foregroundOnly;
+    if (foregroundOnly) {
         foregroundWnd = GetForegroundWindow();
     }
+
+    static thread_local RectColumns s_bounds, s_clipped;
+    static thread_local std::vector<uint8_t> s_onScreen;
+    static thread_local size_t s_lastCount = 0;
+    s_bounds.Clear();
+    out.reserve(s_lastCount + 16);
+
+    size_t excludedCount = 0;
+    struct EnumCtx { Vec* vec; RectColumns* bounds; size_t* excluded; } ctx{ &out, &s_bounds, &excludedCount };
     
     EnumWindows([](HWND h, LPARAM lParam) -> BOOL {
-        auto& vec = *reinterpret_cast<std::vector<HWND>*>(lParam);
+        auto& c = *reinterpret_cast<EnumCtx*>(lParam);
         if (!IsAltTabEligible(h)) return TRUE;
+        if (IsWindowExcluded(h)) { ++*c.excluded; return TRUE; }
         RECT rc{};
         if (!GetWindowBounds(h, rc)) return TRUE;
-
-        RECT inter{};
-        if (IntersectRect(&inter, &rc, &g_virtualScreen) && (inter.right > inter.left) && (inter.bottom > inter.top))
-        {
-            vec.push_back(h);
-        }
+        c.vec->push_back(h);
+        c.bounds->Push({ rc.left, rc.top, rc.right, rc.bottom });
         return TRUE;
-    }, reinterpret_cast<LPARAM>(&result));
+    }, reinterpret_cast<LPARAM>(&ctx));
+    MetricSet(Metric::ExclusionExcludedWindows, static_cast<int64_t>(excludedCount));
+
+    // Virtual-screen intersection for every candidate at once (IntersectRect per window before)
+    s_lastCount = out.size();
+    s_onScreen.resize(out.size());
+    ClipRects(s_bounds, { g_virtualScreen.left, g_virtualScreen.top, g_virtualScreen.right, g_virtualScreen.bottom },
+              s_clipped, s_onScreen.data());
 
     // ׶ â  尡 Ȱȭ , ׶ â ͸
-    if (g_foregroundWindowOnly && foregroundWnd != nullptr)
-    {
-        std::vector<HWND> filtered;
-        for (HWND h : result)
-        {
-            if (h == foregroundWnd || GetAncestor(h, GA_ROOT) == foregroundWnd)
-            {
-                filtered.push_back(h);
-            }
-        }
-        return filtered;
+    const bool filterForeground = foregroundOnly && foregroundWnd != nullptr;
+    size_t kept = 0;
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (!s_onScreen[i]) continue;
+        HWND h = out[i];
+        if (filterForeground && h != foregroundWnd && GetAncestor(h, GA_ROOT) != foregroundWnd) continue;
+        out[kept++] = h;
     }
+    out.resize(kept);
+}
 
+std::vector<HWND> CollectUserVisibleWindows()
+{
+    std::vector<HWND> result;
+    CollectUserVisibleWindowsInto(result);
     return result;
 }
 
+void CollectUserVisibleWindows(ArenaVector<HWND>& out)
+{
+    CollectUserVisibleWindowsInto(out);
+}
+
 COLORREF ToCOLORREF(const D2D1_COLOR_F& c)
 {
     BYTE r = (BYTE)std::clamp((int)std::lround(c.r * 255.0f), 0, 255);
@@ -85,64 +145,214 @@ COLORREF ToCOLORREF(const D2D1_COLOR_F& c)
     return RGB(r, g, b);
 }
 
-void ApplyDwmAttributesToTargets(const std::vector<HWND>& targets)
+static TierScheduler s_tiers; // render thread, or main before it starts
+
+static uint64_t SteadyNowNs()
 {
-    if (g_mode != RenderMode::Dwm) return;
-    COLORREF cr = ToCOLORREF(g_borderColor);
-    int thick = (int)g_thickness;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// What the slot's resolved style asks DWM for
+static AppliedBorder DesiredBorder(WindowRegistry::Slot s)
+{
+    const BorderStyle& style = g_windows.Style(s);
+    int thick = (int)style.thickness;
     if (thick < 1) thick = 1; else if (thick > 1000) thick = 1000;
+    return { ToCOLORREF(ToD2DColor(style.color)), thick, style.corner };
+}
+
+static bool IsApplied(WindowRegistry::Slot s, const AppliedBorder& desired)
+{
+    const AppliedBorder& applied = g_windows.Applied(s);
+    return (g_windows.Flags(s) & WindowRegistry::kApplied) && applied.color == desired.color &&
+           applied.thickness == desired.thickness && applied.corner == desired.corner;
+}
+
+// Writes the desired border; true if DWM took it (the ledger changed)
+static bool WriteDwmBorder(HWND h, WindowRegistry::Slot s, const AppliedBorder& desired, bool hybrid)
+{
+    uint32_t& flags = g_windows.Flags(s);
+    AppliedBorder& applied = g_windows.Applied(s);
+    const bool known = (flags & WindowRegistry::kApplied) != 0;
+    COLORREF cr = desired.color;
+    int thick = desired.thickness;
+    const bool cornerChanged = (!known || applied.corner != desired.corner);
+    HRESULT hr1 = DwmSetWindowAttribute(h, DWMWA_BORDER_COLOR, &cr, sizeof(cr));
+    HRESULT hr2 = DwmSetWindowAttribute(h, DWMWA_VISIBLE_FRAME_BORDER_THICKNESS, &thick, sizeof(thick));
+    if (cornerChanged) ApplyCornerPreference(h, desired.corner);
+    bool changed = false;
+    if (SUCCEEDED(hr1) || SUCCEEDED(hr2)) {
+        applied = desired;
+        flags |= WindowRegistry::kApplied;
+        changed = true;
+        DebugLogF(L"[DWM] Applied border to window 0x%zX", reinterpret_cast<uintptr_t>(h));
+    }
+    if (hybrid && FAILED(hr1)) {
+        flags |= WindowRegistry::kOverlay;
+        DebugLogF(L"[Hybrid] DWM refused the border color for window 0x%zX (hr=%ld), drawing it on the overlay",
+                  reinterpret_cast<uintptr_t>(h), static_cast<long>(hr1));
+    }
+    return changed;
+}
+
+static size_t CountOverlayWindows()
+{
+    size_t overlayWindows = 0;
+    for (WindowRegistry::Slot s : g_windows.Order()) {
+        if (g_windows.Flags(s) & WindowRegistry::kOverlay) ++overlayWindows;
+    }
+    return overlayWindows;
+}
+
+void ApplyDwmAttributesToTargets(const HWND* targets, size_t count)
+{
+    if (!UsesDwmAttributes()) return;
+    const bool hybrid = g_mode == RenderMode::Hybrid;
+    // One settings snapshot for the whole pass; a newer one makes the rest of it stale
+    const auto settings = g_settings.Read();
 
     // ο    (targets ̹ CollectUserVisibleWindows ͸)
-    std::unordered_set<HWND, HwndHash, HwndEq> newTargets;
+    g_windows.BeginPass();
+    bool ledgerChanged = false;
+    // Out-of-date windows, tiered: the foreground window and the popups it owns first
+    static std::vector<TierItem> s_dirty;
+    static std::vector<uint64_t> s_foreground;
+    s_dirty.clear();
+    s_foreground.clear();
+    const uint64_t passNs = SteadyNowNs();
+    HWND foreground = GetForegroundWindow();
+    HWND foregroundRoot = foreground ? GetAncestor(foreground, GA_ROOTOWNER) : nullptr;
 
-    for (HWND h : targets) {
+    for (size_t i = 0; i < count; ++i) {
+        HWND h = targets[i];
+        if (settings.Superseded()) {
+            // The writer queued a refresh; leave the ledger as it is and let that pass finish the job
+            MetricAdd(Metric::SettingsPassesAbandoned);
+            DebugLogF(L"[DWM] Pass for settings v%llu abandoned", static_cast<unsigned long long>(settings->version));
+            return;
+        }
         if (!IsWindow(h)) continue;
-        
-        newTargets.insert(h);
-        
-        auto it = g_applied.find(h);
-        if (it != g_applied.end() && it->second.color == cr && it->second.thickness == thick) {
-            continue; // already applied with same settings
+
+        const WindowRegistry::Slot s = g_windows.Acquire(HwndKey(h));
+        g_windows.Visit(s);
+        if (hybrid) {
+            // The overlay draws fallbacks from the rect column and clips them against every window above
+            RECT rc{};
+            if (GetWindowBounds(h, rc)) g_windows.Rect(s) = { rc.left, rc.top, rc.right, rc.bottom };
         }
-        HRESULT hr1 = DwmSetWindowAttribute(h, DWMWA_BORDER_COLOR, &cr, sizeof(cr));
-        HRESULT hr2 = DwmSetWindowAttribute(h, DWMWA_VISIBLE_FRAME_BORDER_THICKNESS, &thick, sizeof(thick));
-        if (SUCCEEDED(hr1) || SUCCEEDED(hr2)) {
-            g_applied[h] = { cr, thick };
-            DebugLog(L"[DWM] Applied border to window 0x" + std::to_wstring(reinterpret_cast<uintptr_t>(h)));
+
+        // Per-window style (global settings + matching style rule)
+        const BorderStyle style = ResolveWindowStyle(h, *settings);
+        g_windows.Style(s) = style;
+        uint32_t& flags = g_windows.Flags(s);
+        const bool adopted = (flags & WindowRegistry::kAdopted) != 0;
+        flags &= ~WindowRegistry::kAdopted;
+        if (flags & WindowRegistry::kOverlay) continue; // DWM refused it once; the overlay keeps it while it lives
+
+        if (IsApplied(s, DesiredBorder(s))) {
+            if (adopted) MetricAdd(Metric::LedgerSkipped); // the previous instance already wrote it
+            continue; // already applied with same settings
         }
+        s_dirty.push_back({ HwndKey(h), foregroundRoot && GetAncestor(h, GA_ROOTOWNER) == foregroundRoot });
     }
 
-    // ο   Ե  â ⺻ 
-    for (auto it = g_applied.begin(); it != g_applied.end(); ) {
-        if (!IsWindow(it->first)) {
-            it = g_applied.erase(it);
-            continue;
-        }
-        
-        // ο   Ե  â ⺻ 
-        if (newTargets.find(it->first) == newTargets.end()) {
-            COLORREF defaultColor = DWMWA_COLOR_DEFAULT; // ⺻  (ý ⺻)
-            int defaultThick = 1; // ⺻ β
-            DwmSetWindowAttribute(it->first, DWMWA_BORDER_COLOR, &defaultColor, sizeof(defaultColor));
-            DwmSetWindowAttribute(it->first, DWMWA_VISIBLE_FRAME_BORDER_THICKNESS, &defaultThick, sizeof(defaultThick));
-            DebugLog(L"[DWM] Restored default border for window 0x" + std::to_wstring(reinterpret_cast<uintptr_t>(it->first)));
-            it = g_applied.erase(it);
-        } else {
-            ++it;
-        }
+    // Foreground tier now; the rest is left to RunDwmBackgroundSlice
+    s_tiers.Plan(s_dirty, passNs, s_foreground);
+    for (uint64_t key : s_foreground) {
+        const WindowRegistry::Slot s = g_windows.Find(key);
+        if (WriteDwmBorder(KeyHwnd(key), s, DesiredBorder(s), hybrid)) ledgerChanged = true;
     }
+    s_tiers.ForegroundDone(SteadyNowNs());
+    MetricSet(Metric::TierForegroundWindows, static_cast<int64_t>(s_tiers.ForegroundWindows()));
+    MetricSet(Metric::TierForegroundUs, static_cast<int64_t>(s_tiers.ForegroundNs() / 1000));
+    MetricSet(Metric::TierBacklog, static_cast<int64_t>(s_tiers.Backlog()));
+    MetricMax(Metric::TierBacklogMax, static_cast<int64_t>(s_tiers.Backlog()));
+
+    // ο   Ե  â ⺻ 
+    g_windows.SweepUnvisited([&ledgerChanged](WindowRegistry::Slot s) {
+        HWND h = KeyHwnd(g_windows.Handle(s));
+        if (!(g_windows.Flags(s) & WindowRegistry::kApplied)) return;
+        ledgerChanged = true;
+        if (!IsWindow(h)) return;
+        // Also covers windows the previous instance bordered that are no longer targets
+        if (g_windows.Flags(s) & WindowRegistry::kAdopted) MetricAdd(Metric::LedgerRestored);
+        COLORREF defaultColor = DWMWA_COLOR_DEFAULT; // ⺻  (ý ⺻)
+        int defaultThick = 1; // ⺻ β
+        DwmSetWindowAttribute(h, DWMWA_BORDER_COLOR, &defaultColor, sizeof(defaultColor));
+        DwmSetWindowAttribute(h, DWMWA_VISIBLE_FRAME_BORDER_THICKNESS, &defaultThick, sizeof(defaultThick));
+        DebugLogF(L"[DWM] Restored default border for window 0x%zX", reinterpret_cast<uintptr_t>(h));
+    });
+    const size_t overlayWindows = CountOverlayWindows();
+    MetricSet(Metric::RenderDwmWindows, static_cast<int64_t>(g_windows.Order().size() - overlayWindows));
+    MetricSet(Metric::RenderOverlayWindows, static_cast<int64_t>(overlayWindows));
+    if (ledgerChanged) SaveAppliedLedger();
+    PublishLayout();
+    if (hybrid) RefreshHybridOverlay(overlayWindows, *settings);
     
-    DebugLog(L"[DWM] Applied borders to " + std::to_wstring(newTargets.size()) + 
-             L" windows, total tracked: " + std::to_wstring(g_applied.size()));
+    DebugLogF(L"[DWM] Applied borders to %zu windows (%zu on the overlay), total tracked: %zu, %zu deferred",
+              g_windows.Order().size(), overlayWindows, g_windows.Size(), s_tiers.Backlog());
+}
+
+bool RunDwmBackgroundSlice(uint64_t nowNs)
+{
+    if (!UsesDwmAttributes()) return false;
+    static std::vector<uint64_t> s_slice;
+    s_slice.clear();
+    if (!s_tiers.NextSlice(nowNs, s_slice)) return false;
+    const bool hybrid = g_mode == RenderMode::Hybrid;
+
+    bool ledgerChanged = false;
+    bool overlayAdded = false;
+    for (uint64_t key : s_slice) {
+        // Destroyed, swept or rewritten since the pass deferred it
+        const WindowRegistry::Slot s = g_windows.Find(key);
+        if (s == WindowRegistry::kNoSlot || (g_windows.Flags(s) & WindowRegistry::kOverlay)) continue;
+        HWND h = KeyHwnd(key);
+        if (!IsWindow(h)) continue;
+        const AppliedBorder desired = DesiredBorder(s);
+        if (IsApplied(s, desired)) continue;
+        if (WriteDwmBorder(h, s, desired, hybrid)) ledgerChanged = true;
+        if (g_windows.Flags(s) & WindowRegistry::kOverlay) overlayAdded = true;
+    }
+
+    MetricAdd(Metric::TierSlices);
+    MetricAdd(Metric::TierBackgroundWindows, static_cast<int64_t>(s_slice.size()));
+    MetricSet(Metric::TierBacklog, static_cast<int64_t>(s_tiers.Backlog()));
+    if (!s_tiers.Backlog()) MetricSet(Metric::TierDrainUs, static_cast<int64_t>(s_tiers.DrainNs() / 1000));
+    if (ledgerChanged) SaveAppliedLedger();
+    if (overlayAdded) {
+        const size_t overlayWindows = CountOverlayWindows();
+        MetricSet(Metric::RenderDwmWindows, static_cast<int64_t>(g_windows.Order().size() - overlayWindows));
+        MetricSet(Metric::RenderOverlayWindows, static_cast<int64_t>(overlayWindows));
+        RefreshHybridOverlay(overlayWindows, *g_settings.Read());
+    }
+    return ledgerChanged || overlayAdded;
+}
+
+uint64_t DwmBackgroundDueNs()
+{
+    return s_tiers.NextDueNs();
+}
+
+// DWM / hybrid self-tracking: re-collect targets and apply attributes (the ledger covers corners)
+void RefreshDwmTargets()
+{
+    if (!UsesDwmAttributes()) return;
+    ArenaVector<HWND> targets{ ArenaAllocator<HWND>(RenderFrameArena()) };
+    CollectUserVisibleWindows(targets);
+    ApplyDwmAttributesToTargets(targets.data(), targets.size());
 }
 
 void ApplyDwmToAllCurrent()
 {
-    if (g_mode != RenderMode::Dwm) return;
+    if (!UsesDwmAttributes()) return;
     std::vector<HWND> targets;
-    targets.reserve(g_applied.size());
-    for (const auto& kv : g_applied) {
-        if (IsWindow(kv.first)) targets.push_back(kv.first);
+    targets.reserve(g_windows.Size());
+    for (WindowRegistry::Slot s = 0; s < g_windows.SlotCount(); ++s) {
+        if (!g_windows.IsLive(s) || !(g_windows.Flags(s) & WindowRegistry::kApplied)) continue;
+        HWND h = KeyHwnd(g_windows.Handle(s));
+        if (IsWindow(h)) targets.push_back(h);
     }
     ApplyDwmAttributesToTargets(targets);
 }
@@ -150,25 +360,28 @@ void ApplyDwmToAllCurrent()
 // ׶     ¸ 缳ϴ Լ
 void ResetAndApplyDwmAttributes()
 {
-    if (g_mode != RenderMode::Dwm) return;
+    if (!UsesDwmAttributes()) return;
     
     DebugLog(L"[DWM] Resetting all DWM attributes due to foreground mode change (foregroundOnly=" + 
-             std::to_wstring(g_foregroundWindowOnly) + L")");
+             std::to_wstring(g_settings.Read()->foregroundOnly) + L")");
     
     //    ⺻ 
     COLORREF defaultColor = DWMWA_COLOR_DEFAULT;
     int defaultThick = 1;
     
-    for (auto it = g_applied.begin(); it != g_applied.end(); ++it) {
-        if (IsWindow(it->first)) {
-            DwmSetWindowAttribute(it->first, DWMWA_BORDER_COLOR, &defaultColor, sizeof(defaultColor));
-            DwmSetWindowAttribute(it->first, DWMWA_VISIBLE_FRAME_BORDER_THICKNESS, &defaultThick, sizeof(defaultThick));
-            DebugLog(L"[DWM] Reset window 0x" + std::to_wstring(reinterpret_cast<uintptr_t>(it->first)));
+    for (WindowRegistry::Slot s = 0; s < g_windows.SlotCount(); ++s) {
+        if (!g_windows.IsLive(s) || !(g_windows.Flags(s) & WindowRegistry::kApplied)) continue;
+        HWND h = KeyHwnd(g_windows.Handle(s));
+        if (IsWindow(h)) {
+            DwmSetWindowAttribute(h, DWMWA_BORDER_COLOR, &defaultColor, sizeof(defaultColor));
+            DwmSetWindowAttribute(h, DWMWA_VISIBLE_FRAME_BORDER_THICKNESS, &defaultThick, sizeof(defaultThick));
+            DebugLog(L"[DWM] Reset window 0x" + std::to_wstring(reinterpret_cast<uintptr_t>(h)));
         }
     }
     
     //    ʱȭ
-    g_applied.clear();
+    g_windows.Clear();
+    SaveAppliedLedger(); // nothing is applied until the pass below writes it again
     
     // ο   (׶  ο  ڵ ͸)
     auto hwnds = CollectUserVisibleWindows();
@@ -176,7 +389,7 @@ void ResetAndApplyDwmAttributes()
     
     // 𼭸  ٽ 
     for (HWND h : hwnds) {
-        ApplyCornerPreference(h, g_cornerToken);
+        ApplyCornerPreference(h);
     }
     
     DebugLog(L"[DWM] Reset complete, applied to " + std::to_wstring(hwnds.size()) + L" windows");
@@ -194,6 +407,16 @@ void ApplyCornerPreference(HWND hwnd, const std::wstring& token)
     }
 }
 
+void ApplyCornerPreference(HWND hwnd, CornerStyle corner)
+{
+    ApplyCornerPreference(hwnd, std::wstring(CornerStyleToken(corner)));
+}
+
+void ApplyCornerPreference(HWND hwnd)
+{
+    ApplyCornerPreference(hwnd, ResolveWindowStyle(hwnd).corner);
+}
+
 float CornerRadiusFromToken(const std::wstring& token)
 {
     if (token == L"donot") return 0.0f;
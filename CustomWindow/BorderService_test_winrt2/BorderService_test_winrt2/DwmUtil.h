@@ -2,16 +2,39 @@
 #include "pch.h"
 #include "Globals.h"
 #include "Logging.h"
+#include "FrameArena.h"
 #include <vector>
 
 bool IsAltTabEligible(HWND h);
+// DWMWA_CLOAKED cache (CloakCache.h) behind IsAltTabEligible, fed by the CLOAKED / UNCLOAKED events.
+// Forget re-queries the window on its next check; Clear drops everything (missed events:
+// an overflow, or a suspension with the hooks down).
+void NoteWindowCloak(HWND h, bool cloaked);
+void ForgetWindowCloak(HWND h);
+void ClearCloakCache();
 bool GetWindowBounds(HWND h, RECT& out);
 std::vector<HWND> CollectUserVisibleWindows();
-void ApplyDwmAttributesToTargets(const std::vector<HWND>& targets);
+// Same into a frame list (RenderFrameArena in Pipeline.h); what render frames use
+void CollectUserVisibleWindows(ArenaVector<HWND>& out);
+void ApplyDwmAttributesToTargets(const HWND* targets, size_t count);
+inline void ApplyDwmAttributesToTargets(const std::vector<HWND>& targets)
+{
+    ApplyDwmAttributesToTargets(targets.data(), targets.size());
+}
+// Background tier (TierScheduler.h): windows a pass found out of date outside the foreground
+// window and its popups are written here, a slice at a time. Render thread; true if a
+// border changed.
+bool RunDwmBackgroundSlice(uint64_t nowNs);
+// steady_clock ns the next slice is due at, 0 if nothing is deferred
+uint64_t DwmBackgroundDueNs();
 void ApplyDwmToAllCurrent();
+void RefreshDwmTargets();
 void ResetAndApplyDwmAttributes(); //  ߰: ׶    ü 缳
 COLORREF ToCOLORREF(const D2D1_COLOR_F& c);
 
 // New: Corner handling
 void ApplyCornerPreference(HWND hwnd, const std::wstring& token);
+void ApplyCornerPreference(HWND hwnd, CornerStyle corner);
+// Uses the window's resolved style (global corner or the matching style rule)
+void ApplyCornerPreference(HWND hwnd);
 float CornerRadiusFromToken(const std::wstring& token);
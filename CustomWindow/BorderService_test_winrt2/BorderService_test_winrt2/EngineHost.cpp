@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "EngineHost.h"
+#include "Globals.h"
+#include "Logging.h"
+#include "DwmUtil.h"
+#include "OverlayDComp.h"
+#include "Tray.h"
+#include "PowerMonitor.h"
+#include "ProcessFilter.h"
+#include "FastStart.h"
+#include "Pipeline.h"
+#include "LayoutPublisher.h"
+#include "LedgerFile.h"
+#include <future>
+
+int StartEngine()
+{
+    winrt::init_apartment();
+
+    // Create message window (visible overlay unless DWM attributes carry every border)
+    g_overlay = CreateOverlayWindow(g_mode != RenderMode::Dwm);
+
+    // --faststart: enumerate windows (and warm the image-name cache) while the devices are created
+    std::future<std::vector<HWND>> initialWindows;
+    if (g_fastStart) {
+        initialWindows = std::async(std::launch::async, [] {
+            auto hwnds = CollectUserVisibleWindows();
+            MarkStartupPhase(Metric::StartupEnumUs);
+            return hwnds;
+        });
+    }
+
+    // Tray icon
+    InitTrayIcon(g_overlay);
+
+    // Shared-memory layout for the GUI; filled by every refresh from the first frame on
+    OpenLayoutPublisher();
+
+    // Applied-state ledger of the previous instance: adopted so the first DWM pass only
+    // rewrites windows whose attributes differ (DComp mode restores them instead)
+    OpenAppliedLedger();
+
+    if (g_mode == RenderMode::DComp) {
+        // Create devices
+        if (FAILED(CreateD3DDevice())) return -1;
+        if (FAILED(CreateD2D())) return -2;
+        if (FAILED(CreateDComp(g_overlay))) return -3;
+        MarkStartupPhase(Metric::StartupDevicesUs);
+
+        // Hooks before the first frame so changes made meanwhile are queued, not missed
+        if (!StartIntakeThread()) InstallWinEventHooks();
+
+        // Initial draw (this thread; the render thread takes over below)
+        if (initialWindows.valid()) RefreshOverlay(initialWindows.get());
+        else RefreshOverlay();
+
+        DebugLog(L"[Overlay] Started overlay loop (DComp)");
+    } else {
+        // DWM mode tracks windows itself; the GUI no longer pushes HWND lists on every change.
+        // Hybrid mode creates the overlay devices only once a window refuses DWM attributes.
+        if (!StartIntakeThread()) InstallWinEventHooks();
+        if (initialWindows.valid()) ApplyDwmAttributesToTargets(initialWindows.get());
+        else RefreshDwmTargets();
+        NoteFirstCommit();
+
+        DebugLog(g_mode == RenderMode::Hybrid ? L"[Overlay] Started in hybrid mode (overlay for DWM fallbacks)"
+                                              : L"[Overlay] Started in DWM mode (no overlay)");
+    }
+
+    // From here on only the render thread touches the rendering / ledger state
+    StartRenderThread();
+
+    // GUI waits on this named event instead of polling for the window
+    SignalOverlayReady();
+
+    // Fullscreen / battery / lock handling (may suspend the hooks installed above)
+    InitPowerMonitor(g_overlay);
+    return 0;
+}
+
+void RunEngineLoop()
+{
+    MSG msg{};
+    while (GetMessageW(&msg, nullptr, 0, 0))
+    {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+}
+
+void StopEngine()
+{
+    ShutdownPowerMonitor(g_overlay);
+    StopEventPipeline();
+    CloseLayoutPublisher();
+    RestoreAppliedBorders(g_exitRestoreMs);
+    CloseAppliedLedger();
+    UninstallWinEventHooks();
+    ShutdownProcessFilter();
+    ShutdownFastStart();
+    // An in-process host may start the engine again
+    if (g_overlay) {
+        DestroyWindow(g_overlay);
+        g_overlay = nullptr;
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "pch.h"
+
+// Engine lifetime shared by the service EXE (main.cpp) and the in-process library
+// (BorderEngine.cpp). All three run on the thread that owns the overlay window, after
+// g_mode and the settings have been decided.
+
+// Overlay window, tray, devices, hooks, first frame, render thread. 0 on success, or the
+// exit code of the step that failed (-1 D3D, -2 D2D, -3 DComp).
+int StartEngine();
+// Message loop; returns on WM_QUIT (QUIT IPC command, tray Exit, BorderEngineDestroy)
+void RunEngineLoop();
+// Stops the threads and hooks, closes the shared state and destroys the overlay window
+void StopEngine();
@@ -0,0 +1,138 @@
+#include "EventClassifier.h"
+#include "Metrics.h"
+
+// WinEvent ids / object ids (winuser.h), repeated so the table stays portable
+static constexpr uint32_t kEventSystemForeground = 0x0003;
+static constexpr uint32_t kEventSystemMoveSizeStart = 0x000A;
+static constexpr uint32_t kEventSystemMoveSizeEnd = 0x000B;
+static constexpr uint32_t kEventSystemMinimizeStart = 0x0016;
+static constexpr uint32_t kEventSystemMinimizeEnd = 0x0017;
+static constexpr uint32_t kEventObjectDestroy = 0x8001;
+static constexpr uint32_t kEventObjectShow = 0x8002;
+static constexpr uint32_t kEventObjectHide = 0x8003;
+static constexpr uint32_t kEventObjectReorder = 0x8004;
+static constexpr uint32_t kEventObjectLocationChange = 0x800B;
+static constexpr uint32_t kEventObjectNameChange = 0x800C;
+static constexpr uint32_t kEventObjectCloaked = 0x8017;
+static constexpr uint32_t kEventObjectUncloaked = 0x8018;
+static constexpr int32_t kObjidWindow = 0;
+
+enum Require : uint8_t {
+    kNeedObjidWindow = 1 << 0, // idObject == OBJID_WINDOW (not caret, cursor, scroll bar, ...)
+    kNeedHwnd        = 1 << 1,
+    kAllowDesktop    = 1 << 2, // accepted outright when reported on the desktop window
+    kNeedTopLevel    = 1 << 3,
+    kNeedTracked     = 1 << 4, // must already be bordered
+    kNeedTrackable   = 1 << 5, // tracked, or eligible to become so
+};
+
+struct EventRule {
+    uint32_t event;
+    WindowChange change;
+    uint8_t require;
+    Metric accepted;
+    Metric rejected;
+};
+
+static const EventRule s_rules[] = {
+    { kEventSystemForeground,     WindowChange::Focus,     0,
+      Metric::ClassifyFocusAccepted, Metric::ClassifyFocusRejected },
+    { kEventSystemMoveSizeStart,  WindowChange::MoveSizeStart, kNeedObjidWindow | kNeedHwnd | kNeedTopLevel | kNeedTrackable,
+      Metric::ClassifyMoveSizeAccepted, Metric::ClassifyMoveSizeRejected },
+    // Always accepted for a window, so an open session cannot miss its end
+    { kEventSystemMoveSizeEnd,    WindowChange::MoveSizeEnd, kNeedObjidWindow | kNeedHwnd,
+      Metric::ClassifyMoveSizeAccepted, Metric::ClassifyMoveSizeRejected },
+    { kEventSystemMinimizeStart,  WindowChange::Hidden,    kNeedHwnd | kNeedTracked,
+      Metric::ClassifyHiddenAccepted, Metric::ClassifyHiddenRejected },
+    { kEventSystemMinimizeEnd,    WindowChange::Shown,     kNeedHwnd | kNeedTrackable,
+      Metric::ClassifyShownAccepted, Metric::ClassifyShownRejected },
+    { kEventObjectDestroy,        WindowChange::Destroyed, kNeedObjidWindow | kNeedHwnd | kNeedTracked,
+      Metric::ClassifyDestroyedAccepted, Metric::ClassifyDestroyedRejected },
+    { kEventObjectShow,           WindowChange::Shown,     kNeedObjidWindow | kNeedHwnd | kNeedTopLevel | kNeedTrackable,
+      Metric::ClassifyShownAccepted, Metric::ClassifyShownRejected },
+    { kEventObjectHide,           WindowChange::Hidden,    kNeedObjidWindow | kNeedHwnd | kNeedTracked,
+      Metric::ClassifyHiddenAccepted, Metric::ClassifyHiddenRejected },
+    // Virtual-desktop switches and UWP suspension cloak windows instead of hiding them
+    { kEventObjectCloaked,        WindowChange::Hidden,    kNeedObjidWindow | kNeedHwnd | kNeedTracked,
+      Metric::ClassifyHiddenAccepted, Metric::ClassifyHiddenRejected },
+    { kEventObjectUncloaked,      WindowChange::Shown,     kNeedObjidWindow | kNeedHwnd | kNeedTopLevel | kNeedTrackable,
+      Metric::ClassifyShownAccepted, Metric::ClassifyShownRejected },
+    { kEventObjectReorder,        WindowChange::Restacked, kNeedHwnd | kAllowDesktop | kNeedTopLevel | kNeedTrackable,
+      Metric::ClassifyRestackedAccepted, Metric::ClassifyRestackedRejected },
+    { kEventObjectLocationChange, WindowChange::Moved,     kNeedObjidWindow | kNeedHwnd | kNeedTopLevel | kNeedTrackable,
+      Metric::ClassifyMovedAccepted, Metric::ClassifyMovedRejected },
+    { kEventObjectNameChange,     WindowChange::Renamed,   kNeedObjidWindow | kNeedHwnd | kNeedTracked,
+      Metric::ClassifyRenamedAccepted, Metric::ClassifyRenamedRejected },
+};
+
+static const EventRule* FindRule(uint32_t event)
+{
+    for (const auto& r : s_rules) {
+        if (r.event == event) return &r;
+    }
+    return nullptr;
+}
+
+const char* WindowChangeName(WindowChange c)
+{
+    switch (c) {
+    case WindowChange::Moved: return "moved";
+    case WindowChange::Shown: return "shown";
+    case WindowChange::Hidden: return "hidden";
+    case WindowChange::Destroyed: return "destroyed";
+    case WindowChange::Restacked: return "restacked";
+    case WindowChange::Focus: return "focus";
+    case WindowChange::Renamed: return "renamed";
+    case WindowChange::Refresh: return "refresh";
+    case WindowChange::MoveSizeStart: return "movesizestart";
+    case WindowChange::MoveSizeEnd: return "movesizeend";
+    default: return "none";
+    }
+}
+
+static bool PassesStaticChecks(const EventRule& r, int32_t idObject, uint64_t hwnd)
+{
+    if ((r.require & kNeedObjidWindow) && idObject != kObjidWindow) return false;
+    if ((r.require & kNeedHwnd) && hwnd == 0) return false;
+    return true;
+}
+
+bool PreFilterEvent(uint32_t event, int32_t idObject, uint64_t hwnd)
+{
+    const EventRule* r = FindRule(event);
+    if (!r) {
+        MetricAdd(Metric::ClassifyUnknownRejected);
+        return false;
+    }
+    if (!PassesStaticChecks(*r, idObject, hwnd)) {
+        MetricAdd(r->rejected);
+        return false;
+    }
+    return true;
+}
+
+WindowChange ClassifyEvent(const EventRecord& e, WindowFactSource& facts)
+{
+    if (e.event == kEventRefreshRequest) return WindowChange::Refresh;
+
+    const EventRule* r = FindRule(e.event);
+    if (!r) {
+        MetricAdd(Metric::ClassifyUnknownRejected);
+        return WindowChange::None;
+    }
+
+    bool ok = PassesStaticChecks(*r, e.idObject, e.hwnd);
+    if (ok && (r->require & kAllowDesktop) && facts.Query(e.hwnd, WindowFact::Desktop)) {
+        MetricAdd(r->accepted);
+        return r->change;
+    }
+    if (ok && (r->require & kNeedTopLevel)) ok = facts.Query(e.hwnd, WindowFact::TopLevel);
+    if (ok && (r->require & (kNeedTracked | kNeedTrackable))) {
+        // Registry lookup first; the eligibility check costs several window queries
+        ok = facts.Query(e.hwnd, WindowFact::Tracked);
+        if (!ok && (r->require & kNeedTrackable)) ok = facts.Query(e.hwnd, WindowFact::Trackable);
+    }
+
+    MetricAdd(ok ? r->accepted : r->rejected);
+    return ok ? r->change : WindowChange::None;
+}
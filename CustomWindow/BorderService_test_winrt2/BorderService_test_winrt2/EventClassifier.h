@@ -0,0 +1,44 @@
+#pragma once
+#include "EventPipeline.h"
+#include <cstdint>
+
+// Maps raw WinEvents to the window change they represent and drops the ones that cannot
+// change what is drawn (carets, cursors, scroll bars, child windows, tooltips, windows the
+// service never borders). Table-driven; portable, window facts come from the caller.
+
+enum class WindowChange : uint8_t {
+    None = 0,   // rejected
+    Moved,
+    Shown,
+    Hidden,
+    Destroyed,
+    Restacked,
+    Focus,
+    Renamed,    // title change; the style rule match decides whether it matters
+    Refresh,    // kEventRefreshRequest (timer / IPC)
+    MoveSizeStart, // interactive move / resize begins (MoveSizeSession.h)
+    MoveSizeEnd,
+};
+const char* WindowChangeName(WindowChange c);
+
+// Per-window questions the classifier may ask, cheapest first. Only asked when the
+// event's table row needs them.
+enum class WindowFact : uint8_t {
+    Desktop,    // the desktop window itself (top-level z-order changes are reported on it)
+    TopLevel,   // its own root window
+    Tracked,    // currently in the window registry
+    Trackable,  // would be bordered if it were on screen (eligible, not excluded)
+};
+
+class WindowFactSource {
+public:
+    virtual ~WindowFactSource() = default;
+    virtual bool Query(uint64_t hwnd, WindowFact fact) = 0;
+};
+
+// Stage 1, intake thread: event id / idObject / hwnd checks only. False = drop (counted).
+bool PreFilterEvent(uint32_t event, int32_t idObject, uint64_t hwnd);
+
+// Stage 2, render thread: full classification with window facts. Counts accept / reject
+// per change type (classify.* metrics).
+WindowChange ClassifyEvent(const EventRecord& e, WindowFactSource& facts);
@@ -0,0 +1,138 @@
+#include "EventPipeline.h"
+#include "Metrics.h"
+#include <chrono>
+
+static uint64_t SteadyNowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+EventPipeline::EventPipeline(size_t capacity, BatchHandler handler)
+    : m_queue(capacity), m_handler(std::move(handler))
+{
+}
+
+EventPipeline::~EventPipeline()
+{
+    RequestStop();
+    Join();
+}
+
+void EventPipeline::Start()
+{
+    if (m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = false;
+    }
+    m_thread = std::thread([this] { Run(); });
+}
+
+void EventPipeline::RequestStop()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_stop = true;
+    m_cv.notify_one();
+}
+
+void EventPipeline::Join()
+{
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void EventPipeline::Wake()
+{
+    // Only the first push after the consumer went idle pays for the lock; the plain load
+    // keeps the flag's cache line shared while the consumer is already awake. The fence
+    // pairs with the one in Run between clearing the flag and draining: either this load
+    // sees the flag cleared and signals, or that drain sees the record just pushed.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_wakePending.load(std::memory_order_relaxed)) return;
+    if (!m_wakePending.exchange(true, std::memory_order_acq_rel)) {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_cv.notify_one();
+    }
+}
+
+bool EventPipeline::Push(const EventRecord& rec)
+{
+    if (!m_queue.TryPush(rec)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        m_overflowed.store(true, std::memory_order_release);
+        MetricAdd(Metric::QueueDropped);
+        Wake();
+        return false;
+    }
+    // Pushed / depth counters are published by the consumer to keep producers contention-free
+    Wake();
+    return true;
+}
+
+void EventPipeline::PostTask(Task task)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_tasks.push_back(std::move(task));
+    m_cv.notify_one();
+}
+
+void EventPipeline::WakeAt(uint64_t steadyNs)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_wakeAtNs = steadyNs;
+    m_cv.notify_one();
+}
+
+void EventPipeline::Run()
+{
+    EventBatch batch;
+    batch.events.reserve(m_queue.Capacity());
+    std::vector<Task> tasks;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(m_lock);
+            // The deadline is re-read after every wake-up: WakeAt may have moved it
+            for (;;) {
+                if (m_stop || !m_tasks.empty() || m_wakePending.load(std::memory_order_acquire)) break;
+                if (m_wakeAtNs && SteadyNowNs() >= m_wakeAtNs) break;
+                if (m_wakeAtNs) {
+                    m_cv.wait_until(lk, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(m_wakeAtNs)));
+                } else {
+                    m_cv.wait(lk);
+                }
+            }
+            if (m_stop) break;
+            tasks.swap(m_tasks);
+            // Cleared before the drain below, never after it: a push the drain misses
+            // finds the flag clear and wakes the next round
+            m_wakePending.exchange(false, std::memory_order_acq_rel);
+            // Checked on every batch, so a steady stream of events cannot starve the deadline
+            batch.timer = m_wakeAtNs && SteadyNowNs() >= m_wakeAtNs;
+            if (batch.timer) m_wakeAtNs = 0;
+        }
+
+        for (auto& t : tasks) {
+            t();
+            MetricAdd(Metric::QueueTasks);
+        }
+        tasks.clear();
+
+        batch.events.clear();
+        batch.overflowed = m_overflowed.exchange(false, std::memory_order_acq_rel);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // see Wake
+        MetricMax(Metric::QueueMaxDepth, static_cast<int64_t>(m_queue.Depth()));
+        EventRecord rec;
+        while (batch.events.size() < m_queue.Capacity() && m_queue.TryPop(rec)) batch.events.push_back(rec);
+        // Batch limit reached: come straight back for the rest
+        if (m_queue.Depth() > 0) m_wakePending.store(true, std::memory_order_release);
+        MetricSet(Metric::QueueDepth, static_cast<int64_t>(m_queue.Depth()));
+        MetricSet(Metric::QueuePushed, static_cast<int64_t>(m_queue.Pushed()));
+
+        if (batch.events.empty() && !batch.overflowed && !batch.timer) continue;
+        MetricAdd(Metric::QueueBatches);
+        MetricMax(Metric::QueueBatchMax, static_cast<int64_t>(batch.events.size()));
+        if (batch.overflowed) MetricAdd(Metric::QueueResyncs);
+        if (m_handler) m_handler(batch);
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "EventQueue.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Intake -> render hand-off. Portable; Pipeline.cpp wires it to the WinEvent hooks.
+
+// Compact WinEvent record; hwnd is kept as an integer so the core stays portable.
+struct EventRecord {
+    uint32_t event = 0;     // EVENT_* id, or kEventRefreshRequest
+    int32_t idObject = 0;
+    uint64_t hwnd = 0;
+    uint32_t timeMs = 0;    // dwmsEventTime
+};
+static constexpr uint32_t kEventRefreshRequest = 0; // timer / explicit refresh, not a WinEvent
+
+struct EventBatch {
+    std::vector<EventRecord> events;
+    // Records were dropped since the previous batch; the handler must resync everything
+    bool overflowed = false;
+    // The WakeAt deadline passed (the batch may be empty)
+    bool timer = false;
+};
+
+// Backpressure / overflow policy: producers never block (a WinEvent callback or the UI
+// thread must not stall on rendering). When the ring is full the record is dropped,
+// counted, and the next batch is flagged as overflowed so the consumer performs one full
+// resync instead of replaying the lost events.
+class EventPipeline {
+public:
+    using BatchHandler = std::function<void(const EventBatch&)>;
+    using Task = std::function<void()>;
+
+    EventPipeline(size_t capacity, BatchHandler handler);
+    ~EventPipeline();
+
+    EventPipeline(const EventPipeline&) = delete;
+    EventPipeline& operator=(const EventPipeline&) = delete;
+
+    void Start();
+    // Asks the consumer to exit after the current batch; queued records are discarded
+    void RequestStop();
+    void Join();
+    bool Running() const { return m_thread.joinable(); }
+    std::thread::native_handle_type NativeHandle() { return m_thread.native_handle(); }
+    bool OnConsumerThread() const { return std::this_thread::get_id() == m_thread.get_id(); }
+
+    // Any thread, lock-free except for the wake-up of an idle consumer.
+    // Returns false if the record was dropped.
+    bool Push(const EventRecord& rec);
+    // Control-plane work (IPC commands, display changes) run on the consumer thread
+    // before the next batch. Low rate, so a mutex-protected list is fine here.
+    void PostTask(Task task);
+    // Any thread: run a batch (timer set) once steady_clock reaches steadyNs, even with
+    // nothing queued. A single deadline; a later call replaces it, 0 cancels it.
+    void WakeAt(uint64_t steadyNs);
+
+    size_t Depth() const { return m_queue.Depth(); }
+    size_t Capacity() const { return m_queue.Capacity(); }
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void Wake();
+    void Run();
+
+    BoundedMpscQueue<EventRecord> m_queue;
+    BatchHandler m_handler;
+    std::thread m_thread;
+
+    std::mutex m_lock; // guards m_tasks / m_stop and the consumer's wait
+    std::condition_variable m_cv;
+    std::vector<Task> m_tasks;
+    bool m_stop = false;
+    uint64_t m_wakeAtNs = 0;
+    std::atomic<bool> m_wakePending{ false };
+    std::atomic<bool> m_overflowed{ false };
+    std::atomic<uint64_t> m_dropped{ 0 };
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// Bounded lock-free multi-producer / single-consumer ring (sequence-numbered slots).
+// Producers never block: TryPush fails when the ring is full and the caller applies the
+// overflow policy (see EventPipeline). Portable; T must be trivially copyable.
+template <typename T>
+class BoundedMpscQueue {
+    static_assert(std::is_trivially_copyable<T>::value, "queue records must be trivially copyable");
+
+public:
+    // capacity is rounded up to a power of two (minimum 2)
+    explicit BoundedMpscQueue(size_t capacity)
+    {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        m_mask = cap - 1;
+        m_slots.reset(new Slot[cap]);
+        for (size_t i = 0; i < cap; ++i) m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+    BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+    size_t Capacity() const { return m_mask + 1; }
+
+    // Any thread. Returns false (record not queued) when full.
+    bool TryPush(const T& value)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[pos & m_mask];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only.
+    bool TryPop(T& out)
+    {
+        Slot& slot = m_slots[m_head & m_mask];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != m_head + 1) return false; // empty (or producer mid-write)
+        out = slot.value;
+        slot.seq.store(m_head + m_mask + 1, std::memory_order_release);
+        ++m_head;
+        m_headPublished.store(m_head, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Records ever accepted (the tail only advances on a successful push); any thread
+    uint64_t Pushed() const { return m_tail.load(std::memory_order_relaxed); }
+
+    // Approximate; safe from any thread
+    size_t Depth() const
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_headPublished.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq{ 0 };
+        T value{};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_tail{ 0 };
+    alignas(64) size_t m_head = 0;
+    std::atomic<size_t> m_headPublished{ 0 };
+};
@@ -0,0 +1,102 @@
+#include "ExitRestore.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+enum EntryState : uint8_t { kPending = 0, kInFlight, kRestored, kSkipped };
+
+// Shared with the workers, which may outlive the call
+struct RestoreState {
+    std::vector<LedgerEntry> entries;
+    std::unique_ptr<std::atomic<uint8_t>[]> states;
+    std::atomic<size_t> next{ 0 };
+    std::chrono::steady_clock::time_point deadline;
+    size_t batch = 1;
+    std::mutex lock;
+    std::condition_variable done;
+    size_t running = 0;
+};
+
+void RestoreWorker(std::shared_ptr<RestoreState> state, RestoreTarget* target)
+{
+    const size_t count = state->entries.size();
+    for (;;) {
+        const size_t first = state->next.fetch_add(state->batch, std::memory_order_relaxed);
+        if (first >= count) break;
+        const size_t last = std::min(first + state->batch, count);
+        bool late = false;
+        for (size_t i = first; i < last; ++i) {
+            // Past the deadline the rest of the batch stays pending (reported as timed out)
+            if (std::chrono::steady_clock::now() >= state->deadline) {
+                late = true;
+                break;
+            }
+            state->states[i].store(kInFlight, std::memory_order_relaxed);
+            const RestoreOutcome outcome = target->Restore(state->entries[i]);
+            state->states[i].store(outcome == RestoreOutcome::Restored ? kRestored : kSkipped, std::memory_order_release);
+        }
+        if (late) break;
+    }
+    std::lock_guard<std::mutex> guard(state->lock);
+    if (--state->running == 0) state->done.notify_all();
+}
+
+} // namespace
+
+RestoreReport RestoreInParallel(const std::vector<LedgerEntry>& entries, RestoreTarget& target, const RestoreOptions& options)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    RestoreReport report;
+
+    auto state = std::make_shared<RestoreState>();
+    state->entries = entries;
+    state->states.reset(new std::atomic<uint8_t>[entries.size()]);
+    for (size_t i = 0; i < entries.size(); ++i) state->states[i].store(kPending, std::memory_order_relaxed);
+    state->deadline = t0 + std::chrono::nanoseconds(options.deadlineNs);
+    state->batch = std::max<size_t>(options.batch, 1);
+
+    const size_t batches = (entries.size() + state->batch - 1) / state->batch;
+    const size_t workers = options.deadlineNs ? std::min(std::max<size_t>(options.workers, 1), batches) : 0;
+    std::vector<std::thread> threads;
+    state->running = workers;
+    for (size_t w = 0; w < workers; ++w) {
+        try {
+            threads.emplace_back(RestoreWorker, state, &target);
+        } catch (...) {
+            // Fewer threads: the ones started share the work
+            std::lock_guard<std::mutex> guard(state->lock);
+            --state->running;
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lk(state->lock);
+        state->done.wait_until(lk, state->deadline, [&] { return state->running == 0; });
+        report.abandonedWorkers = state->running;
+    }
+    // Workers stuck in Restore keep the shared state alive and exit on their own
+    for (std::thread& t : threads) {
+        if (report.abandonedWorkers) t.detach();
+        else t.join();
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        switch (state->states[i].load(std::memory_order_acquire)) {
+        case kRestored: ++report.restored; break;
+        case kSkipped: ++report.skipped; break;
+        default:
+            ++report.timedOut;
+            report.unfinished.push_back(entries[i]);
+            break;
+        }
+    }
+    report.elapsedNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count());
+    return report;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "AppliedLedger.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Restores the system default DWM attributes of every window the service bordered, at exit,
+// on a pool of worker threads under a hard deadline: a hung or slow window costs one worker,
+// never the exit. Entries not finished by the deadline are returned so the caller can leave
+// them in the ledger for the next instance. Portable; the per-window work comes from the
+// caller (LedgerFile.cpp on Windows).
+
+enum class RestoreOutcome : uint8_t {
+    Restored,
+    Skipped,    // the window is gone or its HWND value now belongs to another window
+};
+
+class RestoreTarget {
+public:
+    virtual ~RestoreTarget() = default;
+    // Called concurrently from the workers. The target must outlive them: a worker still
+    // inside Restore at the deadline is abandoned, not joined.
+    virtual RestoreOutcome Restore(const LedgerEntry& entry) = 0;
+};
+
+struct RestoreOptions {
+    size_t workers = 4;
+    size_t batch = 8;           // entries a worker claims at a time
+    uint64_t deadlineNs = 0;    // from the call; 0 = restore nothing
+};
+
+struct RestoreReport {
+    size_t restored = 0;
+    size_t skipped = 0;
+    size_t timedOut = 0;        // not started or still in progress at the deadline
+    size_t abandonedWorkers = 0;
+    uint64_t elapsedNs = 0;
+    std::vector<LedgerEntry> unfinished; // the timed-out entries
+};
+
+RestoreReport RestoreInParallel(const std::vector<LedgerEntry>& entries, RestoreTarget& target, const RestoreOptions& options);
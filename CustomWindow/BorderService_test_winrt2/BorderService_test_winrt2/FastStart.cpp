@@ -0,0 +1,161 @@
+#include "pch.h"
+#include "Globals.h"
+#include "Logging.h"
+#include "FastStart.h"
+#include "ProcessFilter.h"
+#include "StartupSnapshot.h"
+#include "WindowStyles.h"
+
+static HANDLE s_readyEvent = nullptr;
+static bool s_firstCommitSeen = false;
+
+static std::wstring SnapshotPath()
+{
+    wchar_t base[MAX_PATH] = {};
+    DWORD n = GetEnvironmentVariableW(L"LOCALAPPDATA", base, MAX_PATH);
+    if (n == 0 || n >= MAX_PATH) return std::wstring();
+    std::wstring dir = std::wstring(base) + L"\\CustomWindow";
+    CreateDirectoryW(dir.c_str(), nullptr);
+    return dir + L"\\border_snapshot.txt";
+}
+
+static std::wstring Utf8ToWide(const std::string& s)
+{
+    if (s.empty()) return std::wstring();
+    int len = MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), nullptr, 0);
+    std::wstring out(static_cast<size_t>(len), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), out.data(), len);
+    return out;
+}
+
+static std::string WideToUtf8(const std::wstring& s)
+{
+    if (s.empty()) return std::string();
+    int len = WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), nullptr, 0, nullptr, nullptr);
+    std::string out(static_cast<size_t>(len), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), out.data(), len, nullptr, nullptr);
+    return out;
+}
+
+static std::wstring FormatColor(const ColorF& c)
+{
+    auto byte = [](float v) { return static_cast<unsigned>(std::clamp(static_cast<int>(std::lround(v * 255.0f)), 0, 255)); };
+    wchar_t buf[16];
+    swprintf_s(buf, L"#%02X%02X%02X%02X", byte(c.a), byte(c.r), byte(c.g), byte(c.b));
+    return buf;
+}
+
+bool LoadStartupSnapshot()
+{
+    std::wstring path = SnapshotPath();
+    if (path.empty()) return false;
+
+    HANDLE f = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    std::string data;
+    LARGE_INTEGER size{};
+    if (GetFileSizeEx(f, &size) && size.QuadPart > 0 && size.QuadPart < (1 << 20)) {
+        data.resize(static_cast<size_t>(size.QuadPart));
+        DWORD read = 0;
+        if (!ReadFile(f, data.data(), static_cast<DWORD>(data.size()), &read, nullptr)) read = 0;
+        data.resize(read);
+    }
+    CloseHandle(f);
+
+    StartupSnapshot snap;
+    if (!ParseStartupSnapshot(Utf8ToWide(data), snap)) {
+        DebugLog(L"[FastStart] Snapshot missing header, ignored");
+        return false;
+    }
+
+    if (snap.mode == L"dwm") g_mode = RenderMode::Dwm;
+    else if (snap.mode == L"dcomp") g_mode = RenderMode::DComp;
+    else if (snap.mode == L"hybrid") g_mode = RenderMode::Hybrid;
+    g_settings.Update([&](BorderSettings& s) {
+        ParseHexColor(snap.color, s.color);
+        s.thickness = snap.thickness;
+        s.cornerToken = snap.corner;
+        s.foregroundOnly = snap.foregroundOnly;
+        s.effectToken = snap.effect;
+    });
+    g_powerPolicyEnabled = snap.powerPolicy;
+    if (!snap.exclusions.empty()) SetExcludedProcesses(snap.exclusions);
+    if (!snap.rules.empty()) LoadStyleRules(snap.rules);
+
+    MetricSet(Metric::StartupSnapshotLoaded, 1);
+    DebugLog(L"[FastStart] Loaded settings snapshot " + path);
+    return true;
+}
+
+void SaveStartupSnapshot()
+{
+    std::wstring path = SnapshotPath();
+    if (path.empty()) return;
+
+    StartupSnapshot snap;
+    snap.mode = (g_mode == RenderMode::Dwm) ? L"dwm" : (g_mode == RenderMode::DComp) ? L"dcomp" :
+                (g_mode == RenderMode::Hybrid) ? L"hybrid" : L"auto";
+    {
+        const auto settings = g_settings.Read();
+        snap.color = FormatColor(settings->color);
+        snap.thickness = settings->thickness;
+        snap.corner = settings->cornerToken;
+        snap.foregroundOnly = settings->foregroundOnly;
+        snap.effect = settings->effectToken;
+    }
+    snap.powerPolicy = g_powerPolicyEnabled;
+    snap.exclusions = GetExcludedProcessesList();
+    snap.rules = CurrentStyleRulesText();
+    std::string data = WideToUtf8(SerializeStartupSnapshot(snap));
+
+    std::wstring tmp = path + L".tmp";
+    HANDLE f = CreateFileW(tmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return;
+    DWORD written = 0;
+    BOOL ok = WriteFile(f, data.data(), static_cast<DWORD>(data.size()), &written, nullptr);
+    CloseHandle(f);
+    if (!ok || written != data.size() || !MoveFileExW(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileW(tmp.c_str());
+        DebugLog(L"[FastStart] Failed to write settings snapshot");
+    }
+}
+
+void MarkStartupPhase(Metric m)
+{
+    FILETIME created{}, exited{}, kernel{}, user{}, now{};
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return;
+    GetSystemTimePreciseAsFileTime(&now);
+    ULARGE_INTEGER a{}, b{};
+    a.LowPart = created.dwLowDateTime; a.HighPart = created.dwHighDateTime;
+    b.LowPart = now.dwLowDateTime; b.HighPart = now.dwHighDateTime;
+    if (b.QuadPart >= a.QuadPart) MetricSet(m, static_cast<int64_t>((b.QuadPart - a.QuadPart) / 10));
+}
+
+void NoteFirstCommit()
+{
+    if (s_firstCommitSeen) return;
+    s_firstCommitSeen = true;
+    MarkStartupPhase(Metric::StartupFirstCommitUs);
+}
+
+void SignalOverlayReady()
+{
+    if (s_readyEvent) return;
+    // Manual reset: the GUI may create the event first and wait before the window exists
+    s_readyEvent = CreateEventW(nullptr, TRUE, FALSE, kOverlayReadyEventName);
+    if (!s_readyEvent) return;
+    SetEvent(s_readyEvent);
+    MarkStartupPhase(Metric::StartupReadyUs);
+    DebugLog(L"[FastStart] Ready: first commit " + std::to_wstring(MetricGet(Metric::StartupFirstCommitUs)) +
+             L" us, ready " + std::to_wstring(MetricGet(Metric::StartupReadyUs)) + L" us after process start");
+}
+
+void ShutdownFastStart()
+{
+    if (s_readyEvent) {
+        // A stale signaled event would make the next launch look ready immediately
+        ResetEvent(s_readyEvent);
+        CloseHandle(s_readyEvent);
+        s_readyEvent = nullptr;
+    }
+}
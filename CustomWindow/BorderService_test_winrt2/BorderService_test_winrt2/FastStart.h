@@ -0,0 +1,21 @@
+#pragma once
+#include "pch.h"
+#include "Metrics.h"
+
+// Fast cold start: persisted settings snapshot (%LOCALAPPDATA%\CustomWindow\border_snapshot.txt),
+// a named ready event for the GUI and the startup timeline metrics.
+static constexpr const wchar_t* kOverlayReadyEventName = L"Local\\CustomWindow.BorderOverlay.Ready";
+
+// Applies the last persisted settings to the globals; false if missing or invalid.
+// Command-line arguments parsed afterwards still override it.
+bool LoadStartupSnapshot();
+// Persists the current settings (written to a temp file, then replaced)
+void SaveStartupSnapshot();
+
+// Stores microseconds since process creation in the given startup.* metric
+void MarkStartupPhase(Metric m);
+// Called after every overlay commit / DWM apply; records startup.first_commit_us once
+void NoteFirstCommit();
+// Sets the named ready event (once) so the GUI can stop waiting
+void SignalOverlayReady();
+void ShutdownFastStart();
@@ -0,0 +1,91 @@
+#include "FrameArena.h"
+#include "AllocCounter.h"
+#include "Metrics.h"
+#include <new>
+
+FrameArena::FrameArena(size_t blockBytes) : m_blockBytes(blockBytes ? blockBytes : 4096)
+{
+}
+
+FrameArena::~FrameArena()
+{
+    FreeBlocks();
+}
+
+void FrameArena::AddBlock(size_t minBytes)
+{
+    const size_t size = minBytes > m_blockBytes ? minBytes : m_blockBytes;
+    Block* b = static_cast<Block*>(::operator new(kHeader + size));
+    ++m_blockAllocations;
+    b->next = m_blocks;
+    b->size = size;
+    m_blocks = b;
+    m_cursor = Data(b);
+    m_end = m_cursor + size;
+    m_reserved += size;
+}
+
+void FrameArena::FreeBlocks()
+{
+    while (m_blocks) {
+        Block* next = m_blocks->next;
+        ::operator delete(m_blocks);
+        m_blocks = next;
+    }
+    m_cursor = m_end = nullptr;
+    m_reserved = 0;
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t align)
+{
+    if (bytes == 0) bytes = 1;
+    uintptr_t p = (reinterpret_cast<uintptr_t>(m_cursor) + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+    if (!m_cursor || p + bytes > reinterpret_cast<uintptr_t>(m_end)) {
+        // The rest of the current block is left unused until the next Reset
+        AddBlock(bytes + align);
+        p = (reinterpret_cast<uintptr_t>(m_cursor) + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+    }
+    m_used += (p - reinterpret_cast<uintptr_t>(m_cursor)) + bytes;
+    m_cursor = reinterpret_cast<char*>(p + bytes);
+    return reinterpret_cast<void*>(p);
+}
+
+void FrameArena::Reset()
+{
+    if (m_used > m_peak) m_peak = m_used;
+    if (m_releaseOnReset) {
+        FreeBlocks();
+        m_releaseOnReset = false;
+    } else if (m_blocks && m_blocks->next) {
+        // Outgrew one block: replace them all by one that holds this frame
+        const size_t total = m_reserved;
+        FreeBlocks();
+        AddBlock(total);
+    } else if (m_blocks) {
+        m_cursor = Data(m_blocks);
+        m_end = m_cursor + m_blocks->size;
+    }
+    m_used = 0;
+}
+
+FrameScope::FrameScope(FrameArena& arena) : m_arena(arena), m_startAllocations(ThreadHeapAllocations())
+{
+}
+
+FrameScope::~FrameScope()
+{
+    const int64_t allocations = static_cast<int64_t>(HeapAllocations());
+    m_arena.Reset();
+    MetricAdd(Metric::AllocFrames);
+    MetricSet(Metric::AllocFrame, allocations);
+    if (allocations) MetricAdd(Metric::AllocFramesAllocating);
+    if (allocations > MetricGet(Metric::AllocFrameMax)) MetricSet(Metric::AllocFrameMax, allocations);
+    MetricSet(Metric::AllocTotal, static_cast<int64_t>(::HeapAllocations()));
+    MetricSet(Metric::ArenaPeakBytes, static_cast<int64_t>(m_arena.PeakUsed()));
+    MetricSet(Metric::ArenaBlocks, static_cast<int64_t>(m_arena.BlockAllocations()));
+}
+
+uint64_t FrameScope::HeapAllocations() const
+{
+    return ThreadHeapAllocations() - m_startAllocations;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-frame monotonic arena for the render thread's transient lists (candidate windows,
+// filtered targets, scratch): allocation is a pointer bump, nothing is freed individually,
+// and the whole frame is released at once by Reset. State that lives across frames stays
+// in pooled containers (registry columns, cleared-not-freed scratch vectors). Portable;
+// single thread.
+
+class FrameArena {
+public:
+    explicit FrameArena(size_t blockBytes = 64 * 1024);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Never returns nullptr (throws std::bad_alloc like operator new)
+    void* Allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+    // Releases everything allocated since the last Reset. Blocks are kept; a frame that
+    // needed several is merged into one block that fits it, so a steady workload stops
+    // touching the heap after its first frames.
+    void Reset();
+    // Frees the blocks at the next Reset instead of keeping them, for a long idle period
+    // (IdleResources.h); the frame after that allocates a block again
+    void ReleaseOnReset() { m_releaseOnReset = true; }
+
+    size_t Used() const { return m_used; }
+    size_t PeakUsed() const { return m_peak; }
+    size_t Reserved() const { return m_reserved; }
+    // Heap allocations made for blocks since construction
+    uint64_t BlockAllocations() const { return m_blockAllocations; }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size; // usable bytes after the header
+    };
+    static constexpr size_t kHeader = (sizeof(Block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    void AddBlock(size_t minBytes);
+    void FreeBlocks();
+    static char* Data(Block* b) { return reinterpret_cast<char*>(b) + kHeader; }
+
+    size_t m_blockBytes;
+    Block* m_blocks = nullptr; // current block first
+    char* m_cursor = nullptr;
+    char* m_end = nullptr;
+    size_t m_used = 0;
+    size_t m_peak = 0;
+    size_t m_reserved = 0;
+    uint64_t m_blockAllocations = 0;
+    bool m_releaseOnReset = false;
+};
+
+// Standard allocator over a FrameArena; deallocate is a no-op
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena) noexcept : m_arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.Arena()) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) noexcept {}
+    FrameArena* Arena() const noexcept { return m_arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& o) const noexcept { return m_arena == o.Arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& o) const noexcept { return m_arena != o.Arena(); }
+
+private:
+    FrameArena* m_arena;
+};
+
+// Must not outlive the frame (the arena's next Reset)
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// One render frame: on destruction resets the arena and records the heap allocations the
+// calling thread made meanwhile (AllocCounter.h) in the alloc.* and arena.* metrics
+class FrameScope {
+public:
+    explicit FrameScope(FrameArena& arena);
+    ~FrameScope();
+    FrameScope(const FrameScope&) = delete;
+    FrameScope& operator=(const FrameScope&) = delete;
+
+    FrameArena& Arena() const { return m_arena; }
+    // Heap allocations by this thread since the frame began
+    uint64_t HeapAllocations() const;
+
+private:
+    FrameArena& m_arena;
+    uint64_t m_startAllocations;
+};
@@ -3,19 +3,24 @@
 
 RenderMode g_mode = RenderMode::Auto;
 bool g_console = false;
-D2D1_COLOR_F g_borderColor = D2D1::ColorF(0.0f, 0.8f, 1.0f, 1.0f);
-float g_thickness = 5.0f;
-bool g_foregroundWindowOnly = false;
-std::wstring g_cornerToken = L"default"; // ߰: 𼭸 ձ  ⺻
+SettingsStore g_settings;
+
+bool g_powerPolicyEnabled = true;
+bool g_fastStart = false;
+uint32_t g_exitRestoreMs = 1000;
+uint32_t g_idleReleaseSec = 10;
+bool g_overlayRegion = true;
 
 HWND g_overlay = nullptr;
 RECT g_virtualScreen{};
 
 HWINEVENTHOOK g_hook1 = nullptr, g_hook2 = nullptr, g_hook3 = nullptr;
 HWINEVENTHOOK g_hook4 = nullptr, g_hook5 = nullptr, g_hook6 = nullptr;
+HWINEVENTHOOK g_hook7 = nullptr;
+HWINEVENTHOOK g_hook8 = nullptr;
+HWINEVENTHOOK g_hook9 = nullptr;
 
-std::unordered_map<HWND, RECT, HwndHash, HwndEq> g_targets;
-std::unordered_map<HWND, AppliedState, HwndHash, HwndEq> g_applied;
+WindowRegistry g_windows;
 
 Microsoft::WRL::ComPtr<ID2D1Factory1> g_d2dFactory;
 Microsoft::WRL::ComPtr<ID2D1Device> g_d2dDevice;
@@ -27,8 +32,6 @@ Microsoft::WRL::ComPtr<IDCompositionDevice> g_dcompDevice;
 Microsoft::WRL::ComPtr<IDCompositionTarget> g_dcompTarget;
 Microsoft::WRL::ComPtr<IDCompositionVisual> g_rootVisual;
 Microsoft::WRL::ComPtr<IDCompositionVisual> g_surfaceVisual;
-Microsoft::WRL::ComPtr<IDCompositionSurface> g_surface;
-UINT g_surfaceW = 0, g_surfaceH = 0;
 
 NOTIFYICONDATAW g_nid = { 0 };
 HICON g_trayIcon = nullptr;
@@ -1,10 +1,14 @@
 #pragma once
 #include "pch.h"
+#include "SettingsSnapshot.h"
+#include "StyleRules.h"
+#include "WindowRegistry.h"
 #include <unordered_map>
 #include <unordered_set>
 
 // Render mode
-enum class RenderMode { Auto, Dwm, DComp };
+// Hybrid: DWM attributes per window, the DComp overlay only for windows DWM refuses
+enum class RenderMode { Auto, Dwm, DComp, Hybrid };
 
 // Hash for HWND keys
 struct HwndHash {
@@ -14,22 +18,42 @@ struct HwndHash {
 };
 struct HwndEq { bool operator()(HWND a, HWND b) const noexcept { return a == b; } };
 
+// HWND <-> portable handle (WindowRegistry / EventRecord)
+inline uint64_t HwndKey(HWND h) { return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(h)); }
+inline HWND KeyHwnd(uint64_t key) { return reinterpret_cast<HWND>(static_cast<uintptr_t>(key)); }
+
 // Globals
+// Set once while parsing arguments, before any worker thread starts; read-only afterwards
 extern RenderMode g_mode;
+inline bool UsesDwmAttributes() { return g_mode == RenderMode::Dwm || g_mode == RenderMode::Hybrid; }
 extern bool g_console;
-extern D2D1_COLOR_F g_borderColor;
-extern float g_thickness;
-extern bool g_foregroundWindowOnly; //  ߰: ׶ â  
-extern std::wstring g_cornerToken; // ߰: 𼭸 ձ  
+// Border settings; any thread reads a consistent snapshot with g_settings.Read()
+extern SettingsStore g_settings;
+
+extern bool g_powerPolicyEnabled;
+extern bool g_fastStart; // --faststart: persisted snapshot + parallel first frame
+// --exitdeadline: ms StopEngine may spend restoring default DWM attributes; 0 keeps the
+// borders for the next instance to adopt. UI thread ("QUIT KEEP" clears it).
+extern uint32_t g_exitRestoreMs;
+// --idlerelease: seconds with nothing to draw before the overlay gives back its surface,
+// device caches and working set (IdleResources.h); 0 keeps them
+extern uint32_t g_idleReleaseSec;
+// --region: clip the overlay window to the border bands with SetWindowRgn. Off, the
+// overlay is a layered click-through window, occlusion is painted into the surfaces and
+// the DComp commit alone presents. Hybrid device creation may switch it back on once if
+// DComp refuses the layered window.
+extern bool g_overlayRegion;
 
 extern HWND g_overlay;
 extern RECT g_virtualScreen;
 
 extern HWINEVENTHOOK g_hook1, g_hook2, g_hook3, g_hook4, g_hook5, g_hook6;
+extern HWINEVENTHOOK g_hook7; // EVENT_OBJECT_NAMECHANGE, only while title style rules exist
+extern HWINEVENTHOOK g_hook8; // EVENT_SYSTEM_MOVESIZESTART / END (MoveSizeSession.h)
+extern HWINEVENTHOOK g_hook9; // EVENT_OBJECT_CLOAKED / UNCLOAKED (virtual desktops, TransitionBurst.h)
 
-extern std::unordered_map<HWND, RECT, HwndHash, HwndEq> g_targets;
-struct AppliedState { COLORREF color; int thickness; };
-extern std::unordered_map<HWND, AppliedState, HwndHash, HwndEq> g_applied;
+// Tracked windows: DComp frame rects/styles and the DWM applied-attribute ledger (render thread only)
+extern WindowRegistry g_windows;
 
 extern Microsoft::WRL::ComPtr<ID2D1Factory1> g_d2dFactory;
 extern Microsoft::WRL::ComPtr<ID2D1Device> g_d2dDevice;
@@ -40,9 +64,8 @@ extern Microsoft::WRL::ComPtr<IDXGIDevice> g_dxgiDevice;
 extern Microsoft::WRL::ComPtr<IDCompositionDevice> g_dcompDevice;
 extern Microsoft::WRL::ComPtr<IDCompositionTarget> g_dcompTarget;
 extern Microsoft::WRL::ComPtr<IDCompositionVisual> g_rootVisual;
+// Parent of the per-monitor surface visuals (OverlayDComp.cpp)
 extern Microsoft::WRL::ComPtr<IDCompositionVisual> g_surfaceVisual;
-extern Microsoft::WRL::ComPtr<IDCompositionSurface> g_surface;
-extern UINT g_surfaceW, g_surfaceH;
 
 extern NOTIFYICONDATAW g_nid;
 extern HICON g_trayIcon;
@@ -50,3 +73,6 @@ extern HICON g_trayIcon;
 // Custom messages
 static constexpr UINT WM_APP_REFRESH = WM_APP + 1;
 static constexpr UINT WM_APP_TRAY = WM_APP + 2;
+static constexpr UINT WM_APP_FOREGROUND = WM_APP + 3; // intake -> UI: re-check fullscreen state
+static constexpr UINT WM_APP_HOOKS = WM_APP + 4;      // thread message to the intake thread, wParam = HookCommand
+static constexpr UINT WM_APP_IDLE = WM_APP + 5;       // render -> UI: wParam 1 = idle resources released, 0 = drawing again
@@ -0,0 +1,33 @@
+#include "IdleResources.h"
+
+bool IdleReclaimer::Frame(size_t drawnWindows, uint64_t nowNs, uint64_t frameNs)
+{
+    if (drawnWindows) {
+        if (m_released) {
+            // This frame rebuilt the surface and caches
+            m_released = false;
+            ++m_rehydrations;
+            m_lastRehydrateNs = frameNs;
+            if (frameNs > m_options.rehydrateBudgetNs) ++m_overBudget;
+        }
+        m_idle = false;
+        return false;
+    }
+    if (!m_idle) {
+        m_idle = true;
+        m_idleSinceNs = nowNs;
+    }
+    return !m_released && m_options.idleNs && nowNs - m_idleSinceNs >= m_options.idleNs;
+}
+
+void IdleReclaimer::Released()
+{
+    m_released = true;
+    ++m_releases;
+}
+
+uint64_t IdleReclaimer::DueNs() const
+{
+    if (!m_idle || m_released || !m_options.idleNs) return 0;
+    return m_idleSinceNs + m_options.idleNs;
+}
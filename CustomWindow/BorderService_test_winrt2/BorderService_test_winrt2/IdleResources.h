@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Idle resource policy. With nothing to draw (every window minimized or cloaked, the
+// overlay suspended for a locked session or a display that is off) the overlay still holds
+// a virtual-screen surface, device caches and a working set sized for the busiest frame.
+// After `idle` with nothing drawn the render thread releases them; the next frame with a
+// border rebuilds what it needs, and its duration is checked against `rehydrateBudget`.
+// Portable; the render thread owns it (Pipeline.cpp, SimBackend.h).
+
+struct IdleOptions {
+    uint64_t idleNs = 10000000000ull;       // 0 = never release
+    uint64_t rehydrateBudgetNs = 50000000;  // first frame after a release
+};
+
+class IdleReclaimer {
+public:
+    explicit IdleReclaimer(const IdleOptions& options = IdleOptions()) : m_options(options) {}
+
+    void SetOptions(const IdleOptions& options) { m_options = options; }
+    const IdleOptions& Options() const { return m_options; }
+
+    // After every render batch: the windows the overlay draws now (0 while suspended) and
+    // how long the batch took. True when the resources are due to be released; the caller
+    // releases them and calls Released.
+    bool Frame(size_t drawnWindows, uint64_t nowNs, uint64_t frameNs);
+    void Released();
+    // When the release falls due if nothing is drawn meanwhile; 0 if none is pending
+    uint64_t DueNs() const;
+    bool IsReleased() const { return m_released; }
+
+    uint64_t Releases() const { return m_releases; }
+    uint64_t Rehydrations() const { return m_rehydrations; }
+    uint64_t LastRehydrateNs() const { return m_lastRehydrateNs; }
+    uint64_t OverBudget() const { return m_overBudget; } // rehydrations slower than the budget
+
+private:
+    IdleOptions m_options;
+    bool m_idle = false;     // nothing drawn since m_idleSinceNs
+    bool m_released = false;
+    uint64_t m_idleSinceNs = 0;
+    uint64_t m_releases = 0, m_rehydrations = 0, m_lastRehydrateNs = 0, m_overBudget = 0;
+};
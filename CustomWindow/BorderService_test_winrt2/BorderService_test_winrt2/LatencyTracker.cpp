@@ -0,0 +1,163 @@
+#include "LatencyTracker.h"
+#include "Metrics.h"
+#include <algorithm>
+
+static size_t BucketOf(uint64_t us)
+{
+    if (us < 16) return static_cast<size_t>(us);
+    int msb = 63;
+    while (!(us >> msb)) --msb;
+    const size_t bucket = 16 + static_cast<size_t>(msb - 4) * 8 + static_cast<size_t>((us >> (msb - 3)) & 7);
+    return std::min(bucket, LatencyHistogram::kBuckets - 1);
+}
+
+// Middle of a bucket, in microseconds
+static uint64_t BucketValue(size_t bucket)
+{
+    if (bucket < 16) return bucket;
+    const int msb = static_cast<int>((bucket - 16) / 8) + 4;
+    const uint64_t width = uint64_t(1) << (msb - 3);
+    const uint64_t low = (uint64_t(1) << msb) + ((bucket - 16) % 8) * width;
+    return low + width / 2;
+}
+
+void LatencyHistogram::Add(uint64_t us)
+{
+    ++m_buckets[BucketOf(us)];
+    ++m_count;
+    m_max = std::max(m_max, us);
+}
+
+void LatencyHistogram::Reset()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const
+{
+    if (!m_count) return 0;
+    const double clamped = std::min(std::max(p, 0.0), 100.0);
+    uint64_t rank = static_cast<uint64_t>(clamped / 100.0 * static_cast<double>(m_count) + 0.999999);
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+        seen += m_buckets[b];
+        if (seen >= rank) return std::min(BucketValue(b), m_max);
+    }
+    return m_max;
+}
+
+std::array<uint64_t, LatencyTracker::kClasses> LatencyTracker::Empty()
+{
+    std::array<uint64_t, kClasses> a;
+    a.fill(kNone);
+    return a;
+}
+
+void LatencyTracker::Note(WindowChange change, uint32_t eventMs)
+{
+    const size_t c = static_cast<size_t>(change);
+    if (change == WindowChange::None || c >= kClasses) return;
+    // The tick count wraps; the unsigned difference is the event's age either way
+    const uint32_t ageMs = m_clock.TickMs() - eventMs;
+    if (eventMs == 0 || ageMs > kMaxEventAgeMs) {
+        ++m_untimed;
+        return;
+    }
+    const uint64_t nowUs = m_clock.NowUs();
+    const uint64_t ageUs = static_cast<uint64_t>(ageMs) * 1000;
+    const uint64_t eventUs = nowUs > ageUs ? nowUs - ageUs : 0;
+    m_batch[c] = std::min(m_batch[c], eventUs);
+    m_batchNoted = true;
+}
+
+void LatencyTracker::Committed()
+{
+    if (!m_batchNoted) return;
+    if (m_pendingCount == kMaxPending) {
+        // The compositor stopped reporting (or nobody polls); the oldest frame is given up
+        m_pendingHead = (m_pendingHead + 1) % kMaxPending;
+        --m_pendingCount;
+        ++m_droppedPending;
+    }
+    Frame& f = m_pending[(m_pendingHead + m_pendingCount) % kMaxPending];
+    f.commitUs = m_clock.NowUs();
+    f.oldestUs = m_batch;
+    ++m_pendingCount;
+    Discard();
+}
+
+void LatencyTracker::Discard()
+{
+    m_batch = Empty();
+    m_batchNoted = false;
+}
+
+size_t LatencyTracker::Poll()
+{
+    PresentTiming t;
+    if (!m_present.Query(t)) return 0;
+
+    // Only what the compositor missed while one of our frames was waiting is counted
+    const bool recent = !t.periodUs || t.vblankUs <= m_lastVblankUs + kMissWindowFrames * t.periodUs;
+    if (m_missedBaseline && m_pendingCount && recent && t.missedFrames > m_lastMissed) {
+        m_missed += t.missedFrames - m_lastMissed;
+    }
+    m_lastMissed = t.missedFrames;
+    m_lastVblankUs = t.vblankUs;
+    m_missedBaseline = true;
+
+    size_t resolved = 0;
+    while (m_pendingCount) {
+        const Frame& f = m_pending[m_pendingHead];
+        if (f.commitUs > t.vblankUs) break;
+        // The first vblank at or after the commit, on the reported vblank's grid
+        uint64_t presentUs = t.vblankUs;
+        if (t.periodUs) presentUs -= (t.vblankUs - f.commitUs) / t.periodUs * t.periodUs;
+        for (size_t c = 0; c < kClasses; ++c) {
+            if (f.oldestUs[c] != kNone) m_histograms[c].Add(presentUs - std::min(f.oldestUs[c], presentUs));
+        }
+        m_pendingHead = (m_pendingHead + 1) % kMaxPending;
+        --m_pendingCount;
+        ++m_frames;
+        ++resolved;
+    }
+    return resolved;
+}
+
+void LatencyTracker::Publish() const
+{
+    struct Row { WindowChange change; Metric p50, p95, p99; };
+    static const Row kRows[] = {
+        { WindowChange::Moved, Metric::LatencyMovedP50Us, Metric::LatencyMovedP95Us, Metric::LatencyMovedP99Us },
+        { WindowChange::Shown, Metric::LatencyShownP50Us, Metric::LatencyShownP95Us, Metric::LatencyShownP99Us },
+        { WindowChange::Hidden, Metric::LatencyHiddenP50Us, Metric::LatencyHiddenP95Us, Metric::LatencyHiddenP99Us },
+        { WindowChange::Destroyed, Metric::LatencyDestroyedP50Us, Metric::LatencyDestroyedP95Us, Metric::LatencyDestroyedP99Us },
+        { WindowChange::Restacked, Metric::LatencyRestackedP50Us, Metric::LatencyRestackedP95Us, Metric::LatencyRestackedP99Us },
+        { WindowChange::Focus, Metric::LatencyFocusP50Us, Metric::LatencyFocusP95Us, Metric::LatencyFocusP99Us },
+        { WindowChange::Renamed, Metric::LatencyRenamedP50Us, Metric::LatencyRenamedP95Us, Metric::LatencyRenamedP99Us },
+        { WindowChange::Refresh, Metric::LatencyRefreshP50Us, Metric::LatencyRefreshP95Us, Metric::LatencyRefreshP99Us },
+        { WindowChange::MoveSizeEnd, Metric::LatencyMoveSizeP50Us, Metric::LatencyMoveSizeP95Us, Metric::LatencyMoveSizeP99Us },
+    };
+    for (const Row& r : kRows) {
+        const LatencyHistogram& h = Histogram(r.change);
+        MetricSet(r.p50, static_cast<int64_t>(h.Percentile(50)));
+        MetricSet(r.p95, static_cast<int64_t>(h.Percentile(95)));
+        MetricSet(r.p99, static_cast<int64_t>(h.Percentile(99)));
+    }
+    MetricSet(Metric::LatencyFrames, static_cast<int64_t>(m_frames));
+    MetricSet(Metric::LatencyMissedFrames, static_cast<int64_t>(m_missed));
+    MetricSet(Metric::LatencyPendingDropped, static_cast<int64_t>(m_droppedPending));
+    MetricSet(Metric::LatencyUntimed, static_cast<int64_t>(m_untimed));
+}
+
+void LatencyTracker::Reset()
+{
+    Discard();
+    m_pendingHead = m_pendingCount = 0;
+    for (auto& h : m_histograms) h.Reset();
+    m_frames = m_missed = m_lastMissed = m_lastVblankUs = m_droppedPending = m_untimed = 0;
+    m_missedBaseline = false;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "EventClassifier.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Event-to-present latency. Every queued event carries its source timestamp (the hooks'
+// dwmsEventTime, or the request time of a refresh); the render thread notes, per change
+// type, the oldest timestamp a batch coalesced, turns the batch into a pending frame when
+// it commits and resolves the frame once the compositor reports a vblank at or after the
+// commit. One sample per change type per frame: the wait of its oldest event. Portable; the
+// clock and the present statistics come from the caller (Pipeline.cpp on Windows).
+//
+// Event timestamps are GetTickCount-based, so latencies carry its 10-16 ms granularity.
+
+// Log-linear histogram of microsecond values: exact below 16, then 8 buckets per power of
+// two (at most 12.5% error)
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 16 + 28 * 8;
+
+    void Add(uint64_t us);
+    void Reset();
+    uint64_t Count() const { return m_count; }
+    uint64_t Max() const { return m_max; }
+    // Nearest-rank percentile (0-100), reported as the middle of its bucket; 0 if empty
+    uint64_t Percentile(double p) const;
+
+private:
+    std::array<uint32_t, kBuckets> m_buckets{};
+    uint64_t m_count = 0;
+    uint64_t m_max = 0;
+};
+
+class LatencyClock {
+public:
+    virtual ~LatencyClock() = default;
+    // Commit and present time, microseconds on a monotonic clock
+    virtual uint64_t NowUs() = 0;
+    // The event timestamps' clock (GetTickCount), wrapping every 49.7 days
+    virtual uint32_t TickMs() = 0;
+};
+
+struct PresentTiming {
+    uint64_t vblankUs = 0;      // a recent vblank the compositor presented on (NowUs clock)
+    uint64_t periodUs = 0;      // refresh period; 0 if unknown
+    uint64_t missedFrames = 0;  // compositor's cumulative missed + dropped frames
+};
+
+class PresentSource {
+public:
+    virtual ~PresentSource() = default;
+    virtual bool Query(PresentTiming& out) = 0;
+};
+
+class LatencyTracker {
+public:
+    static constexpr size_t kClasses = static_cast<size_t>(WindowChange::MoveSizeEnd) + 1;
+    // Frames committed and not yet seen presented; older ones are dropped beyond this
+    static constexpr size_t kMaxPending = 8;
+    // Timestamps older than this (or in the future) are not trusted
+    static constexpr uint32_t kMaxEventAgeMs = 60000;
+    // The compositor's missed-frame counter covers every process and polls only happen with
+    // batches; misses are counted only across polls at most this many vblanks apart
+    static constexpr uint64_t kMissWindowFrames = 4;
+
+    LatencyTracker(LatencyClock& clock, PresentSource& present) : m_clock(clock), m_present(present) {}
+
+    // An event of the current batch; eventMs 0 means no timestamp
+    void Note(WindowChange change, uint32_t eventMs);
+    // The batch was drawn and committed now / drew nothing
+    void Committed();
+    void Discard();
+    // Resolves the pending frames the compositor has presented since; returns how many
+    size_t Poll();
+
+    const LatencyHistogram& Histogram(WindowChange change) const { return m_histograms[static_cast<size_t>(change)]; }
+    size_t Pending() const { return m_pendingCount; }
+    uint64_t Frames() const { return m_frames; }
+    uint64_t MissedFrames() const { return m_missed; }
+    uint64_t DroppedPending() const { return m_droppedPending; }
+    uint64_t Untimed() const { return m_untimed; }
+    // latency.* metrics
+    void Publish() const;
+    void Reset();
+
+private:
+    static constexpr uint64_t kNone = UINT64_MAX;
+
+    struct Frame {
+        uint64_t commitUs = 0;
+        std::array<uint64_t, kClasses> oldestUs; // kNone = no event of the type
+    };
+
+    LatencyClock& m_clock;
+    PresentSource& m_present;
+    std::array<uint64_t, kClasses> m_batch = Empty();
+    bool m_batchNoted = false;
+    std::array<Frame, kMaxPending> m_pending{}; // ring, oldest at m_pendingHead
+    size_t m_pendingHead = 0;
+    size_t m_pendingCount = 0;
+    std::array<LatencyHistogram, kClasses> m_histograms{};
+    uint64_t m_frames = 0;
+    uint64_t m_missed = 0;
+    uint64_t m_lastMissed = 0;
+    uint64_t m_lastVblankUs = 0;
+    bool m_missedBaseline = false;
+    uint64_t m_droppedPending = 0;
+    uint64_t m_untimed = 0;
+
+    static std::array<uint64_t, kClasses> Empty();
+};
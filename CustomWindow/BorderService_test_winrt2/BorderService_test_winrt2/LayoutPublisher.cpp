@@ -0,0 +1,97 @@
+#include "pch.h"
+#include "Globals.h"
+#include "Logging.h"
+#include "DwmUtil.h"
+#include "Metrics.h"
+#include "LayoutSnapshot.h"
+#include "LayoutPublisher.h"
+
+static HANDLE s_mapping = nullptr;
+static void* s_view = nullptr;
+static LayoutWriter s_writer;
+static std::vector<LayoutWindow> s_scratch;
+
+bool OpenLayoutPublisher()
+{
+    // SYSTEM / Administrators / the owner may write; authenticated users of the session
+    // may only map it for reading (the GUI is not elevated when the service is)
+    SECURITY_ATTRIBUTES sa{ sizeof(sa), nullptr, FALSE };
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(
+            L"D:P(A;;GA;;;SY)(A;;GA;;;BA)(A;;GA;;;OW)(A;;GR;;;AU)", SDDL_REVISION_1, &sa.lpSecurityDescriptor, nullptr)) {
+        sa.lpSecurityDescriptor = nullptr;
+    }
+
+    const DWORD bytes = static_cast<DWORD>(LayoutBytes(kLayoutCapacity));
+    s_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, sa.lpSecurityDescriptor ? &sa : nullptr,
+                                   PAGE_READWRITE, 0, bytes, kLayoutMappingName);
+    if (sa.lpSecurityDescriptor) LocalFree(sa.lpSecurityDescriptor);
+    if (!s_mapping) {
+        DebugLog(L"[Layout] CreateFileMapping failed: " + std::to_wstring(GetLastError()));
+        return false;
+    }
+
+    s_view = MapViewOfFile(s_mapping, FILE_MAP_WRITE, 0, 0, bytes);
+    if (!s_view || !s_writer.Attach(s_view, bytes, GetCurrentProcessId())) {
+        DebugLog(L"[Layout] MapViewOfFile failed: " + std::to_wstring(GetLastError()));
+        CloseLayoutPublisher();
+        return false;
+    }
+    s_scratch.reserve(kLayoutCapacity);
+    return true;
+}
+
+static void Publish(uint32_t flags)
+{
+    s_scratch.clear();
+    const bool dwm = g_mode == RenderMode::Dwm;
+    const HWND foreground = GetForegroundWindow();
+
+    // Order() is the last refresh pass: the windows currently bordered, topmost first.
+    // A stopped service publishes no windows.
+    static const std::vector<WindowRegistry::Slot> none;
+    for (WindowRegistry::Slot s : (flags & kLayoutStopped) ? none : g_windows.Order()) {
+        const HWND h = KeyHwnd(g_windows.Handle(s));
+        const BorderStyle& style = g_windows.Style(s);
+        LayoutWindow w;
+        w.hwnd = g_windows.Handle(s);
+        if (dwm) {
+            // DWM mode does not keep rects in the registry
+            RECT rc{};
+            if (GetWindowBounds(h, rc)) w.rect = { rc.left, rc.top, rc.right, rc.bottom };
+        } else {
+            w.rect = g_windows.Rect(s);
+        }
+        w.flags = kLayoutVisible;
+        if (g_windows.Flags(s) & WindowRegistry::kApplied) w.flags |= kLayoutApplied;
+        if (g_mode == RenderMode::DComp || (g_windows.Flags(s) & WindowRegistry::kOverlay)) w.flags |= kLayoutOverlay;
+        if (h == foreground) w.flags |= kLayoutForeground;
+        w.color = LayoutColor(style.color);
+        w.thickness = style.thickness;
+        w.corner = style.corner;
+        s_scratch.push_back(w);
+    }
+
+    const WindowRect screen{ g_virtualScreen.left, g_virtualScreen.top, g_virtualScreen.right, g_virtualScreen.bottom };
+    if (dwm) flags |= kLayoutDwmMode;
+    else if (g_mode == RenderMode::Hybrid) flags |= kLayoutHybridMode;
+    s_writer.Publish(screen, s_scratch, flags);
+    MetricAdd(Metric::LayoutPublishes);
+    MetricSet(Metric::LayoutWindows, static_cast<int64_t>(s_scratch.size()));
+}
+
+void PublishLayout()
+{
+    if (!s_writer.Attached()) return;
+    Publish(0);
+}
+
+void CloseLayoutPublisher()
+{
+    // Readers keep the final layout but can tell the service is gone
+    if (s_writer.Attached()) Publish(kLayoutStopped);
+    s_writer = LayoutWriter{};
+    if (s_view) UnmapViewOfFile(s_view);
+    if (s_mapping) CloseHandle(s_mapping);
+    s_view = nullptr;
+    s_mapping = nullptr;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "pch.h"
+
+// Publishes the tracked windows (g_windows) into a named shared-memory region after every
+// refresh, so another process can read the service's live view without enumerating windows.
+// Format and seqlock: LayoutSnapshot.h. Other processes get read access only.
+static constexpr const wchar_t* kLayoutMappingName = L"Local\\BorderServiceLayout";
+static constexpr uint32_t kLayoutCapacity = 1024;
+
+// Main thread, before the first frame. Publishing is skipped if the region cannot be created.
+bool OpenLayoutPublisher();
+// Render thread (or main before the render thread starts): after each refresh pass
+void PublishLayout();
+// After StopEventPipeline: marks the layout stopped and releases the mapping
+void CloseLayoutPublisher();
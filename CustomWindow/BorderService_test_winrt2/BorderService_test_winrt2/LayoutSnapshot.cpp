@@ -0,0 +1,170 @@
+#include "LayoutSnapshot.h"
+#include <cstring>
+
+// The region is shared with other processes, so the words must be plain 64-bit cells
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "layout words must be 8 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "layout words must be lock-free");
+
+static constexpr size_t kHeaderWords = kLayoutHeaderBytes / 8;
+static constexpr size_t kRecordWords = kLayoutRecordBytes / 8;
+
+enum HeaderWord : size_t { kWordMagic, kWordSizes, kWordCapacity, kWordSequence, kWordFrame, kWordCount, kWordScreenLT, kWordScreenRB };
+
+static uint64_t Pack(uint32_t lo, uint32_t hi) { return static_cast<uint64_t>(lo) | (static_cast<uint64_t>(hi) << 32); }
+static uint64_t PackInts(int32_t lo, int32_t hi) { return Pack(static_cast<uint32_t>(lo), static_cast<uint32_t>(hi)); }
+static uint32_t Lo(uint64_t w) { return static_cast<uint32_t>(w); }
+static uint32_t Hi(uint64_t w) { return static_cast<uint32_t>(w >> 32); }
+
+static uint32_t FloatBits(float f)
+{
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static float BitsFloat(uint32_t u)
+{
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+size_t LayoutBytes(uint32_t capacity)
+{
+    return kLayoutHeaderBytes + static_cast<size_t>(capacity) * kLayoutRecordBytes;
+}
+
+uint32_t LayoutColor(const ColorF& c)
+{
+    auto channel = [](float v) {
+        if (v <= 0.0f) return 0u;
+        if (v >= 1.0f) return 255u;
+        return static_cast<uint32_t>(v * 255.0f + 0.5f);
+    };
+    return (channel(c.a) << 24) | (channel(c.r) << 16) | (channel(c.g) << 8) | channel(c.b);
+}
+
+bool LayoutWriter::Attach(void* memory, size_t bytes, uint32_t writerPid)
+{
+    if (!memory || bytes < kLayoutHeaderBytes) return false;
+    m_words = static_cast<std::atomic<uint64_t>*>(memory);
+    m_capacity = static_cast<uint32_t>((bytes - kLayoutHeaderBytes) / kLayoutRecordBytes);
+
+    // A restarted writer keeps the sequence going so readers never see it go backwards
+    uint64_t seq = m_words[kWordSequence].load(std::memory_order_relaxed);
+    if (seq & 1) ++seq;
+    m_frame = m_words[kWordMagic].load(std::memory_order_relaxed) == Pack(kLayoutMagic, kLayoutVersion)
+        ? m_words[kWordFrame].load(std::memory_order_relaxed) : 0;
+
+    m_words[kWordSequence].store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_words[kWordSizes].store(Pack(kLayoutHeaderBytes, kLayoutRecordBytes), std::memory_order_relaxed);
+    m_words[kWordCapacity].store(Pack(m_capacity, writerPid), std::memory_order_relaxed);
+    m_words[kWordFrame].store(m_frame, std::memory_order_relaxed);
+    m_words[kWordCount].store(0, std::memory_order_relaxed);
+    m_words[kWordScreenLT].store(0, std::memory_order_relaxed);
+    m_words[kWordScreenRB].store(0, std::memory_order_relaxed);
+    m_words[kWordMagic].store(Pack(kLayoutMagic, kLayoutVersion), std::memory_order_relaxed);
+    m_words[kWordSequence].store(seq + 2, std::memory_order_release);
+    return true;
+}
+
+void LayoutWriter::Publish(const WindowRect& screen, const std::vector<LayoutWindow>& windows, uint32_t flags)
+{
+    if (!m_words) return;
+    uint32_t count = static_cast<uint32_t>(windows.size());
+    if (count > m_capacity) {
+        count = m_capacity;
+        flags |= kLayoutTruncated;
+    }
+
+    // Seqlock: odd sequence, fence, relaxed payload stores, then the even sequence publishes
+    const uint64_t seq = m_words[kWordSequence].load(std::memory_order_relaxed);
+    m_words[kWordSequence].store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::atomic<uint64_t>* rec = m_words + kHeaderWords;
+    for (uint32_t i = 0; i < count; ++i, rec += kRecordWords) {
+        const LayoutWindow& w = windows[i];
+        rec[0].store(w.hwnd, std::memory_order_relaxed);
+        rec[1].store(PackInts(w.rect.left, w.rect.top), std::memory_order_relaxed);
+        rec[2].store(PackInts(w.rect.right, w.rect.bottom), std::memory_order_relaxed);
+        rec[3].store(Pack(w.color, FloatBits(w.thickness)), std::memory_order_relaxed);
+        rec[4].store(Pack(w.flags, static_cast<uint32_t>(w.corner)), std::memory_order_relaxed);
+    }
+    m_words[kWordFrame].store(++m_frame, std::memory_order_relaxed);
+    m_words[kWordCount].store(Pack(count, flags), std::memory_order_relaxed);
+    m_words[kWordScreenLT].store(PackInts(screen.left, screen.top), std::memory_order_relaxed);
+    m_words[kWordScreenRB].store(PackInts(screen.right, screen.bottom), std::memory_order_relaxed);
+
+    m_words[kWordSequence].store(seq + 2, std::memory_order_release);
+}
+
+bool LayoutReader::Attach(const void* memory, size_t bytes)
+{
+    if (!memory || bytes < kLayoutHeaderBytes) return false;
+    m_words = static_cast<const std::atomic<uint64_t>*>(memory);
+    m_bytes = bytes;
+    return true;
+}
+
+LayoutReader::Result LayoutReader::TryRead(LayoutFrame& out, int attempts, uint64_t* retries) const
+{
+    if (!m_words) return Result::Invalid;
+    for (int attempt = 0; attempt < attempts; ++attempt) {
+        const uint64_t seq = m_words[kWordSequence].load(std::memory_order_acquire);
+        if (seq & 1) {
+            if (retries) ++*retries;
+            continue;
+        }
+        if (m_words[kWordMagic].load(std::memory_order_relaxed) != Pack(kLayoutMagic, kLayoutVersion)) {
+            // A writer may still be attaching (sequence 0 = never written)
+            if (seq == 0) return Result::Busy;
+            return Result::Invalid;
+        }
+        const uint64_t sizes = m_words[kWordSizes].load(std::memory_order_relaxed);
+        const uint64_t capacity = m_words[kWordCapacity].load(std::memory_order_relaxed);
+        const uint64_t countFlags = m_words[kWordCount].load(std::memory_order_relaxed);
+        const uint64_t lt = m_words[kWordScreenLT].load(std::memory_order_relaxed);
+        const uint64_t rb = m_words[kWordScreenRB].load(std::memory_order_relaxed);
+        out.frame = m_words[kWordFrame].load(std::memory_order_relaxed);
+
+        // Torn header values can be nonsense; bound the copy before trusting them
+        uint32_t count = Lo(countFlags);
+        const bool sane = Lo(sizes) == kLayoutHeaderBytes && Hi(sizes) == kLayoutRecordBytes &&
+                          count <= Lo(capacity) && LayoutBytes(count) <= m_bytes;
+        if (!sane) count = 0;
+
+        out.windows.resize(count);
+        const std::atomic<uint64_t>* rec = m_words + kHeaderWords;
+        for (uint32_t i = 0; i < count; ++i, rec += kRecordWords) {
+            LayoutWindow& w = out.windows[i];
+            const uint64_t w0 = rec[0].load(std::memory_order_relaxed);
+            const uint64_t w1 = rec[1].load(std::memory_order_relaxed);
+            const uint64_t w2 = rec[2].load(std::memory_order_relaxed);
+            const uint64_t w3 = rec[3].load(std::memory_order_relaxed);
+            const uint64_t w4 = rec[4].load(std::memory_order_relaxed);
+            w.hwnd = w0;
+            w.rect = { static_cast<int32_t>(Lo(w1)), static_cast<int32_t>(Hi(w1)),
+                       static_cast<int32_t>(Lo(w2)), static_cast<int32_t>(Hi(w2)) };
+            w.color = Lo(w3);
+            w.thickness = BitsFloat(Hi(w3));
+            w.flags = Lo(w4);
+            w.corner = static_cast<CornerStyle>(Hi(w4));
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_words[kWordSequence].load(std::memory_order_relaxed) != seq) {
+            if (retries) ++*retries;
+            continue;
+        }
+        if (!sane) return Result::Invalid;
+        out.sequence = seq;
+        out.flags = Hi(countFlags);
+        out.writerPid = Hi(capacity);
+        out.screen = { static_cast<int32_t>(Lo(lt)), static_cast<int32_t>(Hi(lt)),
+                       static_cast<int32_t>(Lo(rb)), static_cast<int32_t>(Hi(rb)) };
+        return Result::Ok;
+    }
+    return Result::Busy;
+}
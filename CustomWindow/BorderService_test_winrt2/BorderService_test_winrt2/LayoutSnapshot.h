@@ -0,0 +1,102 @@
+#pragma once
+#include "WindowRegistry.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Window layout published for other processes (mapped read-only, see LayoutPublisher.h).
+// Portable.
+//
+// Binary format, little-endian, every field an aligned 64-bit word:
+//   header (64 bytes)
+//     +0  magic 'BSLY' | version << 32
+//     +8  headerBytes | recordBytes << 32
+//     +16 capacity | writer pid << 32
+//     +24 sequence   seqlock: odd while the writer is inside Publish
+//     +32 frame      number of completed publishes
+//     +40 count | flags << 32              (LayoutFlag)
+//     +48 screen left | top << 32
+//     +56 screen right | bottom << 32
+//   record i at 64 + 40 * i
+//     +0  hwnd
+//     +8  left | top << 32
+//     +16 right | bottom << 32
+//     +24 color 0xAARRGGBB | thickness (float bits) << 32
+//     +32 flags | corner << 32             (LayoutWindowFlag, CornerStyle)
+// Readers copy header and records, then accept the copy only if the sequence was even
+// and unchanged; the writer never waits for them.
+
+static constexpr uint32_t kLayoutMagic = 0x594C5342; // "BSLY"
+static constexpr uint32_t kLayoutVersion = 1;
+static constexpr uint32_t kLayoutHeaderBytes = 64;
+static constexpr uint32_t kLayoutRecordBytes = 40;
+
+enum LayoutFlag : uint32_t {
+    kLayoutTruncated = 1u << 0, // more windows were tracked than the region holds
+    kLayoutStopped = 1u << 1,   // service has exited; the contents are final
+    kLayoutDwmMode = 1u << 2,   // borders are DWM attributes rather than the overlay
+    kLayoutHybridMode = 1u << 3, // DWM attributes, overlay for the kLayoutOverlay windows
+};
+
+enum LayoutWindowFlag : uint32_t {
+    kLayoutVisible = 1u << 0,
+    kLayoutApplied = 1u << 1,   // DWM attributes written (DWM mode)
+    kLayoutForeground = 1u << 2,
+    kLayoutOverlay = 1u << 3,   // border drawn by the overlay (DComp mode, hybrid fallback)
+};
+
+struct LayoutWindow {
+    uint64_t hwnd = 0;
+    WindowRect rect;
+    uint32_t flags = 0;         // LayoutWindowFlag
+    uint32_t color = 0;         // 0xAARRGGBB
+    float thickness = 0.0f;
+    CornerStyle corner = CornerStyle::Default;
+};
+
+struct LayoutFrame {
+    uint64_t sequence = 0;
+    uint64_t frame = 0;
+    uint32_t flags = 0;         // LayoutFlag
+    uint32_t writerPid = 0;
+    WindowRect screen;
+    std::vector<LayoutWindow> windows;
+};
+
+// Bytes needed for a region holding capacity records
+size_t LayoutBytes(uint32_t capacity);
+uint32_t LayoutColor(const ColorF& c);
+
+class LayoutWriter {
+public:
+    // memory must be 8-byte aligned, zeroed or previously written by a LayoutWriter.
+    // Fails if bytes cannot hold the header.
+    bool Attach(void* memory, size_t bytes, uint32_t writerPid);
+    bool Attached() const { return m_words != nullptr; }
+    uint32_t Capacity() const { return m_capacity; }
+
+    // Single writer. Windows beyond Capacity() are dropped and kLayoutTruncated is set.
+    void Publish(const WindowRect& screen, const std::vector<LayoutWindow>& windows, uint32_t flags);
+    uint64_t Frames() const { return m_frame; }
+
+private:
+    std::atomic<uint64_t>* m_words = nullptr;
+    uint32_t m_capacity = 0;
+    uint64_t m_frame = 0;
+};
+
+class LayoutReader {
+public:
+    enum class Result { Ok, Busy, Invalid };
+
+    bool Attach(const void* memory, size_t bytes);
+
+    // Invalid: not a layout region (or an unknown version). Busy: every attempt overlapped
+    // a publish; try again later.
+    Result TryRead(LayoutFrame& out, int attempts = 16, uint64_t* retries = nullptr) const;
+
+private:
+    const std::atomic<uint64_t>* m_words = nullptr;
+    size_t m_bytes = 0;
+};
@@ -0,0 +1,203 @@
+#include "pch.h"
+#include "Globals.h"
+#include "Logging.h"
+#include "DwmUtil.h"
+#include "Metrics.h"
+#include "AppliedLedger.h"
+#include "LedgerFile.h"
+#include "ExitRestore.h"
+#include <unordered_set>
+
+static HANDLE s_file = INVALID_HANDLE_VALUE;
+static HANDLE s_mapping = nullptr;
+static void* s_view = nullptr;
+static LedgerWriter s_writer;
+static std::vector<LedgerEntry> s_scratch;
+
+static std::wstring LedgerPath()
+{
+    wchar_t base[MAX_PATH] = {};
+    DWORD n = GetEnvironmentVariableW(L"LOCALAPPDATA", base, MAX_PATH);
+    if (n == 0 || n >= MAX_PATH) return std::wstring();
+    std::wstring dir = std::wstring(base) + L"\\CustomWindow";
+    CreateDirectoryW(dir.c_str(), nullptr);
+    return dir + L"\\border_ledger.bin";
+}
+
+uint64_t WindowIdentity(HWND h)
+{
+    DWORD pid = 0;
+    const DWORD tid = GetWindowThreadProcessId(h, &pid);
+    if (!tid) return 0;
+
+    uint64_t created = 0;
+    if (HANDLE p = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid)) {
+        FILETIME creation{}, exit{}, kernel{}, user{};
+        if (GetProcessTimes(p, &creation, &exit, &kernel, &user)) {
+            created = (static_cast<uint64_t>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime;
+        }
+        CloseHandle(p);
+    }
+    // Protected processes refuse the query; pid + tid alone still rule out most reuse
+    uint64_t id = (static_cast<uint64_t>(pid) << 32) | tid;
+    id ^= created * 0x9E3779B97F4A7C15ull;
+    return id ? id : 1;
+}
+
+// System defaults back on one window. An entry without an identity comes from this
+// instance's registry, whose windows were tracked until now: the HWND alone is trusted.
+static bool RestoreEntry(const LedgerEntry& e)
+{
+    HWND h = KeyHwnd(e.hwnd);
+    if (!IsWindow(h)) return false;
+    if (e.identity && WindowIdentity(h) != e.identity) return false;
+    COLORREF defaultColor = DWMWA_COLOR_DEFAULT;
+    int defaultThick = 1;
+    DwmSetWindowAttribute(h, DWMWA_BORDER_COLOR, &defaultColor, sizeof(defaultColor));
+    DwmSetWindowAttribute(h, DWMWA_VISIBLE_FRAME_BORDER_THICKNESS, &defaultThick, sizeof(defaultThick));
+    if (e.border.corner != CornerStyle::Default) ApplyCornerPreference(h, CornerStyle::Default);
+    return true;
+}
+
+static void RestoreDefaults(const std::vector<LedgerEntry>& entries)
+{
+    for (const LedgerEntry& e : entries) {
+        if (e.identity && RestoreEntry(e)) MetricAdd(Metric::LedgerRestored);
+    }
+}
+
+// DwmSetWindowAttribute goes through the window's thread; a hung window blocks the worker
+// that picked it, not the exit
+class DwmRestoreTarget : public RestoreTarget {
+public:
+    RestoreOutcome Restore(const LedgerEntry& entry) override
+    {
+        return RestoreEntry(entry) ? RestoreOutcome::Restored : RestoreOutcome::Skipped;
+    }
+};
+
+bool OpenAppliedLedger()
+{
+    const std::wstring path = LedgerPath();
+    if (path.empty()) return false;
+
+    // Exclusive: a second service instance must not interleave its writes with ours
+    s_file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (s_file == INVALID_HANDLE_VALUE) {
+        DebugLog(L"[Ledger] CreateFile failed: " + std::to_wstring(GetLastError()));
+        return false;
+    }
+    const DWORD bytes = static_cast<DWORD>(LedgerBytes(kLedgerCapacity));
+    LARGE_INTEGER size{};
+    GetFileSizeEx(s_file, &size);
+    if (size.QuadPart != bytes) {
+        // New file, or one written with another capacity: start over (zeroed = empty)
+        LARGE_INTEGER zero{};
+        SetFilePointerEx(s_file, zero, nullptr, FILE_BEGIN);
+        SetEndOfFile(s_file);
+        LARGE_INTEGER end{};
+        end.QuadPart = bytes;
+        SetFilePointerEx(s_file, end, nullptr, FILE_BEGIN);
+        SetEndOfFile(s_file);
+    }
+
+    s_mapping = CreateFileMappingW(s_file, nullptr, PAGE_READWRITE, 0, bytes, nullptr);
+    s_view = s_mapping ? MapViewOfFile(s_mapping, FILE_MAP_WRITE, 0, 0, bytes) : nullptr;
+    if (!s_view) {
+        DebugLog(L"[Ledger] Mapping failed: " + std::to_wstring(GetLastError()));
+        CloseAppliedLedger();
+        return false;
+    }
+
+    std::vector<LedgerEntry> entries;
+    uint32_t previousPid = 0;
+    const LedgerResult result = ReadLedger(s_view, bytes, entries, &previousPid);
+    if (result == LedgerResult::Invalid || result == LedgerResult::Torn) MetricAdd(Metric::LedgerInvalid);
+
+    if (UsesDwmAttributes()) {
+        const LedgerAdoption adoption = AdoptLedger(entries, g_windows, [](uint64_t hwnd) {
+            HWND h = KeyHwnd(hwnd);
+            return IsWindow(h) ? WindowIdentity(h) : 0;
+        });
+        MetricSet(Metric::LedgerAdopted, static_cast<int64_t>(adoption.adopted));
+        MetricSet(Metric::LedgerStale, static_cast<int64_t>(adoption.stale));
+        DebugLog(L"[Ledger] " + std::wstring(result == LedgerResult::Ok ? L"Adopted " : L"No usable ledger, adopted ") +
+                 std::to_wstring(adoption.adopted) + L" windows from pid " + std::to_wstring(previousPid) +
+                 L" (" + std::to_wstring(adoption.stale) + L" stale)");
+    } else {
+        // DComp mode draws every border itself; take back what a DWM-mode instance left behind
+        RestoreDefaults(entries);
+        entries.clear();
+    }
+
+    s_writer.Attach(s_view, bytes, GetCurrentProcessId());
+    s_scratch.reserve(kLedgerCapacity);
+    // Rewrite at once: adopted entries only, or empty in DComp mode
+    SaveAppliedLedger();
+    return true;
+}
+
+void SaveAppliedLedger()
+{
+    if (!s_writer.Attached()) return;
+    for (WindowRegistry::Slot s = 0; s < g_windows.SlotCount(); ++s) {
+        if (!g_windows.IsLive(s) || !(g_windows.Flags(s) & WindowRegistry::kApplied)) continue;
+        if (!g_windows.Identity(s)) g_windows.Identity(s) = WindowIdentity(KeyHwnd(g_windows.Handle(s)));
+    }
+    CollectLedger(g_windows, s_scratch);
+    if (s_writer.Write(s_scratch) < s_scratch.size()) {
+        DebugLog(L"[Ledger] " + std::to_wstring(s_scratch.size()) + L" applied windows, only " +
+                 std::to_wstring(s_writer.Capacity()) + L" recorded");
+    }
+    MetricAdd(Metric::LedgerWrites);
+}
+
+void RestoreAppliedBorders(uint32_t deadlineMs)
+{
+    if (!UsesDwmAttributes()) return;
+    std::vector<LedgerEntry> entries;
+    CollectLedger(g_windows, entries);
+    if (entries.empty()) return;
+    if (!deadlineMs) {
+        DebugLog(L"[Ledger] Keeping borders on " + std::to_wstring(entries.size()) + L" windows for the next instance");
+        return;
+    }
+
+    // Abandoned workers may still call it after we return
+    static DwmRestoreTarget s_target;
+    RestoreOptions options;
+    options.workers = 4;
+    options.batch = 8;
+    options.deadlineNs = static_cast<uint64_t>(deadlineMs) * 1000000ull;
+    const RestoreReport report = RestoreInParallel(entries, s_target, options);
+
+    // Only what is still bordered stays in the ledger (CloseAppliedLedger writes it)
+    std::unordered_set<uint64_t> unfinished;
+    for (const LedgerEntry& e : report.unfinished) unfinished.insert(e.hwnd);
+    for (const LedgerEntry& e : entries) {
+        if (!unfinished.count(e.hwnd)) g_windows.Release(e.hwnd);
+    }
+
+    MetricSet(Metric::ExitRestored, static_cast<int64_t>(report.restored));
+    MetricSet(Metric::ExitSkipped, static_cast<int64_t>(report.skipped));
+    MetricSet(Metric::ExitTimedOut, static_cast<int64_t>(report.timedOut));
+    MetricSet(Metric::ExitRestoreUs, static_cast<int64_t>(report.elapsedNs / 1000));
+    DebugLogF(L"[Ledger] Exit restore: %zu restored, %zu skipped, %zu timed out (%llu ms, %zu workers abandoned)",
+              report.restored, report.skipped, report.timedOut,
+              static_cast<unsigned long long>(report.elapsedNs / 1000000), report.abandonedWorkers);
+}
+
+void CloseAppliedLedger()
+{
+    if (s_writer.Attached()) {
+        SaveAppliedLedger();
+        FlushViewOfFile(s_view, 0);
+    }
+    s_writer = LedgerWriter{};
+    if (s_view) UnmapViewOfFile(s_view);
+    if (s_mapping) CloseHandle(s_mapping);
+    if (s_file != INVALID_HANDLE_VALUE) CloseHandle(s_file);
+    s_view = nullptr;
+    s_mapping = nullptr;
+    s_file = INVALID_HANDLE_VALUE;
+}
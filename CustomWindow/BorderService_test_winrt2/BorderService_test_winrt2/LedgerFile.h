@@ -0,0 +1,26 @@
+#pragma once
+#include "pch.h"
+
+// Applied-state ledger (format: AppliedLedger.h) in a small memory-mapped file,
+// %LOCALAPPDATA%\CustomWindow\border_ledger.bin, so a restarted service knows which
+// windows already carry its DWM attributes.
+static constexpr uint32_t kLedgerCapacity = 1024;
+
+// Creator identity of a window: its process and thread ids and the process creation
+// time, so an HWND value reused by a later window never matches. 0 if the window is gone.
+uint64_t WindowIdentity(HWND h);
+
+// Main thread, before the first DWM pass. DWM / hybrid modes adopt the live entries into
+// g_windows; DComp mode restores them to the system defaults. Runs without the file if it
+// cannot be mapped.
+bool OpenAppliedLedger();
+// Render thread (or main before the render thread starts): after a DWM pass that changed
+// any window's attributes
+void SaveAppliedLedger();
+// After StopEventPipeline, before CloseAppliedLedger: puts the system default attributes
+// back on every window this instance bordered, on worker threads, for at most deadlineMs.
+// Windows that are gone are skipped; the ones not reached in time stay in the ledger for
+// the next instance. 0 keeps every border (the next instance adopts them).
+void RestoreAppliedBorders(uint32_t deadlineMs);
+// After StopEventPipeline: writes the final state and releases the mapping
+void CloseAppliedLedger();
@@ -1,5 +1,6 @@
 #pragma once
 #include "pch.h"
+#include <cstdarg>
 #include <string>
 
 inline void DebugLog(const std::wstring& s)
@@ -10,6 +11,30 @@ inline void DebugLog(const std::wstring& s)
     }
 }
 
+// printf-style DebugLog for per-frame paths: formats into a stack buffer (long lines are
+// truncated), so logging a frame does not touch the heap
+inline void DebugLogF(_Printf_format_string_ const wchar_t* fmt, ...)
+{
+    wchar_t buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = _vsnwprintf_s(buf, _countof(buf) - 1, _TRUNCATE, fmt, args);
+    va_end(args);
+    if (n < 0) n = static_cast<int>(wcslen(buf));
+    if (GetConsoleWindow()) {
+        _putws(buf);
+    }
+    buf[n] = L'\n';
+    buf[n + 1] = L'\0';
+    OutputDebugStringW(buf);
+}
+
+// ASCII-only narrow -> wide (metric names, policy reasons)
+inline std::wstring ToWide(const std::string& s)
+{
+    return std::wstring(s.begin(), s.end());
+}
+
 inline void EnsureConsole(bool enable)
 {
     if (!enable) return;
@@ -0,0 +1,58 @@
+#include "Metrics.h"
+#include <atomic>
+
+namespace {
+    constexpr size_t kMetricCount = static_cast<size_t>(Metric::Count);
+    std::atomic<int64_t> s_values[kMetricCount];
+
+    const char* const s_names[kMetricCount] = {
+#define METRIC_NAME(id, name) name,
+        METRICS_LIST(METRIC_NAME)
+#undef METRIC_NAME
+    };
+}
+
+void MetricAdd(Metric m, int64_t delta)
+{
+    s_values[static_cast<size_t>(m)].fetch_add(delta, std::memory_order_relaxed);
+}
+
+void MetricSet(Metric m, int64_t value)
+{
+    s_values[static_cast<size_t>(m)].store(value, std::memory_order_relaxed);
+}
+
+void MetricMax(Metric m, int64_t value)
+{
+    auto& slot = s_values[static_cast<size_t>(m)];
+    int64_t cur = slot.load(std::memory_order_relaxed);
+    while (value > cur && !slot.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+}
+
+int64_t MetricGet(Metric m)
+{
+    return s_values[static_cast<size_t>(m)].load(std::memory_order_relaxed);
+}
+
+const char* MetricName(Metric m)
+{
+    return s_names[static_cast<size_t>(m)];
+}
+
+void ResetMetrics()
+{
+    for (auto& v : s_values) v.store(0, std::memory_order_relaxed);
+}
+
+std::string FormatMetrics()
+{
+    std::string out;
+    out.reserve(kMetricCount * 32);
+    for (size_t i = 0; i < kMetricCount; ++i) {
+        if (i) out += ' ';
+        out += s_names[i];
+        out += '=';
+        out += std::to_string(s_values[i].load(std::memory_order_relaxed));
+    }
+    return out;
+}
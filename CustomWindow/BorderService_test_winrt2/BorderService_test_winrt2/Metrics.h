@@ -0,0 +1,168 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Service-wide counters and gauges.
+// Portable (no Windows headers) so the policy/core modules can use it on any platform.
+// Add new entries to METRICS_LIST; the name is what STATS / --bench report.
+#define METRICS_LIST(X) \
+    X(PowerState,           "power.state") \
+    X(PowerTransitions,     "power.transitions") \
+    X(PowerHooksSuspended,  "power.hooks_suspended") \
+    X(PowerRefreshMs,       "power.refresh_ms") \
+    X(ExclusionNames,           "exclusion.names") \
+    X(ExclusionLookups,         "exclusion.lookups") \
+    X(ExclusionCacheHits,       "exclusion.cache_hits") \
+    X(ExclusionCacheMisses,     "exclusion.cache_misses") \
+    X(ExclusionHitRatePct,      "exclusion.hit_rate_pct") \
+    X(ExclusionInvalidations,   "exclusion.invalidations") \
+    X(ExclusionCacheSize,       "exclusion.cache_size") \
+    X(ExclusionExcludedWindows, "exclusion.excluded_windows") \
+    X(RulesCount,           "rules.count") \
+    X(RulesInvalidLines,    "rules.invalid_lines") \
+    X(RulesCompileUs,       "rules.compile_us") \
+    X(RulesEvaluations,     "rules.evaluations") \
+    X(RulesCacheHits,       "rules.cache_hits") \
+    X(RulesCachedWindows,   "rules.cached_windows") \
+    X(StartupSnapshotLoaded, "startup.snapshot_loaded") \
+    X(StartupArgsUs,        "startup.args_us") \
+    X(StartupEnumUs,        "startup.enum_us") \
+    X(StartupDevicesUs,     "startup.devices_us") \
+    X(StartupFirstCommitUs, "startup.first_commit_us") \
+    X(StartupReadyUs,       "startup.ready_us") \
+    X(QueuePushed,          "queue.pushed") \
+    X(QueueDropped,         "queue.dropped") \
+    X(QueueDepth,           "queue.depth") \
+    X(QueueMaxDepth,        "queue.max_depth") \
+    X(QueueBatches,         "queue.batches") \
+    X(QueueBatchMax,        "queue.batch_max") \
+    X(QueueResyncs,         "queue.overflow_resyncs") \
+    X(QueueTasks,           "queue.tasks") \
+    X(ClassifyMovedAccepted,     "classify.moved.accepted") \
+    X(ClassifyMovedRejected,     "classify.moved.rejected") \
+    X(ClassifyShownAccepted,     "classify.shown.accepted") \
+    X(ClassifyShownRejected,     "classify.shown.rejected") \
+    X(ClassifyHiddenAccepted,    "classify.hidden.accepted") \
+    X(ClassifyHiddenRejected,    "classify.hidden.rejected") \
+    X(ClassifyDestroyedAccepted, "classify.destroyed.accepted") \
+    X(ClassifyDestroyedRejected, "classify.destroyed.rejected") \
+    X(ClassifyRestackedAccepted, "classify.restacked.accepted") \
+    X(ClassifyRestackedRejected, "classify.restacked.rejected") \
+    X(ClassifyFocusAccepted,     "classify.focus.accepted") \
+    X(ClassifyFocusRejected,     "classify.focus.rejected") \
+    X(ClassifyRenamedAccepted,   "classify.renamed.accepted") \
+    X(ClassifyRenamedRejected,   "classify.renamed.rejected") \
+    X(ClassifyMoveSizeAccepted,  "classify.movesize.accepted") \
+    X(ClassifyMoveSizeRejected,  "classify.movesize.rejected") \
+    X(ClassifyUnknownRejected,   "classify.unknown.rejected") \
+    X(LayoutPublishes,      "layout.publishes") \
+    X(LayoutWindows,        "layout.windows") \
+    X(RenderDwmWindows,     "render.dwm_windows") \
+    X(RenderOverlayWindows, "render.overlay_windows") \
+    X(RenderRedraws,        "render.redraws") \
+    X(TierForegroundWindows, "tier.foreground_windows") \
+    X(TierForegroundUs,     "tier.foreground_us") \
+    X(TierBackgroundWindows, "tier.background_windows") \
+    X(TierBacklog,          "tier.backlog") \
+    X(TierBacklogMax,       "tier.backlog_max") \
+    X(TierSlices,           "tier.slices") \
+    X(TierDrainUs,          "tier.drain_us") \
+    X(BurstCount,           "burst.count") \
+    X(BurstLastEvents,      "burst.last_events") \
+    X(BurstLastWindows,     "burst.last_windows") \
+    X(BurstMaxEvents,       "burst.max_events") \
+    X(BurstSettleUs,        "burst.settle_us") \
+    X(CloakQueries,         "cloak.queries") \
+    X(CloakCacheHits,       "cloak.cache_hits") \
+    X(SettingsVersion,      "settings.version") \
+    X(SettingsPassesAbandoned, "settings.passes_abandoned") \
+    X(AtlasHits,            "atlas.hits") \
+    X(AtlasMisses,          "atlas.misses") \
+    X(AtlasEvictions,       "atlas.evictions") \
+    X(EffectRetargets,      "effect.retargets") \
+    X(EffectDraws,          "effect.draws") \
+    X(EffectAnimations,     "effect.animations") \
+    X(MonitorCount,         "monitor.count") \
+    X(MonitorRebuilds,      "monitor.rebuilds") \
+    X(MonitorDraws,         "monitor.draws") \
+    X(MonitorUntouched,     "monitor.untouched") \
+    X(MonitorDeferred,      "monitor.deferred") \
+    X(MoveSizeSessions,     "movesize.sessions") \
+    X(MoveSizeFrames,       "movesize.frames") \
+    X(MoveSizeLastFrames,   "movesize.last_frames") \
+    X(MoveSizeLastP99Us,    "movesize.last_p99_us") \
+    X(MoveSizeDeferred,     "movesize.deferred") \
+    X(LedgerAdopted,        "ledger.adopted") \
+    X(LedgerSkipped,        "ledger.skipped") \
+    X(LedgerStale,          "ledger.stale") \
+    X(LedgerRestored,       "ledger.restored") \
+    X(LedgerWrites,         "ledger.writes") \
+    X(LedgerInvalid,        "ledger.invalid") \
+    X(ExitRestored,         "exit.restored") \
+    X(ExitSkipped,          "exit.skipped") \
+    X(ExitTimedOut,         "exit.timed_out") \
+    X(ExitRestoreUs,        "exit.restore_us") \
+    X(GeometryIsa,          "geometry.isa") \
+    X(AllocFrames,          "alloc.frames") \
+    X(AllocFrame,           "alloc.frame") \
+    X(AllocFrameMax,        "alloc.frame_max") \
+    X(AllocFramesAllocating, "alloc.frames_allocating") \
+    X(AllocTotal,           "alloc.total") \
+    X(ArenaPeakBytes,       "arena.peak_bytes") \
+    X(ArenaBlocks,          "arena.blocks") \
+    X(IdleReleases,         "idle.releases") \
+    X(IdleRehydrations,     "idle.rehydrations") \
+    X(IdleRehydrateUs,      "idle.rehydrate_us") \
+    X(IdleOverBudget,       "idle.rehydrate_over_budget") \
+    X(IdlePrivateKbActive,  "idle.private_kb_active") \
+    X(IdlePrivateKbIdle,    "idle.private_kb_idle") \
+    X(IdleGpuKbActive,      "idle.gpu_kb_active") \
+    X(IdleGpuKbIdle,        "idle.gpu_kb_idle") \
+    X(LatencyFrames,        "latency.frames") \
+    X(LatencyMissedFrames,  "latency.missed_frames") \
+    X(LatencyPendingDropped, "latency.pending_dropped") \
+    X(LatencyUntimed,       "latency.untimed") \
+    X(LatencyMovedP50Us,    "latency.moved.p50_us") \
+    X(LatencyMovedP95Us,    "latency.moved.p95_us") \
+    X(LatencyMovedP99Us,    "latency.moved.p99_us") \
+    X(LatencyShownP50Us,    "latency.shown.p50_us") \
+    X(LatencyShownP95Us,    "latency.shown.p95_us") \
+    X(LatencyShownP99Us,    "latency.shown.p99_us") \
+    X(LatencyHiddenP50Us,   "latency.hidden.p50_us") \
+    X(LatencyHiddenP95Us,   "latency.hidden.p95_us") \
+    X(LatencyHiddenP99Us,   "latency.hidden.p99_us") \
+    X(LatencyDestroyedP50Us, "latency.destroyed.p50_us") \
+    X(LatencyDestroyedP95Us, "latency.destroyed.p95_us") \
+    X(LatencyDestroyedP99Us, "latency.destroyed.p99_us") \
+    X(LatencyRestackedP50Us, "latency.restacked.p50_us") \
+    X(LatencyRestackedP95Us, "latency.restacked.p95_us") \
+    X(LatencyRestackedP99Us, "latency.restacked.p99_us") \
+    X(LatencyFocusP50Us,    "latency.focus.p50_us") \
+    X(LatencyFocusP95Us,    "latency.focus.p95_us") \
+    X(LatencyFocusP99Us,    "latency.focus.p99_us") \
+    X(LatencyRenamedP50Us,  "latency.renamed.p50_us") \
+    X(LatencyRenamedP95Us,  "latency.renamed.p95_us") \
+    X(LatencyRenamedP99Us,  "latency.renamed.p99_us") \
+    X(LatencyRefreshP50Us,  "latency.refresh.p50_us") \
+    X(LatencyRefreshP95Us,  "latency.refresh.p95_us") \
+    X(LatencyRefreshP99Us,  "latency.refresh.p99_us") \
+    X(LatencyMoveSizeP50Us, "latency.movesize.p50_us") \
+    X(LatencyMoveSizeP95Us, "latency.movesize.p95_us") \
+    X(LatencyMoveSizeP99Us, "latency.movesize.p99_us")
+
+enum class Metric : uint32_t {
+#define METRIC_ENUM(id, name) id,
+    METRICS_LIST(METRIC_ENUM)
+#undef METRIC_ENUM
+    Count
+};
+
+void MetricAdd(Metric m, int64_t delta = 1);
+void MetricSet(Metric m, int64_t value);
+void MetricMax(Metric m, int64_t value);
+int64_t MetricGet(Metric m);
+const char* MetricName(Metric m);
+void ResetMetrics();
+
+// "name=value name=value ..." on a single line (STATS reply / debug log)
+std::string FormatMetrics();
@@ -0,0 +1,241 @@
+#include "MonitorPartition.h"
+#include <algorithm>
+#include <cstring>
+
+static uint64_t Mix(uint64_t h, uint64_t v)
+{
+    return h ^ (v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2));
+}
+
+uint64_t MonitorDeviceId(const wchar_t* device)
+{
+    // FNV-1a over the UTF-16 code units
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (; device && *device; ++device) {
+        h ^= static_cast<uint16_t>(*device);
+        h *= 0x100000001B3ull;
+    }
+    return h ? h : 1;
+}
+
+static uint64_t FloatBits(float f)
+{
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static bool IsEmpty(const WindowRect& r)
+{
+    return r.right <= r.left || r.bottom <= r.top;
+}
+
+static WindowRect Intersect(const WindowRect& a, const WindowRect& b)
+{
+    return WindowRect{ std::max(a.left, b.left), std::max(a.top, b.top), std::min(a.right, b.right), std::min(a.bottom, b.bottom) };
+}
+
+static WindowRect Union(const WindowRect& a, const WindowRect& b)
+{
+    if (IsEmpty(a)) return b;
+    if (IsEmpty(b)) return a;
+    return WindowRect{ std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom) };
+}
+
+uint64_t WindowDrawState(uint64_t handle, const WindowRect& rect, const BorderStyle& style, uint32_t flags)
+{
+    uint64_t h = Mix(0, handle);
+    h = Mix(h, (static_cast<uint64_t>(static_cast<uint32_t>(rect.left)) << 32) | static_cast<uint32_t>(rect.top));
+    h = Mix(h, (static_cast<uint64_t>(static_cast<uint32_t>(rect.right)) << 32) | static_cast<uint32_t>(rect.bottom));
+    h = Mix(h, (FloatBits(style.color.r) << 32) | FloatBits(style.color.g));
+    h = Mix(h, (FloatBits(style.color.b) << 32) | FloatBits(style.color.a));
+    h = Mix(h, (FloatBits(style.thickness) << 32) | static_cast<uint64_t>(style.corner));
+    return Mix(h, flags);
+}
+
+void MonitorPartition::Apply(const std::vector<MonitorDesc>& monitors, MonitorLayoutChange& change)
+{
+    change.rebuilt = change.retimed = 0;
+    change.removed.clear();
+    m_previous.swap(m_monitors);
+    m_monitors.clear();
+    m_pending = 0;
+
+    const size_t n = std::min(monitors.size(), kMaxMonitors);
+    for (size_t i = 0; i < n; ++i) {
+        const MonitorDesc& d = monitors[i];
+        const MonitorMask bit = MonitorMask(1) << i;
+        auto prev = std::find_if(m_previous.begin(), m_previous.end(), [&](const Entry& e) { return e.desc.id == d.id; });
+        Entry e;
+        if (prev != m_previous.end() && prev->desc.bounds == d.bounds && prev->desc.dpi == d.dpi) {
+            // Same monitor, possibly at another index
+            e = *prev;
+            if (prev->desc.refreshHz != d.refreshHz) change.retimed |= bit;
+            if (!IsEmpty(e.damage)) m_pending |= bit;
+        } else {
+            // A rescaled monitor's last signature still describes the registry there; the
+            // new surface is drawn in full either way
+            if (prev != m_previous.end()) e.signature = prev->signature;
+            e.damage = d.bounds;
+            m_pending |= bit;
+            change.rebuilt |= bit;
+            ++m_rebuilds;
+        }
+        e.desc = d;
+        m_monitors.push_back(e);
+    }
+    for (const Entry& p : m_previous) {
+        if (IndexOf(p.desc.id) == kNoMonitor) change.removed.push_back(p.desc.id);
+    }
+}
+
+size_t MonitorPartition::IndexOf(uint64_t id) const
+{
+    for (size_t i = 0; i < m_monitors.size(); ++i) {
+        if (m_monitors[i].desc.id == id) return i;
+    }
+    return kNoMonitor;
+}
+
+MonitorMask MonitorPartition::All() const
+{
+    return m_monitors.size() >= 32 ? ~MonitorMask(0) : (MonitorMask(1) << m_monitors.size()) - 1;
+}
+
+MonitorMask MonitorPartition::Touching(const WindowRect& rect) const
+{
+    MonitorMask mask = 0;
+    for (size_t i = 0; i < m_monitors.size(); ++i) {
+        if (!IsEmpty(Intersect(rect, m_monitors[i].desc.bounds))) mask |= MonitorMask(1) << i;
+    }
+    return mask;
+}
+
+size_t MonitorPartition::Primary(const WindowRect& rect) const
+{
+    size_t best = kNoMonitor;
+    int64_t bestArea = 0;
+    uint64_t bestDistance = UINT64_MAX;
+    for (size_t i = 0; i < m_monitors.size(); ++i) {
+        const WindowRect& b = m_monitors[i].desc.bounds;
+        const WindowRect x = Intersect(rect, b);
+        if (!IsEmpty(x)) {
+            const int64_t area = static_cast<int64_t>(x.right - x.left) * (x.bottom - x.top);
+            if (area > bestArea) {
+                bestArea = area;
+                best = i;
+            }
+            continue;
+        }
+        if (bestArea > 0) continue;
+        // Gap between the rects along each axis
+        const int64_t dx = std::max<int64_t>({ 0, static_cast<int64_t>(b.left) - rect.right, static_cast<int64_t>(rect.left) - b.right });
+        const int64_t dy = std::max<int64_t>({ 0, static_cast<int64_t>(b.top) - rect.bottom, static_cast<int64_t>(rect.top) - b.bottom });
+        const uint64_t distance = static_cast<uint64_t>(dx * dx + dy * dy);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = i;
+        }
+    }
+    return best;
+}
+
+float MonitorPartition::ScaleThickness(size_t i, float thickness) const
+{
+    if (i >= m_monitors.size()) return thickness;
+    return thickness * static_cast<float>(m_monitors[i].desc.dpi) / 96.0f;
+}
+
+void MonitorPartition::BeginSignatures()
+{
+    for (Entry& e : m_monitors) e.nextSignature = 0xCBF29CE484222325ull;
+}
+
+void MonitorPartition::AddToSignatures(const WindowRect& outer, uint64_t state)
+{
+    for (Entry& e : m_monitors) {
+        if (!IsEmpty(Intersect(outer, e.desc.bounds))) e.nextSignature = Mix(e.nextSignature, state);
+    }
+}
+
+MonitorMask MonitorPartition::EndSignatures()
+{
+    MonitorMask changed = 0;
+    for (size_t i = 0; i < m_monitors.size(); ++i) {
+        Entry& e = m_monitors[i];
+        if (e.nextSignature != e.signature) changed |= MonitorMask(1) << i;
+        e.signature = e.nextSignature;
+    }
+    InvalidateMonitors(changed);
+    return changed;
+}
+
+void MonitorPartition::Invalidate(const WindowRect& damage)
+{
+    for (size_t i = 0; i < m_monitors.size(); ++i) {
+        Entry& e = m_monitors[i];
+        const WindowRect x = Intersect(damage, e.desc.bounds);
+        if (IsEmpty(x)) continue;
+        e.damage = Union(e.damage, x);
+        m_pending |= MonitorMask(1) << i;
+    }
+}
+
+void MonitorPartition::InvalidateMonitors(MonitorMask mask)
+{
+    for (size_t i = 0; i < m_monitors.size(); ++i) {
+        if (!(mask & (MonitorMask(1) << i))) continue;
+        m_monitors[i].damage = m_monitors[i].desc.bounds;
+        m_pending |= MonitorMask(1) << i;
+    }
+}
+
+bool MonitorPartition::PendingFull(size_t i) const
+{
+    return m_monitors[i].damage == m_monitors[i].desc.bounds;
+}
+
+uint64_t MonitorPartition::PeriodNs(size_t i) const
+{
+    return 1000000000ull / std::max<uint32_t>(m_monitors[i].desc.refreshHz, 1);
+}
+
+// A draw may come a little early (an eighth of a period, at most 0.5 ms): wake-up jitter
+// must not cost a whole extra period
+static uint64_t DueAt(uint64_t lastDrawNs, uint64_t periodNs)
+{
+    return lastDrawNs + periodNs - std::min<uint64_t>(periodNs / 8, 500000);
+}
+
+MonitorMask MonitorPartition::Due(uint64_t nowNs) const
+{
+    MonitorMask due = 0;
+    for (size_t i = 0; i < m_monitors.size(); ++i) {
+        const MonitorMask bit = MonitorMask(1) << i;
+        const Entry& e = m_monitors[i];
+        if ((m_pending & bit) && (!e.drawn || nowNs >= DueAt(e.lastDrawNs, PeriodNs(i)))) due |= bit;
+    }
+    return due;
+}
+
+void MonitorPartition::Drawn(size_t i, uint64_t nowNs)
+{
+    Entry& e = m_monitors[i];
+    e.damage = WindowRect{};
+    e.lastDrawNs = nowNs;
+    e.drawn = true;
+    m_pending &= ~(MonitorMask(1) << i);
+    ++m_draws;
+}
+
+uint64_t MonitorPartition::NextDueNs() const
+{
+    uint64_t next = 0;
+    for (size_t i = 0; i < m_monitors.size(); ++i) {
+        if (!(m_pending & (MonitorMask(1) << i))) continue;
+        const Entry& e = m_monitors[i];
+        const uint64_t due = e.drawn ? std::max<uint64_t>(DueAt(e.lastDrawNs, PeriodNs(i)), 1) : 1;
+        if (!next || due < next) next = due;
+    }
+    return next;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "StyleRules.h"
+#include "WindowRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One overlay pipeline per monitor. A single surface over the whole virtual screen was
+// redrawn for a window moving on any one display, at the pace of whichever vblank DWM
+// waited for, and a display change threw all of it away. Here every monitor has its own
+// surface, DPI and refresh period: the changes of a frame are partitioned by the monitors
+// they reach, a monitor is redrawn at most once per its own refresh period, and a topology
+// change rebuilds only the monitors that appeared or changed. Portable; the render thread
+// owns it (OverlayDComp.cpp, the "monitors" benchmark on simulated layouts).
+
+struct MonitorDesc {
+    uint64_t id = 0;        // MonitorDeviceId
+    WindowRect bounds;      // virtual-screen pixels
+    uint32_t dpi = 96;
+    uint32_t refreshHz = 60;
+};
+
+// A monitor's identity across layouts: a hash of its display device name
+// (MONITORINFOEXW::szDevice, "\\.\DISPLAY1"). HMONITOR values are not; a display change
+// may hand out new ones for the same displays. Never 0.
+uint64_t MonitorDeviceId(const wchar_t* device);
+
+// Bit i: monitor i of the current layout
+using MonitorMask = uint32_t;
+
+inline size_t CountMonitors(MonitorMask mask)
+{
+    size_t n = 0;
+    for (; mask; mask &= mask - 1) ++n;
+    return n;
+}
+
+struct MonitorLayoutChange {
+    MonitorMask rebuilt = 0;        // new, moved, resized or rescaled: new surface, drawn in full
+    MonitorMask retimed = 0;        // only the refresh rate changed: surface and content kept
+    std::vector<uint64_t> removed;  // ids of the monitors that went away
+};
+
+// What a window contributes to the look of the monitors it reaches: any change to it
+// (bounds, style, who draws it) changes their signature
+uint64_t WindowDrawState(uint64_t handle, const WindowRect& rect, const BorderStyle& style, uint32_t flags);
+
+class MonitorPartition {
+public:
+    static constexpr size_t kMaxMonitors = 32;
+    static constexpr size_t kNoMonitor = static_cast<size_t>(-1);
+
+    // Replaces the layout (monitors past kMaxMonitors are ignored). A monitor with the same
+    // id, bounds and DPI as before keeps its index's pacing and signature; every rebuilt one
+    // is left pending in full.
+    void Apply(const std::vector<MonitorDesc>& monitors, MonitorLayoutChange& change);
+    size_t Count() const { return m_monitors.size(); }
+    const MonitorDesc& Monitor(size_t i) const { return m_monitors[i].desc; }
+    size_t IndexOf(uint64_t id) const;
+    MonitorMask All() const;
+
+    // Monitors the rect (virtual-screen) reaches
+    MonitorMask Touching(const WindowRect& rect) const;
+    // The monitor showing most of the rect, the nearest one if none does (MonitorFromRect);
+    // kNoMonitor without monitors
+    size_t Primary(const WindowRect& rect) const;
+    // A thickness given in 96-DPI pixels, in monitor i's pixels
+    float ScaleThickness(size_t i, float thickness) const;
+
+    // Full-pass partition: every window of the pass, in z-order, folds its WindowDrawState
+    // into the signature of each monitor its border (`outer`) reaches. EndSignatures marks
+    // the monitors whose signature differs from the previous pass's pending in full and
+    // returns them.
+    void BeginSignatures();
+    void AddToSignatures(const WindowRect& outer, uint64_t state);
+    MonitorMask EndSignatures();
+
+    // Damage (virtual-screen), split over the monitors it reaches
+    void Invalidate(const WindowRect& damage);
+    void InvalidateMonitors(MonitorMask mask);
+    MonitorMask Pending() const { return m_pending; }
+    // Monitor i's pending damage, within its bounds; all of them when PendingFull
+    const WindowRect& PendingRect(size_t i) const { return m_monitors[i].damage; }
+    bool PendingFull(size_t i) const;
+    // Pending monitors whose refresh period has (nearly) passed since their last draw
+    MonitorMask Due(uint64_t nowNs) const;
+    // Monitor i was drawn at nowNs; its damage is gone
+    void Drawn(size_t i, uint64_t nowNs);
+    // Earliest time a pending monitor becomes due; 0 if none is pending
+    uint64_t NextDueNs() const;
+    uint64_t PeriodNs(size_t i) const;
+
+    uint64_t Rebuilds() const { return m_rebuilds; }  // pipelines created by Apply, in total
+    uint64_t Draws() const { return m_draws; }        // monitor draws, in total
+
+private:
+    struct Entry {
+        MonitorDesc desc;
+        WindowRect damage;
+        uint64_t signature = 0;
+        uint64_t nextSignature = 0;
+        uint64_t lastDrawNs = 0;
+        bool drawn = false;
+    };
+
+    std::vector<Entry> m_monitors;
+    std::vector<Entry> m_previous; // Apply scratch
+    MonitorMask m_pending = 0;
+    uint64_t m_rebuilds = 0;
+    uint64_t m_draws = 0;
+};
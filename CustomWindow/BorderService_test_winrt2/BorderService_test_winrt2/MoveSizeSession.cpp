@@ -0,0 +1,55 @@
+#include "MoveSizeSession.h"
+#include "Metrics.h"
+#include <algorithm>
+
+WindowRect MoveSizeDamage(const WindowRect& before, const WindowRect& after, float thickness)
+{
+    const int32_t pad = static_cast<int32_t>(thickness + 0.999f) + 1;
+    return { std::min(before.left, after.left) - pad, std::min(before.top, after.top) - pad,
+             std::max(before.right, after.right) + pad, std::max(before.bottom, after.bottom) + pad };
+}
+
+bool RectsIntersect(const WindowRect& a, const WindowRect& b)
+{
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+bool MoveSizeSession::Begin(uint64_t hwnd, uint64_t nowNs, MoveSizeStats* previous)
+{
+    const bool ended = Active();
+    if (ended) {
+        const MoveSizeStats stats = End(nowNs);
+        if (previous) *previous = stats;
+    }
+    m_hwnd = hwnd;
+    m_startNs = nowNs;
+    m_deferred = 0;
+    m_frameNs.clear();
+    return ended;
+}
+
+MoveSizeStats MoveSizeSession::End(uint64_t nowNs)
+{
+    MoveSizeStats stats;
+    if (!Active()) return stats;
+    stats.hwnd = m_hwnd;
+    stats.frames = m_frameNs.size();
+    stats.durationNs = nowNs > m_startNs ? nowNs - m_startNs : 0;
+    stats.deferred = m_deferred;
+    if (!m_frameNs.empty()) {
+        // Nearest rank; the buffer is reset by the next Begin anyway
+        const size_t rank = (m_frameNs.size() * 99 + 99) / 100 - 1;
+        std::nth_element(m_frameNs.begin(), m_frameNs.begin() + rank, m_frameNs.end());
+        stats.p99Ns = m_frameNs[rank];
+        stats.maxNs = *std::max_element(m_frameNs.begin(), m_frameNs.end());
+    }
+    m_hwnd = 0;
+    m_frameNs.clear();
+
+    MetricAdd(Metric::MoveSizeSessions);
+    MetricAdd(Metric::MoveSizeFrames, static_cast<int64_t>(stats.frames));
+    MetricSet(Metric::MoveSizeLastFrames, static_cast<int64_t>(stats.frames));
+    MetricSet(Metric::MoveSizeLastP99Us, static_cast<int64_t>(stats.p99Ns / 1000));
+    MetricAdd(Metric::MoveSizeDeferred, static_cast<int64_t>(stats.deferred));
+    return stats;
+}
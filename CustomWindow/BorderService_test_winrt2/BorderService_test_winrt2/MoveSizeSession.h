@@ -0,0 +1,49 @@
+#pragma once
+#include "WindowRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Interactive move / resize of one window, between EVENT_SYSTEM_MOVESIZESTART and
+// EVENT_SYSTEM_MOVESIZEEND. While a session is open the render thread re-reads only the
+// moving window and redraws only the area it covers and uncovers; every other window keeps
+// the state of the last full pass, and their changes are held back (Defer) until the one
+// full reconcile at session end. Portable.
+
+// Area a session frame must redraw: the border around the window's old and new rects
+// (thickness plus a pixel of anti-aliasing on each side)
+WindowRect MoveSizeDamage(const WindowRect& before, const WindowRect& after, float thickness);
+bool RectsIntersect(const WindowRect& a, const WindowRect& b);
+
+struct MoveSizeStats {
+    uint64_t hwnd = 0;
+    uint64_t frames = 0;        // frames drawn while the session was open
+    uint64_t p99Ns = 0;
+    uint64_t maxNs = 0;
+    uint64_t durationNs = 0;
+    uint64_t deferred = 0;      // changes of other windows left to the reconcile
+};
+
+class MoveSizeSession {
+public:
+    MoveSizeSession() { m_frameNs.reserve(1024); }
+
+    bool Active() const { return m_hwnd != 0; }
+    uint64_t Window() const { return m_hwnd; }
+    bool Owns(uint64_t hwnd) const { return m_hwnd != 0 && hwnd == m_hwnd; }
+
+    // Opens a session for hwnd. A session still open (its END never arrived) is ended
+    // first and its stats returned through previous; false if there was none.
+    bool Begin(uint64_t hwnd, uint64_t nowNs, MoveSizeStats* previous = nullptr);
+    // Another window changed; the reconcile at session end picks it up
+    void Defer() { ++m_deferred; }
+    void RecordFrame(uint64_t ns) { m_frameNs.push_back(ns); }
+    // Closes the session and publishes the movesize.* metrics
+    MoveSizeStats End(uint64_t nowNs);
+
+private:
+    uint64_t m_hwnd = 0;
+    uint64_t m_startNs = 0;
+    uint64_t m_deferred = 0;
+    std::vector<uint64_t> m_frameNs;
+};
@@ -2,6 +2,27 @@
 #include "Globals.h"
 #include "DwmUtil.h"
 #include "Args.h"
+#include "FastStart.h"
+#include "Metrics.h"
+#include "WindowStyles.h"
+#include "LayoutPublisher.h"
+#include "PowerMonitor.h"
+#include "BorderAtlas.h"
+#include "BorderEffects.h"
+#include "MonitorPartition.h"
+#include "MoveSizeSession.h"
+#include "Pipeline.h"
+#include "RectKernels.h"
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <dxgi1_4.h>
+#include <psapi.h>
+#include <shellscalingapi.h>
+
+// Hybrid mode: set while the overlay has fallback windows; read by the intake and UI threads
+static std::atomic<bool> s_hybridOverlayActive{ false };
+static size_t s_overlayWindows = 0; // render thread
 
 HRESULT CreateD3DDevice()
 {
@@ -40,6 +61,14 @@ HRESULT CreateDComp(HWND hwnd)
     HRESULT hr = DCompositionCreateDevice(g_dxgiDevice.Get(), IID_PPV_ARGS(&g_dcompDevice));
     if (FAILED(hr)) return hr;
     hr = g_dcompDevice->CreateTargetForHwnd(hwnd, TRUE, &g_dcompTarget);
+    if (FAILED(hr) && !g_overlayRegion) {
+        // Region-less mode needs a layered target; without one, fall back to the region
+        DebugLog(L"[Overlay] DComp refused the layered overlay (hr=" + std::to_wstring(hr) + L"), using a window region");
+        SetWindowLongPtrW(hwnd, GWL_EXSTYLE, GetWindowLongPtrW(hwnd, GWL_EXSTYLE) & ~static_cast<LONG_PTR>(WS_EX_LAYERED));
+        SetWindowRgn(hwnd, CreateRectRgn(0, 0, 0, 0), FALSE);
+        g_overlayRegion = true;
+        hr = g_dcompDevice->CreateTargetForHwnd(hwnd, TRUE, &g_dcompTarget);
+    }
     if (FAILED(hr)) return hr;
 
     hr = g_dcompDevice->CreateVisual(&g_rootVisual);
@@ -54,47 +83,111 @@ HRESULT CreateDComp(HWND hwnd)
     return hr;
 }
 
-HRESULT EnsureSurface(UINT width, UINT height)
+static uint64_t SteadyNowNs()
 {
-    if (width == 0 || height == 0) return E_INVALIDARG;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
 
-    if (g_surface && (g_surfaceW != width || g_surfaceH != height)) {
-        g_surface.Reset();
-    }
+// One pipeline per monitor (MonitorPartition.h): a visual under g_surfaceVisual, placed at
+// the monitor, and a surface of the monitor's size. Indexed like s_monitors. Render thread,
+// or the UI thread before StartRenderThread.
+struct MonitorPipeline {
+    uint64_t id = 0;
+    Microsoft::WRL::ComPtr<IDCompositionVisual> visual;
+    Microsoft::WRL::ComPtr<IDCompositionSurface> surface;
+};
+static MonitorPartition s_monitors;
+static std::vector<MonitorPipeline> s_pipelines;
+
+static BOOL CALLBACK CollectMonitor(HMONITOR monitor, HDC, LPRECT, LPARAM param)
+{
+    MONITORINFOEXW mi{};
+    mi.cbSize = sizeof(mi);
+    if (!GetMonitorInfoW(monitor, &mi)) return TRUE;
+    MonitorDesc d;
+    d.id = MonitorDeviceId(mi.szDevice);
+    d.bounds = { mi.rcMonitor.left, mi.rcMonitor.top, mi.rcMonitor.right, mi.rcMonitor.bottom };
+    UINT dpiX = 96, dpiY = 96;
+    if (SUCCEEDED(GetDpiForMonitor(monitor, MDT_EFFECTIVE_DPI, &dpiX, &dpiY))) d.dpi = dpiX;
+    DEVMODEW dm{};
+    dm.dmSize = sizeof(dm);
+    // 0 and 1 stand for the hardware default
+    if (EnumDisplaySettingsW(mi.szDevice, ENUM_CURRENT_SETTINGS, &dm) && dm.dmDisplayFrequency > 1) d.refreshHz = dm.dmDisplayFrequency;
+    reinterpret_cast<std::vector<MonitorDesc>*>(param)->push_back(d);
+    return TRUE;
+}
 
-    if (!g_surface) {
-        HRESULT hr = g_dcompDevice->CreateSurface(width, height, DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_ALPHA_MODE_PREMULTIPLIED, &g_surface);
-        if (FAILED(hr)) return hr;
-        g_surfaceVisual->SetContent(g_surface.Get());
-        g_surfaceW = width;
-        g_surfaceH = height;
-        return S_OK;
+// Places every pipeline's visual at its monitor, in overlay coordinates
+static void PlacePipelines()
+{
+    for (size_t i = 0; i < s_pipelines.size(); ++i) {
+        if (!s_pipelines[i].visual) continue;
+        const WindowRect& b = s_monitors.Monitor(i).bounds;
+        s_pipelines[i].visual->SetOffsetX(static_cast<float>(b.left - g_virtualScreen.left));
+        s_pipelines[i].visual->SetOffsetY(static_cast<float>(b.top - g_virtualScreen.top));
     }
-    return S_OK;
 }
 
-void BeginDrawOnSurface(UINT width, UINT height, ID2D1DeviceContext** outCtx, POINT* offset)
+static void ApplyMonitorLayout(const std::vector<MonitorDesc>& monitors)
 {
-    *outCtx = nullptr;
-    Microsoft::WRL::ComPtr<IDXGISurface> dxgiSurface;
-    RECT upd = { 0,0,(LONG)width,(LONG)height };
-    if (SUCCEEDED(g_surface->BeginDraw(&upd, IID_PPV_ARGS(&dxgiSurface), offset))) {
-        Microsoft::WRL::ComPtr<ID2D1Bitmap1> targetBmp;
-        D2D1_BITMAP_PROPERTIES1 props = D2D1::BitmapProperties1(
-            D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
-            D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
-        g_d2dCtx->CreateBitmapFromDxgiSurface(dxgiSurface.Get(), &props, &targetBmp);
-        g_d2dCtx->SetTarget(targetBmp.Get());
-        *outCtx = g_d2dCtx.Get();
-        (*outCtx)->AddRef();
+    static MonitorLayoutChange s_change;
+    s_monitors.Apply(monitors, s_change);
+
+    std::vector<MonitorPipeline> next(s_monitors.Count());
+    for (size_t i = 0; i < next.size(); ++i) {
+        next[i].id = s_monitors.Monitor(i).id;
+        auto prev = std::find_if(s_pipelines.begin(), s_pipelines.end(), [&](const MonitorPipeline& p) { return p.id == next[i].id; });
+        if (prev == s_pipelines.end()) continue;
+        next[i].visual = std::move(prev->visual);
+        // Rebuilt: the old content has the wrong size or DPI; the next frame draws a new one
+        if (!(s_change.rebuilt & (MonitorMask(1) << i))) next[i].surface = std::move(prev->surface);
+        else if (next[i].visual) next[i].visual->SetContent(nullptr);
     }
+    // What is left belongs to monitors that went away
+    for (MonitorPipeline& p : s_pipelines) {
+        if (p.visual && g_surfaceVisual) g_surfaceVisual->RemoveVisual(p.visual.Get());
+    }
+    s_pipelines.swap(next);
+    PlacePipelines();
+    if (g_dcompDevice) g_dcompDevice->Commit();
+
+    MetricSet(Metric::MonitorCount, static_cast<int64_t>(s_monitors.Count()));
+    MetricSet(Metric::MonitorRebuilds, static_cast<int64_t>(s_monitors.Rebuilds()));
+    for (size_t i = 0; i < s_monitors.Count(); ++i) {
+        const MonitorDesc& m = s_monitors.Monitor(i);
+        const MonitorMask bit = MonitorMask(1) << i;
+        DebugLogF(L"[Monitor] #%zu (%ld,%ld)-(%ld,%ld) %u dpi %u Hz%ls", i, static_cast<long>(m.bounds.left),
+                  static_cast<long>(m.bounds.top), static_cast<long>(m.bounds.right), static_cast<long>(m.bounds.bottom),
+                  m.dpi, m.refreshHz, (s_change.rebuilt & bit) ? L", rebuilt" : (s_change.retimed & bit) ? L", retimed" : L"");
+    }
+    if (!s_change.removed.empty()) DebugLogF(L"[Monitor] %zu monitor(s) removed", s_change.removed.size());
 }
 
-void EndDrawOnSurface()
+// Monitor i's visual and surface; fresh is set when the surface is new and has no content
+static bool EnsurePipeline(size_t i, bool& fresh)
 {
-    g_d2dCtx->SetTarget(nullptr);
-    g_surface->EndDraw();
-    g_dcompDevice->Commit();
+    fresh = false;
+    MonitorPipeline& p = s_pipelines[i];
+    const WindowRect& b = s_monitors.Monitor(i).bounds;
+    if (b.right <= b.left || b.bottom <= b.top) return false;
+    if (!p.visual) {
+        if (FAILED(g_dcompDevice->CreateVisual(&p.visual))) return false;
+        if (FAILED(g_surfaceVisual->AddVisual(p.visual.Get(), FALSE, nullptr))) {
+            p.visual.Reset();
+            return false;
+        }
+        PlacePipelines();
+    }
+    if (!p.surface) {
+        if (FAILED(g_dcompDevice->CreateSurface(b.right - b.left, b.bottom - b.top, DXGI_FORMAT_B8G8R8A8_UNORM,
+                                                DXGI_ALPHA_MODE_PREMULTIPLIED, &p.surface))) {
+            return false;
+        }
+        p.visual->SetContent(p.surface.Get());
+        fresh = true;
+    }
+    return true;
 }
 
 void UpdateVirtualScreenAndResize()
@@ -112,122 +205,695 @@ void UpdateVirtualScreenAndResize()
                    FALSE);
     }
 
-    g_surfaceW = g_surfaceH = 0;
-    g_surface.Reset();
+    std::vector<MonitorDesc> monitors;
+    EnumDisplayMonitors(nullptr, nullptr, CollectMonitor, reinterpret_cast<LPARAM>(&monitors));
+    ApplyMonitorLayout(monitors);
+}
+
+// DComp mode draws every window; hybrid mode only those DWM refused
+static bool DrawnByOverlay(const WindowRegistry& windows, WindowRegistry::Slot s)
+{
+    return g_mode != RenderMode::Hybrid || (windows.Flags(s) & WindowRegistry::kOverlay);
+}
+
+// Nine-patch tiles per style (BorderAtlas.h), uploaded once as device bitmaps. Render thread only.
+static BorderAtlas s_atlas;
+static std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID2D1Bitmap1>> s_atlasBitmaps; // tile id -> bitmap
+static ID2D1DeviceContext* s_atlasContext = nullptr;
+
+static ID2D1Bitmap1* AtlasBitmap(ID2D1DeviceContext* ctx, const NinePatchTile& tile)
+{
+    auto it = s_atlasBitmaps.find(tile.id);
+    if (it != s_atlasBitmaps.end()) return it->second.Get();
+
+    // Drop bitmaps of evicted tiles before adding one
+    for (auto b = s_atlasBitmaps.begin(); b != s_atlasBitmaps.end();) {
+        b = s_atlas.Contains(b->first) ? std::next(b) : s_atlasBitmaps.erase(b);
+    }
+    D2D1_BITMAP_PROPERTIES1 props = D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_NONE,
+        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED), 96.0f, 96.0f);
+    Microsoft::WRL::ComPtr<ID2D1Bitmap1> bitmap;
+    if (FAILED(ctx->CreateBitmap(D2D1::SizeU(tile.size, tile.size), tile.pixels.data(), tile.size * sizeof(uint32_t), &props, &bitmap))) {
+        return nullptr;
+    }
+    return s_atlasBitmaps.emplace(tile.id, bitmap).first->second.Get();
 }
 
-void DrawBorders(ID2D1DeviceContext* ctx, const std::vector<RECT>& rects)
+void DrawBorders(ID2D1DeviceContext* ctx, const WindowRegistry& windows, const RECT* damage, uint64_t effectTarget, uint32_t dpi)
 {
+    // Bitmaps belong to the device context they were created on
+    if (ctx != s_atlasContext) {
+        s_atlasBitmaps.clear();
+        s_atlasContext = ctx;
+    }
+    const uint64_t hits = s_atlas.Hits(), misses = s_atlas.Misses(), evictions = s_atlas.Evictions();
+    static std::vector<NinePatchBlit> s_blits; // at most 8 per window, kept across frames
+
+    // One brush, recolored only when consecutive windows use different rule colors
     Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> brush;
-    ctx->CreateSolidColorBrush(g_borderColor, &brush);
+    ColorF current{};
     ctx->SetAntialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
 
-    const float radius = CornerRadiusFromToken(g_cornerToken);
-    const bool rounded = radius > 0.5f;
-
-    for (const auto& r : rects)
+    // Overlay coordinates for every window of the pass at once (RectKernels.h)
+    static RectColumns s_screenRects, s_localRects, s_occluders;
+    static RectColumnsF s_localRectsF;
+    static std::vector<float> s_thickness;
+    static std::vector<int32_t> s_extents;
+    const std::vector<WindowRegistry::Slot>& order = windows.Order();
+    s_screenRects.Clear();
+    for (WindowRegistry::Slot s : order) s_screenRects.Push(windows.Rect(s));
+    TranslateRects(s_screenRects, -g_virtualScreen.left, -g_virtualScreen.top, s_localRects);
+    RectsToFloat(s_localRects, s_localRectsF);
+
+    // Without a window region nothing clips the borders of lower windows, so the pass runs
+    // bottom-up and each window first clears what it covers (the occluders of
+    // UpdateOverlayRegion) before drawing its own border
+    const bool painter = !g_overlayRegion;
+    if (painter) {
+        s_thickness.clear();
+        for (WindowRegistry::Slot s : order) s_thickness.push_back(windows.Style(s).thickness);
+        s_extents.resize(order.size());
+        StrokeExtents(s_thickness.data(), order.size(), s_extents.data());
+        ExpandRects(s_localRects, s_extents.data(), s_occluders);
+    }
+    auto clearCovered = [&](const WindowRect& r) {
+        if (damage && !RectsIntersect(r, WindowRect{ damage->left, damage->top, damage->right, damage->bottom })) return;
+        ctx->PushAxisAlignedClip(D2D1::RectF((FLOAT)r.left, (FLOAT)r.top, (FLOAT)r.right, (FLOAT)r.bottom), D2D1_ANTIALIAS_MODE_ALIASED);
+        ctx->Clear(D2D1::ColorF(0, 0));
+        ctx->PopAxisAlignedClip();
+    };
+
+    for (size_t k = 0; k < order.size(); ++k)
     {
-        D2D1_RECT_F rf = D2D1::RectF((FLOAT)r.left - (FLOAT)g_virtualScreen.left, (FLOAT)r.top - (FLOAT)g_virtualScreen.top,
-                                     (FLOAT)r.right - (FLOAT)g_virtualScreen.left, (FLOAT)r.bottom - (FLOAT)g_virtualScreen.top);
-        if (rounded) {
+        const size_t i = painter ? order.size() - 1 - k : k;
+        const WindowRegistry::Slot s = order[i];
+        if (!DrawnByOverlay(windows, s)) {
+            // Windows bordered by DWM still hide the overlay borders beneath them
+            if (painter) clearCovered(s_localRects.Get(i));
+            continue;
+        }
+        const BorderStyle& style = windows.Style(s);
+        if (painter) clearCovered(s_occluders.Get(i));
+        // The effect visual carries this one
+        if (windows.Handle(s) == effectTarget) continue;
+
+        const WindowRect local = s_localRects.Get(i);
+        if (damage && !RectsIntersect(MoveSizeDamage(local, local, style.thickness),
+                                      WindowRect{ damage->left, damage->top, damage->right, damage->bottom })) {
+            continue;
+        }
+
+        // Common case: blit the style's pre-rasterized corners and stretched edges
+        if (const NinePatchTile* tile = s_atlas.Acquire(NinePatchKey::From(style, dpi))) {
+            if (ID2D1Bitmap1* bitmap = AtlasBitmap(ctx, *tile)) {
+                s_blits.clear();
+                ComposeNinePatch(*tile, local, s_blits);
+                for (const NinePatchBlit& b : s_blits) {
+                    const D2D1_RECT_F dst = D2D1::RectF((FLOAT)b.dstX, (FLOAT)b.dstY, (FLOAT)(b.dstX + b.dstW), (FLOAT)(b.dstY + b.dstH));
+                    const D2D1_RECT_F src = D2D1::RectF((FLOAT)b.srcX, (FLOAT)b.srcY, (FLOAT)(b.srcX + b.srcW), (FLOAT)(b.srcY + b.srcH));
+                    ctx->DrawBitmap(bitmap, &dst, 1.0f, D2D1_INTERPOLATION_MODE_NEAREST_NEIGHBOR, &src);
+                }
+                continue;
+            }
+        }
+
+        // Styles too large for a tile (or a failed upload) are stroked as geometry
+        if (!brush) {
+            current = style.color;
+            ctx->CreateSolidColorBrush(ToD2DColor(current), &brush);
+            if (!brush) return;
+        } else if (style.color.r != current.r || style.color.g != current.g || style.color.b != current.b || style.color.a != current.a) {
+            current = style.color;
+            brush->SetColor(ToD2DColor(current));
+        }
+
+        const float radius = CornerRadius(style.corner);
+        D2D1_RECT_F rf = D2D1::RectF(s_localRectsF.left[i], s_localRectsF.top[i], s_localRectsF.right[i], s_localRectsF.bottom[i]);
+        if (radius > 0.5f) {
             D2D1_ROUNDED_RECT rr{ rf, radius, radius };
-            ctx->DrawRoundedRectangle(rr, brush.Get(), g_thickness);
+            ctx->DrawRoundedRectangle(rr, brush.Get(), style.thickness);
         } else {
-            ctx->DrawRectangle(rf, brush.Get(), g_thickness);
+            ctx->DrawRectangle(rf, brush.Get(), style.thickness);
         }
     }
+
+    MetricAdd(Metric::AtlasHits, static_cast<int64_t>(s_atlas.Hits() - hits));
+    MetricAdd(Metric::AtlasMisses, static_cast<int64_t>(s_atlas.Misses() - misses));
+    MetricAdd(Metric::AtlasEvictions, static_cast<int64_t>(s_atlas.Evictions() - evictions));
 }
 
-void UpdateOverlayRegion(const std::vector<RECT>& zorderedRects)
+void UpdateOverlayRegion(const WindowRegistry& windows, const RECT* damage, size_t damageCount)
 {
     if (!g_overlay) return;
+    // Copy of the region last given to SetWindowRgn, which takes ownership of its handle
+    static HRGN s_lastRegion = nullptr;
+    // Scratch regions kept across frames and reset with SetRectRgn; only the region handed
+    // to SetWindowRgn is created per frame
+    static HRGN s_coveredRgn = CreateRectRgn(0, 0, 0, 0);
+    static HRGN s_bandRgn = CreateRectRgn(0, 0, 0, 0);
+    static HRGN s_visibleRgn = CreateRectRgn(0, 0, 0, 0);
+    static HRGN s_rectRgn = CreateRectRgn(0, 0, 0, 0);
+    static HRGN s_damageRgn = CreateRectRgn(0, 0, 0, 0);
+    auto addRect = [](HRGN dst, LONG left, LONG top, LONG right, LONG bottom) {
+        SetRectRgn(s_rectRgn, left, top, right, bottom);
+        CombineRgn(dst, dst, s_rectRgn, RGN_OR);
+    };
 
     HRGN finalRgn = CreateRectRgn(0, 0, 0, 0);
-    HRGN coveredRgn = CreateRectRgn(0, 0, 0, 0);
+    HRGN coveredRgn = s_coveredRgn;
+    SetRectRgn(coveredRgn, 0, 0, 0, 0);
+    HRGN damageRgn = nullptr;
+    if (damage && s_lastRegion) {
+        // Outside the damage the region stays as it was; inside it only windows reaching
+        // into the damage can add bands or cover them
+        damageRgn = s_damageRgn;
+        SetRectRgn(damageRgn, 0, 0, 0, 0);
+        for (size_t i = 0; i < damageCount; ++i) addRect(damageRgn, damage[i].left, damage[i].top, damage[i].right, damage[i].bottom);
+        CombineRgn(finalRgn, s_lastRegion, damageRgn, RGN_DIFF);
+    }
+    auto reaches = [&](const RECT& rc) {
+        if (!damageRgn) return true;
+        RECT x;
+        for (size_t i = 0; i < damageCount; ++i) {
+            if (IntersectRect(&x, &rc, &damage[i])) return true;
+        }
+        return false;
+    };
+
+    // Overlay-coordinate rects, whole-pixel stroke extents, occluders and the four border
+    // bands for every window of the pass at once (RectKernels.h)
+    static RectColumns s_screenRects, s_localRects, s_occluders, s_bands[kBandCount];
+    static std::vector<float> s_thickness;
+    static std::vector<int32_t> s_extents;
+    const std::vector<WindowRegistry::Slot>& order = windows.Order();
+    s_screenRects.Clear();
+    s_thickness.clear();
+    for (WindowRegistry::Slot s : order) {
+        s_screenRects.Push(windows.Rect(s));
+        s_thickness.push_back(windows.Style(s).thickness);
+    }
+    s_extents.resize(order.size());
+    TranslateRects(s_screenRects, -g_virtualScreen.left, -g_virtualScreen.top, s_localRects);
+    StrokeExtents(s_thickness.data(), order.size(), s_extents.data());
+    ExpandRects(s_localRects, s_extents.data(), s_occluders);
+    BorderBands(s_localRects, s_extents.data(), s_bands);
 
-    int t = (int)(g_thickness + 0.999f);
-    if (t < 1) t = 1;
-        
-    for (const auto& r : zorderedRects)
+    for (size_t i = 0; i < order.size(); ++i)
     {
-        RECT winR{ r.left - g_virtualScreen.left, r.top - g_virtualScreen.top,
-                   r.right - g_virtualScreen.left, r.bottom - g_virtualScreen.top };
-
-        RECT topBand    { winR.left - t, winR.top - t, winR.right + t, winR.top };
-        RECT bottomBand { winR.left - t, winR.bottom,  winR.right + t, winR.bottom + t };
-        RECT leftBand   { winR.left - t, winR.top - t, winR.left,      winR.bottom + t };
-        RECT rightBand  { winR.right,    winR.top - t, winR.right + t, winR.bottom + t };
-
-        HRGN bandRgn = CreateRectRgn(0, 0, 0, 0);
-        auto addBand = [&](const RECT& band) {
-            HRGN rgnBand = CreateRectRgn(band.left, band.top, band.right, band.bottom);
-            CombineRgn(bandRgn, bandRgn, rgnBand, RGN_OR);
-            DeleteObject(rgnBand);
-        };
-        addBand(topBand);
-        addBand(bottomBand);
-        addBand(leftBand);
-        addBand(rightBand);
-
-        HRGN visibleBands = CreateRectRgn(0, 0, 0, 0);
+        const WindowRegistry::Slot s = order[i];
+        const WindowRect local = s_localRects.Get(i);
+        RECT winR{ local.left, local.top, local.right, local.bottom };
+
+        // Windows bordered by DWM still hide the overlay borders beneath them
+        if (!DrawnByOverlay(windows, s)) {
+            if (!reaches(winR)) continue;
+            addRect(coveredRgn, winR.left, winR.top, winR.right, winR.bottom);
+            continue;
+        }
+
+        const WindowRect outer = s_occluders.Get(i);
+        RECT occ{ outer.left, outer.top, outer.right, outer.bottom };
+        if (!reaches(occ)) continue;
+
+        HRGN bandRgn = s_bandRgn;
+        SetRectRgn(bandRgn, 0, 0, 0, 0);
+        for (size_t k = 0; k < kBandCount; ++k) {
+            const WindowRect band = s_bands[k].Get(i);
+            addRect(bandRgn, band.left, band.top, band.right, band.bottom);
+        }
+
+        HRGN visibleBands = s_visibleRgn;
         CombineRgn(visibleBands, bandRgn, coveredRgn, RGN_DIFF);
+        if (damageRgn) CombineRgn(visibleBands, visibleBands, damageRgn, RGN_AND);
 
         CombineRgn(finalRgn, finalRgn, visibleBands, RGN_OR);
+        addRect(coveredRgn, occ.left, occ.top, occ.right, occ.bottom);
+    }
 
-        RECT occ{ winR.left - t, winR.top - t, winR.right + t, winR.bottom + t };
-        HRGN occRgn = CreateRectRgn(occ.left, occ.top, occ.right, occ.bottom);
-        CombineRgn(coveredRgn, coveredRgn, occRgn, RGN_OR);
+    if (!s_lastRegion) s_lastRegion = CreateRectRgn(0, 0, 0, 0);
+    CombineRgn(s_lastRegion, finalRgn, nullptr, RGN_COPY);
 
-        DeleteObject(occRgn);
-        DeleteObject(visibleBands);
-        DeleteObject(bandRgn);
+    // No DwmFlush: each monitor is paced by its own refresh period (MonitorPartition.h)
+    SetWindowRgn(g_overlay, finalRgn, FALSE);
+}
+
+// Focused-window effect (BorderEffects.h): a visual above the surface whose opacity the
+// compositor animates. Its calls go out with the frame's commit. Render thread only.
+class DCompEffectCompositor : public EffectCompositor {
+public:
+    bool DrawBorder(int32_t width, int32_t height, const WindowRect& window, const BorderStyle& style) override
+    {
+        if (width <= 0 || height <= 0 || !EnsureVisual()) return false;
+        if (!m_surface || width != m_width || height != m_height) {
+            m_surface.Reset();
+            if (FAILED(g_dcompDevice->CreateSurface(width, height, DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_ALPHA_MODE_PREMULTIPLIED, &m_surface))) {
+                return false;
+            }
+            m_visual->SetContent(m_surface.Get());
+            m_width = width;
+            m_height = height;
+        }
+
+        Microsoft::WRL::ComPtr<IDXGISurface> dxgiSurface;
+        POINT offset{ 0, 0 };
+        if (FAILED(m_surface->BeginDraw(nullptr, IID_PPV_ARGS(&dxgiSurface), &offset))) return false;
+        Microsoft::WRL::ComPtr<ID2D1Bitmap1> target;
+        D2D1_BITMAP_PROPERTIES1 props = D2D1::BitmapProperties1(
+            D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
+            D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+        Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> brush;
+        bool ok = SUCCEEDED(g_d2dCtx->CreateBitmapFromDxgiSurface(dxgiSurface.Get(), &props, &target));
+        if (ok) {
+            g_d2dCtx->SetTarget(target.Get());
+            g_d2dCtx->BeginDraw();
+            g_d2dCtx->SetTransform(D2D1::Matrix3x2F::Translation((FLOAT)offset.x, (FLOAT)offset.y));
+            g_d2dCtx->Clear(D2D1::ColorF(0, 0));
+            g_d2dCtx->SetAntialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+            g_d2dCtx->CreateSolidColorBrush(ToD2DColor(style.color), &brush);
+            if (brush) {
+                const float radius = CornerRadius(style.corner);
+                const D2D1_RECT_F rf = D2D1::RectF((FLOAT)window.left, (FLOAT)window.top, (FLOAT)window.right, (FLOAT)window.bottom);
+                if (radius > 0.5f) g_d2dCtx->DrawRoundedRectangle(D2D1_ROUNDED_RECT{ rf, radius, radius }, brush.Get(), style.thickness);
+                else g_d2dCtx->DrawRectangle(rf, brush.Get(), style.thickness);
+            }
+            g_d2dCtx->SetTransform(D2D1::Matrix3x2F::Identity());
+            ok = SUCCEEDED(g_d2dCtx->EndDraw()) && brush;
+            g_d2dCtx->SetTarget(nullptr);
+        }
+        m_surface->EndDraw();
+        return ok;
     }
 
-    SetWindowRgn(g_overlay, finalRgn, FALSE);
-    DwmFlush();
-    DeleteObject(coveredRgn);
+    void Place(int32_t x, int32_t y) override
+    {
+        if (!m_visual) return;
+        m_visual->SetOffsetX(static_cast<float>(x));
+        m_visual->SetOffsetY(static_cast<float>(y));
+    }
+
+    void Animate(const OpacityCurve& curve) override
+    {
+        if (!m_effect) return;
+        Microsoft::WRL::ComPtr<IDCompositionAnimation> animation;
+        if (FAILED(g_dcompDevice->CreateAnimation(&animation))) {
+            m_effect->SetOpacity(1.0f);
+            return;
+        }
+        for (const CurveSegment& seg : curve.segments) {
+            switch (seg.kind) {
+            case CurveSegment::Cubic: animation->AddCubic(seg.begin, seg.a, seg.b, seg.c, seg.d); break;
+            case CurveSegment::Sinusoidal: animation->AddSinusoidal(seg.begin, seg.a, seg.b, seg.c, seg.d); break;
+            case CurveSegment::End: animation->End(seg.begin, seg.a); break;
+            }
+        }
+        m_effect->SetOpacity(animation.Get());
+    }
+
+    void Hide() override
+    {
+        if (m_effect) m_effect->SetOpacity(0.0f);
+    }
+
+    // Idle release: the content goes, the visual stays in the tree
+    void Release()
+    {
+        if (m_visual) m_visual->SetContent(nullptr);
+        m_surface.Reset();
+        m_width = m_height = 0;
+    }
+
+private:
+    bool EnsureVisual()
+    {
+        if (m_visual) return true;
+        if (!g_dcompDevice || !g_rootVisual || !g_surfaceVisual) return false;
+        Microsoft::WRL::ComPtr<IDCompositionVisual> visual;
+        Microsoft::WRL::ComPtr<IDCompositionEffectGroup> effect;
+        if (FAILED(g_dcompDevice->CreateVisual(&visual)) || FAILED(g_dcompDevice->CreateEffectGroup(&effect))) return false;
+        visual->SetEffect(effect.Get());
+        if (FAILED(g_rootVisual->AddVisual(visual.Get(), TRUE, g_surfaceVisual.Get()))) return false;
+        m_visual = visual;
+        m_effect = effect;
+        return true;
+    }
+
+    Microsoft::WRL::ComPtr<IDCompositionVisual> m_visual;
+    Microsoft::WRL::ComPtr<IDCompositionEffectGroup> m_effect;
+    Microsoft::WRL::ComPtr<IDCompositionSurface> m_surface;
+    int32_t m_width = 0, m_height = 0;
+};
+
+static DCompEffectCompositor s_effectCompositor;
+static BorderEffectController s_effects;
+static uint64_t s_effectSettingsVersion = 0;
+
+// The foreground window, if the overlay draws it. Without a region nothing would clip the
+// effect visual, so a window partly covered by another keeps its border in the surface.
+static WindowRegistry::Slot EffectTarget(const WindowRegistry& windows)
+{
+    const WindowRegistry::Slot s = windows.Find(HwndKey(GetForegroundWindow()));
+    if (s == WindowRegistry::kNoSlot || !windows.Visited(s) || !DrawnByOverlay(windows, s)) return WindowRegistry::kNoSlot;
+    if (!g_overlayRegion) {
+        const WindowRect& r = windows.Rect(s);
+        const WindowRect outer = MoveSizeDamage(r, r, windows.Style(s).thickness);
+        for (WindowRegistry::Slot above : windows.Order()) {
+            if (above == s) break;
+            const WindowRect& a = windows.Rect(above);
+            if (RectsIntersect(MoveSizeDamage(a, a, windows.Style(above).thickness), outer)) return WindowRegistry::kNoSlot;
+        }
+    }
+    return s;
+}
+
+// True if the compositor was touched (the frame must commit)
+static bool UpdateBorderEffect(const BorderSettings& settings)
+{
+    if (settings.version != s_effectSettingsVersion) {
+        s_effectSettingsVersion = settings.version;
+        BorderEffect effect;
+        if (!ParseBorderEffect(settings.effectToken, effect)) {
+            DebugLog(L"[Effect] Unknown effect '" + settings.effectToken + L"', none used");
+        }
+        if (s_effects.SetEffect(effect)) DebugLog(L"[Effect] Effect set to '" + settings.effectToken + L"'");
+    }
+    if (!s_effects.Enabled() && s_effects.Target() == 0) return false;
+
+    bool touched;
+    const WindowRegistry::Slot s = s_effects.Enabled() ? EffectTarget(g_windows) : WindowRegistry::kNoSlot;
+    if (s == WindowRegistry::kNoSlot) {
+        touched = s_effects.Update(0, WindowRect{}, BorderStyle{}, s_effectCompositor);
+    } else {
+        const WindowRect& r = g_windows.Rect(s);
+        const WindowRect local{ r.left - g_virtualScreen.left, r.top - g_virtualScreen.top,
+                                r.right - g_virtualScreen.left, r.bottom - g_virtualScreen.top };
+        touched = s_effects.Update(g_windows.Handle(s), local, g_windows.Style(s), s_effectCompositor);
+    }
+    MetricSet(Metric::EffectRetargets, static_cast<int64_t>(s_effects.Retargets()));
+    MetricSet(Metric::EffectDraws, static_cast<int64_t>(s_effects.Draws()));
+    MetricSet(Metric::EffectAnimations, static_cast<int64_t>(s_effects.Animations()));
+    return touched;
+}
+
+// Settings thicknesses are 96-DPI pixels: a window's border follows the DPI of the monitor
+// showing most of it
+static void ScaleToMonitor(WindowRegistry::Slot s)
+{
+    BorderStyle& style = g_windows.Style(s);
+    style.thickness = s_monitors.ScaleThickness(s_monitors.Primary(g_windows.Rect(s)), style.thickness);
+}
+
+// After a full pass: the monitors whose windows changed since the previous one are redrawn,
+// the others keep their surface as it is
+static void PartitionPass()
+{
+    s_monitors.BeginSignatures();
+    for (WindowRegistry::Slot s : g_windows.Order()) {
+        const WindowRect& r = g_windows.Rect(s);
+        const BorderStyle& style = g_windows.Style(s);
+        s_monitors.AddToSignatures(MoveSizeDamage(r, r, style.thickness),
+                                   WindowDrawState(g_windows.Handle(s), r, style, DrawnByOverlay(g_windows, s) ? 1u : 0u));
+    }
+    s_monitors.EndSignatures();
+}
+
+// A window's border and occluder, on every monitor they reach
+static void InvalidateWindow(uint64_t handle)
+{
+    const WindowRegistry::Slot s = g_windows.Find(handle);
+    if (s == WindowRegistry::kNoSlot) return;
+    const WindowRect& r = g_windows.Rect(s);
+    s_monitors.Invalidate(MoveSizeDamage(r, r, g_windows.Style(s).thickness));
+}
+
+// Redraws monitor i's pending damage on its surface
+static bool DrawMonitor(size_t i)
+{
+    const MonitorDesc& m = s_monitors.Monitor(i);
+    const WindowRect& pending = s_monitors.PendingRect(i);
+    // The surface is in the monitor's coordinates, the registry in the overlay's
+    const RECT upd{ pending.left - m.bounds.left, pending.top - m.bounds.top, pending.right - m.bounds.left, pending.bottom - m.bounds.top };
+    const RECT damage{ pending.left - g_virtualScreen.left, pending.top - g_virtualScreen.top,
+                       pending.right - g_virtualScreen.left, pending.bottom - g_virtualScreen.top };
+    IDCompositionSurface* surface = s_pipelines[i].surface.Get();
+
+    Microsoft::WRL::ComPtr<IDXGISurface> dxgiSurface;
+    POINT offset{ 0, 0 };
+    if (FAILED(surface->BeginDraw(&upd, IID_PPV_ARGS(&dxgiSurface), &offset))) return false;
+    Microsoft::WRL::ComPtr<ID2D1Bitmap1> target;
+    D2D1_BITMAP_PROPERTIES1 props = D2D1::BitmapProperties1(
+        D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
+        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+    bool ok = SUCCEEDED(g_d2dCtx->CreateBitmapFromDxgiSurface(dxgiSurface.Get(), &props, &target));
+    if (ok) {
+        g_d2dCtx->SetTarget(target.Get());
+        g_d2dCtx->BeginDraw();
+        // DComp hands out only the update rect, placed at offset, and every pixel of it
+        // must be redrawn
+        g_d2dCtx->SetTransform(D2D1::Matrix3x2F::Translation((FLOAT)(offset.x - upd.left - (m.bounds.left - g_virtualScreen.left)),
+                                                             (FLOAT)(offset.y - upd.top - (m.bounds.top - g_virtualScreen.top))));
+        g_d2dCtx->PushAxisAlignedClip(D2D1::RectF((FLOAT)damage.left, (FLOAT)damage.top, (FLOAT)damage.right, (FLOAT)damage.bottom),
+                                      D2D1_ANTIALIAS_MODE_ALIASED);
+        g_d2dCtx->Clear(D2D1::ColorF(0, 0));
+        DrawBorders(g_d2dCtx.Get(), g_windows, &damage, s_effects.Target(), m.dpi);
+        g_d2dCtx->PopAxisAlignedClip();
+        g_d2dCtx->SetTransform(D2D1::Matrix3x2F::Identity());
+        ok = SUCCEEDED(g_d2dCtx->EndDraw());
+        g_d2dCtx->SetTarget(nullptr);
+    }
+    surface->EndDraw();
+    return ok;
+}
+
+// Region and draw from the registry's current state, for the monitors whose damage is due
+// (MonitorPartition.h); the others wait for their next refresh slot. One commit for all of
+// them. True if anything was drawn.
+static bool RenderOverlayFrame(const BorderSettings& settings)
+{
+    // Before the draw, so the surfaces skip the window the effect visual now carries. The
+    // windows handed between the two are drawn or cleared where they are.
+    const uint64_t effectBefore = s_effects.Target();
+    const bool effectTouched = UpdateBorderEffect(settings);
+    if (s_effects.Target() != effectBefore) {
+        InvalidateWindow(effectBefore);
+        InvalidateWindow(s_effects.Target());
+    }
+
+    const uint64_t now = SteadyNowNs();
+    const MonitorMask due = s_monitors.Due(now);
+    MetricAdd(Metric::MonitorUntouched, static_cast<int64_t>(CountMonitors(s_monitors.All() & ~s_monitors.Pending())));
+    if (!due) {
+        if (effectTouched) g_dcompDevice->Commit();
+        return effectTouched;
+    }
+
+    if (g_overlayRegion) {
+        // Only where the due monitors changed; a waiting monitor keeps the region that
+        // matches its surface
+        static std::vector<RECT> s_regionDamage;
+        s_regionDamage.clear();
+        bool full = due == s_monitors.All();
+        for (size_t i = 0; i < s_monitors.Count(); ++i) {
+            if (!(due & (MonitorMask(1) << i))) continue;
+            if (!s_monitors.PendingFull(i)) full = false;
+            const WindowRect& r = s_monitors.PendingRect(i);
+            s_regionDamage.push_back({ r.left - g_virtualScreen.left, r.top - g_virtualScreen.top,
+                                       r.right - g_virtualScreen.left, r.bottom - g_virtualScreen.top });
+        }
+        UpdateOverlayRegion(g_windows, full ? nullptr : s_regionDamage.data(), s_regionDamage.size());
+    }
+
+    bool drawn = false;
+    for (size_t i = 0; i < s_monitors.Count(); ++i) {
+        if (!(due & (MonitorMask(1) << i))) continue;
+        bool fresh = false;
+        if (EnsurePipeline(i, fresh)) {
+            // A new surface has no previous content to keep
+            if (fresh) s_monitors.InvalidateMonitors(MonitorMask(1) << i);
+            if (DrawMonitor(i)) drawn = true;
+        }
+        // Also on failure: the next change retries, the timer does not spin on it
+        s_monitors.Drawn(i, now);
+    }
+    MetricSet(Metric::MonitorDraws, static_cast<int64_t>(s_monitors.Draws()));
+    if (drawn || effectTouched) {
+        g_dcompDevice->Commit();
+        NoteFirstCommit();
+    }
+    return drawn || effectTouched;
 }
 
 void RefreshOverlay()
 {
     if (!g_overlay || g_mode != RenderMode::DComp) return;
+    ArenaVector<HWND> hwnds{ ArenaAllocator<HWND>(RenderFrameArena()) };
+    CollectUserVisibleWindows(hwnds);
+    RefreshOverlay(hwnds.data(), hwnds.size());
+}
 
-    UINT width = g_virtualScreen.right - g_virtualScreen.left;
-    UINT height = g_virtualScreen.bottom - g_virtualScreen.top;
-    if (FAILED(EnsureSurface(width, height))) return;
+void RefreshOverlay(const HWND* hwnds, size_t count)
+{
+    if (!g_overlay || g_mode != RenderMode::DComp) return;
 
-    std::vector<RECT> rectsZ;
-    {
-        auto hwnds = CollectUserVisibleWindows();
-        rectsZ.reserve(hwnds.size());
-        for (HWND h : hwnds) {
-            RECT rc{};
-            if (GetWindowBounds(h, rc)) rectsZ.push_back(rc);
-        }
+    // One settings snapshot for the whole frame
+    const auto settings = g_settings.Read();
+
+    // Frame pass over the registry: slots persist across frames, so steady state allocates nothing
+    g_windows.BeginPass();
+    for (size_t i = 0; i < count; ++i) {
+        HWND h = hwnds[i];
+        RECT rc{};
+        if (!GetWindowBounds(h, rc)) continue;
+        const WindowRegistry::Slot s = g_windows.Acquire(HwndKey(h));
+        g_windows.Visit(s);
+        g_windows.Rect(s) = { rc.left, rc.top, rc.right, rc.bottom };
+        g_windows.Style(s) = ResolveWindowStyle(h, *settings);
+        ScaleToMonitor(s);
+    }
+    g_windows.SweepUnvisited([](WindowRegistry::Slot) {});
+    s_overlayWindows = g_windows.Order().size();
+    if (settings.Superseded()) {
+        // Styles are already stale; the writer queued a refresh that draws the new ones
+        MetricAdd(Metric::SettingsPassesAbandoned);
+        return;
+    }
+    MetricSet(Metric::RenderDwmWindows, 0);
+    MetricSet(Metric::RenderOverlayWindows, static_cast<int64_t>(g_windows.Order().size()));
+
+    PublishLayout();
+    // Only monitors whose windows changed are drawn; a surface released while idle
+    // (IdleResources.h) comes back once something changes on its monitor
+    PartitionPass();
+    if (s_monitors.Pending()) {
+        DebugLogF(L"[Overlay] Drawing settings v%llu with color: R=%f G=%f B=%f A=%f thickness=%f foregroundOnly=%d rules=%lld windowCount=%zu",
+                  static_cast<unsigned long long>(settings->version), settings->color.r, settings->color.g, settings->color.b,
+                  settings->color.a, settings->thickness, settings->foregroundOnly ? 1 : 0,
+                  static_cast<long long>(MetricGet(Metric::RulesCount)), g_windows.Order().size());
     }
+    RenderOverlayFrame(*settings);
+}
 
-    UpdateOverlayRegion(rectsZ);
+bool RefreshOverlayWindow(HWND hwnd)
+{
+    if (!g_overlay || !g_dcompDevice) return false;
+    if (g_mode != RenderMode::DComp && !(g_mode == RenderMode::Hybrid && HybridOverlayActive())) return false;
+
+    // Every other slot keeps the geometry and style of the last full pass
+    const WindowRegistry::Slot s = g_windows.Find(HwndKey(hwnd));
+    if (s == WindowRegistry::kNoSlot) return false;
+    RECT rc{};
+    if (!GetWindowBounds(hwnd, rc)) return false;
+    const WindowRect next{ rc.left, rc.top, rc.right, rc.bottom };
+    if (next == g_windows.Rect(s)) return false;
+
+    // Only the monitors the border left and entered are redrawn, each at its own rate
+    s_monitors.Invalidate(MoveSizeDamage(g_windows.Rect(s), next, g_windows.Style(s).thickness));
+    g_windows.Rect(s) = next;
+    return RenderOverlayFrame(*g_settings.Read());
+}
 
-    POINT offset{ 0,0 };
-    Microsoft::WRL::ComPtr<ID2D1DeviceContext> ctx;
-    BeginDrawOnSurface(width, height, &ctx, &offset);
-    if (!ctx) return;
+bool FlushOverlayMonitors()
+{
+    if (!g_overlay || !g_dcompDevice || g_mode == RenderMode::Dwm) return false;
+    const MonitorMask due = s_monitors.Due(SteadyNowNs());
+    if (!due) return false;
+    MetricAdd(Metric::MonitorDeferred, static_cast<int64_t>(CountMonitors(due)));
+    return RenderOverlayFrame(*g_settings.Read());
+}
 
-    ctx->BeginDraw();
-    ctx->Clear(D2D1::ColorF(0, 0));
+uint64_t OverlayMonitorsDueNs()
+{
+    // Without devices nothing can be drawn, so nothing is waited for
+    if (!g_overlay || !g_dcompDevice || g_mode == RenderMode::Dwm) return 0;
+    return s_monitors.NextDueNs();
+}
 
-    // Debug log current settings before drawing
-    DebugLog(L"[Overlay] Drawing with color: R=" + std::to_wstring(g_borderColor.r) + 
-             L" G=" + std::to_wstring(g_borderColor.g) + 
-             L" B=" + std::to_wstring(g_borderColor.b) + 
-             L" A=" + std::to_wstring(g_borderColor.a) + 
-             L" thickness=" + std::to_wstring(g_thickness) +
-             L" foregroundOnly=" + std::to_wstring(g_foregroundWindowOnly) +
-             L" windowCount=" + std::to_wstring(rectsZ.size()));
+// Hybrid mode creates the devices on the first fallback; a session DWM fully serves never does
+static bool EnsureOverlayDevices()
+{
+    static bool failed = false;
+    if (failed) return false;
+    if (g_dcompDevice) return true;
 
-    DrawBorders(ctx.Get(), rectsZ);
+    HRESULT hr = CreateD3DDevice();
+    if (SUCCEEDED(hr)) hr = CreateD2D();
+    if (SUCCEEDED(hr)) hr = CreateDComp(g_overlay);
+    if (FAILED(hr)) {
+        failed = true;
+        DebugLog(L"[Hybrid] Overlay device creation failed (hr=" + std::to_wstring(hr) + L"), fallback windows stay unbordered");
+        return false;
+    }
+    DebugLog(L"[Hybrid] Overlay devices created for DWM fallbacks");
+    return true;
+}
+
+void RefreshHybridOverlay(size_t fallbackWindows, const BorderSettings& settings)
+{
+    if (!g_overlay || g_mode != RenderMode::Hybrid) return;
+    s_overlayWindows = fallbackWindows;
+
+    // Nothing drawn before and nothing to draw now: DWM covers every window
+    if (fallbackWindows == 0 && !s_hybridOverlayActive.load(std::memory_order_relaxed)) return;
+    // The overlay is hidden; the resume refresh catches up
+    if (IsOverlaySuspended()) return;
+    if (!EnsureOverlayDevices()) return;
+
+    // The frame after the last fallback went away clears the region and surfaces
+    s_hybridOverlayActive.store(fallbackWindows != 0, std::memory_order_relaxed);
+    for (WindowRegistry::Slot s : g_windows.Order()) {
+        if (g_windows.Flags(s) & WindowRegistry::kOverlay) ScaleToMonitor(s);
+    }
+    PartitionPass();
+    RenderOverlayFrame(settings);
+}
+
+bool HybridOverlayActive()
+{
+    return s_hybridOverlayActive.load(std::memory_order_relaxed);
+}
 
-    if (SUCCEEDED(ctx->EndDraw())) {
-        EndDrawOnSurface();
+size_t OverlayWindowCount()
+{
+    return s_overlayWindows;
+}
+
+void ReleaseOverlayResources()
+{
+    s_effects.Reset(s_effectCompositor);
+    s_effectCompositor.Release();
+    s_atlasBitmaps.clear();
+    s_atlasContext = nullptr;
+    if (g_d2dCtx) g_d2dCtx->SetTarget(nullptr);
+    bool released = false;
+    for (MonitorPipeline& p : s_pipelines) {
+        if (!p.surface) continue;
+        p.visual->SetContent(nullptr);
+        p.surface.Reset();
+        released = true;
+    }
+    if (released) g_dcompDevice->Commit();
+    if (g_d2dDevice) g_d2dDevice->ClearResources(0);
+    if (g_d3dCtx) {
+        // Trim requires the context to hold no references to what it is meant to free
+        g_d3dCtx->ClearState();
+        g_d3dCtx->Flush();
+    }
+    Microsoft::WRL::ComPtr<IDXGIDevice3> dxgi3;
+    if (g_dxgiDevice && SUCCEEDED(g_dxgiDevice.As(&dxgi3))) dxgi3->Trim();
+}
+
+void QueryMemoryUsage(uint64_t& privateBytes, uint64_t& gpuBytes)
+{
+    privateBytes = gpuBytes = 0;
+    PROCESS_MEMORY_COUNTERS_EX pmc{};
+    pmc.cb = sizeof(pmc);
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&pmc), sizeof(pmc)))
+        privateBytes = pmc.PrivateUsage;
+
+    Microsoft::WRL::ComPtr<IDXGIAdapter> adapter;
+    Microsoft::WRL::ComPtr<IDXGIAdapter3> adapter3;
+    DXGI_QUERY_VIDEO_MEMORY_INFO info{};
+    if (g_dxgiDevice && SUCCEEDED(g_dxgiDevice->GetAdapter(&adapter)) && SUCCEEDED(adapter.As(&adapter3)) &&
+        SUCCEEDED(adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info))) {
+        gpuBytes = info.CurrentUsage;
     }
 }
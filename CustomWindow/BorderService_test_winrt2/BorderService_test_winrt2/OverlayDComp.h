@@ -1,15 +1,48 @@
 #pragma once
 #include "pch.h"
 #include "Globals.h"
+#include "StyleRules.h"
 #include <vector>
 
 HRESULT CreateD3DDevice();
 HRESULT CreateD2D();
 HRESULT CreateDComp(HWND hwnd);
-HRESULT EnsureSurface(UINT width, UINT height);
-void BeginDrawOnSurface(UINT width, UINT height, ID2D1DeviceContext** outCtx, POINT* offset);
-void EndDrawOnSurface();
+// Re-reads the virtual screen and the monitors (MonitorPartition.h). Only monitors that
+// appeared, moved, resized or changed DPI get a new surface; the others keep theirs.
 void UpdateVirtualScreenAndResize();
-void DrawBorders(ID2D1DeviceContext* ctx, const std::vector<RECT>& rects);
-void UpdateOverlayRegion(const std::vector<RECT>& zorderedRects);
+// Both walk windows.Order() (z-order, top first) over the rect / style columns; with damage
+// (overlay coordinates) only windows whose border reaches into it take part. DrawBorders
+// skips effectTarget, whose border the effect visual carries (BorderEffects.h), and keys
+// its tiles by the DPI of the monitor it draws. The region takes damageCount rects.
+void DrawBorders(ID2D1DeviceContext* ctx, const WindowRegistry& windows, const RECT* damage = nullptr, uint64_t effectTarget = 0,
+                 uint32_t dpi = 96);
+void UpdateOverlayRegion(const WindowRegistry& windows, const RECT* damage = nullptr, size_t damageCount = 1);
 void RefreshOverlay();
+// Draws the given (already enumerated) windows, e.g. the parallel startup enumeration
+void RefreshOverlay(const HWND* hwnds, size_t count);
+inline void RefreshOverlay(const std::vector<HWND>& hwnds)
+{
+    RefreshOverlay(hwnds.data(), hwnds.size());
+}
+// Move/size session frame: re-reads only hwnd's bounds and redraws the area its border
+// left and entered. False if nothing was drawn (not bordered, not moved).
+bool RefreshOverlayWindow(HWND hwnd);
+// Hybrid mode, after a DWM pass: redraws the registry's kOverlay windows (devices on first use)
+void RefreshHybridOverlay(size_t fallbackWindows, const BorderSettings& settings);
+// Per-monitor pacing: monitors whose damage waited for their next refresh slot are drawn
+// once it comes. Render thread; true if anything was drawn.
+bool FlushOverlayMonitors();
+// steady_clock ns the next waiting monitor is due at, 0 if none waits
+uint64_t OverlayMonitorsDueNs();
+// Hybrid mode has fallback windows on the overlay, so geometry events matter. Any thread.
+bool HybridOverlayActive();
+// Windows the overlay drew last: every bordered window in DComp mode, the DWM fallbacks in
+// hybrid mode. Render thread.
+size_t OverlayWindowCount();
+// Idle release (IdleResources.h): drops the monitors' surfaces, the atlas bitmaps and D2D's resource
+// cache and trims the device. The devices stay, so the next frame only recreates what it
+// draws. Render thread.
+void ReleaseOverlayResources();
+// Private bytes of the process and local video memory used through the overlay device
+// (0 without one or before DXGI 1.4)
+void QueryMemoryUsage(uint64_t& privateBytes, uint64_t& gpuBytes);
@@ -0,0 +1,467 @@
+#include "pch.h"
+#include "Globals.h"
+#include "Logging.h"
+#include "DwmUtil.h"
+#include "OverlayDComp.h"
+#include "PowerMonitor.h"
+#include "WindowStyles.h"
+#include "Tray.h"
+#include "ProcessFilter.h"
+#include "EventClassifier.h"
+#include "Pipeline.h"
+#include "MoveSizeSession.h"
+#include "LatencyTracker.h"
+#include "Metrics.h"
+#include "TransitionBurst.h"
+#include "IdleResources.h"
+#include <chrono>
+#include <memory>
+
+static constexpr size_t kQueueCapacity = 4096;
+
+static void HandleBatch(const EventBatch& batch);
+
+static EventPipeline s_pipeline(kQueueCapacity, HandleBatch);
+static HANDLE s_intakeThread = nullptr;
+static DWORD s_intakeThreadId = 0;
+static MoveSizeSession s_moveSize; // render thread
+static FrameArena s_frameArena;    // render thread
+static BurstDetector s_burst;      // render thread
+static uint32_t s_resumesSeen = 0; // render thread: OverlayResumeCount() as of the last batch
+static IdleReclaimer s_idle;       // render thread
+
+static uint64_t NowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void EndMoveSizeSession()
+{
+    const MoveSizeStats stats = s_moveSize.End(NowNs());
+    DebugLogF(L"[MoveSize] Session ended: %llu frame(s), p99 %llu us, max %llu us, %llu deferred change(s)",
+              static_cast<unsigned long long>(stats.frames), static_cast<unsigned long long>(stats.p99Ns / 1000),
+              static_cast<unsigned long long>(stats.maxNs / 1000), static_cast<unsigned long long>(stats.deferred));
+}
+
+FrameArena& RenderFrameArena()
+{
+    return s_frameArena;
+}
+
+// QueryPerformanceCounter in microseconds, the clock DWM and DComp report frame times on
+static uint64_t QpcToUs(int64_t qpc)
+{
+    static const int64_t frequency = [] {
+        LARGE_INTEGER f{};
+        QueryPerformanceFrequency(&f);
+        return f.QuadPart;
+    }();
+    return static_cast<uint64_t>(qpc / frequency * 1000000 + qpc % frequency * 1000000 / frequency);
+}
+
+class Win32LatencyClock : public LatencyClock {
+public:
+    uint64_t NowUs() override
+    {
+        LARGE_INTEGER now{};
+        QueryPerformanceCounter(&now);
+        return QpcToUs(now.QuadPart);
+    }
+    uint32_t TickMs() override { return GetTickCount(); }
+};
+
+// The last composed frame: DComp frame statistics while the overlay device exists, DWM's
+// timing info otherwise. The missed-frame counters come from DWM either way.
+class Win32PresentSource : public PresentSource {
+public:
+    bool Query(PresentTiming& out) override
+    {
+        DWM_TIMING_INFO info{};
+        info.cbSize = sizeof(info);
+        if (FAILED(DwmGetCompositionTimingInfo(nullptr, &info))) return false;
+        out.vblankUs = QpcToUs(static_cast<int64_t>(info.qpcVBlank));
+        out.periodUs = QpcToUs(static_cast<int64_t>(info.qpcRefreshPeriod));
+        out.missedFrames = info.cFramesMissed + info.cFramesDropped;
+
+        DCOMPOSITION_FRAME_STATISTICS stats{};
+        if (g_dcompDevice && SUCCEEDED(g_dcompDevice->GetFrameStatistics(&stats)) && stats.lastFrameTime.QuadPart) {
+            out.vblankUs = QpcToUs(stats.lastFrameTime.QuadPart);
+            const DXGI_RATIONAL& rate = stats.currentCompositionRate;
+            if (rate.Numerator) out.periodUs = 1000000ull * rate.Denominator / rate.Numerator;
+        }
+        return true;
+    }
+};
+
+static Win32LatencyClock s_latencyClock;
+static Win32PresentSource s_presentSource;
+static LatencyTracker s_latency(s_latencyClock, s_presentSource); // render thread
+
+// Answers the classifier's questions from the live window state (render thread)
+class Win32WindowFacts : public WindowFactSource {
+public:
+    bool Query(uint64_t key, WindowFact fact) override
+    {
+        HWND h = KeyHwnd(key);
+        switch (fact) {
+        case WindowFact::Desktop: return h == GetDesktopWindow();
+        case WindowFact::TopLevel: return GetAncestor(h, GA_ROOT) == h;
+        case WindowFact::Tracked: return g_windows.Find(key) != WindowRegistry::kNoSlot;
+        case WindowFact::Trackable: return IsWindow(h) && IsAltTabEligible(h) && !IsWindowExcluded(h);
+        }
+        return false;
+    }
+};
+
+// Closes the burst if it has settled and turns it into one refresh; false while it holds
+static bool SettleBurst(uint64_t nowNs)
+{
+    if (!s_burst.Settle(nowNs)) return false;
+    MetricAdd(Metric::BurstCount);
+    MetricSet(Metric::BurstLastEvents, static_cast<int64_t>(s_burst.LastEvents()));
+    MetricSet(Metric::BurstLastWindows, static_cast<int64_t>(s_burst.LastWindows()));
+    MetricSet(Metric::BurstMaxEvents, static_cast<int64_t>(s_burst.MaxEvents()));
+    return true;
+}
+
+// Windows whose borders need the overlay's resources (IdleResources.h); pure DWM mode has
+// none but the working set, which is only worth giving back with no border at all
+static size_t DrawnWindowCount(bool suspended)
+{
+    if (g_mode == RenderMode::Dwm) return g_windows.Size();
+    return suspended ? 0 : OverlayWindowCount();
+}
+
+static void ReleaseIdleResources(uint64_t idleNs)
+{
+    uint64_t privateBefore = 0, gpuBefore = 0, privateAfter = 0, gpuAfter = 0;
+    QueryMemoryUsage(privateBefore, gpuBefore);
+    ReleaseOverlayResources();
+    s_frameArena.ReleaseOnReset();
+    SetProcessWorkingSetSize(GetCurrentProcess(), static_cast<SIZE_T>(-1), static_cast<SIZE_T>(-1));
+    QueryMemoryUsage(privateAfter, gpuAfter);
+    s_idle.Released();
+
+    MetricAdd(Metric::IdleReleases);
+    MetricSet(Metric::IdlePrivateKbActive, static_cast<int64_t>(privateBefore / 1024));
+    MetricSet(Metric::IdlePrivateKbIdle, static_cast<int64_t>(privateAfter / 1024));
+    MetricSet(Metric::IdleGpuKbActive, static_cast<int64_t>(gpuBefore / 1024));
+    MetricSet(Metric::IdleGpuKbIdle, static_cast<int64_t>(gpuAfter / 1024));
+    DebugLogF(L"[Idle] Nothing drawn for %llu s, resources released: private %llu -> %llu KB, GPU %llu -> %llu KB",
+              static_cast<unsigned long long>(idleNs / 1000000000ull),
+              static_cast<unsigned long long>(privateBefore / 1024), static_cast<unsigned long long>(privateAfter / 1024),
+              static_cast<unsigned long long>(gpuBefore / 1024), static_cast<unsigned long long>(gpuAfter / 1024));
+    if (g_overlay) PostMessageW(g_overlay, WM_APP_IDLE, 1, 0);
+}
+
+// Earliest of two steady_clock deadlines, 0 meaning none
+static uint64_t EarliestDue(uint64_t a, uint64_t b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return (std::min)(a, b);
+}
+
+static void HandleBatch(const EventBatch& batch)
+{
+    // explicit: timer / IPC / overflow resync. fromEvents: a WinEvent that changes what is drawn.
+    // sessionMoved: only the window of the open move/size session moved.
+    const uint64_t t0 = NowNs();
+    // Releases the frame's arena lists and records its heap allocations (alloc.* metrics)
+    FrameScope frame(s_frameArena);
+    bool explicitRefresh = batch.overflowed;
+    bool fromEvents = false;
+    bool sessionMoved = false;
+    Win32WindowFacts facts;
+
+    // Frames committed by earlier batches that have reached the screen since
+    if (s_latency.Poll()) s_latency.Publish();
+
+    // Lost events may include the session's end, a cloak change or a burst's last events
+    if (batch.overflowed) {
+        if (s_moveSize.Active()) EndMoveSizeSession();
+        ClearCloakCache();
+        s_burst.Reset();
+    }
+    // So may a suspension: the hooks were down and the intake dropped the rest (Tray.cpp)
+    const uint32_t resumes = OverlayResumeCount();
+    if (resumes != s_resumesSeen) {
+        s_resumesSeen = resumes;
+        ClearCloakCache();
+    }
+
+    for (const auto& e : batch.events) {
+        HWND h = KeyHwnd(e.hwnd);
+        // The style and cloak caches must forget every destroyed HWND, bordered or not
+        // (values are reused)
+        if (e.event == EVENT_OBJECT_DESTROY) {
+            ForgetWindowStyle(h);
+            ForgetWindowCloak(h);
+        } else if ((e.event == EVENT_OBJECT_CLOAKED || e.event == EVENT_OBJECT_UNCLOAKED) && e.idObject == OBJID_WINDOW) {
+            NoteWindowCloak(h, e.event == EVENT_OBJECT_CLOAKED);
+        }
+
+        const WindowChange change = ClassifyEvent(e, facts);
+        // Coalesced: the batch keeps the oldest timestamp per change type
+        s_latency.Note(change, e.timeMs);
+        // Only transitions of windows we draw (or would) count towards a burst
+        if (change != WindowChange::None && IsTransitionEvent(e.event)) s_burst.Note(e.hwnd, t0);
+        switch (change) {
+        case WindowChange::None:
+            break;
+        case WindowChange::Refresh:
+            explicitRefresh = true;
+            break;
+        case WindowChange::MoveSizeStart:
+            // A session whose END never came is reconciled now
+            if (s_moveSize.Active()) {
+                EndMoveSizeSession();
+                fromEvents = true;
+            }
+            s_moveSize.Begin(e.hwnd, NowNs());
+            break;
+        case WindowChange::MoveSizeEnd:
+            // The one full reconcile of the session
+            if (s_moveSize.Owns(e.hwnd)) {
+                EndMoveSizeSession();
+                fromEvents = true;
+            }
+            break;
+        case WindowChange::Destroyed:
+            g_windows.Release(e.hwnd);
+            if (s_moveSize.Owns(e.hwnd)) EndMoveSizeSession();
+            fromEvents = true;
+            break;
+        case WindowChange::Renamed:
+            // Title change: refresh only if the window now matches a different style rule
+            if (ReevaluateWindowStyle(h)) fromEvents = true;
+            break;
+        case WindowChange::Focus:
+            // DWM attributes only care about focus when restricted to the foreground window;
+            // overlay borders are restacked by it
+            if (g_mode != RenderMode::DComp && !g_settings.Read()->foregroundOnly && !HybridOverlayActive()) break;
+            if (s_moveSize.Active()) {
+                s_moveSize.Defer();
+                break;
+            }
+            fromEvents = true;
+            break;
+        case WindowChange::Moved:
+            if (s_moveSize.Owns(e.hwnd)) {
+                sessionMoved = true;
+                break;
+            }
+            [[fallthrough]];
+        default:
+            if (change == WindowChange::Hidden && s_moveSize.Owns(e.hwnd)) EndMoveSizeSession();
+            // Everything but the moving window stays frozen until the session ends
+            if (s_moveSize.Active()) {
+                s_moveSize.Defer();
+                break;
+            }
+            fromEvents = true;
+            break;
+        }
+    }
+
+    // A timer or IPC refresh during a drag waits for the reconcile at session end, like the
+    // other windows' changes; only a resync after lost events cannot wait
+    if (explicitRefresh && !batch.overflowed && s_moveSize.Active()) {
+        s_moveSize.Defer();
+        explicitRefresh = false;
+    }
+
+    bool suspended = IsOverlaySuspended();
+    // The hooks are down while suspended; the resume refresh reconciles
+    if (suspended) {
+        if (s_moveSize.Active()) EndMoveSizeSession();
+        s_burst.Reset();
+    }
+
+    // Mass transition (TransitionBurst.h): the passes its events would each cause, and any
+    // timer or IPC refresh meanwhile, are held until it settles; then one pass re-reads
+    // every window and draws the result. The held events keep their timestamps for it.
+    bool held = false, settled = false;
+    if (s_burst.Active()) {
+        settled = SettleBurst(NowNs());
+        held = !settled;
+        explicitRefresh = false;
+        fromEvents = settled;
+    }
+
+    bool drawn = false;
+    uint64_t wakeNs = s_burst.SettleDueNs();
+    if (g_mode == RenderMode::DComp) {
+        if ((explicitRefresh || fromEvents) && !suspended) {
+            RefreshOverlay();
+            drawn = true;
+        } else if (sessionMoved && !suspended) {
+            drawn = RefreshOverlayWindow(KeyHwnd(s_moveSize.Window()));
+        }
+    } else if (UsesDwmAttributes()) {
+        // Hybrid: the DWM pass ends by redrawing the overlay fallbacks
+        if (explicitRefresh || (fromEvents && !suspended)) {
+            RefreshDwmTargets();
+            drawn = true;
+        } else if (sessionMoved && !suspended) {
+            drawn = RefreshOverlayWindow(KeyHwnd(s_moveSize.Window()));
+        }
+        // Background tier of the last pass (DwmUtil.h): on the pipeline's timer, after the
+        // events that arrived meanwhile. Held while suspended or dragging; the reconcile
+        // that ends either re-plans it.
+        if (!suspended && !s_moveSize.Active()) {
+            if (batch.timer && !s_burst.Active() && RunDwmBackgroundSlice(NowNs())) drawn = true;
+            wakeNs = EarliestDue(wakeNs, DwmBackgroundDueNs());
+        }
+    }
+    // Per-monitor pacing (MonitorPartition.h): a monitor drawn less than one of its refresh
+    // periods ago keeps its damage until the timer brings its next slot
+    if (g_mode != RenderMode::Dwm && !suspended) {
+        if (batch.timer && FlushOverlayMonitors()) drawn = true;
+        wakeNs = EarliestDue(wakeNs, OverlayMonitorsDueNs());
+    }
+    if (drawn) {
+        MetricAdd(Metric::RenderRedraws);
+        s_latency.Committed();
+    } else if (!held) {
+        s_latency.Discard();
+    }
+    if (settled) {
+        const uint64_t settleNs = NowNs() - s_burst.LastStartNs();
+        MetricSet(Metric::BurstSettleUs, static_cast<int64_t>(settleNs / 1000));
+        DebugLogF(L"[Burst] %llu transition event(s) on %llu window(s), settled in %llu us",
+                  static_cast<unsigned long long>(s_burst.LastEvents()), static_cast<unsigned long long>(s_burst.LastWindows()),
+                  static_cast<unsigned long long>(settleNs / 1000));
+    }
+    if (drawn && s_moveSize.Active()) s_moveSize.RecordFrame(NowNs() - t0);
+
+    // Nothing to draw for a while: the surface, device caches and working set go back. The
+    // first frame that draws again rebuilds them and is checked against the budget.
+    const bool wasReleased = s_idle.IsReleased();
+    const uint64_t now = NowNs();
+    if (s_idle.Frame(DrawnWindowCount(suspended), now, now - t0)) {
+        ReleaseIdleResources(s_idle.Options().idleNs);
+    } else if (wasReleased && !s_idle.IsReleased()) {
+        MetricAdd(Metric::IdleRehydrations);
+        MetricSet(Metric::IdleRehydrateUs, static_cast<int64_t>(s_idle.LastRehydrateNs() / 1000));
+        MetricSet(Metric::IdleOverBudget, static_cast<int64_t>(s_idle.OverBudget()));
+        if (g_overlay) PostMessageW(g_overlay, WM_APP_IDLE, 0, 0);
+    }
+    s_pipeline.WakeAt(EarliestDue(wakeNs, s_idle.DueNs()));
+}
+
+void PushWinEvent(DWORD eventId, HWND hwnd, LONG idObject, DWORD timeMs)
+{
+    EventRecord rec;
+    rec.event = eventId;
+    rec.idObject = idObject;
+    rec.hwnd = HwndKey(hwnd);
+    rec.timeMs = timeMs;
+    s_pipeline.Push(rec);
+}
+
+void RequestRender()
+{
+    EventRecord rec;
+    rec.event = kEventRefreshRequest;
+    rec.timeMs = GetTickCount(); // on the hooks' clock, for latency.refresh.*
+    s_pipeline.Push(rec);
+}
+
+void PostRenderTask(std::function<void()> task)
+{
+    s_pipeline.PostTask(std::move(task));
+}
+
+bool ForwardHookCommand(HookCommand cmd)
+{
+    if (!s_intakeThreadId || GetCurrentThreadId() == s_intakeThreadId) return false;
+    PostThreadMessageW(s_intakeThreadId, WM_APP_HOOKS, static_cast<WPARAM>(cmd), 0);
+    return true;
+}
+
+static DWORD WINAPI IntakeThreadProc(LPVOID param)
+{
+    SetThreadDescription(GetCurrentThread(), L"BorderOverlay WinEvent intake");
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+
+    // Create the message queue before signalling, so forwarded hook commands are not lost
+    MSG msg{};
+    PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    InstallWinEventHooks();
+    SetEvent(static_cast<HANDLE>(param));
+
+    while (GetMessageW(&msg, nullptr, 0, 0)) {
+        if (msg.hwnd == nullptr && msg.message == WM_APP_HOOKS) {
+            switch (static_cast<HookCommand>(msg.wParam)) {
+            case HookCommand::Install: InstallWinEventHooks(); break;
+            case HookCommand::Suspend: SuspendWinEventHooks(); break;
+            case HookCommand::Uninstall: UninstallWinEventHooks(); break;
+            }
+            continue;
+        }
+        DispatchMessageW(&msg);
+    }
+
+    UninstallWinEventHooks();
+    return 0;
+}
+
+bool StartIntakeThread()
+{
+    if (s_intakeThread) return true;
+    HANDLE ready = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!ready) return false;
+    s_intakeThread = CreateThread(nullptr, 0, IntakeThreadProc, ready, 0, &s_intakeThreadId);
+    if (!s_intakeThread) {
+        s_intakeThreadId = 0;
+        CloseHandle(ready);
+        DebugLog(L"[Pipeline] Failed to start the intake thread");
+        return false;
+    }
+    WaitForSingleObject(ready, INFINITE);
+    CloseHandle(ready);
+    DebugLog(L"[Pipeline] Intake thread started, queue capacity " + std::to_wstring(s_pipeline.Capacity()));
+    return true;
+}
+
+void StartRenderThread()
+{
+    IdleOptions idle;
+    idle.idleNs = static_cast<uint64_t>(g_idleReleaseSec) * 1000000000ull;
+    s_idle.SetOptions(idle);
+
+    // Background tier of the first pass, drawn on this thread
+    s_pipeline.WakeAt(DwmBackgroundDueNs());
+    s_pipeline.Start();
+    SetThreadDescription(static_cast<HANDLE>(s_pipeline.NativeHandle()), L"BorderOverlay render");
+}
+
+// Waits for a thread handle while still dispatching this thread's sent messages
+static void WaitPumping(HANDLE thread)
+{
+    for (;;) {
+        DWORD r = MsgWaitForMultipleObjects(1, &thread, FALSE, INFINITE, QS_ALLINPUT);
+        if (r != WAIT_OBJECT_0 + 1) break;
+        MSG msg{};
+        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) DispatchMessageW(&msg);
+    }
+}
+
+void StopEventPipeline()
+{
+    if (s_intakeThread) {
+        PostThreadMessageW(s_intakeThreadId, WM_QUIT, 0, 0);
+        WaitForSingleObject(s_intakeThread, INFINITE);
+        CloseHandle(s_intakeThread);
+        s_intakeThread = nullptr;
+        s_intakeThreadId = 0;
+    }
+    if (s_pipeline.Running()) {
+        s_pipeline.RequestStop();
+        WaitPumping(static_cast<HANDLE>(s_pipeline.NativeHandle()));
+        s_pipeline.Join();
+    }
+    DebugLog(L"[Pipeline] Stopped, " + std::to_wstring(s_pipeline.Dropped()) + L" event(s) dropped in total");
+}
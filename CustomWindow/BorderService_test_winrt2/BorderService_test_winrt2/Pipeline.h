@@ -0,0 +1,35 @@
+#pragma once
+#include "pch.h"
+#include "EventPipeline.h"
+#include "FrameArena.h"
+#include <functional>
+
+// Thread layout (see EventPipeline.h for the queue and its overflow policy):
+//  - UI thread (main): overlay window, tray, IPC and power messages. Never renders.
+//  - Intake thread: owns the WinEvent hooks; WinEventProc only filters and enqueues.
+//  - Render thread: the only thread touching the D2D/DComp objects, g_windows, the style
+//    cache and the settings globals once started. IPC commands reach it as posted tasks,
+//    so no settings mutex is needed.
+
+// Starts the intake thread (which installs the hooks). Events queue up until StartRenderThread.
+bool StartIntakeThread();
+// Starts consuming the queue; call after the first frame has been drawn on the main thread.
+void StartRenderThread();
+// Stops both threads. Pumps the calling (UI) thread's messages while waiting, because
+// the render thread may be blocked in SetWindowRgn on the overlay window.
+void StopEventPipeline();
+
+// Any thread: enqueue a WinEvent / a coalesced full refresh
+void PushWinEvent(DWORD eventId, HWND hwnd, LONG idObject, DWORD timeMs);
+void RequestRender();
+// Any thread: run work on the render thread before its next batch
+void PostRenderTask(std::function<void()> task);
+
+// Transient lists of the current render frame (enumerated windows, DWM targets). Reset
+// when the batch ends; render thread only, or the UI thread before StartRenderThread.
+FrameArena& RenderFrameArena();
+
+// Hook (un)installation must happen on the intake thread, whose message loop receives the
+// out-of-context callbacks. Returns true if the command was forwarded there instead.
+enum class HookCommand { Install, Suspend, Uninstall };
+bool ForwardHookCommand(HookCommand cmd);
@@ -0,0 +1,246 @@
+#include "pch.h"
+#include "Globals.h"
+#include "Logging.h"
+#include "Tray.h"
+#include "DwmUtil.h"
+#include "PowerMonitor.h"
+#include <atomic>
+
+// Power setting GUIDs (winnt.h), defined locally so no extra import lib is needed.
+static const GUID kGuidAcDcPowerSource = { 0x5d3e9a59, 0xe9d5, 0x4b00, { 0xa6, 0xbd, 0xff, 0x34, 0xff, 0x51, 0x65, 0x48 } };
+static const GUID kGuidPowerSavingStatus = { 0xe00958c0, 0xc213, 0x4ace, { 0xac, 0x77, 0xfe, 0xcc, 0xed, 0x2e, 0xee, 0xa5 } };
+static const GUID kGuidConsoleDisplayState = { 0x6fe69556, 0x704a, 0x47a0, { 0x8f, 0x24, 0xc2, 0x8d, 0x93, 0x6f, 0xda, 0x47 } };
+
+static constexpr UINT_PTR kRefreshTimerId = 1;
+static constexpr UINT_PTR kFullscreenPollTimerId = 2;
+static constexpr UINT kFullscreenPollMs = 2000;
+
+static PowerPolicyEngine s_power;
+static HPOWERNOTIFY s_acdcNotify = nullptr;
+static HPOWERNOTIFY s_saverNotify = nullptr;
+static HPOWERNOTIFY s_displayNotify = nullptr;
+static bool s_sessionNotify = false;
+static bool s_started = false;
+static bool s_renderIdle = false;
+// Mirror of the current state for the intake and render threads (s_power is UI-thread only)
+static std::atomic<bool> s_suspended{ false };
+static std::atomic<uint32_t> s_resumes{ 0 };
+
+void ApplyEcoQos(bool enable)
+{
+    THREAD_POWER_THROTTLING_STATE ts{};
+    ts.Version = THREAD_POWER_THROTTLING_CURRENT_VERSION;
+    ts.ControlMask = THREAD_POWER_THROTTLING_EXECUTION_SPEED;
+    ts.StateMask = enable ? THREAD_POWER_THROTTLING_EXECUTION_SPEED : 0;
+    SetThreadInformation(GetCurrentThread(), ThreadPowerThrottling, &ts, sizeof(ts));
+
+    PROCESS_POWER_THROTTLING_STATE ps{};
+    ps.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+    ps.ControlMask = PROCESS_POWER_THROTTLING_EXECUTION_SPEED;
+    ps.StateMask = enable ? PROCESS_POWER_THROTTLING_EXECUTION_SPEED : 0;
+    SetProcessInformation(GetCurrentProcess(), ProcessPowerThrottling, &ps, sizeof(ps));
+}
+
+static bool IsFullscreenWindow(HWND fg)
+{
+    if (!fg) return false;
+    fg = GetAncestor(fg, GA_ROOT);
+    if (!fg || fg == g_overlay) return false;
+
+    wchar_t cls[64] = {};
+    GetClassNameW(fg, cls, 64);
+    if (wcscmp(cls, L"Progman") == 0 || wcscmp(cls, L"WorkerW") == 0 || wcscmp(cls, L"Shell_TrayWnd") == 0)
+        return false;
+
+    // Maximized captioned windows are not fullscreen even if they cover the monitor
+    LONG_PTR style = GetWindowLongPtr(fg, GWL_STYLE);
+    if ((style & WS_CAPTION) == WS_CAPTION) return false;
+
+    RECT wr{};
+    if (!GetWindowBounds(fg, wr)) return false;
+    HMONITOR mon = MonitorFromWindow(fg, MONITOR_DEFAULTTONULL);
+    MONITORINFO mi{ sizeof(mi) };
+    if (!mon || !GetMonitorInfoW(mon, &mi)) return false;
+    return wr.left <= mi.rcMonitor.left && wr.top <= mi.rcMonitor.top &&
+           wr.right >= mi.rcMonitor.right && wr.bottom >= mi.rcMonitor.bottom;
+}
+
+static bool QueryFullscreen(HWND fg)
+{
+    QUERY_USER_NOTIFICATION_STATE st{};
+    if (SUCCEEDED(SHQueryUserNotificationState(&st))) {
+        if (st == QUNS_RUNNING_D3D_FULL_SCREEN || st == QUNS_PRESENTATION_MODE) return true;
+    }
+    return IsFullscreenWindow(fg);
+}
+
+static void ReadSystemPowerStatus(PowerInputs& in)
+{
+    SYSTEM_POWER_STATUS sps{};
+    if (GetSystemPowerStatus(&sps)) {
+        in.onBattery = (sps.ACLineStatus == 0);
+        in.batterySaver = (sps.SystemStatusFlag == 1);
+    }
+}
+
+// Nothing to draw needs no fast resync; an event that brings a border back wakes the
+// render thread on its own
+static void ApplyRefreshTimer(const PowerDecision& d)
+{
+    UINT interval = d.refreshIntervalMs;
+    if (s_renderIdle && interval) interval = (std::max)(interval, s_power.Config().throttledIntervalMs);
+    if (interval) SetTimer(g_overlay, kRefreshTimerId, interval, nullptr);
+    else KillTimer(g_overlay, kRefreshTimerId);
+}
+
+static void ApplyPowerDecision(const PowerDecision& d)
+{
+    DebugLog(L"[Power] State -> " + ToWide(PowerStateName(d.state)) + L" (" + ToWide(d.reason) +
+             L"), refresh=" + std::to_wstring(d.refreshIntervalMs) +
+             L"ms, hooks=" + std::to_wstring(d.hooksEnabled) + L", ecoqos=" + std::to_wstring(d.ecoQos));
+
+    const bool suspended = d.state == PowerState::Suspended;
+    if (s_suspended.exchange(suspended, std::memory_order_acq_rel) && !suspended)
+        s_resumes.fetch_add(1, std::memory_order_release);
+    ApplyEcoQos(d.ecoQos);
+
+    if (!g_overlay) return;
+    if (g_mode == RenderMode::Dwm) {
+        // Nothing to hide; just catch up on what changed while suspended
+        if (d.state != PowerState::Suspended) PostMessageW(g_overlay, WM_APP_REFRESH, 0, 0);
+        return;
+    }
+
+    if (d.hooksEnabled) InstallWinEventHooks();
+    else SuspendWinEventHooks();
+
+    ApplyRefreshTimer(d);
+
+    // Fullscreen exit does not always raise a foreground event; poll slowly while suspended by it
+    if (d.state == PowerState::Suspended && s_power.Inputs().fullscreenForeground)
+        SetTimer(g_overlay, kFullscreenPollTimerId, kFullscreenPollMs, nullptr);
+    else
+        KillTimer(g_overlay, kFullscreenPollTimerId);
+
+    if (d.state == PowerState::Suspended) {
+        ShowWindow(g_overlay, SW_HIDE);
+        // One batch with nothing to draw starts the render thread's idle clock
+        PostMessageW(g_overlay, WM_APP_REFRESH, 0, 0);
+    } else {
+        ShowWindow(g_overlay, SW_SHOWNOACTIVATE);
+        PostMessageW(g_overlay, WM_APP_REFRESH, 0, 0);
+    }
+}
+
+static void UpdateInputs(const PowerInputs& in)
+{
+    if (!s_started) return;
+    if (s_power.Update(in)) {
+        ApplyPowerDecision(s_power.Current());
+    }
+}
+
+void InitPowerMonitor(HWND hwnd)
+{
+    if (!g_powerPolicyEnabled || !hwnd || s_started) return;
+
+    s_acdcNotify = RegisterPowerSettingNotification(hwnd, &kGuidAcDcPowerSource, DEVICE_NOTIFY_WINDOW_HANDLE);
+    s_saverNotify = RegisterPowerSettingNotification(hwnd, &kGuidPowerSavingStatus, DEVICE_NOTIFY_WINDOW_HANDLE);
+    s_displayNotify = RegisterPowerSettingNotification(hwnd, &kGuidConsoleDisplayState, DEVICE_NOTIFY_WINDOW_HANDLE);
+    s_sessionNotify = WTSRegisterSessionNotification(hwnd, NOTIFY_FOR_THIS_SESSION) != FALSE;
+
+    s_started = true;
+
+    PowerInputs in = s_power.Inputs();
+    ReadSystemPowerStatus(in);
+    in.fullscreenForeground = QueryFullscreen(GetForegroundWindow());
+    s_power.Update(in);
+    ApplyPowerDecision(s_power.Current());
+    DebugLog(L"[Power] Power monitor started");
+}
+
+void ShutdownPowerMonitor(HWND hwnd)
+{
+    if (!s_started) return;
+    if (s_acdcNotify) { UnregisterPowerSettingNotification(s_acdcNotify); s_acdcNotify = nullptr; }
+    if (s_saverNotify) { UnregisterPowerSettingNotification(s_saverNotify); s_saverNotify = nullptr; }
+    if (s_displayNotify) { UnregisterPowerSettingNotification(s_displayNotify); s_displayNotify = nullptr; }
+    if (s_sessionNotify) { WTSUnRegisterSessionNotification(hwnd); s_sessionNotify = false; }
+    if (hwnd) KillTimer(hwnd, kFullscreenPollTimerId);
+    s_started = false;
+    if (s_suspended.exchange(false, std::memory_order_acq_rel)) s_resumes.fetch_add(1, std::memory_order_release);
+}
+
+bool HandlePowerMessage(HWND, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    if (!s_started) return false;
+
+    switch (msg)
+    {
+    case WM_POWERBROADCAST:
+        {
+            PowerInputs in = s_power.Inputs();
+            if (wParam == PBT_POWERSETTINGCHANGE && lParam) {
+                auto* ps = reinterpret_cast<const POWERBROADCAST_SETTING*>(lParam);
+                DWORD v = 0;
+                if (ps->DataLength >= sizeof(DWORD)) memcpy(&v, ps->Data, sizeof(DWORD));
+                if (IsEqualGUID(ps->PowerSetting, kGuidAcDcPowerSource)) in.onBattery = (v != 0);        // PoAc = 0
+                else if (IsEqualGUID(ps->PowerSetting, kGuidPowerSavingStatus)) in.batterySaver = (v != 0);
+                else if (IsEqualGUID(ps->PowerSetting, kGuidConsoleDisplayState)) in.displayOff = (v == 0); // 0 off, 1 on, 2 dimmed
+            } else if (wParam == PBT_APMPOWERSTATUSCHANGE) {
+                ReadSystemPowerStatus(in);
+            } else if (wParam == PBT_APMRESUMEAUTOMATIC) {
+                ReadSystemPowerStatus(in);
+                in.displayOff = false;
+            }
+            UpdateInputs(in);
+            return true;
+        }
+    case WM_WTSSESSION_CHANGE:
+        {
+            PowerInputs in = s_power.Inputs();
+            if (wParam == WTS_SESSION_LOCK) in.sessionLocked = true;
+            else if (wParam == WTS_SESSION_UNLOCK) in.sessionLocked = false;
+            else return true;
+            UpdateInputs(in);
+            return true;
+        }
+    case WM_TIMER:
+        if (wParam == kFullscreenPollTimerId) {
+            OnForegroundChangedForPower(GetForegroundWindow());
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+void OnForegroundChangedForPower(HWND fg)
+{
+    if (!s_started) return;
+    PowerInputs in = s_power.Inputs();
+    in.fullscreenForeground = QueryFullscreen(fg);
+    if (in != s_power.Inputs()) UpdateInputs(in);
+}
+
+void SetRenderIdle(bool idle)
+{
+    if (s_renderIdle == idle) return;
+    s_renderIdle = idle;
+    if (g_overlay && g_mode != RenderMode::Dwm) ApplyRefreshTimer(s_power.Current());
+}
+
+bool IsOverlaySuspended()
+{
+    return s_suspended.load(std::memory_order_acquire);
+}
+
+uint32_t OverlayResumeCount()
+{
+    return s_resumes.load(std::memory_order_acquire);
+}
+
+const PowerDecision& CurrentPowerDecision()
+{
+    return s_power.Current();
+}
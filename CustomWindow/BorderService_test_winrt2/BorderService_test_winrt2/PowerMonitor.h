@@ -0,0 +1,29 @@
+#pragma once
+#include "pch.h"
+#include "Globals.h"
+#include "PowerPolicy.h"
+
+// Win32 side of the power policy: collects battery / battery saver / display /
+// session lock / fullscreen inputs and applies the resulting PowerDecision.
+void InitPowerMonitor(HWND hwnd);
+void ShutdownPowerMonitor(HWND hwnd);
+
+// Returns true if the message was a power/session message and has been handled.
+bool HandlePowerMessage(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+// Re-evaluates the fullscreen input for the given foreground window.
+void OnForegroundChangedForPower(HWND fg);
+
+// The render thread released its idle resources (IdleResources.h) / draws again; the
+// refresh timer runs at the throttled interval meanwhile. UI thread (WM_APP_IDLE).
+void SetRenderIdle(bool idle);
+
+// Any thread
+bool IsOverlaySuspended();
+// Suspended -> running transitions so far. The hooks were down in between, so a consumer
+// that sees it change has missed events (the render thread's cloak cache).
+uint32_t OverlayResumeCount();
+const PowerDecision& CurrentPowerDecision();
+
+// Marks the calling thread (and the process) as EcoQoS / power-throttled.
+void ApplyEcoQos(bool enable);
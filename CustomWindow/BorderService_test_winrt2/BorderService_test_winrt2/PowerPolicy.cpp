@@ -0,0 +1,77 @@
+#include "PowerPolicy.h"
+#include "Metrics.h"
+
+PowerDecision EvaluatePowerPolicy(const PowerInputs& in, const PowerPolicyConfig& cfg)
+{
+    PowerDecision d{};
+    d.state = PowerState::Active;
+    d.refreshIntervalMs = cfg.activeIntervalMs;
+    d.hooksEnabled = true;
+    d.ecoQos = false;
+    d.reason = "active";
+
+    auto suspend = [&](const char* why) {
+        d.state = PowerState::Suspended;
+        d.refreshIntervalMs = 0;
+        d.hooksEnabled = false;
+        d.ecoQos = true;
+        d.reason = why;
+        return d;
+    };
+
+    if (in.sessionLocked) return suspend("locked");
+    if (in.displayOff) return suspend("display-off");
+    if (in.fullscreenForeground && cfg.suspendOnFullscreen) return suspend("fullscreen");
+
+    if (cfg.throttleOnBattery && (in.batterySaver || in.onBattery)) {
+        d.state = PowerState::Throttled;
+        d.refreshIntervalMs = cfg.throttledIntervalMs;
+        d.ecoQos = true;
+        d.reason = in.batterySaver ? "battery-saver" : "battery";
+    }
+    return d;
+}
+
+PowerPolicyEngine::PowerPolicyEngine(const PowerPolicyConfig& cfg)
+    : m_cfg(cfg)
+{
+    m_decision = EvaluatePowerPolicy(m_inputs, m_cfg);
+    MetricSet(Metric::PowerState, static_cast<int64_t>(m_decision.state));
+    MetricSet(Metric::PowerRefreshMs, m_decision.refreshIntervalMs);
+}
+
+bool PowerPolicyEngine::Update(const PowerInputs& in)
+{
+    m_inputs = in;
+    return Publish(EvaluatePowerPolicy(m_inputs, m_cfg));
+}
+
+void PowerPolicyEngine::SetConfig(const PowerPolicyConfig& cfg)
+{
+    m_cfg = cfg;
+    Publish(EvaluatePowerPolicy(m_inputs, m_cfg));
+}
+
+bool PowerPolicyEngine::Publish(const PowerDecision& d)
+{
+    if (d == m_decision) {
+        m_decision.reason = d.reason;
+        return false;
+    }
+    m_decision = d;
+    MetricSet(Metric::PowerState, static_cast<int64_t>(d.state));
+    MetricSet(Metric::PowerHooksSuspended, d.hooksEnabled ? 0 : 1);
+    MetricSet(Metric::PowerRefreshMs, d.refreshIntervalMs);
+    MetricAdd(Metric::PowerTransitions);
+    return true;
+}
+
+const char* PowerStateName(PowerState s)
+{
+    switch (s) {
+    case PowerState::Active: return "active";
+    case PowerState::Throttled: return "throttled";
+    case PowerState::Suspended: return "suspended";
+    }
+    return "unknown";
+}
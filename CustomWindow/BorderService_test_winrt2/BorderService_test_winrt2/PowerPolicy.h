@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+
+// Power policy: decides how much work the overlay may do given the machine state.
+// Pure logic with no Windows dependency; PowerMonitor.cpp feeds it real inputs.
+
+enum class PowerState : int {
+    Active = 0,     // normal hooks + refresh cadence
+    Throttled = 1,  // hooks on, slower refresh, EcoQoS
+    Suspended = 2,  // hooks and refresh timer off, overlay hidden
+};
+
+struct PowerInputs {
+    bool onBattery = false;
+    bool batterySaver = false;
+    bool sessionLocked = false;
+    bool displayOff = false;
+    bool fullscreenForeground = false;
+
+    bool operator==(const PowerInputs& o) const {
+        return onBattery == o.onBattery && batterySaver == o.batterySaver &&
+               sessionLocked == o.sessionLocked && displayOff == o.displayOff &&
+               fullscreenForeground == o.fullscreenForeground;
+    }
+    bool operator!=(const PowerInputs& o) const { return !(*this == o); }
+};
+
+struct PowerPolicyConfig {
+    uint32_t activeIntervalMs = 150;
+    uint32_t throttledIntervalMs = 1000;
+    bool suspendOnFullscreen = true;
+    bool throttleOnBattery = true;
+};
+
+struct PowerDecision {
+    PowerState state = PowerState::Active;
+    uint32_t refreshIntervalMs = 150; // 0 = refresh timer stopped
+    bool hooksEnabled = true;
+    bool ecoQos = false;
+    const char* reason = "active";
+
+    bool operator==(const PowerDecision& o) const {
+        return state == o.state && refreshIntervalMs == o.refreshIntervalMs &&
+               hooksEnabled == o.hooksEnabled && ecoQos == o.ecoQos;
+    }
+    bool operator!=(const PowerDecision& o) const { return !(*this == o); }
+};
+
+// Stateless mapping from inputs to a decision.
+// Priority: locked > display off > fullscreen > battery saver > battery > active.
+PowerDecision EvaluatePowerPolicy(const PowerInputs& in, const PowerPolicyConfig& cfg);
+
+// Keeps the last inputs/decision and reports transitions (also mirrored to Metrics).
+class PowerPolicyEngine {
+public:
+    explicit PowerPolicyEngine(const PowerPolicyConfig& cfg = PowerPolicyConfig{});
+
+    // Returns true if the decision changed.
+    bool Update(const PowerInputs& in);
+    void SetConfig(const PowerPolicyConfig& cfg);
+
+    const PowerInputs& Inputs() const { return m_inputs; }
+    const PowerDecision& Current() const { return m_decision; }
+    const PowerPolicyConfig& Config() const { return m_cfg; }
+
+private:
+    bool Publish(const PowerDecision& d);
+
+    PowerPolicyConfig m_cfg;
+    PowerInputs m_inputs;
+    PowerDecision m_decision;
+};
+
+const char* PowerStateName(PowerState s);
@@ -0,0 +1,121 @@
+#include "ProcessExclusion.h"
+#include "Metrics.h"
+#include <cwctype>
+
+std::wstring NormalizeImageName(const std::wstring& nameOrPath)
+{
+    size_t start = nameOrPath.find_last_of(L"\\/");
+    start = (start == std::wstring::npos) ? 0 : start + 1;
+    size_t end = nameOrPath.size();
+    while (end > start && (nameOrPath[end - 1] == L' ' || nameOrPath[end - 1] == L'\t')) --end;
+    while (start < end && (nameOrPath[start] == L' ' || nameOrPath[start] == L'\t')) ++start;
+
+    std::wstring out(nameOrPath, start, end - start);
+    if (out.size() > 4) {
+        std::wstring ext = out.substr(out.size() - 4);
+        for (auto& c : ext) c = (wchar_t)std::towlower(c);
+        if (ext == L".exe") out.resize(out.size() - 4);
+    }
+    for (auto& c : out) c = (wchar_t)std::towlower(c);
+    return out;
+}
+
+std::vector<std::wstring> ParseExclusionList(const std::wstring& list)
+{
+    std::vector<std::wstring> out;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t end = list.find(L'|', pos);
+        if (end == std::wstring::npos) end = list.size();
+        std::wstring name = NormalizeImageName(list.substr(pos, end - pos));
+        if (!name.empty()) out.push_back(std::move(name));
+        pos = end + 1;
+    }
+    return out;
+}
+
+void ExclusionSet::Assign(const std::vector<std::wstring>& names)
+{
+    m_names.clear();
+    for (const auto& n : names) {
+        std::wstring norm = NormalizeImageName(n);
+        if (!norm.empty()) m_names.insert(std::move(norm));
+    }
+    ++m_generation;
+    MetricSet(Metric::ExclusionNames, static_cast<int64_t>(m_names.size()));
+}
+
+ImageNameCache::ImageNameCache(Resolver resolver)
+    : m_resolver(std::move(resolver))
+{
+}
+
+void ImageNameCache::CountLookup(bool hit)
+{
+    ++m_lookups;
+    if (hit) ++m_hits;
+    MetricAdd(Metric::ExclusionLookups);
+    MetricAdd(hit ? Metric::ExclusionCacheHits : Metric::ExclusionCacheMisses);
+    MetricSet(Metric::ExclusionHitRatePct, static_cast<int64_t>(m_hits * 100 / m_lookups));
+}
+
+ImageNameCache::Entry* ImageNameCache::FindOrResolve(uint32_t pid)
+{
+    auto it = m_entries.find(pid);
+    if (it != m_entries.end()) {
+        CountLookup(true);
+        return &it->second;
+    }
+    CountLookup(false);
+
+    std::wstring name;
+    if (!m_resolver || !m_resolver(pid, name)) return nullptr;
+    Entry& e = m_entries[pid];
+    e.name = NormalizeImageName(name);
+    MetricSet(Metric::ExclusionCacheSize, static_cast<int64_t>(m_entries.size()));
+    return &e;
+}
+
+bool ImageNameCache::IsExcluded(uint32_t pid, const ExclusionSet& set)
+{
+    if (set.Empty() || pid == 0) return false;
+    std::lock_guard<std::mutex> guard(m_lock);
+    Entry* e = FindOrResolve(pid);
+    if (!e) return false;
+    if (e->verdictGeneration != set.Generation()) {
+        e->excluded = set.Contains(e->name);
+        e->verdictGeneration = set.Generation();
+    }
+    return e->excluded;
+}
+
+bool ImageNameCache::Lookup(uint32_t pid, std::wstring& outName)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    Entry* e = FindOrResolve(pid);
+    if (!e) return false;
+    outName = e->name;
+    return true;
+}
+
+void ImageNameCache::Invalidate(uint32_t pid)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_entries.erase(pid)) {
+        MetricAdd(Metric::ExclusionInvalidations);
+        MetricSet(Metric::ExclusionCacheSize, static_cast<int64_t>(m_entries.size()));
+    }
+}
+
+void ImageNameCache::Clear()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_entries.clear();
+    MetricSet(Metric::ExclusionCacheSize, 0);
+}
+
+size_t ImageNameCache::Size() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_entries.size();
+}
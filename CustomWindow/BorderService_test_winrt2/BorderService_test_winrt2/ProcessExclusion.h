@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Process exclusion applied inside the service.
+// Portable: the PID -> image name resolver is injected (Win32 uses QueryFullProcessImageNameW).
+
+// "C:\\Apps\\Foo.EXE" -> "foo"
+std::wstring NormalizeImageName(const std::wstring& nameOrPath);
+
+// Parses "a|b|c" (IPC / --exclude) into normalized names, dropping empties.
+std::vector<std::wstring> ParseExclusionList(const std::wstring& list);
+
+class ExclusionSet {
+public:
+    void Assign(const std::vector<std::wstring>& names);
+    bool Contains(const std::wstring& normalizedName) const { return m_names.count(normalizedName) != 0; }
+    bool Empty() const { return m_names.empty(); }
+    size_t Size() const { return m_names.size(); }
+    // Bumped on every Assign so cached verdicts can be revalidated cheaply
+    uint32_t Generation() const { return m_generation; }
+
+private:
+    std::unordered_set<std::wstring> m_names;
+    uint32_t m_generation = 1;
+};
+
+// PID -> image name cache with a cached exclusion verdict per entry.
+// Entries are dropped by Invalidate() when the process exits; safe to call from any thread.
+class ImageNameCache {
+public:
+    using Resolver = std::function<bool(uint32_t pid, std::wstring& outName)>;
+
+    explicit ImageNameCache(Resolver resolver);
+
+    // Looks up (resolving on miss) and returns the exclusion verdict for pid.
+    // Unresolvable PIDs are never excluded.
+    bool IsExcluded(uint32_t pid, const ExclusionSet& set);
+
+    // Returns false if the name could not be resolved.
+    bool Lookup(uint32_t pid, std::wstring& outName);
+
+    void Invalidate(uint32_t pid);
+    void Clear();
+    size_t Size() const;
+
+private:
+    struct Entry {
+        std::wstring name;
+        uint32_t verdictGeneration = 0;
+        bool excluded = false;
+    };
+
+    Entry* FindOrResolve(uint32_t pid);
+    void CountLookup(bool hit);
+
+    Resolver m_resolver;
+    mutable std::mutex m_lock;
+    std::unordered_map<uint32_t, Entry> m_entries;
+    uint64_t m_lookups = 0;
+    uint64_t m_hits = 0;
+};
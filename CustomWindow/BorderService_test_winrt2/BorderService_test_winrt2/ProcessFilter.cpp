@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "ProcessExclusion.h"
+#include "ProcessFilter.h"
+#include <mutex>
+
+// Exit watches keep the process handle open, which also prevents the PID from being
+// reused while its cache entry is alive. The wait callback drops the entry on exit.
+struct ExitWatch {
+    HANDLE process = nullptr;
+    HANDLE wait = nullptr;
+};
+
+static std::mutex s_watchLock;
+static std::unordered_map<DWORD, ExitWatch> s_watches;
+static ExclusionSet s_excluded;
+static std::wstring s_excludedList;
+
+static bool ResolveImageName(uint32_t pid, std::wstring& out);
+static ImageNameCache s_cache(ResolveImageName);
+
+static void CALLBACK OnProcessExited(PVOID context, BOOLEAN)
+{
+    DWORD pid = static_cast<DWORD>(reinterpret_cast<uintptr_t>(context));
+
+    // Watch first, entry second: a lookup resolving the PID in between finds no watch and
+    // registers a new one (firing at once on the dead process), so no entry is left
+    // without a watch. Not under one lock: the resolver takes s_watchLock inside the
+    // cache's lock.
+    ExitWatch w{};
+    bool watched = false;
+    {
+        std::lock_guard<std::mutex> guard(s_watchLock);
+        auto it = s_watches.find(pid);
+        if (it != s_watches.end()) {
+            w = it->second;
+            s_watches.erase(it);
+            watched = true;
+        }
+    }
+    s_cache.Invalidate(pid);
+    if (!watched) return;
+    // Non-blocking unregister is allowed from inside the callback
+    if (w.wait) UnregisterWaitEx(w.wait, nullptr);
+    if (w.process) CloseHandle(w.process);
+}
+
+static bool ResolveImageName(uint32_t pid, std::wstring& out)
+{
+    HANDLE proc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
+    if (!proc) return false;
+
+    wchar_t path[MAX_PATH] = {};
+    DWORD len = MAX_PATH;
+    if (!QueryFullProcessImageNameW(proc, 0, path, &len)) {
+        CloseHandle(proc);
+        return false;
+    }
+    out.assign(path, len);
+
+    std::lock_guard<std::mutex> guard(s_watchLock);
+    if (s_watches.count(pid)) {
+        CloseHandle(proc);
+        return true;
+    }
+    ExitWatch w{ proc, nullptr };
+    if (!RegisterWaitForSingleObject(&w.wait, proc, OnProcessExited,
+                                     reinterpret_cast<PVOID>(static_cast<uintptr_t>(pid)),
+                                     INFINITE, WT_EXECUTEONLYONCE)) {
+        // Without an exit watch the entry could outlive the process; don't cache it
+        CloseHandle(proc);
+        return false;
+    }
+    s_watches[pid] = w;
+    return true;
+}
+
+void SetExcludedProcesses(const std::wstring& list)
+{
+    s_excludedList = list;
+    s_excluded.Assign(ParseExclusionList(list));
+    DebugLog(L"[Exclude] " + std::to_wstring(s_excluded.Size()) + L" process name(s) excluded");
+}
+
+bool HasExcludedProcesses()
+{
+    return !s_excluded.Empty();
+}
+
+std::wstring GetExcludedProcessesList()
+{
+    return s_excludedList;
+}
+
+bool IsWindowExcluded(HWND h)
+{
+    if (s_excluded.Empty()) return false;
+    DWORD pid = 0;
+    GetWindowThreadProcessId(h, &pid);
+    return s_cache.IsExcluded(pid, s_excluded);
+}
+
+bool GetWindowImageName(HWND h, std::wstring& normalizedName)
+{
+    DWORD pid = 0;
+    GetWindowThreadProcessId(h, &pid);
+    if (!pid) return false;
+    return s_cache.Lookup(pid, normalizedName);
+}
+
+void ShutdownProcessFilter()
+{
+    std::unordered_map<DWORD, ExitWatch> watches;
+    {
+        std::lock_guard<std::mutex> guard(s_watchLock);
+        watches.swap(s_watches);
+    }
+    for (auto& kv : watches) {
+        if (kv.second.wait) UnregisterWaitEx(kv.second.wait, INVALID_HANDLE_VALUE);
+        if (kv.second.process) CloseHandle(kv.second.process);
+    }
+    s_cache.Clear();
+}
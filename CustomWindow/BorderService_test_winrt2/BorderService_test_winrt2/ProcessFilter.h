@@ -0,0 +1,14 @@
+#pragma once
+#include "pch.h"
+#include <string>
+
+// In-service process exclusion (replaces the GUI-side filtering of the HWND list).
+// list: "name1|name2|..." - file names or paths, with or without .exe
+void SetExcludedProcesses(const std::wstring& list);
+bool HasExcludedProcesses();
+// The list as last set (persisted in the startup snapshot)
+std::wstring GetExcludedProcessesList();
+bool IsWindowExcluded(HWND h);
+// Normalized image name of the window's process ("foo" for C:\\Apps\\Foo.exe), via the shared cache
+bool GetWindowImageName(HWND h, std::wstring& normalizedName);
+void ShutdownProcessFilter();
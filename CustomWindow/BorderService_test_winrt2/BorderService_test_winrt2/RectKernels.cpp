@@ -0,0 +1,474 @@
+#include "RectKernels.h"
+#include "Metrics.h"
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RECT_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define RECT_TARGET_SSE2
+#define RECT_TARGET_AVX2
+#else
+#define RECT_TARGET_SSE2 __attribute__((target("sse2")))
+#define RECT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+void RectColumns::Resize(size_t n)
+{
+    left.resize(n);
+    top.resize(n);
+    right.resize(n);
+    bottom.resize(n);
+}
+
+void RectColumns::Push(const WindowRect& r)
+{
+    left.push_back(r.left);
+    top.push_back(r.top);
+    right.push_back(r.right);
+    bottom.push_back(r.bottom);
+}
+
+void RectColumnsF::Resize(size_t n)
+{
+    left.resize(n);
+    top.resize(n);
+    right.resize(n);
+    bottom.resize(n);
+}
+
+// Raw column pointers, offset to the first rect a kernel (or its scalar tail) handles
+struct InCols {
+    const int32_t *l, *t, *r, *b;
+    InCols At(size_t i) const { return { l + i, t + i, r + i, b + i }; }
+};
+struct OutCols {
+    int32_t *l, *t, *r, *b;
+    OutCols At(size_t i) const { return { l + i, t + i, r + i, b + i }; }
+};
+struct OutColsF {
+    float *l, *t, *r, *b;
+    OutColsF At(size_t i) const { return { l + i, t + i, r + i, b + i }; }
+};
+
+struct RectKernelTable {
+    RectIsa isa;
+    void (*clip)(InCols in, OutCols out, size_t n, const WindowRect& to, uint8_t* nonEmpty);
+    void (*expand)(InCols in, const int32_t* by, OutCols out, size_t n);
+    void (*bands)(InCols in, const int32_t* t, const OutCols* bands, size_t n);
+    void (*translate)(InCols in, int32_t dx, int32_t dy, OutCols out, size_t n);
+    void (*toFloat)(InCols in, OutColsF out, size_t n);
+    void (*stroke)(const float* thickness, size_t n, int32_t* out);
+};
+
+// ---- scalar: the reference every other path must match bit for bit ----
+
+static void ClipScalar(InCols in, OutCols out, size_t n, const WindowRect& to, uint8_t* nonEmpty)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const int32_t l = in.l[i] > to.left ? in.l[i] : to.left;
+        const int32_t t = in.t[i] > to.top ? in.t[i] : to.top;
+        const int32_t r = in.r[i] < to.right ? in.r[i] : to.right;
+        const int32_t b = in.b[i] < to.bottom ? in.b[i] : to.bottom;
+        out.l[i] = l;
+        out.t[i] = t;
+        out.r[i] = r;
+        out.b[i] = b;
+        nonEmpty[i] = (r > l && b > t) ? 1 : 0;
+    }
+}
+
+static void ExpandScalar(InCols in, const int32_t* by, OutCols out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const int32_t d = by[i];
+        out.l[i] = in.l[i] - d;
+        out.t[i] = in.t[i] - d;
+        out.r[i] = in.r[i] + d;
+        out.b[i] = in.b[i] + d;
+    }
+}
+
+static void BandsScalar(InCols in, const int32_t* t, const OutCols* bands, size_t n)
+{
+    const OutCols& top = bands[kBandTop];
+    const OutCols& bottom = bands[kBandBottom];
+    const OutCols& left = bands[kBandLeft];
+    const OutCols& right = bands[kBandRight];
+    for (size_t i = 0; i < n; ++i) {
+        const int32_t l = in.l[i], tp = in.t[i], r = in.r[i], b = in.b[i], d = t[i];
+        top.l[i] = l - d;    top.t[i] = tp - d;   top.r[i] = r + d;    top.b[i] = tp;
+        bottom.l[i] = l - d; bottom.t[i] = b;     bottom.r[i] = r + d; bottom.b[i] = b + d;
+        left.l[i] = l - d;   left.t[i] = tp;      left.r[i] = l;       left.b[i] = b;
+        right.l[i] = r;      right.t[i] = tp;     right.r[i] = r + d;  right.b[i] = b;
+    }
+}
+
+static void TranslateScalar(InCols in, int32_t dx, int32_t dy, OutCols out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out.l[i] = in.l[i] + dx;
+        out.t[i] = in.t[i] + dy;
+        out.r[i] = in.r[i] + dx;
+        out.b[i] = in.b[i] + dy;
+    }
+}
+
+static void ToFloatScalar(InCols in, OutColsF out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out.l[i] = static_cast<float>(in.l[i]);
+        out.t[i] = static_cast<float>(in.t[i]);
+        out.r[i] = static_cast<float>(in.r[i]);
+        out.b[i] = static_cast<float>(in.b[i]);
+    }
+}
+
+static void StrokeScalar(const float* thickness, size_t n, int32_t* out)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const int32_t t = static_cast<int32_t>(thickness[i] + 0.999f);
+        out[i] = t < 1 ? 1 : t;
+    }
+}
+
+static const RectKernelTable s_scalar = {
+    RectIsa::Scalar, ClipScalar, ExpandScalar, BandsScalar, TranslateScalar, ToFloatScalar, StrokeScalar,
+};
+
+#if RECT_KERNELS_X86
+
+// ---- SSE2: 4 rects per step (no 32-bit min/max before SSE4.1, so compare and select) ----
+
+RECT_TARGET_SSE2 static inline __m128i Load4(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+RECT_TARGET_SSE2 static inline void Store4(int32_t* p, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+RECT_TARGET_SSE2 static inline __m128i Max4(__m128i a, __m128i b)
+{
+    const __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+}
+RECT_TARGET_SSE2 static inline __m128i Min4(__m128i a, __m128i b)
+{
+    const __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, b), _mm_andnot_si128(gt, a));
+}
+
+RECT_TARGET_SSE2 static void ClipSse2(InCols in, OutCols out, size_t n, const WindowRect& to, uint8_t* nonEmpty)
+{
+    const __m128i tl = _mm_set1_epi32(to.left), tt = _mm_set1_epi32(to.top);
+    const __m128i tr = _mm_set1_epi32(to.right), tb = _mm_set1_epi32(to.bottom);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i l = Max4(Load4(in.l + i), tl), t = Max4(Load4(in.t + i), tt);
+        const __m128i r = Min4(Load4(in.r + i), tr), b = Min4(Load4(in.b + i), tb);
+        Store4(out.l + i, l);
+        Store4(out.t + i, t);
+        Store4(out.r + i, r);
+        Store4(out.b + i, b);
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(r, l), _mm_cmpgt_epi32(b, t))));
+        for (int j = 0; j < 4; ++j) nonEmpty[i + j] = static_cast<uint8_t>((mask >> j) & 1);
+    }
+    ClipScalar(in.At(i), out.At(i), n - i, to, nonEmpty + i);
+}
+
+RECT_TARGET_SSE2 static void ExpandSse2(InCols in, const int32_t* by, OutCols out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i d = Load4(by + i);
+        Store4(out.l + i, _mm_sub_epi32(Load4(in.l + i), d));
+        Store4(out.t + i, _mm_sub_epi32(Load4(in.t + i), d));
+        Store4(out.r + i, _mm_add_epi32(Load4(in.r + i), d));
+        Store4(out.b + i, _mm_add_epi32(Load4(in.b + i), d));
+    }
+    ExpandScalar(in.At(i), by + i, out.At(i), n - i);
+}
+
+RECT_TARGET_SSE2 static void BandsSse2(InCols in, const int32_t* t, const OutCols* bands, size_t n)
+{
+    const OutCols& top = bands[kBandTop];
+    const OutCols& bottom = bands[kBandBottom];
+    const OutCols& left = bands[kBandLeft];
+    const OutCols& right = bands[kBandRight];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i l = Load4(in.l + i), tp = Load4(in.t + i), r = Load4(in.r + i), b = Load4(in.b + i);
+        const __m128i d = Load4(t + i);
+        const __m128i lm = _mm_sub_epi32(l, d), rp = _mm_add_epi32(r, d);
+        const __m128i tm = _mm_sub_epi32(tp, d), bp = _mm_add_epi32(b, d);
+        Store4(top.l + i, lm);    Store4(top.t + i, tm);    Store4(top.r + i, rp);    Store4(top.b + i, tp);
+        Store4(bottom.l + i, lm); Store4(bottom.t + i, b);  Store4(bottom.r + i, rp); Store4(bottom.b + i, bp);
+        Store4(left.l + i, lm);   Store4(left.t + i, tp);   Store4(left.r + i, l);    Store4(left.b + i, b);
+        Store4(right.l + i, r);   Store4(right.t + i, tp);  Store4(right.r + i, rp);  Store4(right.b + i, b);
+    }
+    const OutCols rest[kBandCount] = { top.At(i), bottom.At(i), left.At(i), right.At(i) };
+    BandsScalar(in.At(i), t + i, rest, n - i);
+}
+
+RECT_TARGET_SSE2 static void TranslateSse2(InCols in, int32_t dx, int32_t dy, OutCols out, size_t n)
+{
+    const __m128i vx = _mm_set1_epi32(dx), vy = _mm_set1_epi32(dy);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        Store4(out.l + i, _mm_add_epi32(Load4(in.l + i), vx));
+        Store4(out.t + i, _mm_add_epi32(Load4(in.t + i), vy));
+        Store4(out.r + i, _mm_add_epi32(Load4(in.r + i), vx));
+        Store4(out.b + i, _mm_add_epi32(Load4(in.b + i), vy));
+    }
+    TranslateScalar(in.At(i), dx, dy, out.At(i), n - i);
+}
+
+RECT_TARGET_SSE2 static void ToFloatSse2(InCols in, OutColsF out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out.l + i, _mm_cvtepi32_ps(Load4(in.l + i)));
+        _mm_storeu_ps(out.t + i, _mm_cvtepi32_ps(Load4(in.t + i)));
+        _mm_storeu_ps(out.r + i, _mm_cvtepi32_ps(Load4(in.r + i)));
+        _mm_storeu_ps(out.b + i, _mm_cvtepi32_ps(Load4(in.b + i)));
+    }
+    ToFloatScalar(in.At(i), out.At(i), n - i);
+}
+
+RECT_TARGET_SSE2 static void StrokeSse2(const float* thickness, size_t n, int32_t* out)
+{
+    const __m128 bias = _mm_set1_ps(0.999f);
+    const __m128i one = _mm_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i t = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(thickness + i), bias));
+        Store4(out + i, Max4(t, one));
+    }
+    StrokeScalar(thickness + i, n - i, out + i);
+}
+
+static const RectKernelTable s_sse2 = {
+    RectIsa::Sse2, ClipSse2, ExpandSse2, BandsSse2, TranslateSse2, ToFloatSse2, StrokeSse2,
+};
+
+// ---- AVX2: 8 rects per step ----
+
+RECT_TARGET_AVX2 static inline __m256i Load8(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+RECT_TARGET_AVX2 static inline void Store8(int32_t* p, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+RECT_TARGET_AVX2 static void ClipAvx2(InCols in, OutCols out, size_t n, const WindowRect& to, uint8_t* nonEmpty)
+{
+    const __m256i tl = _mm256_set1_epi32(to.left), tt = _mm256_set1_epi32(to.top);
+    const __m256i tr = _mm256_set1_epi32(to.right), tb = _mm256_set1_epi32(to.bottom);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i l = _mm256_max_epi32(Load8(in.l + i), tl), t = _mm256_max_epi32(Load8(in.t + i), tt);
+        const __m256i r = _mm256_min_epi32(Load8(in.r + i), tr), b = _mm256_min_epi32(Load8(in.b + i), tb);
+        Store8(out.l + i, l);
+        Store8(out.t + i, t);
+        Store8(out.r + i, r);
+        Store8(out.b + i, b);
+        const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_and_si256(_mm256_cmpgt_epi32(r, l), _mm256_cmpgt_epi32(b, t))));
+        for (int j = 0; j < 8; ++j) nonEmpty[i + j] = static_cast<uint8_t>((mask >> j) & 1);
+    }
+    ClipScalar(in.At(i), out.At(i), n - i, to, nonEmpty + i);
+}
+
+RECT_TARGET_AVX2 static void ExpandAvx2(InCols in, const int32_t* by, OutCols out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i d = Load8(by + i);
+        Store8(out.l + i, _mm256_sub_epi32(Load8(in.l + i), d));
+        Store8(out.t + i, _mm256_sub_epi32(Load8(in.t + i), d));
+        Store8(out.r + i, _mm256_add_epi32(Load8(in.r + i), d));
+        Store8(out.b + i, _mm256_add_epi32(Load8(in.b + i), d));
+    }
+    ExpandScalar(in.At(i), by + i, out.At(i), n - i);
+}
+
+RECT_TARGET_AVX2 static void BandsAvx2(InCols in, const int32_t* t, const OutCols* bands, size_t n)
+{
+    const OutCols& top = bands[kBandTop];
+    const OutCols& bottom = bands[kBandBottom];
+    const OutCols& left = bands[kBandLeft];
+    const OutCols& right = bands[kBandRight];
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i l = Load8(in.l + i), tp = Load8(in.t + i), r = Load8(in.r + i), b = Load8(in.b + i);
+        const __m256i d = Load8(t + i);
+        const __m256i lm = _mm256_sub_epi32(l, d), rp = _mm256_add_epi32(r, d);
+        const __m256i tm = _mm256_sub_epi32(tp, d), bp = _mm256_add_epi32(b, d);
+        Store8(top.l + i, lm);    Store8(top.t + i, tm);    Store8(top.r + i, rp);    Store8(top.b + i, tp);
+        Store8(bottom.l + i, lm); Store8(bottom.t + i, b);  Store8(bottom.r + i, rp); Store8(bottom.b + i, bp);
+        Store8(left.l + i, lm);   Store8(left.t + i, tp);   Store8(left.r + i, l);    Store8(left.b + i, b);
+        Store8(right.l + i, r);   Store8(right.t + i, tp);  Store8(right.r + i, rp);  Store8(right.b + i, b);
+    }
+    const OutCols rest[kBandCount] = { top.At(i), bottom.At(i), left.At(i), right.At(i) };
+    BandsScalar(in.At(i), t + i, rest, n - i);
+}
+
+RECT_TARGET_AVX2 static void TranslateAvx2(InCols in, int32_t dx, int32_t dy, OutCols out, size_t n)
+{
+    const __m256i vx = _mm256_set1_epi32(dx), vy = _mm256_set1_epi32(dy);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        Store8(out.l + i, _mm256_add_epi32(Load8(in.l + i), vx));
+        Store8(out.t + i, _mm256_add_epi32(Load8(in.t + i), vy));
+        Store8(out.r + i, _mm256_add_epi32(Load8(in.r + i), vx));
+        Store8(out.b + i, _mm256_add_epi32(Load8(in.b + i), vy));
+    }
+    TranslateScalar(in.At(i), dx, dy, out.At(i), n - i);
+}
+
+RECT_TARGET_AVX2 static void ToFloatAvx2(InCols in, OutColsF out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out.l + i, _mm256_cvtepi32_ps(Load8(in.l + i)));
+        _mm256_storeu_ps(out.t + i, _mm256_cvtepi32_ps(Load8(in.t + i)));
+        _mm256_storeu_ps(out.r + i, _mm256_cvtepi32_ps(Load8(in.r + i)));
+        _mm256_storeu_ps(out.b + i, _mm256_cvtepi32_ps(Load8(in.b + i)));
+    }
+    ToFloatScalar(in.At(i), out.At(i), n - i);
+}
+
+RECT_TARGET_AVX2 static void StrokeAvx2(const float* thickness, size_t n, int32_t* out)
+{
+    const __m256 bias = _mm256_set1_ps(0.999f);
+    const __m256i one = _mm256_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i t = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_loadu_ps(thickness + i), bias));
+        Store8(out + i, _mm256_max_epi32(t, one));
+    }
+    StrokeScalar(thickness + i, n - i, out + i);
+}
+
+static const RectKernelTable s_avx2 = {
+    RectIsa::Avx2, ClipAvx2, ExpandAvx2, BandsAvx2, TranslateAvx2, ToFloatAvx2, StrokeAvx2,
+};
+
+#endif // RECT_KERNELS_X86
+
+// ---- dispatch ----
+
+const char* RectIsaName(RectIsa isa)
+{
+    switch (isa) {
+    case RectIsa::Scalar: return "scalar";
+    case RectIsa::Sse2: return "sse2";
+    case RectIsa::Avx2: return "avx2";
+    }
+    return "?";
+}
+
+static RectIsa Detect()
+{
+#if RECT_KERNELS_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4] = {};
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+    __cpuid(regs, 1);
+    if (!(regs[3] & (1 << 26))) return RectIsa::Scalar;
+    // AVX2 needs the CPU bit and the OS saving YMM state (OSXSAVE + XCR0 bits 1 and 2)
+    const bool osAvx = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && ((_xgetbv(0) & 0x6) == 0x6);
+    if (osAvx && maxLeaf >= 7) {
+        __cpuidex(regs, 7, 0);
+        if (regs[1] & (1 << 5)) return RectIsa::Avx2;
+    }
+    return RectIsa::Sse2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return RectIsa::Avx2;
+    if (__builtin_cpu_supports("sse2")) return RectIsa::Sse2;
+    return RectIsa::Scalar;
+#endif
+#else
+    return RectIsa::Scalar;
+#endif
+}
+
+static const RectKernelTable* TableFor(RectIsa isa)
+{
+#if RECT_KERNELS_X86
+    if (isa == RectIsa::Avx2) return &s_avx2;
+    if (isa == RectIsa::Sse2) return &s_sse2;
+#endif
+    (void)isa;
+    return &s_scalar;
+}
+
+static std::atomic<const RectKernelTable*> s_table{ nullptr };
+
+static const RectKernelTable& Kernels()
+{
+    const RectKernelTable* t = s_table.load(std::memory_order_acquire);
+    if (!t) {
+        t = TableFor(DetectRectIsa());
+        s_table.store(t, std::memory_order_release);
+        MetricSet(Metric::GeometryIsa, static_cast<int64_t>(t->isa));
+    }
+    return *t;
+}
+
+RectIsa DetectRectIsa()
+{
+    static const RectIsa detected = Detect();
+    return detected;
+}
+
+RectIsa ActiveRectIsa()
+{
+    return Kernels().isa;
+}
+
+RectIsa SetRectIsa(RectIsa isa)
+{
+    if (static_cast<uint32_t>(isa) > static_cast<uint32_t>(DetectRectIsa())) isa = DetectRectIsa();
+    const RectKernelTable* t = TableFor(isa);
+    s_table.store(t, std::memory_order_release);
+    MetricSet(Metric::GeometryIsa, static_cast<int64_t>(t->isa));
+    return t->isa;
+}
+
+static InCols In(const RectColumns& c) { return { c.left.data(), c.top.data(), c.right.data(), c.bottom.data() }; }
+static OutCols Out(RectColumns& c) { return { c.left.data(), c.top.data(), c.right.data(), c.bottom.data() }; }
+
+void ClipRects(const RectColumns& in, const WindowRect& to, RectColumns& out, uint8_t* nonEmpty)
+{
+    out.Resize(in.Size());
+    Kernels().clip(In(in), Out(out), in.Size(), to, nonEmpty);
+}
+
+void ExpandRects(const RectColumns& in, const int32_t* by, RectColumns& out)
+{
+    out.Resize(in.Size());
+    Kernels().expand(In(in), by, Out(out), in.Size());
+}
+
+void BorderBands(const RectColumns& in, const int32_t* t, RectColumns bands[kBandCount])
+{
+    OutCols out[kBandCount];
+    for (size_t k = 0; k < kBandCount; ++k) {
+        bands[k].Resize(in.Size());
+        out[k] = Out(bands[k]);
+    }
+    Kernels().bands(In(in), t, out, in.Size());
+}
+
+void TranslateRects(const RectColumns& in, int32_t dx, int32_t dy, RectColumns& out)
+{
+    out.Resize(in.Size());
+    Kernels().translate(In(in), dx, dy, Out(out), in.Size());
+}
+
+void RectsToFloat(const RectColumns& in, RectColumnsF& out)
+{
+    out.Resize(in.Size());
+    Kernels().toFloat(In(in), { out.left.data(), out.top.data(), out.right.data(), out.bottom.data() }, in.Size());
+}
+
+void StrokeExtents(const float* thickness, size_t n, int32_t* out)
+{
+    Kernels().stroke(thickness, n, out);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "WindowRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Batch geometry over structure-of-arrays rects: the per-window arithmetic of
+// CollectUserVisibleWindows (clip to the virtual screen), UpdateOverlayRegion (stroke
+// extent, occluder expansion, border bands) and DrawBorders (virtual-screen offset, float
+// conversion), done for every window of a pass at once. SSE2 and AVX2 paths are picked at
+// runtime (DetectRectIsa); every path produces bit-identical results to the scalar one.
+// Portable; non-x86 builds use the scalar path.
+
+// Four parallel columns, one entry per rect
+struct RectColumns {
+    std::vector<int32_t> left, top, right, bottom;
+
+    size_t Size() const { return left.size(); }
+    void Resize(size_t n);
+    void Clear() { Resize(0); }
+    void Push(const WindowRect& r);
+    WindowRect Get(size_t i) const { return { left[i], top[i], right[i], bottom[i] }; }
+};
+
+struct RectColumnsF {
+    std::vector<float> left, top, right, bottom;
+
+    size_t Size() const { return left.size(); }
+    void Resize(size_t n);
+};
+
+// Border bands of a window, non-overlapping: top and bottom span the corners,
+// left and right only the window's height
+enum RectBand : size_t { kBandTop, kBandBottom, kBandLeft, kBandRight, kBandCount };
+
+enum class RectIsa : uint32_t { Scalar, Sse2, Avx2 };
+const char* RectIsaName(RectIsa isa);
+// Best path the CPU and OS support
+RectIsa DetectRectIsa();
+// Path the kernels use (DetectRectIsa unless forced)
+RectIsa ActiveRectIsa();
+// Forces a path, limited to what DetectRectIsa allows; returns the path now in use
+RectIsa SetRectIsa(RectIsa isa);
+
+// out may be in. Outputs are resized to in.Size().
+
+// Intersection with `to`; nonEmpty[i] = 1 if it has area (IntersectRect's result), else 0
+void ClipRects(const RectColumns& in, const WindowRect& to, RectColumns& out, uint8_t* nonEmpty);
+// Grows rect i by by[i] on every side
+void ExpandRects(const RectColumns& in, const int32_t* by, RectColumns& out);
+// Four bands of width t[i] around rect i (the stroke UpdateOverlayRegion cuts out)
+void BorderBands(const RectColumns& in, const int32_t* t, RectColumns bands[kBandCount]);
+void TranslateRects(const RectColumns& in, int32_t dx, int32_t dy, RectColumns& out);
+void RectsToFloat(const RectColumns& in, RectColumnsF& out);
+// Whole-pixel stroke extent: max(1, (int)(thickness + 0.999f))
+void StrokeExtents(const float* thickness, size_t n, int32_t* out);
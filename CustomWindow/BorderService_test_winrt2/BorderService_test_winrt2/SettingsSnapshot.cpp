@@ -0,0 +1,102 @@
+#include "SettingsSnapshot.h"
+#include <thread>
+
+BorderStyle BorderSettings::Style() const
+{
+    BorderStyle s;
+    s.color = color;
+    s.thickness = thickness;
+    s.corner = CornerStyleFromToken(cornerToken);
+    return s;
+}
+
+SettingsStore::SettingsStore()
+{
+    BorderSettings* initial = new BorderSettings();
+    initial->version = 1;
+    m_live.store(1, std::memory_order_relaxed);
+    m_version.store(1, std::memory_order_relaxed);
+    m_current.store(initial, std::memory_order_release);
+}
+
+SettingsStore::~SettingsStore()
+{
+    // No Ref may outlive the store
+    for (auto& r : m_retired) delete r.second;
+    delete m_current.load(std::memory_order_relaxed);
+}
+
+SettingsStore::Ref::~Ref()
+{
+    if (m_store) m_store->m_readers[m_slot].epoch.store(0, std::memory_order_release);
+}
+
+bool SettingsStore::Ref::Superseded() const
+{
+    return m_store && m_store->Version() != m_settings->version;
+}
+
+SettingsStore::Ref SettingsStore::Read() const
+{
+    // Start at a per-thread slot so readers on different threads rarely collide
+    const size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id()) % kReaderSlots;
+    for (;;) {
+        for (size_t i = 0; i < kReaderSlots; ++i) {
+            const size_t slot = (start + i) % kReaderSlots;
+            uint64_t expected = 0;
+            // An epoch read before a concurrent Update's increment is older, so only more
+            // conservative: that Update keeps its retired snapshot until this Ref is gone
+            const uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+            if (!m_readers[slot].epoch.compare_exchange_strong(expected, epoch, std::memory_order_seq_cst)) continue;
+            const BorderSettings* settings = m_current.load(std::memory_order_seq_cst);
+            return Ref(this, slot, settings);
+        }
+        std::this_thread::yield();
+    }
+}
+
+uint64_t SettingsStore::Update(const std::function<void(BorderSettings&)>& edit, BorderSettings* previous)
+{
+    std::lock_guard<std::mutex> lock(m_writeLock);
+    const BorderSettings* old = m_current.load(std::memory_order_relaxed);
+    BorderSettings* next = new BorderSettings(*old);
+    m_live.fetch_add(1, std::memory_order_relaxed);
+    if (previous) *previous = *old;
+    edit(*next);
+    next->version = old->version + 1;
+
+    m_current.store(next, std::memory_order_seq_cst);
+    m_version.store(next->version, std::memory_order_release);
+    // Readers that announce a later epoch load the pointer after the swap above
+    m_retired.emplace_back(m_epoch.fetch_add(1, std::memory_order_seq_cst), old);
+    ReclaimLocked();
+    return next->version;
+}
+
+size_t SettingsStore::Reclaim()
+{
+    std::lock_guard<std::mutex> lock(m_writeLock);
+    return ReclaimLocked();
+}
+
+size_t SettingsStore::ReclaimLocked()
+{
+    if (m_retired.empty()) return 0;
+    uint64_t oldestReader = UINT64_MAX;
+    for (const auto& r : m_readers) {
+        const uint64_t e = r.epoch.load(std::memory_order_seq_cst);
+        if (e && e < oldestReader) oldestReader = e;
+    }
+    // A snapshot retired at epoch e is unreachable once every active reader started after e
+    size_t kept = 0;
+    for (auto& r : m_retired) {
+        if (r.first < oldestReader) {
+            delete r.second;
+            m_live.fetch_sub(1, std::memory_order_relaxed);
+        } else {
+            m_retired[kept++] = r;
+        }
+    }
+    m_retired.resize(kept);
+    return kept;
+}
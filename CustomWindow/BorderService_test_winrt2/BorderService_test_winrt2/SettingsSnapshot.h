@@ -0,0 +1,98 @@
+#pragma once
+#include "StyleRules.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Border settings as immutable, versioned snapshots (the SET IPC command, --color /
+// --thickness / --corner / --foregroundonly / --effect, the startup snapshot). Portable.
+//
+// Readers on any thread pin the current snapshot with SettingsStore::Read() and see one
+// consistent set of values for as long as they hold the Ref; they never block and never
+// take a lock. Writers copy, edit and publish a new snapshot with an atomic pointer swap.
+// The old one is retired and freed once no reader can still hold it (epoch-based
+// reclamation: each reader announces the epoch it started in, in a fixed slot array).
+
+struct BorderSettings {
+    uint64_t version = 0;       // 1 for the defaults, +1 per Update
+    ColorF color{ 0.0f, 0.8f, 1.0f, 1.0f };
+    float thickness = 5.0f;
+    std::wstring cornerToken = L"default";
+    bool foregroundOnly = false;
+    std::wstring effectToken = L"none"; // focused-window effect (BorderEffects.h)
+
+    // Global border style before style rules
+    BorderStyle Style() const;
+};
+
+class SettingsStore {
+public:
+    // Concurrent Refs beyond this wait for a slot to free up
+    static constexpr size_t kReaderSlots = 64;
+
+    class Ref {
+    public:
+        Ref(Ref&& other) noexcept : m_store(other.m_store), m_slot(other.m_slot), m_settings(other.m_settings)
+        {
+            other.m_store = nullptr;
+        }
+        Ref(const Ref&) = delete;
+        Ref& operator=(const Ref&) = delete;
+        Ref& operator=(Ref&&) = delete;
+        ~Ref();
+
+        const BorderSettings& operator*() const { return *m_settings; }
+        const BorderSettings* operator->() const { return m_settings; }
+        // A newer snapshot has been published; work tagged with this one is stale
+        bool Superseded() const;
+
+    private:
+        friend class SettingsStore;
+        Ref(const SettingsStore* store, size_t slot, const BorderSettings* settings)
+            : m_store(store), m_slot(slot), m_settings(settings) {}
+
+        const SettingsStore* m_store;
+        size_t m_slot;
+        const BorderSettings* m_settings;
+    };
+
+    SettingsStore();
+    ~SettingsStore();
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+
+    // Any thread, lock-free (a slot CAS and two stores)
+    Ref Read() const;
+    uint64_t Version() const { return m_version.load(std::memory_order_acquire); }
+
+    // Any thread; writers serialize. Copies the current snapshot, applies edit and
+    // publishes the result as the next version. previous receives the replaced snapshot.
+    uint64_t Update(const std::function<void(BorderSettings&)>& edit, BorderSettings* previous = nullptr);
+
+    // Frees retired snapshots no reader can still hold (Update does this as well).
+    // Returns how many remain retired.
+    size_t Reclaim();
+    // Snapshots allocated and not yet freed, the current one included
+    size_t LiveSnapshots() const { return m_live.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{ 0 }; // 0 = free, else the epoch the reader started in
+    };
+
+    size_t ReclaimLocked();
+
+    std::atomic<const BorderSettings*> m_current{ nullptr };
+    std::atomic<uint64_t> m_version{ 0 };
+    std::atomic<uint64_t> m_epoch{ 1 };
+    mutable ReaderSlot m_readers[kReaderSlots];
+    std::atomic<size_t> m_live{ 0 };
+
+    std::mutex m_writeLock;
+    std::vector<std::pair<uint64_t, const BorderSettings*>> m_retired; // (retire epoch, snapshot)
+};
@@ -0,0 +1,711 @@
+#include "SimBackend.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <chrono>
+
+// winuser.h values (the simulated desktop reports what Windows reports)
+static constexpr uint32_t kEventSystemForeground = 0x0003;
+static constexpr uint32_t kEventSystemMinimizeStart = 0x0016;
+static constexpr uint32_t kEventSystemMinimizeEnd = 0x0017;
+static constexpr uint32_t kEventSystemMoveSizeStart = 0x000A;
+static constexpr uint32_t kEventSystemMoveSizeEnd = 0x000B;
+static constexpr uint32_t kEventObjectDestroy = 0x8001;
+static constexpr uint32_t kEventObjectShow = 0x8002;
+static constexpr uint32_t kEventObjectHide = 0x8003;
+static constexpr uint32_t kEventObjectReorder = 0x8004;
+static constexpr uint32_t kEventObjectLocationChange = 0x800B;
+static constexpr uint32_t kEventObjectNameChange = 0x800C;
+static constexpr uint32_t kEventObjectValueChange = 0x800E;
+static constexpr uint32_t kEventObjectCloaked = 0x8017;
+static constexpr uint32_t kEventObjectUncloaked = 0x8018;
+static constexpr int32_t kObjidWindow = 0;
+static constexpr int32_t kObjidClient = -4;
+static constexpr int32_t kObjidCaret = -8;
+static constexpr int32_t kObjidCursor = -9;
+
+static uint64_t SimNowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void Emit(std::vector<EventRecord>& out, uint32_t event, int32_t idObject, uint64_t hwnd)
+{
+    EventRecord e;
+    e.event = event;
+    e.idObject = idObject;
+    e.hwnd = hwnd;
+    out.push_back(e);
+}
+
+static bool Intersects(const WindowRect& a, const WindowRect& b)
+{
+    return RectsIntersect(a, b);
+}
+
+// Appends r minus c (at most four pieces) to out
+static void SubtractRect(const WindowRect& r, const WindowRect& c, std::vector<WindowRect>& out)
+{
+    if (!Intersects(r, c)) {
+        out.push_back(r);
+        return;
+    }
+    if (c.top > r.top) out.push_back({ r.left, r.top, r.right, c.top });
+    if (c.bottom < r.bottom) out.push_back({ r.left, c.bottom, r.right, r.bottom });
+    const int32_t top = std::max(r.top, c.top), bottom = std::min(r.bottom, c.bottom);
+    if (c.left > r.left) out.push_back({ r.left, top, c.left, bottom });
+    if (c.right < r.right) out.push_back({ c.right, top, r.right, bottom });
+}
+
+// Appends the part of a not covered by any rect of b to out
+static void SubtractArea(const std::vector<WindowRect>& a, const std::vector<WindowRect>& b, std::vector<WindowRect>& out)
+{
+    std::vector<WindowRect> pieces, next;
+    for (const WindowRect& r : a) {
+        pieces.assign(1, r);
+        for (const WindowRect& c : b) {
+            next.clear();
+            for (const WindowRect& f : pieces) SubtractRect(f, c, next);
+            pieces.swap(next);
+            if (pieces.empty()) break;
+        }
+        out.insert(out.end(), pieces.begin(), pieces.end());
+    }
+}
+
+// ---- SimDesktop ----
+
+const SimWindow* SimDesktop::Find(uint64_t hwnd) const
+{
+    auto it = m_windows.find(hwnd);
+    return it == m_windows.end() ? nullptr : &it->second;
+}
+
+uint64_t SimDesktop::Create(const WindowRect& rc, const std::wstring& process, const std::wstring& windowClass,
+                            const std::wstring& title, std::vector<EventRecord>& out)
+{
+    // HWND values are multiples of 4; hwnd + 2 stands for the window's child edit control
+    const uint64_t hwnd = m_nextHwnd;
+    m_nextHwnd += 4;
+
+    SimWindow& w = m_windows[hwnd];
+    w.hwnd = hwnd;
+    w.rect = rc;
+    w.process = process;
+    w.windowClass = windowClass;
+    w.title = title;
+    m_zorder.insert(m_zorder.begin(), hwnd);
+
+    Emit(out, kEventObjectShow, kObjidWindow, hwnd);
+    Emit(out, kEventObjectLocationChange, kObjidWindow, hwnd);
+    m_foreground = hwnd;
+    Emit(out, kEventSystemForeground, kObjidWindow, hwnd);
+    Emit(out, kEventObjectReorder, kObjidClient, kDesktop);
+    return hwnd;
+}
+
+void SimDesktop::Destroy(uint64_t hwnd, std::vector<EventRecord>& out)
+{
+    if (!m_windows.erase(hwnd)) return;
+    m_zorder.erase(std::find(m_zorder.begin(), m_zorder.end(), hwnd));
+    Emit(out, kEventObjectHide, kObjidWindow, hwnd);
+    Emit(out, kEventObjectDestroy, kObjidWindow, hwnd);
+    // The child control goes with it
+    Emit(out, kEventObjectDestroy, kObjidWindow, hwnd + 2);
+
+    if (m_foreground == hwnd) {
+        m_foreground = m_zorder.empty() ? 0 : m_zorder.front();
+        if (m_foreground) Emit(out, kEventSystemForeground, kObjidWindow, m_foreground);
+        Emit(out, kEventObjectReorder, kObjidClient, kDesktop);
+    }
+}
+
+void SimDesktop::MoveBy(uint64_t hwnd, int32_t dx, int32_t dy, std::vector<EventRecord>& out)
+{
+    auto it = m_windows.find(hwnd);
+    if (it == m_windows.end()) return;
+    WindowRect& r = it->second.rect;
+    r.left += dx; r.right += dx;
+    r.top += dy; r.bottom += dy;
+    Emit(out, kEventObjectLocationChange, kObjidWindow, hwnd);
+}
+
+void SimDesktop::MoveTo(uint64_t hwnd, const WindowRect& rc, std::vector<EventRecord>& out)
+{
+    auto it = m_windows.find(hwnd);
+    if (it == m_windows.end() || it->second.rect == rc) return;
+    it->second.rect = rc;
+    Emit(out, kEventObjectLocationChange, kObjidWindow, hwnd);
+}
+
+void SimDesktop::BeginMoveSize(uint64_t hwnd, std::vector<EventRecord>& out)
+{
+    if (m_windows.count(hwnd)) Emit(out, kEventSystemMoveSizeStart, kObjidWindow, hwnd);
+}
+
+void SimDesktop::EndMoveSize(uint64_t hwnd, std::vector<EventRecord>& out)
+{
+    if (m_windows.count(hwnd)) Emit(out, kEventSystemMoveSizeEnd, kObjidWindow, hwnd);
+}
+
+void SimDesktop::Activate(uint64_t hwnd, std::vector<EventRecord>& out)
+{
+    auto z = std::find(m_zorder.begin(), m_zorder.end(), hwnd);
+    if (z == m_zorder.end()) return;
+    std::rotate(m_zorder.begin(), z, z + 1);
+    m_foreground = hwnd;
+    Emit(out, kEventSystemForeground, kObjidWindow, hwnd);
+    Emit(out, kEventObjectReorder, kObjidClient, kDesktop);
+}
+
+void SimDesktop::SetTitle(uint64_t hwnd, const std::wstring& title, std::vector<EventRecord>& out)
+{
+    auto it = m_windows.find(hwnd);
+    if (it == m_windows.end()) return;
+    it->second.title = title;
+    Emit(out, kEventObjectNameChange, kObjidWindow, hwnd);
+}
+
+void SimDesktop::Minimize(uint64_t hwnd, bool minimized, std::vector<EventRecord>& out)
+{
+    auto it = m_windows.find(hwnd);
+    if (it == m_windows.end() || it->second.minimized == minimized) return;
+    it->second.minimized = minimized;
+    Emit(out, minimized ? kEventSystemMinimizeStart : kEventSystemMinimizeEnd, kObjidWindow, hwnd);
+}
+
+void SimDesktop::Cloak(uint64_t hwnd, bool cloaked, std::vector<EventRecord>& out)
+{
+    auto it = m_windows.find(hwnd);
+    if (it == m_windows.end() || it->second.cloaked == cloaked) return;
+    it->second.cloaked = cloaked;
+    Emit(out, cloaked ? kEventObjectCloaked : kEventObjectUncloaked, kObjidWindow, hwnd);
+}
+
+void SimDesktop::Type(uint64_t hwnd, std::vector<EventRecord>& out)
+{
+    const uint64_t edit = hwnd + 2;
+    Emit(out, kEventObjectValueChange, kObjidClient, edit);
+    Emit(out, kEventObjectLocationChange, kObjidCaret, edit);
+    Emit(out, kEventObjectNameChange, kObjidClient, edit);
+    Emit(out, kEventObjectLocationChange, kObjidCursor, 0);
+}
+
+// ---- SimService ----
+
+SimService::SimService(SimDesktop& desktop, size_t queueCapacity)
+    : m_desktop(desktop), m_queue(queueCapacity)
+{
+}
+
+bool SimService::Offer(const EventRecord& e)
+{
+    const uint64_t t0 = SimNowNs();
+    bool queued = false;
+    // Suspended, WinEventProc drops what the hooks still report but DESTROY and MOVESIZEEND
+    const bool suspendedDrop = m_suspended && e.event != kEventRefreshRequest && e.event != kEventObjectDestroy &&
+                               e.event != kEventSystemMoveSizeEnd;
+    if (!suspendedDrop && (e.event == kEventRefreshRequest || PreFilterEvent(e.event, e.idObject, e.hwnd))) {
+        queued = m_queue.TryPush(e);
+        if (!queued) {
+            m_overflowed = true;
+            ++m_dropped;
+        }
+    }
+    m_stages.intake += SimNowNs() - t0;
+    return queued;
+}
+
+void SimService::SetSuspended(bool suspended)
+{
+    if (suspended == m_suspended) return;
+    m_suspended = suspended;
+    if (!suspended) ++m_resumes;
+    EventRecord refresh;
+    refresh.event = kEventRefreshRequest;
+    Offer(refresh);
+}
+
+void SimService::ApplySettings(const BorderStyle& style, bool foregroundOnly)
+{
+    m_style = style;
+    m_foregroundOnly = foregroundOnly;
+    ++m_settingsGeneration;
+}
+
+void SimService::ApplyRules(const std::wstring& text)
+{
+    m_rules.Compile(ParseStyleRules(text));
+    ++m_settingsGeneration;
+}
+
+bool SimService::Query(uint64_t hwnd, WindowFact fact)
+{
+    const SimWindow* w = m_desktop.Find(hwnd);
+    switch (fact) {
+    case WindowFact::Desktop: return hwnd == SimDesktop::kDesktop;
+    case WindowFact::TopLevel: return w != nullptr || hwnd == SimDesktop::kDesktop;
+    case WindowFact::Tracked: return m_windows.Find(hwnd) != WindowRegistry::kNoSlot;
+    case WindowFact::Trackable: return w && w->trackable && !IsCloaked(*w);
+    }
+    return false;
+}
+
+bool SimService::IsCloaked(const SimWindow& w)
+{
+    bool cloaked = false;
+    if (m_cloaks.Find(w.hwnd, cloaked)) {
+        MetricAdd(Metric::CloakCacheHits);
+        return cloaked;
+    }
+    MetricAdd(Metric::CloakQueries);
+    m_cloaks.Note(w.hwnd, w.cloaked);
+    return w.cloaked;
+}
+
+uint64_t SimService::NowNs() const
+{
+    return m_clocked ? m_clockNs : SimNowNs();
+}
+
+BorderStyle SimService::Resolve(const SimWindow& w, int32_t& rule) const
+{
+    rule = m_rules.Empty() ? CompiledStyleRules::kNoMatch : m_rules.Match(w.process, w.windowClass, w.title);
+    return rule == CompiledStyleRules::kNoMatch ? m_style : m_rules.Rule(rule).Apply(m_style);
+}
+
+bool SimService::Reevaluate(uint64_t hwnd)
+{
+    // ReevaluateWindowStyle: only title patterns can change the outcome of a rename
+    if (!m_rules.HasTitlePatterns()) return false;
+    const WindowRegistry::Slot s = m_windows.Find(hwnd);
+    const SimWindow* w = m_desktop.Find(hwnd);
+    if (s == WindowRegistry::kNoSlot || !w) return false;
+    int32_t rule;
+    Resolve(*w, rule);
+    if (rule == m_styleRule[s] && m_styleGeneration[s] == m_settingsGeneration) return false;
+    m_styleGeneration[s] = 0; // re-resolved on the next refresh
+    return true;
+}
+
+bool SimService::RunFrame()
+{
+    const uint64_t t0 = SimNowNs();
+    // Everything the frame allocates from the arena is released when it ends
+    FrameScope frame(m_arena);
+    const bool redrawn = HandleBatch();
+
+    // The Pipeline.cpp idle check, with the scratch below standing in for the surface
+    const bool wasReleased = m_idle.IsReleased();
+    if (m_idle.Frame(m_windows.Size(), NowNs(), SimNowNs() - t0)) {
+        ReleaseIdle();
+    } else if (wasReleased && !m_idle.IsReleased()) {
+        MetricAdd(Metric::IdleRehydrations);
+        MetricSet(Metric::IdleRehydrateUs, static_cast<int64_t>(m_idle.LastRehydrateNs() / 1000));
+        MetricSet(Metric::IdleOverBudget, static_cast<int64_t>(m_idle.OverBudget()));
+    }
+    m_lastFrameAllocations = frame.HeapAllocations();
+    return redrawn;
+}
+
+// Frees instead of clearing: the vectors are only needed again when something is drawn
+template <typename T>
+static void FreeVector(std::vector<T>& v)
+{
+    std::vector<T>().swap(v);
+}
+
+static void FreeColumns(RectColumns& c)
+{
+    FreeVector(c.left);
+    FreeVector(c.top);
+    FreeVector(c.right);
+    FreeVector(c.bottom);
+}
+
+void SimService::ReleaseIdle()
+{
+    const size_t before = MemoryBytes();
+    FreeVector(m_covered);
+    FreeVector(m_fragments);
+    FreeVector(m_next);
+    FreeVector(m_region);
+    FreeVector(m_primitives);
+    FreeColumns(m_geom);
+    FreeColumns(m_clipped);
+    FreeColumns(m_outer);
+    for (RectColumns& band : m_bands) FreeColumns(band);
+    FreeVector(m_geomF.left);
+    FreeVector(m_geomF.top);
+    FreeVector(m_geomF.right);
+    FreeVector(m_geomF.bottom);
+    FreeVector(m_thickness);
+    FreeVector(m_extent);
+    FreeVector(m_mask);
+    if (m_effectCompositor) m_effects.Reset(*m_effectCompositor);
+    m_arena.ReleaseOnReset();
+    m_idle.Released();
+
+    MetricAdd(Metric::IdleReleases);
+    MetricSet(Metric::IdlePrivateKbActive, static_cast<int64_t>(before / 1024));
+    // The arena's blocks go when the frame ends
+    MetricSet(Metric::IdlePrivateKbIdle, static_cast<int64_t>((MemoryBytes() - m_arena.Reserved()) / 1024));
+}
+
+bool SimService::HandleBatch()
+{
+    const uint64_t t0 = SimNowNs();
+    bool explicitRefresh = m_overflowed;
+    bool fromEvents = false;
+    bool sessionMoved = false;
+    // Lost events may include the session's end, a cloak change or a burst's last events
+    if (m_overflowed) {
+        if (m_session.Active()) m_session.End(SimNowNs());
+        m_cloaks.Clear();
+        m_burst.Reset();
+    }
+    // So may a suspension
+    if (m_resumes != m_resumesSeen) {
+        m_resumesSeen = m_resumes;
+        m_cloaks.Clear();
+    }
+    const bool overflowed = m_overflowed;
+    m_overflowed = false;
+    m_sessionFrame = false;
+
+    EventRecord e;
+    while (m_queue.TryPop(e)) {
+        if (e.event == kEventObjectDestroy) {
+            m_cloaks.Forget(e.hwnd);
+        } else if ((e.event == kEventObjectCloaked || e.event == kEventObjectUncloaked) && e.idObject == kObjidWindow) {
+            m_cloaks.Note(e.hwnd, e.event == kEventObjectCloaked);
+        }
+        const WindowChange change = ClassifyEvent(e, *this);
+        if (m_burstsEnabled && change != WindowChange::None && IsTransitionEvent(e.event)) m_burst.Note(e.hwnd, NowNs());
+        switch (change) {
+        case WindowChange::None:
+            break;
+        case WindowChange::Refresh:
+            explicitRefresh = true;
+            break;
+        case WindowChange::MoveSizeStart:
+            // A session whose END never came is reconciled now
+            if (m_session.Begin(e.hwnd, SimNowNs())) fromEvents = true;
+            break;
+        case WindowChange::MoveSizeEnd:
+            if (m_session.Owns(e.hwnd)) {
+                m_session.End(SimNowNs());
+                fromEvents = true;
+            }
+            break;
+        case WindowChange::Destroyed: {
+            const WindowRegistry::Slot s = m_windows.Find(e.hwnd);
+            if (s != WindowRegistry::kNoSlot) {
+                m_styleGeneration[s] = 0;
+                m_windows.Release(s);
+            }
+            if (m_session.Owns(e.hwnd)) m_session.End(SimNowNs());
+            fromEvents = true;
+            break;
+        }
+        case WindowChange::Renamed:
+            if (Reevaluate(e.hwnd)) fromEvents = true;
+            break;
+        case WindowChange::Moved:
+            if (m_session.Owns(e.hwnd)) {
+                sessionMoved = true;
+                break;
+            }
+            [[fallthrough]];
+        default:
+            if (change == WindowChange::Hidden && m_session.Owns(e.hwnd)) m_session.End(SimNowNs());
+            if (m_session.Active()) {
+                m_session.Defer();
+                break;
+            }
+            fromEvents = true;
+            break;
+        }
+    }
+    m_stages.classify += SimNowNs() - t0;
+
+    // A timer or IPC refresh during a drag waits for the reconcile at session end
+    if (explicitRefresh && !overflowed && m_session.Active()) {
+        m_session.Defer();
+        explicitRefresh = false;
+    }
+
+    // Nothing is drawn while suspended; the resume refresh reconciles
+    if (m_suspended) {
+        if (m_session.Active()) m_session.End(SimNowNs());
+        m_burst.Reset();
+        return false;
+    }
+
+    // Mass transition: held until it settles, then one refresh re-reads every window
+    bool settled = false;
+    if (m_burst.Active()) {
+        settled = m_burst.Settle(NowNs());
+        explicitRefresh = false;
+        fromEvents = settled;
+    }
+    if (settled) {
+        MetricAdd(Metric::BurstCount);
+        MetricSet(Metric::BurstLastEvents, static_cast<int64_t>(m_burst.LastEvents()));
+        MetricSet(Metric::BurstLastWindows, static_cast<int64_t>(m_burst.LastWindows()));
+        MetricSet(Metric::BurstMaxEvents, static_cast<int64_t>(m_burst.MaxEvents()));
+        MetricSet(Metric::BurstSettleUs, static_cast<int64_t>((NowNs() - m_burst.LastStartNs()) / 1000));
+    }
+
+    if (explicitRefresh || fromEvents) {
+        Refresh();
+    } else if (!sessionMoved || !RefreshWindow(m_session.Window())) {
+        return false;
+    }
+    if (m_session.Active()) m_session.RecordFrame(SimNowNs() - t0);
+    ++m_redraws;
+    return true;
+}
+
+void SimService::Refresh()
+{
+    // CollectUserVisibleWindows
+    uint64_t t0 = SimNowNs();
+    ArenaVector<uint64_t> visible{ ArenaAllocator<uint64_t>(m_arena) };
+    ArenaVector<uint64_t> candidates{ ArenaAllocator<uint64_t>(m_arena) };
+    candidates.reserve(m_desktop.ZOrder().size());
+    m_geom.Clear();
+    const uint64_t foreground = m_desktop.Foreground();
+    for (uint64_t h : m_desktop.ZOrder()) {
+        const SimWindow* w = m_desktop.Find(h);
+        if (!w->visible || w->minimized || !w->trackable || IsCloaked(*w)) continue;
+        if (m_foregroundOnly && h != foreground) continue;
+        candidates.push_back(h);
+        m_geom.Push(w->rect);
+    }
+    // Virtual-screen intersection for every candidate at once
+    m_mask.resize(candidates.size());
+    ClipRects(m_geom, m_desktop.Screen(), m_clipped, m_mask.data());
+    visible.reserve(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (m_mask[i]) visible.push_back(candidates[i]);
+    }
+    uint64_t t1 = SimNowNs();
+    m_stages.enumerate += t1 - t0;
+
+    // RefreshOverlay's frame pass
+    m_windows.BeginPass();
+    for (uint64_t h : visible) {
+        const WindowRegistry::Slot s = m_windows.Acquire(h);
+        m_windows.Visit(s);
+        m_windows.Rect(s) = m_desktop.Find(h)->rect;
+    }
+    if (m_styleGeneration.size() < m_windows.SlotCount()) {
+        m_styleGeneration.resize(m_windows.SlotCount(), 0);
+        m_styleRule.resize(m_windows.SlotCount(), CompiledStyleRules::kNoMatch);
+    }
+    m_windows.SweepUnvisited([this](WindowRegistry::Slot s) { m_styleGeneration[s] = 0; });
+    t0 = SimNowNs();
+    m_stages.registry += t0 - t1;
+
+    // ResolveWindowStyle: rule match cached per window until settings or rules change
+    for (WindowRegistry::Slot s : m_windows.Order()) {
+        if (m_styleGeneration[s] == m_settingsGeneration) continue;
+        m_windows.Style(s) = Resolve(*m_desktop.Find(m_windows.Handle(s)), m_styleRule[s]);
+        m_styleGeneration[s] = m_settingsGeneration;
+    }
+    t1 = SimNowNs();
+    m_stages.style += t1 - t0;
+
+    if (m_regionMode) BuildRegion();
+    t0 = SimNowNs();
+    m_stages.region += t0 - t1;
+
+    UpdateEffect();
+    BuildPrimitives();
+    m_stages.draw += SimNowNs() - t0;
+}
+
+bool SimService::RefreshWindow(uint64_t hwnd)
+{
+    // RefreshOverlayWindow: one window's bounds, region from the registry, damage-only draw
+    uint64_t t0 = SimNowNs();
+    const WindowRegistry::Slot s = m_windows.Find(hwnd);
+    const SimWindow* w = m_desktop.Find(hwnd);
+    if (s == WindowRegistry::kNoSlot || !w) return false;
+    if (w->rect == m_windows.Rect(s)) return false;
+    const WindowRect damage = MoveSizeDamage(m_windows.Rect(s), w->rect, m_windows.Style(s).thickness);
+    m_windows.Rect(s) = w->rect;
+    uint64_t t1 = SimNowNs();
+    m_stages.registry += t1 - t0;
+
+    // A window handed to or from the effect visual is drawn or cleared outside the damage
+    const uint64_t effectBefore = m_effects.Target();
+    UpdateEffect();
+    const WindowRect* clip = m_effects.Target() == effectBefore ? &damage : nullptr;
+    m_sessionFrame = clip != nullptr;
+    m_sessionDamage = damage;
+
+    if (m_regionMode) BuildRegion(clip);
+    t0 = SimNowNs();
+    m_stages.region += t0 - t1;
+
+    BuildPrimitives(clip);
+    m_stages.draw += SimNowNs() - t0;
+    return true;
+}
+
+bool SimService::VerifySessionFrame(const std::vector<WindowRect>& before)
+{
+    if (!m_sessionFrame || !m_regionMode) return true;
+    // Full rebuild from the same registry state, then the incremental region back in place
+    // (copied, so the frame's vectors keep their capacity)
+    const std::vector<WindowRect> incremental = m_region;
+    BuildRegion();
+    const std::vector<WindowRect> full = m_region;
+    m_region.assign(incremental.begin(), incremental.end());
+
+    std::vector<WindowRect> diff, outside;
+    SubtractArea(m_region, full, diff);
+    SubtractArea(full, m_region, diff);
+    if (!diff.empty()) return false;
+    // The damage covers everything the frame changed
+    SubtractArea(before, full, diff);
+    SubtractArea(full, before, diff);
+    SubtractArea(diff, { m_sessionDamage }, outside);
+    return outside.empty();
+}
+
+void SimService::UpdateEffect()
+{
+    // UpdateBorderEffect: the foreground window; without a region, only while nothing covers it
+    if (!m_effectCompositor || (!m_effects.Enabled() && m_effects.Target() == 0)) return;
+    WindowRegistry::Slot s = m_effects.Enabled() ? m_windows.Find(m_desktop.Foreground()) : WindowRegistry::kNoSlot;
+    if (s != WindowRegistry::kNoSlot && !m_regionMode) {
+        const WindowRect& r = m_windows.Rect(s);
+        const WindowRect outer = MoveSizeDamage(r, r, m_windows.Style(s).thickness);
+        for (WindowRegistry::Slot above : m_windows.Order()) {
+            if (above == s) break;
+            const WindowRect& a = m_windows.Rect(above);
+            if (Intersects(MoveSizeDamage(a, a, m_windows.Style(above).thickness), outer)) {
+                s = WindowRegistry::kNoSlot;
+                break;
+            }
+        }
+    }
+    if (s == WindowRegistry::kNoSlot) {
+        m_effects.Update(0, WindowRect{}, BorderStyle{}, *m_effectCompositor);
+    } else {
+        const WindowRect& screen = m_desktop.Screen();
+        const WindowRect& r = m_windows.Rect(s);
+        const WindowRect local{ r.left - screen.left, r.top - screen.top, r.right - screen.left, r.bottom - screen.top };
+        m_effects.Update(m_windows.Handle(s), local, m_windows.Style(s), *m_effectCompositor);
+    }
+    MetricSet(Metric::EffectRetargets, static_cast<int64_t>(m_effects.Retargets()));
+    MetricSet(Metric::EffectDraws, static_cast<int64_t>(m_effects.Draws()));
+    MetricSet(Metric::EffectAnimations, static_cast<int64_t>(m_effects.Animations()));
+}
+
+void SimService::BuildRegion(const WindowRect* damage)
+{
+    // UpdateOverlayRegion: each window's four border bands minus everything above it. With
+    // damage, the region outside it is kept and only windows reaching into it take part.
+    if (damage) {
+        m_next.clear();
+        for (const WindowRect& f : m_region) SubtractRect(f, *damage, m_next);
+        m_region.swap(m_next);
+    } else {
+        m_region.clear();
+    }
+    m_covered.clear();
+
+    // Stroke extents, occluder rects and bands for the whole pass (RectKernels.h)
+    const std::vector<WindowRegistry::Slot>& order = m_windows.Order();
+    const size_t n = order.size();
+    m_geom.Clear();
+    m_thickness.clear();
+    for (WindowRegistry::Slot s : order) {
+        m_geom.Push(m_windows.Rect(s));
+        m_thickness.push_back(m_windows.Style(s).thickness);
+    }
+    m_extent.resize(n);
+    StrokeExtents(m_thickness.data(), n, m_extent.data());
+    ExpandRects(m_geom, m_extent.data(), m_outer);
+    BorderBands(m_geom, m_extent.data(), m_bands);
+    m_mask.assign(n * kBandCount, 1);
+    if (damage) {
+        for (size_t k = 0; k < kBandCount; ++k) ClipRects(m_bands[k], *damage, m_bands[k], m_mask.data() + k * n);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const WindowRect outer = m_outer.Get(i);
+        if (damage && !Intersects(outer, *damage)) continue;
+        for (size_t k = 0; k < kBandCount; ++k) {
+            if (!m_mask[k * n + i]) continue;
+            m_fragments.assign(1, m_bands[k].Get(i));
+            for (const WindowRect& c : m_covered) {
+                m_next.clear();
+                for (const WindowRect& f : m_fragments) SubtractRect(f, c, m_next);
+                m_fragments.swap(m_next);
+                if (m_fragments.empty()) break;
+            }
+            m_region.insert(m_region.end(), m_fragments.begin(), m_fragments.end());
+        }
+        m_covered.push_back(outer);
+    }
+}
+
+void SimService::BuildPrimitives(const WindowRect* damage)
+{
+    // DrawBorders: one stroked (rounded) rectangle per window, in z-order; a session frame
+    // draws only the windows whose border touches the damage. Without a region the pass
+    // runs bottom-up and clears each window's occluder first.
+    m_primitives.clear();
+    const WindowRect& screen = m_desktop.Screen();
+    const std::vector<WindowRegistry::Slot>& order = m_windows.Order();
+    const size_t n = order.size();
+    const bool painter = !m_regionMode;
+    m_geom.Clear();
+    for (WindowRegistry::Slot s : order) m_geom.Push(m_windows.Rect(s));
+    TranslateRects(m_geom, -screen.left, -screen.top, m_clipped);
+    RectsToFloat(m_clipped, m_geomF);
+    if (painter) {
+        m_thickness.clear();
+        for (WindowRegistry::Slot s : order) m_thickness.push_back(m_windows.Style(s).thickness);
+        m_extent.resize(n);
+        StrokeExtents(m_thickness.data(), n, m_extent.data());
+        ExpandRects(m_clipped, m_extent.data(), m_outer);
+    }
+    for (size_t k = 0; k < n; ++k) {
+        const size_t i = painter ? n - 1 - k : k;
+        const WindowRect& r = m_windows.Rect(order[i]);
+        const BorderStyle& style = m_windows.Style(order[i]);
+        const bool effect = m_windows.Handle(order[i]) == m_effects.Target();
+        if (painter) {
+            const WindowRect o = m_outer.Get(i);
+            const WindowRect screenOuter{ o.left + screen.left, o.top + screen.top, o.right + screen.left, o.bottom + screen.top };
+            if (!damage || Intersects(screenOuter, *damage)) {
+                m_primitives.push_back({ static_cast<float>(o.left), static_cast<float>(o.top), static_cast<float>(o.right),
+                                         static_cast<float>(o.bottom), 0.0f, 0.0f, ColorF{ 0, 0, 0, 0 }, true });
+            }
+        }
+        // The effect visual carries this one
+        if (effect || (damage && !Intersects(MoveSizeDamage(r, r, style.thickness), *damage))) continue;
+        m_primitives.push_back({ m_geomF.left[i], m_geomF.top[i], m_geomF.right[i], m_geomF.bottom[i],
+                                 CornerRadius(style.corner), style.thickness, style.color, false });
+    }
+}
+
+size_t SimService::MemoryBytes() const
+{
+    return m_windows.MemoryBytes() +
+           m_queue.Capacity() * (sizeof(EventRecord) + sizeof(size_t)) +
+           (m_styleGeneration.capacity() + m_styleRule.capacity()) * sizeof(uint32_t) +
+           m_arena.Reserved() +
+           (m_covered.capacity() + m_fragments.capacity() + m_next.capacity() + m_region.capacity()) * sizeof(WindowRect) +
+           m_primitives.capacity() * sizeof(Primitive) +
+           (m_geom.left.capacity() + m_clipped.left.capacity() + m_outer.left.capacity() +
+            kBandCount * m_bands[0].left.capacity()) * 4 * sizeof(int32_t) +
+           m_geomF.left.capacity() * 4 * sizeof(float) + m_thickness.capacity() * sizeof(float) +
+           m_extent.capacity() * sizeof(int32_t) + m_mask.capacity();
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include "BorderEffects.h"
+#include "CloakCache.h"
+#include "EventClassifier.h"
+#include "EventQueue.h"
+#include "FrameArena.h"
+#include "IdleResources.h"
+#include "MoveSizeSession.h"
+#include "RectKernels.h"
+#include "StyleRules.h"
+#include "TransitionBurst.h"
+#include "WindowRegistry.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Simulated window backend for the end-to-end scenarios (--bench idle / drag / cascade /
+// alttab / foreground / settings / desktop / minimize / suspend). SimDesktop plays the
+// window manager and reports the WinEvents Windows would; SimService runs them through the
+// same portable stages as the service (pre-filter, queue, classify, registry pass, style
+// rules) and replaces the GDI region and D2D draw with portable code doing the same
+// per-window work. Headless.
+
+struct SimWindow {
+    uint64_t hwnd = 0;
+    WindowRect rect;
+    bool visible = true;
+    bool minimized = false;
+    bool cloaked = false;       // on another virtual desktop
+    bool trackable = true;      // alt-tab eligible and not excluded
+    std::wstring process;       // lower-cased, as StyleRules expects
+    std::wstring windowClass;
+    std::wstring title;
+};
+
+class SimDesktop {
+public:
+    static constexpr uint64_t kDesktop = 0x10;
+
+    explicit SimDesktop(const WindowRect& screen) : m_screen(screen) {}
+
+    const WindowRect& Screen() const { return m_screen; }
+    const SimWindow* Find(uint64_t hwnd) const;
+    // Top-level windows, topmost first
+    const std::vector<uint64_t>& ZOrder() const { return m_zorder; }
+    uint64_t Foreground() const { return m_foreground; }
+
+    // Each mutation appends the WinEvents Windows reports for it
+    uint64_t Create(const WindowRect& rc, const std::wstring& process, const std::wstring& windowClass,
+                    const std::wstring& title, std::vector<EventRecord>& out);
+    void Destroy(uint64_t hwnd, std::vector<EventRecord>& out);
+    void MoveBy(uint64_t hwnd, int32_t dx, int32_t dy, std::vector<EventRecord>& out);
+    // Move and/or resize; nothing is reported if the bounds are unchanged
+    void MoveTo(uint64_t hwnd, const WindowRect& rc, std::vector<EventRecord>& out);
+    // Mouse down / up on the title bar
+    void BeginMoveSize(uint64_t hwnd, std::vector<EventRecord>& out);
+    void EndMoveSize(uint64_t hwnd, std::vector<EventRecord>& out);
+    void Activate(uint64_t hwnd, std::vector<EventRecord>& out);
+    void SetTitle(uint64_t hwnd, const std::wstring& title, std::vector<EventRecord>& out);
+    // Minimize / restore (Win+D, Win+Shift+M); nothing is reported if unchanged
+    void Minimize(uint64_t hwnd, bool minimized, std::vector<EventRecord>& out);
+    // Virtual-desktop switch, one window at a time; nothing is reported if unchanged
+    void Cloak(uint64_t hwnd, bool cloaked, std::vector<EventRecord>& out);
+    // Keystroke in a child edit control: caret, value and scroll noise
+    void Type(uint64_t hwnd, std::vector<EventRecord>& out);
+
+private:
+    WindowRect m_screen;
+    std::unordered_map<uint64_t, SimWindow> m_windows;
+    std::vector<uint64_t> m_zorder;
+    uint64_t m_foreground = 0;
+    uint64_t m_nextHwnd = 0x1000;
+};
+
+// Cumulative wall time per render stage
+struct SimStageNs {
+    uint64_t intake = 0;    // PreFilterEvent + queue push (intake thread)
+    uint64_t classify = 0;  // queue drain + ClassifyEvent (HandleBatch)
+    uint64_t enumerate = 0; // CollectUserVisibleWindows
+    uint64_t registry = 0;  // registry frame pass + sweep
+    uint64_t style = 0;     // ResolveWindowStyle
+    uint64_t region = 0;    // UpdateOverlayRegion
+    uint64_t draw = 0;      // DrawBorders
+};
+
+class SimService : private WindowFactSource {
+public:
+    explicit SimService(SimDesktop& desktop, size_t queueCapacity = 1024);
+
+    // Intake stand-in: stage-1 filter and push. False when filtered or dropped.
+    bool Offer(const EventRecord& e);
+    // SET / RULES stand-ins: start a new settings generation; the caller offers the
+    // refresh request (kEventRefreshRequest) like the IPC handler does
+    void ApplySettings(const BorderStyle& style, bool foregroundOnly);
+    void ApplyRules(const std::wstring& text);
+    // Burst detection (TransitionBurst.h) on / off, and the clock it runs on: simulated
+    // time once SetClock was called, the steady clock before
+    void EnableBursts(bool enable) { m_burstsEnabled = enable; }
+    void SetClock(uint64_t nowNs)
+    {
+        m_clockNs = nowNs;
+        m_clocked = true;
+    }
+    // PowerMonitor stand-in: suspended, the intake drops every WinEvent but DESTROY and
+    // MOVESIZEEND (Tray.cpp) and nothing is drawn; each change offers a refresh request
+    void SetSuspended(bool suspended);
+    // Idle release (IdleResources.h): the per-frame scratch and the arena's blocks go back
+    void SetIdleOptions(const IdleOptions& options) { m_idle.SetOptions(options); }
+    const IdleReclaimer& Idle() const { return m_idle; }
+    // --region off: no region is built and DrawBorders paints bottom-up, clearing each
+    // window's occluder before its border
+    void SetRegionMode(bool region) { m_regionMode = region; }
+    // Focused-window effect (BorderEffects.h) on the given compositor; nullptr turns it off
+    void SetEffect(const BorderEffect& effect, EffectCompositor* compositor)
+    {
+        m_effects.SetEffect(compositor ? effect : BorderEffect());
+        if (!compositor && m_effectCompositor) m_effects.Reset(*m_effectCompositor);
+        m_effectCompositor = compositor;
+    }
+    const BorderEffectController& Effects() const { return m_effects; }
+
+    // Render-thread stand-in: drain the queue through HandleBatch's logic. True if redrawn.
+    bool RunFrame();
+    // Heap allocations made by the last RunFrame (0 in steady state)
+    uint64_t LastFrameAllocations() const { return m_lastFrameAllocations; }
+    const FrameArena& Arena() const { return m_arena; }
+
+    const SimStageNs& Stages() const { return m_stages; }
+    const WindowRegistry& Windows() const { return m_windows; }
+    size_t RegionRects() const { return m_region.size(); }
+    const std::vector<WindowRect>& Region() const { return m_region; }
+    // The last RunFrame was a move/size session frame, drawn within its damage only
+    bool LastFrameWasSession() const { return m_sessionFrame; }
+    // After a session frame: its incrementally updated region must equal a full rebuild and
+    // differ from `before` (Region() ahead of the frame) only inside the frame's damage.
+    // True for any other frame.
+    bool VerifySessionFrame(const std::vector<WindowRect>& before);
+    // Clears + strokes of the last draw
+    size_t PrimitiveCount() const { return m_primitives.size(); }
+    uint64_t Redraws() const { return m_redraws; }
+    uint64_t Dropped() const { return m_dropped; }
+    // Registry, queue and per-frame scratch the render thread keeps alive
+    size_t MemoryBytes() const;
+
+private:
+    struct Primitive {
+        float left, top, right, bottom, radius, thickness;
+        ColorF color;
+        bool clear; // fill with transparent instead of stroking
+    };
+
+    bool Query(uint64_t hwnd, WindowFact fact) override;
+    // IsWindowCloaked: the cache, else the desktop's state (noted for next time)
+    bool IsCloaked(const SimWindow& w);
+    uint64_t NowNs() const;
+    void ReleaseIdle();
+    bool HandleBatch();
+    void Refresh();
+    // Move/size session frame: only the moving window is re-read and redrawn
+    bool RefreshWindow(uint64_t hwnd);
+    BorderStyle Resolve(const SimWindow& w, int32_t& rule) const;
+    bool Reevaluate(uint64_t hwnd);
+    void UpdateEffect();
+    void BuildRegion(const WindowRect* damage = nullptr);
+    void BuildPrimitives(const WindowRect* damage = nullptr);
+
+    SimDesktop& m_desktop;
+    BoundedMpscQueue<EventRecord> m_queue;
+    bool m_overflowed = false;
+    uint64_t m_dropped = 0;
+
+    BorderStyle m_style;
+    bool m_foregroundOnly = false;
+    CompiledStyleRules m_rules;
+    uint32_t m_settingsGeneration = 1;
+    MoveSizeSession m_session;
+    bool m_sessionFrame = false;
+    WindowRect m_sessionDamage;
+    BurstDetector m_burst;
+    bool m_burstsEnabled = true;
+    CloakCache m_cloaks;
+    bool m_suspended = false;
+    uint32_t m_resumes = 0, m_resumesSeen = 0;
+    bool m_regionMode = true;
+    BorderEffectController m_effects;
+    EffectCompositor* m_effectCompositor = nullptr;
+    IdleReclaimer m_idle;
+    bool m_clocked = false;
+    uint64_t m_clockNs = 0;
+
+    WindowRegistry m_windows;
+    std::vector<uint32_t> m_styleGeneration; // per slot: settings generation of Style()
+    std::vector<int32_t> m_styleRule;        // per slot: matched rule index
+    std::vector<WindowRect> m_covered, m_fragments, m_next, m_region;
+    std::vector<Primitive> m_primitives;
+    // Transient per-frame lists (HandleBatch's FrameScope); reset after every RunFrame
+    FrameArena m_arena;
+    // Batch geometry scratch (RectKernels.h): one entry per candidate / ordered window
+    RectColumns m_geom, m_clipped, m_outer, m_bands[kBandCount];
+    RectColumnsF m_geomF;
+    std::vector<float> m_thickness;
+    std::vector<int32_t> m_extent;
+    std::vector<uint8_t> m_mask;
+
+    SimStageNs m_stages;
+    uint64_t m_redraws = 0;
+    uint64_t m_lastFrameAllocations = 0;
+};
@@ -0,0 +1,80 @@
+#include "StartupSnapshot.h"
+#include <cwchar>
+
+static const wchar_t kHeader[] = L"CustomWindowSnapshot 1";
+
+// Values are single-line; embedded line breaks would split the record
+static std::wstring OneLine(const std::wstring& s)
+{
+    std::wstring out(s);
+    for (auto& c : out) {
+        if (c == L'\r' || c == L'\n') c = L'|';
+    }
+    return out;
+}
+
+std::wstring SerializeStartupSnapshot(const StartupSnapshot& s)
+{
+    std::wstring out = kHeader;
+    out += L"\n";
+    auto put = [&out](const wchar_t* key, const std::wstring& value) {
+        out += key;
+        out += L"=";
+        out += OneLine(value);
+        out += L"\n";
+    };
+    put(L"mode", s.mode);
+    put(L"color", s.color);
+    put(L"thickness", std::to_wstring(s.thickness));
+    put(L"corner", s.corner);
+    put(L"foregroundonly", s.foregroundOnly ? L"1" : L"0");
+    put(L"effect", s.effect);
+    put(L"powerpolicy", s.powerPolicy ? L"1" : L"0");
+    put(L"exclude", s.exclusions);
+    put(L"rules", s.rules);
+    return out;
+}
+
+bool ParseStartupSnapshot(const std::wstring& text, StartupSnapshot& out)
+{
+    size_t pos = text.find_first_of(L"\r\n");
+    std::wstring header = text.substr(0, pos);
+    if (header != kHeader) return false;
+
+    StartupSnapshot s;
+    while (pos != std::wstring::npos && pos < text.size()) {
+        size_t start = text.find_first_not_of(L"\r\n", pos);
+        if (start == std::wstring::npos) break;
+        pos = text.find_first_of(L"\r\n", start);
+        std::wstring line = text.substr(start, pos == std::wstring::npos ? std::wstring::npos : pos - start);
+
+        size_t eq = line.find(L'=');
+        if (eq == std::wstring::npos) continue;
+        std::wstring key = line.substr(0, eq);
+        std::wstring value = line.substr(eq + 1);
+
+        if (key == L"mode") {
+            if (value == L"auto" || value == L"dwm" || value == L"dcomp" || value == L"hybrid") s.mode = value;
+        } else if (key == L"color") {
+            if (!value.empty() && value[0] == L'#') s.color = value;
+        } else if (key == L"thickness") {
+            wchar_t* end = nullptr;
+            float t = std::wcstof(value.c_str(), &end);
+            if (end != value.c_str() && t > 0 && t < 1000) s.thickness = t;
+        } else if (key == L"corner") {
+            s.corner = value;
+        } else if (key == L"foregroundonly") {
+            s.foregroundOnly = (value == L"1");
+        } else if (key == L"effect") {
+            s.effect = value;
+        } else if (key == L"powerpolicy") {
+            s.powerPolicy = (value != L"0");
+        } else if (key == L"exclude") {
+            s.exclusions = value;
+        } else if (key == L"rules") {
+            s.rules = value;
+        }
+    }
+    out = s;
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+
+// Last-known settings persisted by the service so a --faststart launch can paint its
+// first frame without waiting for the GUI's IPC. Portable: FastStart.cpp handles the file.
+
+struct StartupSnapshot {
+    std::wstring mode = L"auto";      // auto | dwm | dcomp | hybrid
+    std::wstring color = L"#FF00CCFF"; // #AARRGGBB
+    float thickness = 5.0f;
+    std::wstring corner = L"default";
+    bool foregroundOnly = false;
+    std::wstring effect = L"none";    // none | pulse | fade, optionally ":<ms>"
+    bool powerPolicy = true;
+    std::wstring exclusions;          // "a|b" (same as --exclude)
+    std::wstring rules;               // rule lines joined with '|' (same as RULES)
+};
+
+// "CustomWindowSnapshot 1" header followed by key=value lines.
+std::wstring SerializeStartupSnapshot(const StartupSnapshot& s);
+
+// Returns false for a missing/unknown header or version. Unknown keys are ignored and
+// malformed values keep their defaults, so older snapshots still load.
+bool ParseStartupSnapshot(const std::wstring& text, StartupSnapshot& out);
@@ -0,0 +1,287 @@
+#include "StyleRules.h"
+#include "ProcessExclusion.h"
+#include <algorithm>
+#include <cwctype>
+#include <deque>
+
+bool operator==(const BorderStyle& a, const BorderStyle& b)
+{
+    return a.color.r == b.color.r && a.color.g == b.color.g && a.color.b == b.color.b && a.color.a == b.color.a &&
+           a.thickness == b.thickness && a.corner == b.corner;
+}
+
+bool ParseHexColor(const std::wstring& hex, ColorF& out)
+{
+    std::wstring h = hex;
+    if (!h.empty() && h[0] == L'#') h.erase(h.begin());
+    if (h.size() != 6 && h.size() != 8) return false;
+    unsigned long val = 0;
+    for (wchar_t c : h) {
+        unsigned d;
+        if (c >= L'0' && c <= L'9') d = c - L'0';
+        else if (c >= L'a' && c <= L'f') d = 10 + (c - L'a');
+        else if (c >= L'A' && c <= L'F') d = 10 + (c - L'A');
+        else return false;
+        val = (val << 4) | d;
+    }
+    out.a = (h.size() == 8) ? ((val >> 24) & 0xFF) / 255.0f : 1.0f;
+    out.r = ((val >> 16) & 0xFF) / 255.0f;
+    out.g = ((val >> 8) & 0xFF) / 255.0f;
+    out.b = (val & 0xFF) / 255.0f;
+    return true;
+}
+
+CornerStyle CornerStyleFromToken(const std::wstring& token)
+{
+    if (token == L"donot") return CornerStyle::DoNot;
+    if (token == L"round") return CornerStyle::Round;
+    if (token == L"roundsmall") return CornerStyle::RoundSmall;
+    return CornerStyle::Default;
+}
+
+const wchar_t* CornerStyleToken(CornerStyle c)
+{
+    switch (c) {
+    case CornerStyle::DoNot: return L"donot";
+    case CornerStyle::Round: return L"round";
+    case CornerStyle::RoundSmall: return L"roundsmall";
+    default: return L"default";
+    }
+}
+
+float CornerRadius(CornerStyle c)
+{
+    switch (c) {
+    case CornerStyle::DoNot: return 0.0f;
+    case CornerStyle::RoundSmall: return 6.0f;
+    case CornerStyle::Round: return 12.0f;
+    default: return 8.0f;
+    }
+}
+
+BorderStyle StyleRule::Apply(const BorderStyle& base) const
+{
+    BorderStyle s = base;
+    if (hasColor) s.color = color;
+    if (hasThickness) s.thickness = thickness;
+    if (hasCorner) s.corner = corner;
+    return s;
+}
+
+static std::wstring Trim(const std::wstring& s)
+{
+    size_t b = 0, e = s.size();
+    while (b < e && std::iswspace(s[b])) ++b;
+    while (e > b && std::iswspace(s[e - 1])) --e;
+    return s.substr(b, e - b);
+}
+
+static bool ParseRuleLine(const std::wstring& line, StyleRule& rule)
+{
+    bool hasCriteria = false, hasOverride = false;
+    size_t pos = 0;
+    while (pos <= line.size()) {
+        size_t end = line.find(L';', pos);
+        if (end == std::wstring::npos) end = line.size();
+        std::wstring field = Trim(line.substr(pos, end - pos));
+        pos = end + 1;
+        if (field.empty()) continue;
+
+        size_t eq = field.find(L'=');
+        if (eq == std::wstring::npos) return false;
+        std::wstring key = CompiledStyleRules::Lower(Trim(field.substr(0, eq)));
+        std::wstring val = Trim(field.substr(eq + 1));
+
+        if (key == L"process") { rule.process = (val == L"*") ? std::wstring() : NormalizeImageName(val); hasCriteria = true; }
+        else if (key == L"class") { rule.windowClass = (val == L"*") ? std::wstring() : CompiledStyleRules::Lower(val); hasCriteria = true; }
+        else if (key == L"title") { rule.title = (val == L"*") ? std::wstring() : CompiledStyleRules::Lower(val); hasCriteria = true; }
+        else if (key == L"color") {
+            if (!ParseHexColor(val, rule.color)) return false;
+            rule.hasColor = hasOverride = true;
+        }
+        else if (key == L"thickness") {
+            wchar_t* endp = nullptr;
+            float t = std::wcstof(val.c_str(), &endp);
+            if (endp == val.c_str() || !(t > 0 && t < 1000)) return false;
+            rule.thickness = t;
+            rule.hasThickness = hasOverride = true;
+        }
+        else if (key == L"corner") {
+            rule.corner = CornerStyleFromToken(CompiledStyleRules::Lower(val));
+            rule.hasCorner = hasOverride = true;
+        }
+        else return false;
+    }
+    return hasCriteria && hasOverride;
+}
+
+std::vector<StyleRule> ParseStyleRules(const std::wstring& text, size_t* invalidLines)
+{
+    std::vector<StyleRule> rules;
+    size_t invalid = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find_first_of(L"\r\n|", pos);
+        if (end == std::wstring::npos) end = text.size();
+        std::wstring line = Trim(text.substr(pos, end - pos));
+        pos = end + 1;
+        if (line.empty() || line[0] == L'#') continue;
+
+        StyleRule r;
+        if (ParseRuleLine(line, r)) rules.push_back(std::move(r));
+        else ++invalid;
+    }
+    if (invalidLines) *invalidLines = invalid;
+    return rules;
+}
+
+std::wstring CompiledStyleRules::Lower(const std::wstring& s)
+{
+    std::wstring out(s);
+    for (auto& c : out) c = (wchar_t)std::towlower(c);
+    return out;
+}
+
+void CompiledStyleRules::OrInto(Mask& dst, const std::vector<uint32_t>& ruleIds)
+{
+    for (uint32_t id : ruleIds) dst[id >> 6] |= (uint64_t(1) << (id & 63));
+}
+
+void CompiledStyleRules::Compile(std::vector<StyleRule> rules)
+{
+    m_rules = std::move(rules);
+    m_words = (m_rules.size() + 63) / 64;
+    m_byProcess.clear();
+    m_byClass.clear();
+    m_anyProcess.assign(m_words, 0);
+    m_anyClass.assign(m_words, 0);
+    m_anyTitle.assign(m_words, 0);
+
+    // Distinct title patterns share one automaton terminal each
+    std::unordered_map<std::wstring, uint32_t> patternIds;
+    std::vector<std::wstring> patterns;
+    m_rulesByPattern.clear();
+
+    for (uint32_t i = 0; i < m_rules.size(); ++i) {
+        const StyleRule& r = m_rules[i];
+        const uint64_t bit = uint64_t(1) << (i & 63);
+
+        if (r.process.empty()) m_anyProcess[i >> 6] |= bit;
+        else m_byProcess[r.process].push_back(i);
+
+        if (r.windowClass.empty()) m_anyClass[i >> 6] |= bit;
+        else m_byClass[r.windowClass].push_back(i);
+
+        if (r.title.empty()) {
+            m_anyTitle[i >> 6] |= bit;
+        } else {
+            auto ins = patternIds.emplace(r.title, static_cast<uint32_t>(patterns.size()));
+            if (ins.second) {
+                patterns.push_back(r.title);
+                m_rulesByPattern.emplace_back();
+            }
+            m_rulesByPattern[ins.first->second].push_back(i);
+        }
+    }
+
+    m_patternCount = patterns.size();
+    BuildAutomaton(patterns);
+    ++m_generation;
+}
+
+int32_t CompiledStyleRules::Edge(const AcNode& n, wchar_t ch)
+{
+    auto it = std::lower_bound(n.next.begin(), n.next.end(), ch,
+                               [](const std::pair<wchar_t, int32_t>& e, wchar_t c) { return e.first < c; });
+    return (it != n.next.end() && it->first == ch) ? it->second : -1;
+}
+
+void CompiledStyleRules::BuildAutomaton(const std::vector<std::wstring>& patterns)
+{
+    m_ac.assign(1, AcNode{});
+    for (uint32_t p = 0; p < patterns.size(); ++p) {
+        int32_t node = 0;
+        for (wchar_t ch : patterns[p]) {
+            int32_t nxt = Edge(m_ac[node], ch);
+            if (nxt < 0) {
+                nxt = static_cast<int32_t>(m_ac.size());
+                auto& edges = m_ac[node].next;
+                auto it = std::lower_bound(edges.begin(), edges.end(), ch,
+                                           [](const std::pair<wchar_t, int32_t>& e, wchar_t c) { return e.first < c; });
+                edges.insert(it, { ch, nxt });
+                m_ac.emplace_back();
+            }
+            node = nxt;
+        }
+        m_ac[node].pattern = static_cast<int32_t>(p);
+    }
+
+    // BFS for failure and output links
+    std::deque<int32_t> queue;
+    for (const auto& e : m_ac[0].next) {
+        m_ac[e.second].fail = 0;
+        queue.push_back(e.second);
+    }
+    while (!queue.empty()) {
+        int32_t u = queue.front();
+        queue.pop_front();
+        for (const auto& e : m_ac[u].next) {
+            int32_t v = e.second;
+            int32_t f = m_ac[u].fail;
+            while (f > 0 && Edge(m_ac[f], e.first) < 0) f = m_ac[f].fail;
+            int32_t t = Edge(m_ac[f], e.first);
+            m_ac[v].fail = (t >= 0 && t != v) ? t : 0;
+            int32_t fv = m_ac[v].fail;
+            m_ac[v].outLink = (m_ac[fv].pattern >= 0) ? fv : m_ac[fv].outLink;
+            queue.push_back(v);
+        }
+    }
+}
+
+int32_t CompiledStyleRules::Step(int32_t node, wchar_t ch) const
+{
+    for (;;) {
+        int32_t nxt = Edge(m_ac[node], ch);
+        if (nxt >= 0) return nxt;
+        if (node == 0) return 0;
+        node = m_ac[node].fail;
+    }
+}
+
+int32_t CompiledStyleRules::Match(const std::wstring& processLower, const std::wstring& classLower, const std::wstring& titleLower) const
+{
+    if (m_rules.empty()) return kNoMatch;
+
+    // Scratch masks are reused per thread so steady-state matching does not allocate
+    thread_local Mask cand, scratch;
+    cand.assign(m_anyProcess.begin(), m_anyProcess.end());
+    if (auto it = m_byProcess.find(processLower); it != m_byProcess.end()) OrInto(cand, it->second);
+
+    scratch.assign(m_anyClass.begin(), m_anyClass.end());
+    if (auto it = m_byClass.find(classLower); it != m_byClass.end()) OrInto(scratch, it->second);
+
+    uint64_t any = 0;
+    for (size_t w = 0; w < m_words; ++w) any |= (cand[w] &= scratch[w]);
+    if (!any) return kNoMatch;
+
+    scratch.assign(m_anyTitle.begin(), m_anyTitle.end());
+    if (m_patternCount) {
+        int32_t node = 0;
+        for (wchar_t ch : titleLower) {
+            node = Step(node, ch);
+            for (int32_t o = (m_ac[node].pattern >= 0) ? node : m_ac[node].outLink; o >= 0; o = m_ac[o].outLink) {
+                OrInto(scratch, m_rulesByPattern[static_cast<size_t>(m_ac[o].pattern)]);
+            }
+        }
+    }
+
+    for (size_t w = 0; w < m_words; ++w) {
+        uint64_t bits = cand[w] & scratch[w];
+        if (bits) {
+            int32_t bit = 0;
+            while (!(bits & 1)) { bits >>= 1; ++bit; }
+            return static_cast<int32_t>(w * 64 + bit);
+        }
+    }
+    return kNoMatch;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-application border style rules.
+// Portable: rules are parsed and compiled here; WindowStyles.cpp feeds real window data.
+
+enum class CornerStyle : uint8_t { Default = 0, DoNot, Round, RoundSmall };
+
+struct ColorF { float r = 0, g = 0, b = 0, a = 1; };
+
+struct BorderStyle {
+    ColorF color{ 0.0f, 0.8f, 1.0f, 1.0f };
+    float thickness = 5.0f;
+    CornerStyle corner = CornerStyle::Default;
+};
+
+bool operator==(const BorderStyle& a, const BorderStyle& b);
+inline bool operator!=(const BorderStyle& a, const BorderStyle& b) { return !(a == b); }
+
+// "#RRGGBB" / "#AARRGGBB" (same format as --color / SET color=)
+bool ParseHexColor(const std::wstring& hex, ColorF& out);
+CornerStyle CornerStyleFromToken(const std::wstring& token);
+const wchar_t* CornerStyleToken(CornerStyle c);
+float CornerRadius(CornerStyle c);
+
+struct StyleRule {
+    // Match criteria; empty = any. process: image name without extension,
+    // windowClass: exact class name, title: substring. All case-insensitive.
+    std::wstring process;
+    std::wstring windowClass;
+    std::wstring title;
+
+    // Overrides applied on top of the global settings
+    bool hasColor = false;
+    bool hasThickness = false;
+    bool hasCorner = false;
+    ColorF color;
+    float thickness = 0.0f;
+    CornerStyle corner = CornerStyle::Default;
+
+    BorderStyle Apply(const BorderStyle& base) const;
+};
+
+// One rule per line ('\n' or '|' separated); fields separated by ';':
+//   process=cmd; title=Administrator:; color=#FF0000; thickness=6; corner=round
+// Lines starting with '#' are comments. Invalid lines are skipped and counted.
+std::vector<StyleRule> ParseStyleRules(const std::wstring& text, size_t* invalidLines = nullptr);
+
+// Rule set compiled into interned-string indexes plus an Aho-Corasick automaton over
+// title patterns. Matching is first-rule-wins in declaration order.
+class CompiledStyleRules {
+public:
+    static constexpr int32_t kNoMatch = -1;
+
+    void Compile(std::vector<StyleRule> rules);
+    bool Empty() const { return m_rules.empty(); }
+    size_t RuleCount() const { return m_rules.size(); }
+    bool HasTitlePatterns() const { return m_patternCount > 0; }
+    // Bumped on every Compile; cached per-window results carry it
+    uint32_t Generation() const { return m_generation; }
+    const StyleRule& Rule(int32_t index) const { return m_rules[static_cast<size_t>(index)]; }
+
+    // Inputs must already be lower-cased (see Lower()); title may be empty.
+    int32_t Match(const std::wstring& processLower, const std::wstring& classLower, const std::wstring& titleLower) const;
+
+    static std::wstring Lower(const std::wstring& s);
+
+private:
+    using Mask = std::vector<uint64_t>;
+
+    struct AcNode {
+        std::vector<std::pair<wchar_t, int32_t>> next; // sorted by character
+        int32_t fail = 0;
+        int32_t outLink = -1;   // nearest suffix node that ends a pattern
+        int32_t pattern = -1;   // pattern ending exactly here
+    };
+
+    void BuildAutomaton(const std::vector<std::wstring>& patterns);
+    int32_t Step(int32_t node, wchar_t ch) const;
+    static int32_t Edge(const AcNode& n, wchar_t ch);
+    static void OrInto(Mask& dst, const std::vector<uint32_t>& ruleIds);
+
+    std::vector<StyleRule> m_rules;
+    size_t m_words = 0;
+
+    // Interned process/class names -> rules naming them; wildcard masks hold rules with "any"
+    std::unordered_map<std::wstring, std::vector<uint32_t>> m_byProcess;
+    std::unordered_map<std::wstring, std::vector<uint32_t>> m_byClass;
+    Mask m_anyProcess, m_anyClass, m_anyTitle;
+
+    std::vector<AcNode> m_ac;
+    std::vector<std::vector<uint32_t>> m_rulesByPattern;
+    size_t m_patternCount = 0;
+    uint32_t m_generation = 0;
+};
@@ -0,0 +1,63 @@
+#include "TierScheduler.h"
+#include <algorithm>
+
+TierScheduler::TierScheduler(const TierOptions& options) : m_options(options)
+{
+    if (!m_options.budget) m_options.budget = 1;
+}
+
+void TierScheduler::Plan(const std::vector<TierItem>& dirty, uint64_t nowNs, std::vector<uint64_t>& foregroundOut)
+{
+    m_backlog.clear();
+    m_head = 0;
+    m_foregroundWindows = 0;
+    for (const TierItem& item : dirty) {
+        if (item.foreground) {
+            foregroundOut.push_back(item.handle);
+            ++m_foregroundWindows;
+        } else {
+            m_backlog.push_back(item.handle);
+        }
+    }
+    m_maxBacklog = std::max(m_maxBacklog, m_backlog.size());
+    m_planNs = nowNs;
+    m_foregroundNs = 0;
+    if (m_backlog.empty()) m_drainNs = 0;
+}
+
+void TierScheduler::ForegroundDone(uint64_t nowNs)
+{
+    m_foregroundNs = nowNs - m_planNs;
+}
+
+uint64_t TierScheduler::NextDueNs() const
+{
+    if (!Backlog()) return 0;
+    // As soon as nothing else is queued, but never closer than the interval to the last
+    // slice, whichever plan it belonged to
+    const uint64_t due = m_slices ? std::max(m_planNs, m_lastSliceNs + m_options.intervalNs) : m_planNs;
+    return std::max<uint64_t>(due, 1);
+}
+
+size_t TierScheduler::NextSlice(uint64_t nowNs, std::vector<uint64_t>& out)
+{
+    if (!Backlog() || nowNs < NextDueNs()) return 0;
+    const size_t n = std::min(m_options.budget, Backlog());
+    out.insert(out.end(), m_backlog.begin() + m_head, m_backlog.begin() + m_head + n);
+    m_head += n;
+    m_lastSliceNs = nowNs;
+    ++m_slices;
+    m_backgroundWindows += n;
+    if (!Backlog()) {
+        m_drainNs = nowNs - m_planNs;
+        m_backlog.clear();
+        m_head = 0;
+    }
+    return n;
+}
+
+void TierScheduler::Clear()
+{
+    m_backlog.clear();
+    m_head = 0;
+}
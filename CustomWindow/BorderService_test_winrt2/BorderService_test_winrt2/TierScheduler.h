@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Two-tier order for the windows a full pass finds out of date. The foreground window and
+// the popups it owns (same root owner) are written at once, in the pass; everything else
+// goes to a background backlog drained in slices of at most `budget` windows, between
+// event batches and no sooner than `interval` after the previous slice.
+// After an alt-tab or an app launch the window being looked at no longer waits behind
+// dozens of background windows. Portable; the render thread owns it (DwmUtil.cpp).
+
+struct TierItem {
+    uint64_t handle = 0;
+    bool foreground = false;
+};
+
+struct TierOptions {
+    size_t budget = 16;                 // background windows per slice
+    uint64_t intervalNs = 8000000;      // between slices
+};
+
+class TierScheduler {
+public:
+    explicit TierScheduler(const TierOptions& options = TierOptions());
+
+    // A full pass found these windows out of date (z-order, top first). Appends the
+    // foreground tier to foregroundOut; the background ones replace the backlog, since the
+    // pass re-examined every window the previous one deferred.
+    void Plan(const std::vector<TierItem>& dirty, uint64_t nowNs, std::vector<uint64_t>& foregroundOut);
+    // The foreground tier of the last Plan has been written
+    void ForegroundDone(uint64_t nowNs);
+    // Appends the background windows due at nowNs (none before NextDueNs)
+    size_t NextSlice(uint64_t nowNs, std::vector<uint64_t>& out);
+    // Earliest time the next slice may run; 0 with an empty backlog
+    uint64_t NextDueNs() const;
+    void Clear();
+
+    size_t Backlog() const { return m_backlog.size() - m_head; }
+    size_t MaxBacklog() const { return m_maxBacklog; }
+    uint64_t Slices() const { return m_slices; }
+    uint64_t ForegroundWindows() const { return m_foregroundWindows; }   // last Plan
+    uint64_t BackgroundWindows() const { return m_backgroundWindows; }   // handed out in total
+    uint64_t ForegroundNs() const { return m_foregroundNs; }             // last Plan -> ForegroundDone
+    uint64_t DrainNs() const { return m_drainNs; }                       // last Plan -> backlog empty
+
+private:
+    TierOptions m_options;
+    std::vector<uint64_t> m_backlog;
+    size_t m_head = 0;
+    size_t m_maxBacklog = 0;
+    uint64_t m_planNs = 0;
+    uint64_t m_lastSliceNs = 0;
+    uint64_t m_slices = 0;
+    uint64_t m_foregroundWindows = 0;
+    uint64_t m_backgroundWindows = 0;
+    uint64_t m_foregroundNs = 0;
+    uint64_t m_drainNs = 0;
+};
@@ -0,0 +1,91 @@
+#include "TransitionBurst.h"
+#include <algorithm>
+
+// winuser.h values, repeated so the detector stays portable
+static constexpr uint32_t kEventSystemMinimizeStart = 0x0016;
+static constexpr uint32_t kEventSystemMinimizeEnd = 0x0017;
+static constexpr uint32_t kEventObjectHide = 0x8003;
+static constexpr uint32_t kEventObjectCloaked = 0x8017;
+static constexpr uint32_t kEventObjectUncloaked = 0x8018;
+
+bool IsTransitionEvent(uint32_t event)
+{
+    switch (event) {
+    case kEventSystemMinimizeStart:
+    case kEventSystemMinimizeEnd:
+    case kEventObjectHide:
+    case kEventObjectCloaked:
+    case kEventObjectUncloaked:
+        return true;
+    default:
+        return false;
+    }
+}
+
+BurstDetector::BurstDetector(const BurstOptions& options) : m_options(options)
+{
+    if (m_options.threshold < 2) m_options.threshold = 2;
+    m_recentNs.resize(m_options.threshold);
+    m_recentHwnd.resize(m_options.threshold);
+    m_affected.reserve(256);
+}
+
+bool BurstDetector::Note(uint64_t hwnd, uint64_t nowNs)
+{
+    if (m_active) {
+        m_lastNs = nowNs;
+        ++m_events;
+        if (m_affected.size() < kMaxAffected) m_affected.push_back(hwnd);
+        return true;
+    }
+
+    const size_t n = m_options.threshold;
+    m_recentNs[(m_recentHead + m_recentCount) % n] = nowNs;
+    m_recentHwnd[(m_recentHead + m_recentCount) % n] = hwnd;
+    if (m_recentCount < n) ++m_recentCount;
+    else m_recentHead = (m_recentHead + 1) % n;
+    // Forget what fell out of the window
+    while (m_recentCount && nowNs - m_recentNs[m_recentHead] > m_options.windowNs) {
+        m_recentHead = (m_recentHead + 1) % n;
+        --m_recentCount;
+    }
+    if (m_recentCount < n) return false;
+
+    m_active = true;
+    m_startNs = m_recentNs[m_recentHead];
+    m_lastNs = nowNs;
+    m_events = m_recentCount;
+    m_affected.clear();
+    for (size_t i = 0; i < m_recentCount; ++i) m_affected.push_back(m_recentHwnd[(m_recentHead + i) % n]);
+    m_recentCount = 0;
+    return true;
+}
+
+uint64_t BurstDetector::SettleDueNs() const
+{
+    if (!m_active) return 0;
+    return std::max<uint64_t>(std::min(m_lastNs + m_options.settleNs, m_startNs + m_options.maxHoldNs), 1);
+}
+
+bool BurstDetector::Settle(uint64_t nowNs)
+{
+    if (!m_active || nowNs < SettleDueNs()) return false;
+    std::sort(m_affected.begin(), m_affected.end());
+    m_affected.erase(std::unique(m_affected.begin(), m_affected.end()), m_affected.end());
+
+    m_active = false;
+    ++m_bursts;
+    m_lastEvents = m_events;
+    m_lastWindows = m_affected.size();
+    m_maxEvents = std::max(m_maxEvents, m_events);
+    m_lastHoldNs = nowNs - m_startNs;
+    m_affected.clear();
+    return true;
+}
+
+void BurstDetector::Reset()
+{
+    m_active = false;
+    m_recentCount = 0;
+    m_affected.clear();
+}
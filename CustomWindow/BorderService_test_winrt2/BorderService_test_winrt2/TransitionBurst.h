@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Mass transitions: a virtual-desktop switch cloaks and uncloaks every window of both
+// desktops, Win+D minimizes them all. Each of those WinEvents used to cost a full refresh,
+// spread over as many batches as the burst spans. Once `threshold` transition events fall
+// within `window`, the render thread holds every redraw until no transition event came for
+// `settle` (or `maxHold` passed since the burst began), then re-reads every window in one
+// full pass and draws it. Portable; the render thread owns it (Pipeline.cpp).
+
+// EVENT_OBJECT_CLOAKED / UNCLOAKED, EVENT_OBJECT_HIDE, EVENT_SYSTEM_MINIMIZESTART / END
+bool IsTransitionEvent(uint32_t event);
+
+struct BurstOptions {
+    size_t threshold = 6;
+    uint64_t windowNs = 50000000;
+    uint64_t settleNs = 32000000;
+    uint64_t maxHoldNs = 250000000;
+};
+
+class BurstDetector {
+public:
+    explicit BurstDetector(const BurstOptions& options = BurstOptions());
+
+    // A transition event of hwnd, seen at nowNs. True while a burst is open.
+    bool Note(uint64_t hwnd, uint64_t nowNs);
+    bool Active() const { return m_active; }
+    // When the open burst settles if nothing else arrives; 0 without one
+    uint64_t SettleDueNs() const;
+    // Closes the burst if it has settled by nowNs. LastWindows() then counts the distinct
+    // windows it touched (including the events that opened it).
+    bool Settle(uint64_t nowNs);
+    // Drops the open burst and the recent history (overflow resync, suspension)
+    void Reset();
+
+    uint64_t Bursts() const { return m_bursts; }
+    uint64_t LastEvents() const { return m_lastEvents; }
+    uint64_t LastWindows() const { return m_lastWindows; }
+    uint64_t MaxEvents() const { return m_maxEvents; }
+    uint64_t LastStartNs() const { return m_startNs; }  // first event of the last burst
+    uint64_t LastHoldNs() const { return m_lastHoldNs; } // first event -> settled
+
+private:
+    static constexpr size_t kMaxAffected = 4096;
+
+    BurstOptions m_options;
+    // Recent transition events before a burst opens (ring of threshold entries)
+    std::vector<uint64_t> m_recentNs, m_recentHwnd;
+    size_t m_recentHead = 0, m_recentCount = 0;
+
+    bool m_active = false;
+    uint64_t m_startNs = 0, m_lastNs = 0, m_events = 0;
+    std::vector<uint64_t> m_affected;
+
+    uint64_t m_bursts = 0, m_lastEvents = 0, m_lastWindows = 0, m_maxEvents = 0, m_lastHoldNs = 0;
+};
@@ -6,6 +6,13 @@
 #include "Tray.h"
 #include "Args.h"
 #include "ConsoleUtil.h"
+#include "PowerMonitor.h"
+#include "Metrics.h"
+#include "ProcessFilter.h"
+#include "WindowStyles.h"
+#include "FastStart.h"
+#include "Pipeline.h"
+#include "EventClassifier.h"
 
 #ifndef ARRAYSIZE
 #define ARRAYSIZE(a) (sizeof(a)/sizeof((a)[0]))
@@ -42,32 +49,29 @@ static bool ParseColorString(const std::wstring& hex, D2D1_COLOR_F& out)
     return true;
 }
 
-static void HandleSettingsMessage(const std::wstring& msg)
+static bool IsQuitCommand(const std::wstring& msg)
 {
-    // Handle QUIT command
     auto msgUpper = msg;
     std::transform(msgUpper.begin(), msgUpper.end(), msgUpper.begin(), ::towupper);
-    if (msgUpper == L"QUIT" || msgUpper.rfind(L"QUIT ", 0) == 0) {
-        DebugLog(L"[Overlay] Received QUIT command via IPC, posting WM_QUIT");
-        PostQuitMessage(0);
-        return;
-    }
+    return msgUpper == L"QUIT" || msgUpper.rfind(L"QUIT ", 0) == 0;
+}
 
-    // Expect: SET foregroundonly=0/1 color=#.. thickness=N corner=token or REFRESH ...
+// Edits the next settings snapshot; keys that are absent keep their value.
+// Runs inside g_settings.Update on the UI thread (OverlayProc).
+static void ParseSettingsMessage(const std::wstring& msg, BorderSettings& settings)
+{
+    // Expect: SET foregroundonly=0/1 color=#.. thickness=N corner=token effect=token or REFRESH ...
     auto lower = msg; 
     std::transform(lower.begin(), lower.end(), lower.begin(), ::towlower);
     
-    bool wasForgroundOnly = g_foregroundWindowOnly;
-    std::wstring previousCorner = g_cornerToken; //  corner  
-    
     // Parse foregroundonly
     size_t fgPos = lower.find(L"foregroundonly=");
     if (fgPos != std::wstring::npos) {
         size_t start = fgPos + 15;
         size_t end = lower.find_first_of(L" \r\n\t", start);
         std::wstring fgStr = lower.substr(start, end == std::wstring::npos ? 1 : end - start);
-        g_foregroundWindowOnly = (fgStr == L"1" || fgStr == L"true");
-        DebugLog(L"[Overlay] ForegroundWindowOnly updated: " + std::to_wstring(g_foregroundWindowOnly));
+        settings.foregroundOnly = (fgStr == L"1" || fgStr == L"true");
+        DebugLog(L"[Overlay] ForegroundWindowOnly updated: " + std::to_wstring(settings.foregroundOnly));
     }
     
     // Parse color
@@ -79,7 +83,7 @@ static void HandleSettingsMessage(const std::wstring& msg)
         
         D2D1_COLOR_F newColor;
         if (ParseColorString(colorStr, newColor)) {
-            g_borderColor = newColor;
+            settings.color = { newColor.r, newColor.g, newColor.b, newColor.a };
             DebugLog(L"[Overlay] Color updated: " + colorStr);
         }
     }
@@ -94,7 +98,7 @@ static void HandleSettingsMessage(const std::wstring& msg)
         try {
             float newThickness = std::stof(thickStr);
             if (newThickness > 0 && newThickness < 1000) {
-                g_thickness = newThickness;
+                settings.thickness = newThickness;
                 DebugLog(L"[Overlay] Thickness updated: " + std::to_wstring(newThickness));
             }
         } catch (...) {
@@ -107,25 +111,43 @@ static void HandleSettingsMessage(const std::wstring& msg)
     if (cpos != std::wstring::npos) {
         size_t start = cpos + 7; 
         size_t end = lower.find_first_of(L" \r\n\t", start);
-        g_cornerToken = lower.substr(start, end == std::wstring::npos ? std::wstring::npos : end - start);
-        DebugLog(L"[Overlay] Corner updated: " + g_cornerToken);
+        settings.cornerToken = lower.substr(start, end == std::wstring::npos ? std::wstring::npos : end - start);
+        DebugLog(L"[Overlay] Corner updated: " + settings.cornerToken);
     }
 
+    // Parse effect (none / pulse / fade[:ms]); the render thread parses the token
+    size_t epos = lower.find(L"effect=");
+    if (epos != std::wstring::npos) {
+        size_t start = epos + 7;
+        size_t end = lower.find_first_of(L" \r\n\t", start);
+        settings.effectToken = lower.substr(start, end == std::wstring::npos ? std::wstring::npos : end - start);
+        DebugLog(L"[Overlay] Effect updated: " + settings.effectToken);
+    }
+}
+
+// Per-window side effects of a published change. Runs on the render thread.
+static void ApplySettingsChange(const BorderSettings& previous)
+{
+    const auto settings = g_settings.Read();
+    MetricSet(Metric::SettingsVersion, static_cast<int64_t>(settings->version));
+    const std::wstring& previousCorner = previous.cornerToken;
+    const bool wasForgroundOnly = previous.foregroundOnly;
+
     // corner  Ǿ   â ǽð 
-    if (previousCorner != g_cornerToken) {
-        DebugLog(L"[Overlay] Corner preference changed from '" + previousCorner + L"' to '" + g_cornerToken + L"'");
+    if (previousCorner != settings->cornerToken) {
+        DebugLog(L"[Overlay] Corner preference changed from '" + previousCorner + L"' to '" + settings->cornerToken + L"'");
         
-        if (g_mode == RenderMode::Dwm) {
+        if (UsesDwmAttributes()) {
             // DWM :  â 𼭸  
             auto hwnds = CollectUserVisibleWindows();
             for (HWND h : hwnds) {
-                ApplyCornerPreference(h, g_cornerToken);
+                ApplyCornerPreference(h);
             }
             DebugLog(L"[Overlay] Applied corner preference to " + std::to_wstring(hwnds.size()) + L" windows");
         } else if (g_mode == RenderMode::DComp) {
             // DComp :  ٽ ׸ (DrawBorders ο radius )
             if (g_overlay) {
-                PostMessageW(g_overlay, WM_APP_REFRESH, 0, 0);
+                RequestRender();
                 DebugLog(L"[Overlay] Triggered DComp refresh for corner change");
             }
             
@@ -133,7 +155,7 @@ static void HandleSettingsMessage(const std::wstring& msg)
             if (IsWindows11OrGreater()) {
                 auto hwnds = CollectUserVisibleWindows();
                 for (HWND h : hwnds) {
-                    ApplyCornerPreference(h, g_cornerToken);
+                    ApplyCornerPreference(h);
                 }
                 DebugLog(L"[Overlay] Applied corner preference to " + std::to_wstring(hwnds.size()) + L" windows (DComp+Win11)");
             }
@@ -141,18 +163,18 @@ static void HandleSettingsMessage(const std::wstring& msg)
     }
 
     // ׶ ɼ   ü ó
-    if (wasForgroundOnly != g_foregroundWindowOnly) {
+    if (wasForgroundOnly != settings->foregroundOnly) {
         DebugLog(L"[Overlay] Foreground mode changed from " + std::to_wstring(wasForgroundOnly) + 
-                 L" to " + std::to_wstring(g_foregroundWindowOnly));
+                 L" to " + std::to_wstring(settings->foregroundOnly));
         
-        if (g_mode == RenderMode::Dwm) {
+        if (UsesDwmAttributes()) {
             // DWM 忡 ü ¸ 缳
             ResetAndApplyDwmAttributes();
             DebugLog(L"[Overlay] Reset and reapplied all DWM attributes (including corners) due to foreground mode change");
         } else if (g_mode == RenderMode::DComp) {
             // DComp 忡  ΰħ
             if (g_overlay) {
-                PostMessageW(g_overlay, WM_APP_REFRESH, 0, 0);
+                RequestRender();
                 DebugLog(L"[Overlay] Triggered DComp refresh due to foreground mode change");
             }
             
@@ -160,7 +182,7 @@ static void HandleSettingsMessage(const std::wstring& msg)
             if (IsWindows11OrGreater()) {
                 auto hwnds = CollectUserVisibleWindows();
                 for (HWND h : hwnds) {
-                    ApplyCornerPreference(h, g_cornerToken);
+                    ApplyCornerPreference(h);
                 }
                 DebugLog(L"[Overlay] Reapplied corner preferences to " + std::to_wstring(hwnds.size()) + 
                          L" windows after foreground mode change (DComp+Win11)");
@@ -169,21 +191,110 @@ static void HandleSettingsMessage(const std::wstring& msg)
     }
 }
 
+// Set by the intake thread when a WM_APP_FOREGROUND is in flight
+static std::atomic<bool> s_foregroundPending{ false };
+
+static void LogStats()
+{
+    DebugLog(L"[Stats] " + ToWide(FormatMetrics()));
+}
+
+// IPC commands that touch exclusions, styles or the DWM ledger; runs on the render thread
+static void HandleOverlayCommand(const std::wstring& msgStr)
+{
+    if (msgStr.rfind(L"HWNDS ", 0) == 0) {
+        std::vector<HWND> targets;
+        size_t pos = 6;
+        while (pos < msgStr.size()) {
+            while (pos < msgStr.size() && msgStr[pos] == L' ') ++pos;
+            if (pos >= msgStr.size()) break;
+            size_t end = msgStr.find(L' ', pos);
+            std::wstring tok = msgStr.substr(pos, end == std::wstring::npos ? std::wstring::npos : end - pos);
+            HWND h = nullptr;
+            try {
+                if (tok.rfind(L"0x", 0) == 0 || tok.rfind(L"0X", 0) == 0) tok = tok.substr(2);
+                unsigned long long v = std::stoull(tok, nullptr, 16);
+                h = reinterpret_cast<HWND>(v);
+            } catch (...) { h = nullptr; }
+            if (h && IsWindow(h) && !IsWindowExcluded(h)) targets.push_back(h);
+            if (end == std::wstring::npos) break;
+            pos = end + 1;
+        }
+        
+        // ׶  忡  â  ٽ ͸
+        if (g_settings.Read()->foregroundOnly) {
+            HWND foregroundWnd = GetForegroundWindow();
+            std::vector<HWND> filteredTargets;
+            for (HWND h : targets) {
+                if (h == foregroundWnd || GetAncestor(h, GA_ROOT) == foregroundWnd) {
+                    filteredTargets.push_back(h);
+                }
+            }
+            targets = filteredTargets;
+            DebugLog(L"[Overlay] Applied foreground filtering to HWNDS message: " + 
+                    std::to_wstring(filteredTargets.size()) + L" windows remaining");
+        }
+        
+        ApplyDwmAttributesToTargets(targets);
+        if (UsesDwmAttributes()) {
+            for (HWND h : targets) ApplyCornerPreference(h);
+        }
+    } else if (msgStr.rfind(L"EXCLUDE", 0) == 0) {
+        SetExcludedProcesses(msgStr.size() > 8 ? msgStr.substr(8) : std::wstring());
+        SaveStartupSnapshot();
+        RequestRender();
+    } else if (msgStr.rfind(L"RULES", 0) == 0) {
+        LoadStyleRules(msgStr.size() > 6 ? msgStr.substr(6) : std::wstring());
+        SaveStartupSnapshot();
+        if (!IsOverlaySuspended()) InstallWinEventHooks(); // adds/drops the title hook
+        if (g_mode == RenderMode::DComp && IsWindows11OrGreater()) {
+            for (HWND h : CollectUserVisibleWindows()) ApplyCornerPreference(h);
+        }
+        RequestRender();
+    }
+}
+
+// Publishing on the calling thread lets a pass already running on the render thread see the
+// new version and stop early; the side effects and the redraw follow on the render thread.
+void PublishSettings(const std::function<void(BorderSettings&)>& edit)
+{
+    BorderSettings previous;
+    g_settings.Update(edit, &previous);
+    PostRenderTask([previous] {
+        ApplySettingsChange(previous);
+        SaveStartupSnapshot();
+        // DWM mode re-diffs the ledger against the new per-window styles
+        RequestRender();
+    });
+}
+
+void PostOverlayCommand(const std::wstring& msgStr)
+{
+    PostRenderTask([msgStr] { HandleOverlayCommand(msgStr); });
+}
+
 LRESULT CALLBACK OverlayProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
+    if (HandlePowerMessage(hwnd, msg, wParam, lParam)) {
+        return (msg == WM_POWERBROADCAST) ? TRUE : 0;
+    }
+
     switch (msg)
     {
     case WM_TIMER:
-        if (wParam == 1) {
-            if (g_mode == RenderMode::DComp) {
-                RefreshOverlay();
-            }
-        }
+        // Hybrid mode polls only while the overlay has fallback windows
+        if (wParam == 1 && (g_mode != RenderMode::Hybrid || HybridOverlayActive())) RequestRender();
         return 0;
     case WM_APP_REFRESH:
-        if (g_mode == RenderMode::DComp) {
-            RefreshOverlay();
-        }
+        RequestRender();
+        return 0;
+    case WM_APP_IDLE:
+        SetRenderIdle(wParam != 0);
+        return 0;
+    case WM_APP_FOREGROUND:
+        // Coalesced by the intake thread; always evaluate the current foreground window
+        s_foregroundPending.store(false, std::memory_order_relaxed);
+        OnForegroundChangedForPower(GetForegroundWindow());
         return 0;
     case WM_COPYDATA:
         {
@@ -195,47 +306,18 @@ LRESULT CALLBACK OverlayProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
                 std::wstring msgStr(data, data + wlen);
                 DebugLog(L"[Overlay] WM_COPYDATA received: " + msgStr);
 
-                if (msgStr.rfind(L"HWNDS ", 0) == 0) {
-                    std::vector<HWND> targets;
-                    size_t pos = 6;
-                    while (pos < msgStr.size()) {
-                        while (pos < msgStr.size() && msgStr[pos] == L' ') ++pos;
-                        if (pos >= msgStr.size()) break;
-                        size_t end = msgStr.find(L' ', pos);
-                        std::wstring tok = msgStr.substr(pos, end == std::wstring::npos ? std::wstring::npos : end - pos);
-                        HWND h = nullptr;
-                        try {
-                            if (tok.rfind(L"0x", 0) == 0 || tok.rfind(L"0X", 0) == 0) tok = tok.substr(2);
-                            unsigned long long v = std::stoull(tok, nullptr, 16);
-                            h = reinterpret_cast<HWND>(v);
-                        } catch (...) { h = nullptr; }
-                        if (h && IsWindow(h)) targets.push_back(h);
-                        if (end == std::wstring::npos) break;
-                        pos = end + 1;
-                    }
-                    
-                    // ׶  忡  â  ٽ ͸
-                    if (g_foregroundWindowOnly) {
-                        HWND foregroundWnd = GetForegroundWindow();
-                        std::vector<HWND> filteredTargets;
-                        for (HWND h : targets) {
-                            if (h == foregroundWnd || GetAncestor(h, GA_ROOT) == foregroundWnd) {
-                                filteredTargets.push_back(h);
-                            }
-                        }
-                        targets = filteredTargets;
-                        DebugLog(L"[Overlay] Applied foreground filtering to HWNDS message: " + 
-                                std::to_wstring(filteredTargets.size()) + L" windows remaining");
-                    }
-                    
-                    ApplyDwmAttributesToTargets(targets);
-                    if (g_mode == RenderMode::Dwm) {
-                        for (HWND h : targets) ApplyCornerPreference(h, g_cornerToken);
-                    }
+                if (IsQuitCommand(msgStr)) {
+                    DebugLog(L"[Overlay] Received QUIT command via IPC, posting WM_QUIT");
+                    // "QUIT KEEP": restart, the next instance adopts the borders as they are
+                    if (_wcsicmp(msgStr.c_str(), L"QUIT KEEP") == 0) g_exitRestoreMs = 0;
+                    PostQuitMessage(0);
+                } else if (msgStr.rfind(L"STATS", 0) == 0) {
+                    LogStats();
+                } else if (msgStr.rfind(L"HWNDS ", 0) == 0 || msgStr.rfind(L"EXCLUDE", 0) == 0 ||
+                           msgStr.rfind(L"RULES", 0) == 0) {
+                    PostOverlayCommand(msgStr);
                 } else {
-                    HandleSettingsMessage(msgStr);
-                    if (g_mode == RenderMode::DComp)
-                        PostMessageW(hwnd, WM_APP_REFRESH, 0, 0);
+                    PublishSettings([&](BorderSettings& s) { ParseSettingsMessage(msgStr, s); });
                 }
             }
             return 0;
@@ -246,9 +328,10 @@ LRESULT CALLBACK OverlayProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         return static_cast<LRESULT>(MA_NOACTIVATE);
     case WM_DISPLAYCHANGE:
     case WM_DPICHANGED:
-        UpdateVirtualScreenAndResize();
-        if (g_mode == RenderMode::DComp)
-            PostMessageW(hwnd, WM_APP_REFRESH, 0, 0);
+        PostRenderTask([] {
+            UpdateVirtualScreenAndResize();
+            if (g_mode != RenderMode::Dwm) RequestRender();
+        });
         return 0;
     case WM_APP_TRAY:
         if (lParam == WM_LBUTTONDBLCLK) {
@@ -305,6 +388,9 @@ HWND CreateOverlayWindow(bool visible)
     DWORD style = WS_POPUP;
     if (visible) {
         exStyle |= WS_EX_TRANSPARENT | WS_EX_TOPMOST | WS_EX_NOACTIVATE;
+        // Without a region the window spans the desktop, and WS_EX_TRANSPARENT passes clicks
+        // through only when it is layered; DComp content replaces its redirection surface
+        if (!g_overlayRegion) exStyle |= WS_EX_LAYERED | WS_EX_NOREDIRECTIONBITMAP;
     }
 
     HWND h = CreateWindowExW(
@@ -318,6 +404,9 @@ HWND CreateOverlayWindow(bool visible)
     CHANGEFILTERSTRUCT cfs{ sizeof(CHANGEFILTERSTRUCT) };
     ChangeWindowMessageFilterEx(h, WM_COPYDATA, MSGFLT_ALLOW, &cfs);
 
+    // Empty until the first region update, so an overlay with nothing drawn yet covers nothing
+    if (visible && g_overlayRegion) SetWindowRgn(h, CreateRectRgn(0, 0, 0, 0), FALSE);
+    if (visible && !g_overlayRegion) SetLayeredWindowAttributes(h, 0, 255, LWA_ALPHA);
     if (visible) ShowWindow(h, SW_SHOW);
     if (visible) SetTimer(h, 1, 150, nullptr);
 
@@ -341,46 +430,75 @@ void InitTrayIcon(HWND hwnd)
 
 void InstallWinEventHooks()
 {
+    if (ForwardHookCommand(HookCommand::Install)) return;
     DWORD flags = WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS;
-    g_hook1 = SetWinEventHook(EVENT_OBJECT_SHOW, EVENT_OBJECT_HIDE, nullptr, WinEventProc, 0, 0, flags);
-    g_hook2 = SetWinEventHook(EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE, nullptr, WinEventProc, 0, 0, flags);
-    g_hook3 = SetWinEventHook(EVENT_SYSTEM_MINIMIZESTART, EVENT_SYSTEM_MINIMIZEEND, nullptr, WinEventProc, 0, 0, flags);
-    g_hook4 = SetWinEventHook(EVENT_OBJECT_DESTROY, EVENT_OBJECT_DESTROY, nullptr, WinEventProc, 0, 0, flags);
-    g_hook5 = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr, WinEventProc, 0, 0, flags);
-    g_hook6 = SetWinEventHook(EVENT_OBJECT_REORDER, EVENT_OBJECT_REORDER, nullptr, WinEventProc, 0, 0, flags);
+    if (!g_hook1) g_hook1 = SetWinEventHook(EVENT_OBJECT_SHOW, EVENT_OBJECT_HIDE, nullptr, WinEventProc, 0, 0, flags);
+    if (!g_hook2) g_hook2 = SetWinEventHook(EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE, nullptr, WinEventProc, 0, 0, flags);
+    if (!g_hook3) g_hook3 = SetWinEventHook(EVENT_SYSTEM_MINIMIZESTART, EVENT_SYSTEM_MINIMIZEEND, nullptr, WinEventProc, 0, 0, flags);
+    if (!g_hook4) g_hook4 = SetWinEventHook(EVENT_OBJECT_DESTROY, EVENT_OBJECT_DESTROY, nullptr, WinEventProc, 0, 0, flags);
+    if (!g_hook5) g_hook5 = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr, WinEventProc, 0, 0, flags);
+    if (!g_hook6) g_hook6 = SetWinEventHook(EVENT_OBJECT_REORDER, EVENT_OBJECT_REORDER, nullptr, WinEventProc, 0, 0, flags);
+    if (!g_hook8) g_hook8 = SetWinEventHook(EVENT_SYSTEM_MOVESIZESTART, EVENT_SYSTEM_MOVESIZEEND, nullptr, WinEventProc, 0, 0, flags);
+    if (!g_hook9) g_hook9 = SetWinEventHook(EVENT_OBJECT_CLOAKED, EVENT_OBJECT_UNCLOAKED, nullptr, WinEventProc, 0, 0, flags);
+
+    // Title changes only matter while some style rule matches on the title
+    if (HasTitleStyleRules()) {
+        if (!g_hook7) g_hook7 = SetWinEventHook(EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE, nullptr, WinEventProc, 0, 0, flags);
+    } else if (g_hook7) {
+        UnhookWinEvent(g_hook7); g_hook7 = nullptr;
+    }
+}
+
+// Power suspension: drop every hook except foreground, which is needed to notice leaving fullscreen
+void SuspendWinEventHooks()
+{
+    if (ForwardHookCommand(HookCommand::Suspend)) return;
+    if (g_hook1) { UnhookWinEvent(g_hook1); g_hook1 = nullptr; }
+    if (g_hook2) { UnhookWinEvent(g_hook2); g_hook2 = nullptr; }
+    if (g_hook3) { UnhookWinEvent(g_hook3); g_hook3 = nullptr; }
+    if (g_hook4) { UnhookWinEvent(g_hook4); g_hook4 = nullptr; }
+    if (g_hook6) { UnhookWinEvent(g_hook6); g_hook6 = nullptr; }
+    if (g_hook7) { UnhookWinEvent(g_hook7); g_hook7 = nullptr; }
+    if (g_hook8) { UnhookWinEvent(g_hook8); g_hook8 = nullptr; }
+    if (g_hook9) { UnhookWinEvent(g_hook9); g_hook9 = nullptr; }
 }
 
 void UninstallWinEventHooks()
 {
+    if (ForwardHookCommand(HookCommand::Uninstall)) return;
     if (g_hook1) { UnhookWinEvent(g_hook1); g_hook1 = nullptr; }
     if (g_hook2) { UnhookWinEvent(g_hook2); g_hook2 = nullptr; }
     if (g_hook3) { UnhookWinEvent(g_hook3); g_hook3 = nullptr; }
     if (g_hook4) { UnhookWinEvent(g_hook4); g_hook4 = nullptr; }
     if (g_hook5) { UnhookWinEvent(g_hook5); g_hook5 = nullptr; }
     if (g_hook6) { UnhookWinEvent(g_hook6); g_hook6 = nullptr; }
+    if (g_hook7) { UnhookWinEvent(g_hook7); g_hook7 = nullptr; }
+    if (g_hook8) { UnhookWinEvent(g_hook8); g_hook8 = nullptr; }
+    if (g_hook9) { UnhookWinEvent(g_hook9); g_hook9 = nullptr; }
 }
 
-void CALLBACK WinEventProc(HWINEVENTHOOK, DWORD eventId, HWND hwnd, LONG idObject, LONG, DWORD, DWORD)
+// Runs on the intake thread: filter and enqueue only, everything else happens on the render thread
+void CALLBACK WinEventProc(HWINEVENTHOOK, DWORD eventId, HWND hwnd, LONG idObject, LONG, DWORD, DWORD timeMs)
 {
-    if (eventId >= EVENT_OBJECT_CREATE && eventId <= EVENT_OBJECT_HIDE) {
-        if (idObject != OBJID_WINDOW || hwnd == nullptr) return;
-    }
-    
-    // ׶ â  忡 ׶ â    Ʈ
-    if (g_foregroundWindowOnly && eventId == EVENT_SYSTEM_FOREGROUND) {
-        if (g_overlay && g_mode == RenderMode::DComp) {
-            LRESULT res{};
-            if (!SendMessageTimeoutW(g_overlay, WM_APP_REFRESH, 0, 0, SMTO_NORMAL, 50, reinterpret_cast<PDWORD_PTR>(&res))) {
-                PostMessageW(g_overlay, WM_APP_REFRESH, 0, 0);
-            }
-        }
-        return;
-    }
-    
-    if (g_overlay && g_mode == RenderMode::DComp) {
-        LRESULT res{};
-        if (!SendMessageTimeoutW(g_overlay, WM_APP_REFRESH, 0, 0, SMTO_NORMAL, 50, reinterpret_cast<PDWORD_PTR>(&res))) {
-            PostMessageW(g_overlay, WM_APP_REFRESH, 0, 0);
+    // Carets, cursors, scroll bars and other non-window objects never leave this thread
+    if (!PreFilterEvent(eventId, idObject, HwndKey(hwnd))) return;
+
+    // Fullscreen can be entered by resizing the foreground window as well as by switching to it
+    if (eventId == EVENT_SYSTEM_FOREGROUND ||
+        (eventId == EVENT_OBJECT_LOCATIONCHANGE && idObject == OBJID_WINDOW && hwnd && hwnd == GetForegroundWindow())) {
+        if (g_overlay && !s_foregroundPending.exchange(true, std::memory_order_relaxed)) {
+            PostMessageW(g_overlay, WM_APP_FOREGROUND, 0, 0);
         }
     }
+
+    // Style cache entries must be dropped even while suspended (HWND values are reused),
+    // and an open move/size session must always see its end
+    if (IsOverlaySuspended() && eventId != EVENT_OBJECT_DESTROY && eventId != EVENT_SYSTEM_MOVESIZEEND) return;
+
+    // DWM mode tracks its own targets; geometry and z-order are handled by DWM itself.
+    // Hybrid mode needs them only while the overlay draws fallback windows.
+    if ((g_mode == RenderMode::Dwm || (g_mode == RenderMode::Hybrid && !HybridOverlayActive())) &&
+        (eventId == EVENT_OBJECT_LOCATIONCHANGE || eventId == EVENT_OBJECT_REORDER || eventId == EVENT_SYSTEM_MOVESIZESTART)) return;
+
+    PushWinEvent(eventId, hwnd, idObject, timeMs);
 }
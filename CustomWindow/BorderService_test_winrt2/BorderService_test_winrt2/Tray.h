@@ -6,5 +6,12 @@ LRESULT CALLBACK OverlayProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 HWND CreateOverlayWindow(bool visible);
 void InitTrayIcon(HWND hwnd);
 void InstallWinEventHooks();
+void SuspendWinEventHooks();
 void UninstallWinEventHooks();
 void CALLBACK WinEventProc(HWINEVENTHOOK, DWORD eventId, HWND hwnd, LONG idObject, LONG, DWORD, DWORD);
+
+// What the WM_COPYDATA handler does, for in-process hosts (BorderEngine.cpp). Any thread.
+// Publishes a settings edit like SET and redraws
+void PublishSettings(const std::function<void(BorderSettings&)>& edit);
+// HWNDS / EXCLUDE / RULES command, run on the render thread
+void PostOverlayCommand(const std::wstring& msgStr);
@@ -0,0 +1,147 @@
+#include "WindowRegistry.h"
+#include <algorithm>
+
+size_t WindowRegistry::Bucket(uint64_t key) const
+{
+    // Fibonacci hashing: HWND values are multiples of 2/4 and cluster, so mix before masking
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> m_indexShift);
+}
+
+void WindowRegistry::Rehash(size_t buckets)
+{
+    std::vector<IndexEntry> old;
+    old.swap(m_index);
+    m_index.assign(buckets, IndexEntry{});
+    m_indexShift = 64;
+    for (size_t b = buckets; b > 1; b >>= 1) --m_indexShift;
+
+    const size_t mask = buckets - 1;
+    for (const auto& e : old) {
+        if (!e.key) continue;
+        size_t i = Bucket(e.key);
+        while (m_index[i].key) i = (i + 1) & mask;
+        m_index[i] = e;
+    }
+}
+
+WindowRegistry::Slot WindowRegistry::Find(uint64_t handle) const
+{
+    if (m_index.empty() || !handle) return kNoSlot;
+    const size_t mask = m_index.size() - 1;
+    for (size_t i = Bucket(handle);; i = (i + 1) & mask) {
+        const IndexEntry& e = m_index[i];
+        if (e.key == handle) return e.slot;
+        if (!e.key) return kNoSlot;
+    }
+}
+
+WindowRegistry::Slot WindowRegistry::Acquire(uint64_t handle)
+{
+    Slot existing = Find(handle);
+    if (existing != kNoSlot) return existing;
+
+    if ((m_size + 1) * 2 > m_index.size()) Rehash(m_index.empty() ? 64 : m_index.size() * 2);
+
+    Slot s;
+    if (!m_free.empty()) {
+        s = m_free.back();
+        m_free.pop_back();
+    } else {
+        s = static_cast<Slot>(m_handles.size());
+        m_handles.push_back(0);
+        m_flags.push_back(0);
+        m_generations.push_back(0);
+        m_seenEpoch.push_back(0);
+        m_rects.emplace_back();
+        m_styles.emplace_back();
+        m_applied.emplace_back();
+        m_identities.push_back(0);
+    }
+    m_handles[s] = handle;
+    m_flags[s] = kLive;
+    ++m_generations[s];
+    m_seenEpoch[s] = 0;
+    m_rects[s] = WindowRect{};
+    m_styles[s] = BorderStyle{};
+    m_applied[s] = AppliedBorder{};
+    m_identities[s] = 0;
+
+    const size_t mask = m_index.size() - 1;
+    size_t i = Bucket(handle);
+    while (m_index[i].key) i = (i + 1) & mask;
+    m_index[i] = { handle, s };
+    ++m_size;
+    return s;
+}
+
+void WindowRegistry::IndexErase(uint64_t key)
+{
+    const size_t mask = m_index.size() - 1;
+    size_t i = Bucket(key);
+    while (m_index[i].key != key) {
+        if (!m_index[i].key) return;
+        i = (i + 1) & mask;
+    }
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    for (size_t j = (i + 1) & mask; m_index[j].key; j = (j + 1) & mask) {
+        size_t home = Bucket(m_index[j].key);
+        // Move j into the hole at i unless its home lies cyclically in (i, j]
+        bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (stays) continue;
+        m_index[i] = m_index[j];
+        i = j;
+    }
+    m_index[i] = IndexEntry{};
+}
+
+void WindowRegistry::Release(Slot s)
+{
+    if (!IsLive(s)) return;
+    IndexErase(m_handles[s]);
+    m_handles[s] = 0;
+    m_flags[s] = 0;
+    m_free.push_back(s);
+    --m_size;
+}
+
+bool WindowRegistry::Release(uint64_t handle)
+{
+    Slot s = Find(handle);
+    if (s == kNoSlot) return false;
+    Release(s);
+    return true;
+}
+
+void WindowRegistry::Clear()
+{
+    for (Slot s = 0; s < m_flags.size(); ++s) Release(s);
+    m_order.clear();
+}
+
+void WindowRegistry::BeginPass()
+{
+    m_order.clear();
+    if (++m_epoch == 0) {
+        // Wrapped: forget every old mark so nothing looks visited by accident
+        std::fill(m_seenEpoch.begin(), m_seenEpoch.end(), 0u);
+        m_epoch = 1;
+    }
+}
+
+void WindowRegistry::Visit(Slot s)
+{
+    if (!IsLive(s) || m_seenEpoch[s] == m_epoch) return;
+    m_seenEpoch[s] = m_epoch;
+    m_order.push_back(s);
+}
+
+size_t WindowRegistry::MemoryBytes() const
+{
+    return m_index.capacity() * sizeof(IndexEntry) +
+           (m_handles.capacity() + m_identities.capacity()) * sizeof(uint64_t) +
+           (m_flags.capacity() + m_generations.capacity() + m_seenEpoch.capacity()) * sizeof(uint32_t) +
+           m_rects.capacity() * sizeof(WindowRect) +
+           m_styles.capacity() * sizeof(BorderStyle) +
+           m_applied.capacity() * sizeof(AppliedBorder) +
+           (m_free.capacity() + m_order.capacity()) * sizeof(Slot);
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "StyleRules.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Tracked windows: flat open-addressing handle -> slot index plus structure-of-arrays
+// columns, so per-frame passes (filter, region, DWM diff) walk contiguous memory instead
+// of one heap node per window. Portable; handles are HWND values widened to uint64_t.
+// Render thread only (see Pipeline.h).
+
+struct WindowRect { int32_t left = 0, top = 0, right = 0, bottom = 0; };
+inline bool operator==(const WindowRect& a, const WindowRect& b)
+{
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+// DWM attributes last written to a window (mirrors what DwmSetWindowAttribute accepted)
+struct AppliedBorder {
+    uint32_t color = 0;   // COLORREF
+    int32_t thickness = 0;
+    CornerStyle corner = CornerStyle::Default;
+};
+
+class WindowRegistry {
+public:
+    using Slot = uint32_t;
+    static constexpr Slot kNoSlot = UINT32_MAX;
+
+    enum Flag : uint32_t {
+        kLive = 1u << 0,
+        kApplied = 1u << 1, // AppliedBorder column is valid
+        kOverlay = 1u << 2, // hybrid mode: DWM refused the border, the overlay draws it
+        kAdopted = 1u << 3, // Applied came from the previous instance's ledger, not yet re-diffed
+    };
+
+    // Slot of the handle, or kNoSlot
+    Slot Find(uint64_t handle) const;
+    // Existing slot, or a new one (freed slots are reused first). handle must be non-zero.
+    Slot Acquire(uint64_t handle);
+    void Release(Slot s);
+    bool Release(uint64_t handle);
+    void Clear();
+
+    size_t Size() const { return m_size; }
+    size_t SlotCount() const { return m_handles.size(); }
+    bool IsLive(Slot s) const { return s < m_flags.size() && (m_flags[s] & kLive); }
+
+    // Column accessors; slot ids stay stable until Release
+    uint64_t Handle(Slot s) const { return m_handles[s]; }
+    // Bumped every time a slot is (re)assigned, so a stored {slot, generation} detects reuse
+    uint32_t Generation(Slot s) const { return m_generations[s]; }
+    uint32_t& Flags(Slot s) { return m_flags[s]; }
+    uint32_t Flags(Slot s) const { return m_flags[s]; }
+    WindowRect& Rect(Slot s) { return m_rects[s]; }
+    const WindowRect& Rect(Slot s) const { return m_rects[s]; }
+    BorderStyle& Style(Slot s) { return m_styles[s]; }
+    const BorderStyle& Style(Slot s) const { return m_styles[s]; }
+    AppliedBorder& Applied(Slot s) { return m_applied[s]; }
+    // Creator identity of the window (AppliedLedger.h), 0 until first needed
+    uint64_t& Identity(Slot s) { return m_identities[s]; }
+
+    // Per-refresh pass: BeginPass, Visit every current window in z-order (top first),
+    // then iterate Order() and SweepUnvisited() the windows that disappeared.
+    void BeginPass();
+    void Visit(Slot s);
+    bool Visited(Slot s) const { return m_seenEpoch[s] == m_epoch; }
+    const std::vector<Slot>& Order() const { return m_order; }
+    // Calls onStale(slot) for each live slot not visited in this pass, then releases it.
+    template <typename F>
+    size_t SweepUnvisited(F&& onStale)
+    {
+        size_t n = 0;
+        for (Slot s = 0; s < m_flags.size(); ++s) {
+            if (!(m_flags[s] & kLive) || m_seenEpoch[s] == m_epoch) continue;
+            onStale(s);
+            Release(s);
+            ++n;
+        }
+        return n;
+    }
+
+    // Index + columns + free list / order vectors
+    size_t MemoryBytes() const;
+
+private:
+    struct IndexEntry {
+        uint64_t key = 0; // 0 = empty
+        Slot slot = kNoSlot;
+    };
+
+    size_t Bucket(uint64_t key) const;
+    void Rehash(size_t buckets);
+    void IndexErase(uint64_t key);
+
+    std::vector<IndexEntry> m_index; // power-of-two size, load <= 1/2, linear probing
+    size_t m_indexShift = 64;
+    size_t m_size = 0;
+
+    std::vector<uint64_t> m_handles;
+    std::vector<uint32_t> m_flags;
+    std::vector<uint32_t> m_generations;
+    std::vector<uint32_t> m_seenEpoch;
+    std::vector<WindowRect> m_rects;
+    std::vector<BorderStyle> m_styles;
+    std::vector<AppliedBorder> m_applied;
+    std::vector<uint64_t> m_identities;
+
+    std::vector<Slot> m_free;
+    std::vector<Slot> m_order;
+    uint32_t m_epoch = 1;
+};
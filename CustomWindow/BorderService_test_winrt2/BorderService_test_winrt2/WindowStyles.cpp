@@ -0,0 +1,157 @@
+#include "pch.h"
+#include "Globals.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "ProcessFilter.h"
+#include "WindowStyles.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+// All access happens on the render thread (event batches and IPC tasks, see Pipeline.h),
+// except HasTitleStyleRules which the intake thread reads when (re)installing hooks
+struct CachedMatch {
+    uint32_t generation = 0;
+    int32_t rule = CompiledStyleRules::kNoMatch;
+};
+
+static CompiledStyleRules s_rules;
+static std::wstring s_rulesText;
+static std::atomic<bool> s_hasTitleRules{ false };
+static std::unordered_map<HWND, CachedMatch, HwndHash, HwndEq> s_matches;
+
+static constexpr size_t kPruneThreshold = 4096;
+
+void LoadStyleRules(const std::wstring& text)
+{
+    s_rulesText = text;
+    size_t invalid = 0;
+    auto rules = ParseStyleRules(text, &invalid);
+
+    auto t0 = std::chrono::steady_clock::now();
+    s_rules.Compile(std::move(rules));
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+
+    s_hasTitleRules.store(s_rules.HasTitlePatterns(), std::memory_order_release);
+    s_matches.clear();
+    MetricSet(Metric::RulesCount, static_cast<int64_t>(s_rules.RuleCount()));
+    MetricSet(Metric::RulesInvalidLines, static_cast<int64_t>(invalid));
+    MetricSet(Metric::RulesCompileUs, static_cast<int64_t>(us));
+    MetricSet(Metric::RulesCachedWindows, 0);
+    DebugLog(L"[Rules] Compiled " + std::to_wstring(s_rules.RuleCount()) + L" rule(s), " +
+             std::to_wstring(invalid) + L" invalid line(s), " + std::to_wstring(us) + L" us");
+}
+
+bool LoadStyleRulesFromFile(const std::wstring& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        DebugLog(L"[Rules] Cannot open " + path);
+        return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    std::string utf8 = ss.str();
+    if (utf8.size() >= 3 && utf8.compare(0, 3, "\xEF\xBB\xBF") == 0) utf8.erase(0, 3);
+
+    std::wstring text;
+    if (!utf8.empty()) {
+        int len = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+        text.resize(static_cast<size_t>(len));
+        MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), text.data(), len);
+    }
+    LoadStyleRules(text);
+    return true;
+}
+
+bool HasStyleRules()
+{
+    return !s_rules.Empty();
+}
+
+const std::wstring& CurrentStyleRulesText()
+{
+    return s_rulesText;
+}
+
+bool HasTitleStyleRules()
+{
+    return s_hasTitleRules.load(std::memory_order_acquire);
+}
+
+static int32_t EvaluateRule(HWND h)
+{
+    std::wstring process;
+    GetWindowImageName(h, process);
+
+    wchar_t cls[256] = {};
+    GetClassNameW(h, cls, 256);
+
+    std::wstring title;
+    if (s_rules.HasTitlePatterns()) {
+        wchar_t buf[512] = {};
+        int n = GetWindowTextW(h, buf, 512);
+        title.assign(buf, n > 0 ? static_cast<size_t>(n) : 0);
+    }
+
+    MetricAdd(Metric::RulesEvaluations);
+    return s_rules.Match(process, CompiledStyleRules::Lower(cls), CompiledStyleRules::Lower(title));
+}
+
+static void PruneMatches()
+{
+    for (auto it = s_matches.begin(); it != s_matches.end(); ) {
+        if (!IsWindow(it->first)) it = s_matches.erase(it);
+        else ++it;
+    }
+}
+
+BorderStyle ResolveWindowStyle(HWND h, const BorderSettings& settings)
+{
+    BorderStyle base = settings.Style();
+    if (s_rules.Empty()) return base;
+
+    auto it = s_matches.find(h);
+    if (it != s_matches.end() && it->second.generation == s_rules.Generation()) {
+        MetricAdd(Metric::RulesCacheHits);
+    } else {
+        if (s_matches.size() >= kPruneThreshold) PruneMatches();
+        CachedMatch& m = s_matches[h];
+        m.generation = s_rules.Generation();
+        m.rule = EvaluateRule(h);
+        it = s_matches.find(h);
+        MetricSet(Metric::RulesCachedWindows, static_cast<int64_t>(s_matches.size()));
+    }
+    return it->second.rule == CompiledStyleRules::kNoMatch ? base : s_rules.Rule(it->second.rule).Apply(base);
+}
+
+BorderStyle ResolveWindowStyle(HWND h)
+{
+    return ResolveWindowStyle(h, *g_settings.Read());
+}
+
+bool ReevaluateWindowStyle(HWND h)
+{
+    if (!s_rules.HasTitlePatterns()) return false;
+    auto it = s_matches.find(h);
+    if (it == s_matches.end()) return false; // not seen yet; resolved on first use
+
+    int32_t rule = EvaluateRule(h);
+    bool changed = rule != it->second.rule || it->second.generation != s_rules.Generation();
+    it->second.rule = rule;
+    it->second.generation = s_rules.Generation();
+    return changed;
+}
+
+void ForgetWindowStyle(HWND h)
+{
+    if (s_matches.erase(h)) {
+        MetricSet(Metric::RulesCachedWindows, static_cast<int64_t>(s_matches.size()));
+    }
+}
+
+D2D1_COLOR_F ToD2DColor(const ColorF& c)
+{
+    return D2D1::ColorF(c.r, c.g, c.b, c.a);
+}
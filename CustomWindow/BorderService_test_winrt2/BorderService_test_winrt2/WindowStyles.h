@@ -0,0 +1,27 @@
+#pragma once
+#include "pch.h"
+#include "SettingsSnapshot.h"
+#include "StyleRules.h"
+#include <string>
+
+// Per-window border style: the global settings (a g_settings snapshot) with the first
+// matching style rule applied on top. The matched rule index is cached per
+// window and re-evaluated only on title change (ReevaluateWindowStyle) or rule reload.
+
+// text: see ParseStyleRules (RULES IPC command / --rules file)
+void LoadStyleRules(const std::wstring& text);
+bool LoadStyleRulesFromFile(const std::wstring& path);
+bool HasStyleRules();
+// Rule text as last loaded (persisted in the startup snapshot)
+const std::wstring& CurrentStyleRulesText();
+bool HasTitleStyleRules();
+
+// Passes resolve every window against the one snapshot they captured
+BorderStyle ResolveWindowStyle(HWND h, const BorderSettings& settings);
+BorderStyle ResolveWindowStyle(HWND h);
+
+// EVENT_OBJECT_NAMECHANGE: returns true if the window now matches a different rule
+bool ReevaluateWindowStyle(HWND h);
+void ForgetWindowStyle(HWND h);
+
+D2D1_COLOR_F ToD2DColor(const ColorF& c);
@@ -5,6 +5,8 @@
 // Windows & graphics headers
 #include <windows.h>
 #include <shellapi.h>
+#include <wtsapi32.h>
+#include <sddl.h>
 #include <dwmapi.h>
 #include <d2d1_1.h>
 #include <dcomp.h>
@@ -24,3 +26,6 @@
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "gdi32.lib")
 #pragma comment(lib, "Shell32.lib")
+#pragma comment(lib, "Wtsapi32.lib")
+#pragma comment(lib, "Advapi32.lib")
+#pragma comment(lib, "Shcore.lib")
@@ -19,7 +19,10 @@ public class BorderServiceAdvancedPerformanceTests : IDisposable
     private readonly ITestOutputHelper _output;
     private readonly List<Process> _processesToCleanup = new();
 
-    private const string BorderServiceTestWinrtPath = @"C:\Users\subin\source\repos\BorderService_Test_winrt\BorderService_Test_winrt";
+    // ȯ  BORDERSERVICE_TEST_WINRT_DIR    (⺻:   üũƿ BorderService_Test_winrt)
+    private static readonly string BorderServiceTestWinrtPath =
+        Environment.GetEnvironmentVariable("BORDERSERVICE_TEST_WINRT_DIR")
+        ?? @"..\BorderService_Test_winrt\BorderService_Test_winrt";
     private const string BorderServiceTestWinrt2Path = @"CustomWindow\BorderService_test_winrt2";
 
     private const int WarmupDurationMs = 3000;
@@ -21,7 +21,10 @@ public class BorderServicePerformanceTests : IDisposable
     private readonly List<Process> _processesToCleanup = new();
 
     // 테스트 대상 실행 파일 경로
-    private const string BorderServiceTestWinrtPath = @"C:\Users\subin\source\repos\BorderService_Test_winrt\BorderService_Test_winrt";
+    // 환경 변수 BORDERSERVICE_TEST_WINRT_DIR 로 재정의 가능 (기본값: 저장소 옆에 체크아웃한 BorderService_Test_winrt)
+    private static readonly string BorderServiceTestWinrtPath =
+        Environment.GetEnvironmentVariable("BORDERSERVICE_TEST_WINRT_DIR")
+        ?? @"..\BorderService_Test_winrt\BorderService_Test_winrt";
     private const string BorderServiceTestWinrt2Path = @"CustomWindow\BorderService_test_winrt2";
 
     // 성능 측정 관련 상수
@@ -100,6 +100,7 @@ namespace CustomWindow
                     BorderService.SetRenderModePreference(ConfigStore.Config.BorderRenderMode);
                     BorderService.SetForegroundWindowOnly(ConfigStore.Config.ForegroundWindowOnly);
                     BorderService.UpdateCornerMode(ConfigStore.Config.WindowCornerMode);
+                    BorderService.UpdateStyleRules(ConfigStore.Config.Snapshot.StyleRules);
 
                     // Start BorderService with configured settings
                     WindowTracker.Start();
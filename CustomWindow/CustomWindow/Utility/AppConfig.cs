@@ -26,6 +26,7 @@ public sealed class AppConfig
     public bool AutoWindowChange { get; set; }
     public bool ForegroundWindowOnly { get; set; } // ׶ â ׵θ ǥ
     public List<string> ExcludedPrograms { get; set; } = new();
+    public string StyleRules { get; set; } = string.Empty; // ۺ ׵θ Ģ ( ٿ ϳ, --rules ϰ  )
     public string? WindowCornerMode { get; set; }
     public bool AutoAdmin { get; set; }
     public bool MinimizeToTray { get; set; }
@@ -43,7 +44,7 @@ public sealed class AppConfig
     public bool ForceBorderColor { get; set; }
     public int WindowApplyDelayMs { get; set; } = 200;
 
-    // Border render method: "Auto", "Dwm", or "DComp"
+    // Border render method: "Auto", "Dwm", "DComp", or "Hybrid"
     public string BorderRenderMode { get; set; } = "Auto";
     
     // Enable/Disable window tracker logging
@@ -22,7 +22,7 @@ public static class BorderService
     private static bool _lastShowConsole = false;
     private static string _lastCorner = "default"; // normalized tokens: default|donot|round|roundsmall
 
-    // Render mode preference (Auto/Dwm/DComp)
+    // Render mode preference (Auto/Dwm/DComp/Hybrid)
     private static string _renderModePreference = "Auto";
 
     // Foreground window only mode
@@ -31,11 +31,21 @@ public static class BorderService
     // Excluded processes cache (names without extension)
     private static string[] _excluded = Array.Empty<string>();
 
+    // Per-application style rules (one rule per line, see StyleRules.h in the service)
+    private static string _styleRules = string.Empty;
+
     // IPC constants
     private const uint WM_COPYDATA = 0x004A;
     private const uint SMTO_NORMAL = 0x0000;
     private const uint SMTO_ABORTIFHUNG = 0x0002;
     private const string OverlayWindowClass = "BorderOverlayDCompWindowClass";
+    // Time the service may spend putting the default DWM borders back on QUIT (--exitdeadline);
+    // it exits on its own afterwards, so the GUI only kills it if it is hung
+    private const int ExitRestoreDeadlineMs = 1000;
+
+    // Set by the service after its first frame (see FastStart.h); reset before every launch
+    private const string OverlayReadyEventName = @"Local\CustomWindow.BorderOverlay.Ready";
+    private static EventWaitHandle? _overlayReady;
 
     //  ÷:    UpdateThickness/UpdateColor 
     private static bool _isRestarting = false;
@@ -90,7 +100,7 @@ public static class BorderService
         return info.Found ? $"EXE ˻: {info.Path}" : "EXE  ã  ";
     }
 
-    /// <summary>  ȣ (Auto/Dwm/DComp)</summary>
+    /// <summary>  ȣ (Auto/Dwm/DComp/Hybrid)</summary>
     public static void SetRenderModePreference(string mode)
     {
         lock (_sync)
@@ -174,48 +184,64 @@ public static class BorderService
             _excluded = excludedProcesses ?? Array.Empty<string>();
 
             LogMessage($"Starting in EXE mode (Color={borderColorHex}, Thickness={thickness}, Console={(_lastShowConsole ? "Show" : "Hide")}, Mode={_renderModePreference}, Corner={_lastCorner}, ForegroundOnly={_foregroundWindowOnly})");
+            // â   ͸ 񽺰   (  --exclude ڷ   )
             StartWinRTConsole(borderColorHex, thickness, exePath: null, showConsole: _lastShowConsole);
+        }
+    }
 
-            // Subscribe to WindowTracker updates to push HWND list to overlay
-            try
+    /// <summary> μ   (  IPC 񽺿 )</summary>
+    public static void UpdateExcludedProcesses(string[] excludedProcesses)
+    {
+        lock (_sync)
+        {
+            _excluded = excludedProcesses ?? Array.Empty<string>();
+            if (!OverlayAvailable) return;
+
+            var hwnd = FindOverlayWindow();
+            if (hwnd != IntPtr.Zero && TrySendCopyData(hwnd, $"EXCLUDE {BuildExclusionList()}"))
             {
-                WindowTracker.WindowSetChanged -= OnWindowSetChanged;
-                WindowTracker.WindowSetChanged += OnWindowSetChanged;
+                LogMessage($"Applied exclusion list via IPC ({_excluded.Length} entries)");
+                return;
+            }
+            LogMessage("IPC failed for exclusion change");
+            if (IsExeModeRunning)
+            {
+                RestartWinRTConsoleForSettingsUpdate(GetCurrentColorOrDefault(), GetCurrentThicknessOrDefault(), exePath: null, showConsole: _lastShowConsole);
             }
-            catch { }
         }
     }
 
-    private static void OnWindowSetChanged(IReadOnlyCollection<nint> handles)
+    /// <summary>Per-application style rules, e.g. "process=cmd; title=Administrator:; color=#FF0000" (applied via IPC)</summary>
+    public static void UpdateStyleRules(string rulesText)
     {
-        try
+        lock (_sync)
         {
+            _styleRules = rulesText ?? string.Empty;
             if (!OverlayAvailable) return;
 
-            // Apply exclusion: map to process names then filter
-            var detailed = WindowTracker.GetCurrentWindowsDetailed();
-            var excludedSet = new HashSet<string>(_excluded.Select(x => Path.GetFileNameWithoutExtension(x) ?? string.Empty), StringComparer.OrdinalIgnoreCase);
-            var filtered = detailed
-                .Where(t => t.Handle != IntPtr.Zero)
-                .Where(t => string.IsNullOrEmpty(t.ProcessName) || !excludedSet.Contains(t.ProcessName!))
-                .Select(t => t.Handle)
-                .ToArray();
-
-            TrySendHwndListToOverlay(filtered);
-        }
-        catch (Exception ex)
-        {
-            LogMessage($"OnWindowSetChanged error: {ex.Message}");
+            var hwnd = FindOverlayWindow();
+            if (hwnd != IntPtr.Zero && TrySendCopyData(hwnd, BuildRulesMessage()))
+            {
+                LogMessage("Applied style rules via IPC");
+                return;
+            }
+            LogMessage("IPC failed for style rules change");
         }
     }
 
+    // Lines are sent '|' separated so the message stays single-line (the settings TextBox uses '\r' line breaks)
+    private static string BuildRulesMessage() =>
+        "RULES " + string.Join('|', _styleRules.Split(new[] { '\r', '\n' }, StringSplitOptions.RemoveEmptyEntries | StringSplitOptions.TrimEntries));
+
+    private static string BuildExclusionList() =>
+        string.Join('|', _excluded.Select(x => Path.GetFileNameWithoutExtension(x?.Trim() ?? string.Empty))
+                                  .Where(x => !string.IsNullOrEmpty(x) && x.IndexOf('"') < 0));
+
     /// <summary>BorderService </summary>
     public static void StopIfRunning()
     {
         lock (_sync)
         {
-            try { WindowTracker.WindowSetChanged -= OnWindowSetChanged; } catch { }
-
             if (!_running && _winrtProc == null) return;
 
             LogMessage("Stopping BorderService");
@@ -224,7 +250,9 @@ public static class BorderService
         }
     }
 
-    private static void StopWinRTConsoleIfRunning()
+    // quitCommand: "QUIT" restores the default DWM borders before exiting, "QUIT KEEP" (restart)
+    // leaves them for the next instance to adopt
+    private static void StopWinRTConsoleIfRunning(string quitCommand = "QUIT")
     {
         try
         {
@@ -235,10 +263,10 @@ public static class BorderService
                 var hwnd = FindOverlayWindow();
                 if (hwnd != IntPtr.Zero)
                 {
-                    if (TrySendCopyData(hwnd, "QUIT"))
+                    if (TrySendCopyData(hwnd, quitCommand))
                     {
-                        LogMessage("Sent QUIT command via IPC, waiting for process to exit...");
-                        if (_winrtProc.WaitForExit(2000))
+                        LogMessage($"Sent {quitCommand} command via IPC, waiting for process to exit...");
+                        if (_winrtProc.WaitForExit(ExitRestoreDeadlineMs + 2000))
                         {
                             LogMessage("Process exited gracefully");
                             _winrtProc = null;
@@ -249,7 +277,7 @@ public static class BorderService
                     }
                     else
                     {
-                        LogMessage("Failed to send QUIT command, forcing termination...");
+                        LogMessage($"Failed to send {quitCommand} command, forcing termination...");
                     }
                 }
                 else
@@ -410,10 +438,13 @@ public static class BorderService
     {
         var color = string.IsNullOrWhiteSpace(borderColorHex) ? "#0078FF" : borderColorHex.Trim();
         var modeArg = _renderModePreference.Equals("dwm", StringComparison.OrdinalIgnoreCase) ? "dwm" :
-                      _renderModePreference.Equals("dcomp", StringComparison.OrdinalIgnoreCase) ? "dcomp" : "auto";
+                      _renderModePreference.Equals("dcomp", StringComparison.OrdinalIgnoreCase) ? "dcomp" :
+                      _renderModePreference.Equals("hybrid", StringComparison.OrdinalIgnoreCase) ? "hybrid" : "auto";
         var cornerArg = _lastCorner;
         var foregroundArg = _foregroundWindowOnly ? "1" : "0";
-        return $"{(withConsole ? "--console " : string.Empty)}--mode {modeArg} --color \"{color}\" --thickness {thickness} --corner {cornerArg} --foregroundonly {foregroundArg}";
+        var exclusions = BuildExclusionList();
+        var excludeArg = exclusions.Length > 0 ? $" --exclude \"{exclusions}\"" : string.Empty;
+        return $"{(withConsole ? "--console " : string.Empty)}--faststart --exitdeadline {ExitRestoreDeadlineMs} --mode {modeArg} --color \"{color}\" --thickness {thickness} --corner {cornerArg} --foregroundonly {foregroundArg}{excludeArg}";
     }
 
     private static string? FindWinRTExePath()
@@ -472,6 +503,9 @@ public static class BorderService
                     RedirectStandardError = !showConsole
                 };
 
+                _overlayReady ??= new EventWaitHandle(false, EventResetMode.ManualReset, OverlayReadyEventName);
+                _overlayReady.Reset();
+
                 _winrtProc = Process.Start(psi) ?? throw new InvalidOperationException("Failed to start BorderServiceWinRT process.");
 
                 if (!showConsole)
@@ -489,7 +523,6 @@ public static class BorderService
                     {
                         _winrtProc = null;
                         _running = false;
-                        try { WindowTracker.WindowSetChanged -= OnWindowSetChanged; } catch { }
                     }
                 };
 
@@ -503,15 +536,8 @@ public static class BorderService
                     {
                         TrySendCopyData(hwnd, BuildSettingsMessage());
                         TrySendCopyData(hwnd, BuildRefreshMessage());
+                        if (_styleRules.Length > 0) TrySendCopyData(hwnd, BuildRulesMessage());
                         LogMessage("Overlay ready -> settings re-applied via IPC");
-
-                        var detailed = WindowTracker.GetCurrentWindowsDetailed();
-                        var excludedSet = new HashSet<string>(_excluded.Select(x => Path.GetFileNameWithoutExtension(x) ?? string.Empty), StringComparer.OrdinalIgnoreCase);
-                        var filtered = detailed.Where(t => t.Handle != IntPtr.Zero)
-                                               .Where(t => string.IsNullOrEmpty(t.ProcessName) || !excludedSet.Contains(t.ProcessName!))
-                                               .Select(t => t.Handle)
-                                               .ToArray();
-                        TrySendHwndListToOverlay(filtered);
                     }
                     else { LogMessage("Overlay not ready within timeout after start"); }
                 });
@@ -527,16 +553,6 @@ public static class BorderService
         }
     }
 
-    private static bool TrySendHwndListToOverlay(IReadOnlyCollection<nint> handles)
-    {
-        if (handles == null || handles.Count == 0) return false;
-        var hwnd = FindOverlayWindow();
-        if (hwnd == IntPtr.Zero) return false;
-        var parts = handles.Select(h => $"0x{((IntPtr)h).ToInt64():X}");
-        var msg = "HWNDS " + string.Join(' ', parts);
-        return TrySendCopyData(hwnd, msg);
-    }
-
     private static string BuildSettingsMessage() => $"SET foregroundonly={(_foregroundWindowOnly ? "1" : "0")} color={NormalizeColor(GetCurrentColorOrDefault())} thickness={GetCurrentThicknessOrDefault()} corner={_lastCorner}";
     private static string BuildRefreshMessage() => $"REFRESH foregroundonly={(_foregroundWindowOnly ? "1" : "0")} color={NormalizeColor(GetCurrentColorOrDefault())} thickness={GetCurrentThicknessOrDefault()} corner={_lastCorner}";
 
@@ -570,6 +586,13 @@ public static class BorderService
 
     private static IntPtr WaitForOverlayWindowReady(int timeoutMs = 1500, int intervalMs = 100)
     {
+        // The service signals the named event after its first frame, so no polling is needed
+        if (_overlayReady != null)
+        {
+            _overlayReady.WaitOne(timeoutMs);
+            return FindOverlayWindow();
+        }
+
         var sw = Stopwatch.StartNew();
         IntPtr h = IntPtr.Zero;
         while (sw.ElapsedMilliseconds < timeoutMs)
@@ -665,12 +688,7 @@ public static class BorderService
         {
             _isRestarting = true;
             LogMessage($"Restarting BorderService with Color={borderColorHex}, Thickness={thickness}, Console={showConsole}");
-
-            if (_winrtProc != null && !_winrtProc.HasExited)
-            {
-                _winrtProc.Kill(entireProcessTree: true);
-                _winrtProc.WaitForExit(1000);
-            }
+            StopWinRTConsoleIfRunning("QUIT KEEP");
         }
         catch (Exception ex)
         {
@@ -729,36 +747,8 @@ public static class BorderService
                 var hwnd = FindOverlayWindow();
                 if (hwnd != IntPtr.Zero)
                 {
+                    // â   ͸ 񽺰 SET ó   
                     TrySendCopyData(hwnd, msg);
-
-                    // ׶ ɼ   ణ ð ΰ â  ٽ 
-                    System.Threading.Tasks.Task.Delay(200).ContinueWith(_ =>
-                    {
-                        try
-                        {
-                            // ü â  ٽ Ͽ  (͸ C++ ʿ ó)
-                            var allDetails = WindowTracker.GetCurrentWindowsDetailed();
-                            var excludedSet = new HashSet<string>(_excluded.Select(x => Path.GetFileNameWithoutExtension(x) ?? string.Empty), StringComparer.OrdinalIgnoreCase);
-                            var allWindows = allDetails.Where(t => t.Handle != IntPtr.Zero)
-                                                      .Where(t => string.IsNullOrEmpty(t.ProcessName) || !excludedSet.Contains(t.ProcessName!))
-                                                      .Select(t => t.Handle)
-                                                      .ToArray();
-
-                            TrySendHwndListToOverlay(allWindows);
-                            LogMessage($"Sent complete window list ({allWindows.Length} windows) after foreground mode change");
-
-                            // ߰ ΰħ û ( ° ΰħ Ȯ ݿ)
-                            System.Threading.Tasks.Task.Delay(100).ContinueWith(__ =>
-                            {
-                                TrySendRefreshToOverlay();
-                                LogMessage("Sent final refresh after foreground mode change");
-                            }, System.Threading.Tasks.TaskScheduler.Default);
-                        }
-                        catch (Exception ex)
-                        {
-                            LogMessage($"Failed to send window list after foreground mode change: {ex.Message}");
-                        }
-                    }, System.Threading.Tasks.TaskScheduler.Default);
                 }
                 else if (IsExeModeRunning)
                 {
@@ -104,6 +104,7 @@ public partial class NormalSettingsViewModel : ObservableObject
                 
                 // â 𼭸  
                 BorderService.UpdateCornerMode(_config.WindowCornerMode);
+                BorderService.UpdateStyleRules(_config.Snapshot.StyleRules);
                 
                 BorderService.StartIfNeeded(borderHex, thickness, _config.Snapshot.ExcludedPrograms.ToArray());
                 
@@ -242,13 +243,31 @@ public partial class NormalSettingsViewModel : ObservableObject
                 _config.Snapshot.ExcludedPrograms.Add(item);
             OnPropertyChanged();
 
-            // AutoWindowChange Ȱ ¸ BorderService Ͽ  ݿ
+            // AutoWindowChange Ȱ ¸   񽺿  ϸ 
             if (AutoWindowChange)
             {
-                BorderService.StopIfRunning();
-                var borderHex = _config.BorderColor ?? "#0078FF";
-                BorderService.StartIfNeeded(borderHex, _config.BorderThickness, _config.Snapshot.ExcludedPrograms.ToArray());
-                WindowTracker.AddExternalLog("Excluded   -> BorderService ");
+                BorderService.UpdateExcludedProcesses(_config.Snapshot.ExcludedPrograms.ToArray());
+                WindowTracker.AddExternalLog("Excluded   -> BorderService ");
+                CheckBorderServiceStatus();
+            }
+        }
+    }
+
+    public string StyleRuleList
+    {
+        get => _config.Snapshot.StyleRules;
+        set
+        {
+            var text = value ?? string.Empty;
+            if (_config.Snapshot.StyleRules == text) return;
+            _config.Snapshot.StyleRules = text;
+            OnPropertyChanged();
+
+            //   RULES IPC Ģ ü
+            if (AutoWindowChange)
+            {
+                BorderService.UpdateStyleRules(text);
+                WindowTracker.AddExternalLog("ۺ Ģ  -> BorderService ");
                 CheckBorderServiceStatus();
             }
         }
@@ -33,9 +33,9 @@ try {
 
 Write-Host ""
 
-# CSV  ã
+# CSV  ã ( --bench ó  bench_*.json )
 Write-Host "3??  CSV  ˻ ..." -ForegroundColor Yellow
-$csvFiles = Get-ChildItem -Path . -Filter "*timeseries.csv" -File
+$csvFiles = @(Get-ChildItem -Path . -Filter "*timeseries.csv" -File) + @(Get-ChildItem -Path . -Filter "bench_*.json" -File)
 
 if ($csvFiles.Count -eq 0) {
     Write-Host "? ð迭 CSV  ã  ϴ." -ForegroundColor Red
@@ -55,7 +55,7 @@ if ($csvFiles.Count -eq 0) {
         # ٽ CSV  ã
         Write-Host ""
         Write-Host "CSV  ˻ ..." -ForegroundColor Yellow
-        $csvFiles = Get-ChildItem -Path . -Filter "*timeseries.csv" -File
+        $csvFiles = @(Get-ChildItem -Path . -Filter "*timeseries.csv" -File) + @(Get-ChildItem -Path . -Filter "bench_*.json" -File)
     } else {
         exit 0
     }
@@ -1,11 +1,14 @@
+# -*- coding: cp949 -*-
 """
 BorderService   ׷  ũƮ
 
 CSV Ͽ ð迭 ͸ о ׷ մϴ.
+ --bench ó (JSON)   ֽϴ.
 
 :
     python plot_performance.py performance_comparison_timeseries.csv
     python plot_performance.py performance_test_winrt_timeseries.csv
+    python plot_performance.py bench_scenarios.json
     
 ʿ Ű:
     pip install matplotlib pandas
@@ -13,6 +16,7 @@ CSV 
 
 import sys
 import os
+import json
 import pandas as pd
 import matplotlib.pyplot as plt
 import matplotlib.dates as mdates
@@ -224,12 +228,93 @@ def plot_summary_comparison(csv_file):
     
     plt.show()
 
+def load_bench_results(json_file):
+    """--bench  б ( ٿ JSON ü ϳ, Ǵ JSON 迭)"""
+    with open(json_file, encoding='utf-8') as f:
+        text = f.read().strip()
+    if text.startswith('['):
+        results = json.loads(text)
+    else:
+        results = [json.loads(line) for line in text.splitlines() if line.strip()]
+    # ð迭 ִ ó  
+    return [r for r in results if r.get('TimeSeriesData')]
+
+def plot_bench_json(json_file):
+    """ùķ̼ ó  ð / ܰ躰  ׷ """
+    
+    results = load_bench_results(json_file)
+    if not results:
+        print(f"? ó  ϴ: {json_file}")
+        sys.exit(1)
+    
+    stages = ['Enumerate', 'Registry', 'Style', 'Region', 'Draw']
+    plt.style.use('seaborn-v0_8-darkgrid')
+    
+    for result in results:
+        name = result.get('Benchmark', 'scenario')
+        df = pd.DataFrame(result['TimeSeriesData'])
+        
+        fig, axes = plt.subplots(2, 2, figsize=(16, 10))
+        fig.suptitle(f'BorderService Scenario: {name} ({int(result.get("MaxTracked", 0))} windows tracked, simulated)',
+                     fontsize=16, fontweight='bold')
+        
+        # CPU  (ùķ̼ ð  ó ð)
+        ax1 = axes[0, 0]
+        ax1.plot(df['ElapsedSeconds'], df['CpuPercent'], color='#2E86AB', linewidth=2)
+        ax1.fill_between(df['ElapsedSeconds'], df['CpuPercent'], alpha=0.3, color='#2E86AB')
+        ax1.set_ylabel('CPU Usage (% of one core)', fontsize=11, fontweight='bold')
+        ax1.set_xlabel('Time (seconds)', fontsize=9)
+        ax1.grid(True, alpha=0.3)
+        ax1.set_title(f'CPU Usage (avg {result["AverageCpuPercent"]:.3f}%)', fontsize=11, fontweight='bold')
+        
+        #  ð ( ִ밪)
+        ax2 = axes[0, 1]
+        ax2.plot(df['ElapsedSeconds'], df['FrameMs'], color='#C73E1D', linewidth=2)
+        ax2.axhline(result['P95FrameMs'], color='gray', linestyle='--', linewidth=1, label='P95')
+        ax2.set_ylabel('Frame Time (ms)', fontsize=11, fontweight='bold')
+        ax2.set_xlabel('Time (seconds)', fontsize=9)
+        ax2.grid(True, alpha=0.3)
+        ax2.legend(loc='upper right')
+        ax2.set_title(f'Frame Time (avg {result["AverageFrameMs"]:.3f} ms, max {result["MaxFrameMs"]:.3f} ms)',
+                      fontsize=11, fontweight='bold')
+        
+        # ̺Ʈ / ٽ ׸ 
+        ax3 = axes[1, 0]
+        ax3.bar(df['ElapsedSeconds'], df['Events'], width=0.08, color='#F18F01', alpha=0.6, label='Events')
+        ax3.plot(df['ElapsedSeconds'], df['Redraws'], color='#5E2CA5', linewidth=2, label='Redraws')
+        ax3.set_ylabel('Count per sample', fontsize=11, fontweight='bold')
+        ax3.set_xlabel('Time (seconds)', fontsize=9)
+        ax3.grid(True, alpha=0.3)
+        ax3.legend(loc='upper right')
+        ax3.set_title('Events vs Redraws', fontsize=11, fontweight='bold')
+        
+        # ܰ躰 
+        ax4 = axes[1, 1]
+        costs = [result.get(f'{s}UsPerRedraw', 0) for s in stages]
+        bars = ax4.bar(stages, costs, color=['#2E86AB', '#A23B72', '#F18F01', '#C73E1D', '#06A77D'], alpha=0.8)
+        for bar in bars:
+            ax4.text(bar.get_x() + bar.get_width() / 2., bar.get_height(),
+                     f'{bar.get_height():.2f}', ha='center', va='bottom', fontsize=9)
+        ax4.set_ylabel('Microseconds per redraw', fontsize=11, fontweight='bold')
+        ax4.grid(True, alpha=0.3, axis='y')
+        ax4.set_title('Per-Stage Cost', fontsize=11, fontweight='bold')
+        
+        plt.tight_layout()
+        
+        output_file = json_file.replace('.json', f'_{name}_graph.png')
+        plt.savefig(output_file, dpi=300, bbox_inches='tight')
+        print(f"? ׷ : {output_file}")
+    
+    # ׷ ǥ
+    plt.show()
+
 def main():
     if len(sys.argv) < 2:
         print(": python plot_performance.py <csv_file>")
         print("\n:")
         print("  python plot_performance.py performance_comparison_timeseries.csv")
         print("  python plot_performance.py performance_test_winrt_timeseries.csv")
+        print("  python plot_performance.py bench_scenarios.json")
         sys.exit(1)
     
     csv_file = sys.argv[1]
@@ -240,6 +325,13 @@ def main():
     
     print(f"?? ׷  : {csv_file}")
     
+    # --bench ó 
+    if csv_file.endswith('.json'):
+        print(" ó ׷  ...")
+        plot_bench_json(csv_file)
+        print("\n? Ϸ!")
+        return
+    
     # CSV   ȮϿ Ÿ Ǵ
     df = pd.read_csv(csv_file, nrows=0)
     columns = df.columns.tolist()